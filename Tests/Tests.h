@@ -10,36 +10,332 @@
 #define TonicDemo_Tests_h
 
 #include "Synth.h"
-#include "RampedValue.h"
-#include<time.h> 
+#include "Mixer.h"
+#include "Arithmetic.h"
+#include "SineWave.h"
+#include "Filters.h"
+#include "StereoDelay.h"
+#include "PolySynth.h"
+#include "SawtoothWave.h"
+#include "ControlMidiToFreq.h"
 
 namespace Tonic {
 
   namespace PerformanceTest{
     
-    const int NUM_TEST_BUFFERS_TO_FILL = 10000;
-  
-    void testRampedValue(){
-  
-      //////// test ramped value ////////
+    // Per-node timings, including RampedValue's, are in the TonicBenchmark executable
+    // (examples/Standalone/TonicBenchmark). These tests cover whole-engine behaviour.
+    
+    const int NUM_PARALLEL_MIXER_INPUTS = 32;
+    const int NUM_PARALLEL_MIXER_BLOCKS = 2000;
     
-      RampedValue testRamp;
+    void testParallelMixer(){
+      
+      //////// mixer scaling across thread counts ////////
+      
+#if TONIC_HAS_CPP_11
+      unsigned int maxThreads = std::thread::hardware_concurrency();
+      if (maxThreads < 1) maxThreads = 1;
+      
+      Mixer mixer;
+      for (int i = 0; i < NUM_PARALLEL_MIXER_INPUTS; i++){
+        Synth synth;
+        synth.setOutputGen( (SineWave().freq(100 + 7*i) * 0.1) >> LPF24().cutoff(800 + 10*i) >> StereoDelay(0.1, 0.15).feedback(0.4) );
+        mixer.addInput(synth);
+      }
+      
+      float *outBuffer = new float[kSynthesisBlockSize * 2];
+      double serialTime = 0;
+      
+      for (unsigned int threads = 1; threads <= maxThreads; threads++){
+        
+        mixer.setNumThreads(threads);
+        
+        double startTime = monotonicTime();
+        for (int i = 0; i < NUM_PARALLEL_MIXER_BLOCKS; i++){
+          mixer.fillBufferOfFloats(outBuffer, kSynthesisBlockSize, 2);
+        }
+        double elapsed = monotonicTime() - startTime;
+        
+        if (threads == 1) serialTime = elapsed;
+        
+        ParallelMixStats stats = mixer.parallelStats();
+        
+        printf("[Tonic] Tested parallel Mixer with %i inputs on %u thread(s). Time to fill %i blocks: %f ms, speedup %.2fx, efficiency %.0f%% (busy %.2f threads)\n",
+               NUM_PARALLEL_MIXER_INPUTS, threads, NUM_PARALLEL_MIXER_BLOCKS, elapsed * 1000.0,
+               serialTime / elapsed, 100.0 * (serialTime / elapsed) / threads, threads > 1 ? stats.speedup() : 1.0);
+      }
       
-      TonicFrames testFrames(kSynthesisBlockSize, 1);
+      delete [] outBuffer;
+#endif
+      
+    }
     
-      clock_t startTime = clock();
+    const int NUM_GRAPH_SWAPS = 200;
+    const int NUM_GRAPH_SWAP_SINES = 200;
     
-      for(int i = 0; i < NUM_TEST_BUFFERS_TO_FILL; i++){
-          testRamp.tick(testFrames);        
-          testRamp.setValue(rand() % 100);
-          testRamp.setTarget(rand() % 100);
+    Generator sineBank(int numSines){
+      Adder adder;
+      for (int i = 0; i < numSines; i++){
+        adder.input(SineWave().freq(100 + i) * 0.01);
       }
+      return adder >> LPF24().cutoff(1000);
+    }
+    
+    void testGraphSwapContention(){
       
-      clock_t endTime = clock();
-      float diff = (((float)endTime - (float)startTime) / CLOCKS_PER_SEC ) * 1000;   
+      //////// worst-case block time while another thread replaces the graph ////////
+      
+#if TONIC_HAS_CPP_11
+      Synth synth;
+      synth.setOutputGen(sineBank(NUM_GRAPH_SWAP_SINES));
+      
+      std::atomic<bool> done(false);
+      std::thread uiThread([&]{
+        for (int i = 0; i < NUM_GRAPH_SWAPS; i++){
+          synth.setOutputGen(sineBank(NUM_GRAPH_SWAP_SINES));
+          synth.forceNewOutput();
+        }
+        synth.collectGarbage();
+        done = true;
+      });
+      
+      float *outBuffer = new float[kSynthesisBlockSize * 2];
+      synth.resetBlockTimingStats();
+      while (!done){
+        synth.fillBufferOfFloats(outBuffer, kSynthesisBlockSize, 2);
+      }
+      uiThread.join();
+      delete [] outBuffer;
+      
+      Tonic_::BlockTimingStats stats = synth.blockTimingStats();
+      
+      printf("[Tonic] Tested graph swaps during rendering. %i swaps over %lu blocks: mean block %.1f us, worst block %.1f us\n",
+             NUM_GRAPH_SWAPS, stats.blocks, stats.meanSeconds() * 1e6, stats.maxSeconds * 1e6);
+#endif
+      
+    }
+    
+    const int NUM_COMPILED_GRAPH_NODES = 300;
+    const int NUM_COMPILED_GRAPH_BLOCKS = 4000;
+    
+    void testCompiledGraph(){
+      
+      //////// recursive vs. flattened rendering of a deep chain of generators ////////
+      
+      float *outBuffer = new float[kSynthesisBlockSize * 2];
+      
+      for (int compiled = 0; compiled < 2; compiled++){
+        
+        Generator chain = SineWave().freq(220);
+        for (int i = 0; i < NUM_COMPILED_GRAPH_NODES; i++){
+          chain = chain * 0.99 + 0.001;
+        }
+        
+        Synth synth;
+        synth.setOutputGen(chain);
+        if (compiled) synth.compile(8 * NUM_COMPILED_GRAPH_NODES);
+        
+        double startTime = monotonicTime();
+        for (int i = 0; i < NUM_COMPILED_GRAPH_BLOCKS; i++){
+          synth.fillBufferOfFloats(outBuffer, kSynthesisBlockSize, 2);
+        }
+        double elapsed = monotonicTime() - startTime;
+        
+        printf("[Tonic] Tested %s rendering of a %i-stage chain. Time to fill %i blocks: %f ms\n",
+               synth.isCompiled() ? "compiled" : "recursive", NUM_COMPILED_GRAPH_NODES, NUM_COMPILED_GRAPH_BLOCKS, elapsed * 1000.0);
+      }
+      
+      delete [] outBuffer;
+      
+    }
+    
+    const int NUM_BLOCK_SIZE_TEST_FRAMES = 44100 * 10;
+    
+    void testBlockSizes(){
+      
+      //////// per-sample rendering cost across synthesis block sizes ////////
+      
+      const unsigned int blockSizes[] = {16, 32, 64, 128, 256, 512, 1024};
+      const unsigned int numBlockSizes = sizeof(blockSizes) / sizeof(blockSizes[0]);
+      const unsigned int bufferFrames = 1024;
+      
+      float *outBuffer = new float[bufferFrames * 2];
+      
+      for (unsigned int b = 0; b < numBlockSizes; b++){
+        
+        Synth synth;
+        synth.setOutputGen( sineBank(32) * 0.5 >> StereoDelay(0.1, 0.15).feedback(0.4) );
+        synth.setBlockSize(blockSizes[b]);
+        
+        // first buffer applies the block size and resizes everything
+        synth.fillBufferOfFloats(outBuffer, bufferFrames, 2);
+        
+        double startTime = monotonicTime();
+        for (int i = 0; i < NUM_BLOCK_SIZE_TEST_FRAMES; i += bufferFrames){
+          synth.fillBufferOfFloats(outBuffer, bufferFrames, 2);
+        }
+        double elapsed = monotonicTime() - startTime;
+        
+        printf("[Tonic] Tested rendering with %u-frame blocks. %.1f ns per sample\n",
+               synth.blockSize(), elapsed * 1e9 / NUM_BLOCK_SIZE_TEST_FRAMES);
+      }
+      
+      delete [] outBuffer;
+      
+    }
+    
+    const int NUM_POLY_VOICES = 32;
+    const int NUM_POLY_BLOCKS = 4000;
+    
+    void testPolySynth(){
+      
+      //////// rendering cost against the number of sounding voices ////////
+      
+      const int heldNotes[] = {0, 1, 4, 16, 32};
+      
+      float *outBuffer = new float[kSynthesisBlockSize * 2];
+      
+      for (int n = 0; n < 5; n++){
+        
+        PolySynth poly;
+        for (int v = 0; v < NUM_POLY_VOICES; v++){
+          Synth voice;
+          ControlParameter note = voice.addParameter("polyNote");
+          ADSR env = ADSR(0.01, 0.1, 0.8, 0.2).trigger(voice.addParameter("polyGate"));
+          voice.setOutputGen( (SawtoothWave().freq(ControlMidiToFreq().input(note)) >> LPF12().cutoff(2000)) * env * 0.05 );
+          poly.addVoice(voice, env);
+        }
+        
+        for (int i = 0; i < heldNotes[n]; i++){
+          poly.noteOn(40 + i);
+        }
+        
+        double startTime = monotonicTime();
+        for (int i = 0; i < NUM_POLY_BLOCKS; i++){
+          poly.fillBufferOfFloats(outBuffer, kSynthesisBlockSize, 2);
+        }
+        double elapsed = monotonicTime() - startTime;
+        
+        printf("[Tonic] Tested PolySynth with %i of %i voices sounding. Time to fill %i blocks: %f ms\n",
+               poly.numSoundingVoices(), NUM_POLY_VOICES, NUM_POLY_BLOCKS, elapsed * 1000.0);
+      }
+      
+      delete [] outBuffer;
+      
+    }
+    
+    const int NUM_SILENCE_TEST_SYNTHS = 32;
+    const int NUM_SILENCE_TEST_BLOCKS = 4000;
+    
+    void testSilenceSkipping(){
+      
+      //////// mostly idle synths, with and without skipping silent subgraphs ////////
+      
+      float *outBuffer = new float[kSynthesisBlockSize * 2];
+      
+      for (int skip = 0; skip < 2; skip++){
+        
+        Mixer mixer;
+        mixer.setSkipSilence(skip != 0);
+        
+        for (int i = 0; i < NUM_SILENCE_TEST_SYNTHS; i++){
+          Synth synth;
+          ADSR env = ADSR(0.01, 0.1, 0.5, 0.2).trigger(synth.addParameter("gate", i == 0 ? 1 : 0));
+          synth.setOutputGen( ((SawtoothWave().freq(100 + 11*i) >> LPF12().cutoff(1500)) * env * 0.05) >> StereoDelay(0.1, 0.15).feedback(0.4) );
+          mixer.addInput(synth);
+        }
+        
+        mixer.resetBlockTimingStats();
+        
+        double startTime = monotonicTime();
+        for (int i = 0; i < NUM_SILENCE_TEST_BLOCKS; i++){
+          mixer.fillBufferOfFloats(outBuffer, kSynthesisBlockSize, 2);
+        }
+        double elapsed = monotonicTime() - startTime;
+        
+        printf("[Tonic] Tested %i synths with one playing, silence skipping %s. Time to fill %i blocks: %f ms, %.1f nodes skipped per block\n",
+               NUM_SILENCE_TEST_SYNTHS, skip ? "on" : "off", NUM_SILENCE_TEST_BLOCKS, elapsed * 1000.0, mixer.blockTimingStats().meanSkippedNodes());
+      }
+      
+      delete [] outBuffer;
+      
+    }
+    
+    const int NUM_CONSTANT_GAIN_STAGES = 200;
+    const int NUM_CONSTANT_GAIN_BLOCKS = 4000;
+    
+    void testConstantGains(){
+      
+      //////// gain stages applied as scalars vs. as full blocks ////////
+      
+      float *outBuffer = new float[kSynthesisBlockSize * 2];
+      
+      for (int constant = 1; constant >= 0; constant--){
+        
+        // silent but not constant, so it makes each gain a full block
+        Generator notConstant = SineWave().freq(0);
+        
+        Generator chain = SineWave().freq(220);
+        for (int i = 0; i < NUM_CONSTANT_GAIN_STAGES; i++){
+          Generator gain = constant ? Generator(FixedValue(0.99)) : Generator(notConstant + 0.99);
+          chain = chain * gain + 0.001;
+        }
+        
+        Synth synth;
+        synth.setOutputGen(chain);
+        
+        double startTime = monotonicTime();
+        for (int i = 0; i < NUM_CONSTANT_GAIN_BLOCKS; i++){
+          synth.fillBufferOfFloats(outBuffer, kSynthesisBlockSize, 2);
+        }
+        double elapsed = monotonicTime() - startTime;
+        
+        printf("[Tonic] Tested %i %s gain stages. Time to fill %i blocks: %f ms\n",
+               NUM_CONSTANT_GAIN_STAGES, constant ? "constant" : "per-sample", NUM_CONSTANT_GAIN_BLOCKS, elapsed * 1000.0);
+      }
+      
+      delete [] outBuffer;
+      
+    }
+    
+    const int NUM_DEFERRED_DELETION_GRAPHS = 50;
+    const int NUM_DEFERRED_DELETION_SINES = 200;
+    
+    void testDeferredDeletion(){
+      
+      //////// cost of dropping the last reference to a graph, on and off a rendering thread ////////
+      
+      double immediateSeconds = 0;
+      double deferredSeconds = 0;
+      double reclaimSeconds = 0;
+      
+      for (int i = 0; i < NUM_DEFERRED_DELETION_GRAPHS; i++){
+        
+        Generator graph = sineBank(NUM_DEFERRED_DELETION_SINES);
+        double startTime = monotonicTime();
+        graph = Generator();
+        immediateSeconds += monotonicTime() - startTime;
+        
+        graph = sineBank(NUM_DEFERRED_DELETION_SINES);
+        {
+          Tonic_::RenderScope_ renderScope;
+          startTime = monotonicTime();
+          graph = Generator();
+          deferredSeconds += monotonicTime() - startTime;
+        }
+        
+        startTime = monotonicTime();
+        Tonic_::reclaimDeferredDeletions();
+        reclaimSeconds += monotonicTime() - startTime;
+      }
+      
+      printf("[Tonic] Tested dropping %i graphs of %i sines. Mean time to drop: %.2f us immediately, %.2f us while rendering (%.2f us to reclaim later)\n",
+             NUM_DEFERRED_DELETION_GRAPHS, NUM_DEFERRED_DELETION_SINES,
+             immediateSeconds * 1e6 / NUM_DEFERRED_DELETION_GRAPHS,
+             deferredSeconds * 1e6 / NUM_DEFERRED_DELETION_GRAPHS,
+             reclaimSeconds * 1e6 / NUM_DEFERRED_DELETION_GRAPHS);
       
-      printf("[Tonic] Tested RampedValue. Time to fill %i TonicFrames: %f\n",NUM_TEST_BUFFERS_TO_FILL, diff);
-
     }
   }
 
@@ -48,7 +344,14 @@ namespace Tonic {
     
     printf("\n\n[Tonic] Running performance tests.\n ");
     
-    PerformanceTest::testRampedValue();
+    PerformanceTest::testParallelMixer();
+    PerformanceTest::testGraphSwapContention();
+    PerformanceTest::testCompiledGraph();
+    PerformanceTest::testBlockSizes();
+    PerformanceTest::testPolySynth();
+    PerformanceTest::testSilenceSkipping();
+    PerformanceTest::testConstantGains();
+    PerformanceTest::testDeferredDeletion();
     
   }
 }
@@ -27,7 +27,7 @@ public:
     SampleTable lookupTable = SampleTable(tablesize, 1);
     
     TonicFloat norm = 1.0f / tablesize;
-    TonicFloat * tableData = lookupTable.dataPointer();
+    TonicFloat * tableData = lookupTable.planarDataPointer();
     for (unsigned int i=0; i<tablesize; i++){
       
       // sum a few sine waves
@@ -29,19 +29,18 @@ public:
     
     ControlParameter pitch = addParameter("pitch",0);
       
-    Adder outputAdder;
+    // all the sines in one generator, computed together
+    OscillatorBank bank = OscillatorBank().partials(NUM_SINES);
     
     for (int s=0; s<NUM_SINES; s++){
       
       ControlGenerator pitchGen = ((pitch * 220 + 220) * powf(2, (s - (NUM_SINES/2)) * 5.0f / 12.0f));
             
-      outputAdder.input(SineWave().freq( pitchGen.smoothed() ));
+      bank.freq(s, pitchGen).amp(s, (1.0f/NUM_SINES) * 0.5f);
       
     }
     
-    Generator outputGen = outputAdder * ((1.0f/NUM_SINES) * 0.5f);
-    
-    setOutputGen(outputGen);
+    setOutputGen(bank);
 
   }
 
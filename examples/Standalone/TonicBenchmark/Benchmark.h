@@ -0,0 +1,171 @@
+//
+//  Benchmark.h
+//  TonicBenchmark
+//
+//
+
+// Timing and reporting shared by the node, graph, session and kernel benchmarks
+
+#ifndef TONIC_BENCHMARK_H
+#define TONIC_BENCHMARK_H
+
+#include <cmath>
+#include "Tonic.h"
+
+namespace Tonic {
+
+  //! Something rendered one block at a time
+  class BenchmarkTarget {
+
+  public:
+
+    virtual ~BenchmarkTarget() {}
+    virtual void renderBlock() = 0;
+
+  };
+
+  //! Ticks a generator directly, with its own context
+  class GeneratorBenchmarkTarget : public BenchmarkTarget {
+
+  protected:
+
+    Generator                   gen_;
+    Tonic_::SynthesisContext_   context_;
+
+  public:
+
+    GeneratorBenchmarkTarget(Generator gen, unsigned int blockSize) : gen_(gen) {
+      context_.blockSize = blockSize;
+    }
+
+    void renderBlock(){
+      gen_.tick(context_);
+      context_.tick();
+    }
+
+    //! Number of distinct generators computed per block, found by recording a GraphSchedule_
+    unsigned int countNodes(){
+      Tonic_::GraphSchedule_ schedule;
+      schedule.reserve(1 << 20);
+      Tonic_::SynthesisContext_ context = context_;
+      context.recordSchedule = &schedule;
+      schedule.beginRecording();
+      gen_.tick(context);
+      schedule.endRecording();
+      context_.tick();
+      return schedule.size();
+    }
+
+  };
+
+  //! Fills a stereo buffer from a Synth, Mixer or other BufferFiller
+  class BufferFillerBenchmarkTarget : public BenchmarkTarget {
+
+  protected:
+
+    BufferFiller        filler_;
+    vector<TonicFloat>  buffer_;
+    unsigned int        blockSize_;
+
+  public:
+
+    BufferFillerBenchmarkTarget(BufferFiller filler, unsigned int blockSize) : filler_(filler), buffer_(blockSize * 2), blockSize_(blockSize) {
+      filler_.setBlockSize(blockSize);
+    }
+
+    void renderBlock(){
+      filler_.fillBufferOfFloats(&buffer_[0], blockSize_, 2);
+    }
+
+  };
+
+  //! Seconds per block over a number of timed repetitions
+  struct BenchmarkTiming {
+
+    unsigned long blocksPerRep;
+    double        mean;
+    double        variance;
+    double        min;
+    double        median;
+
+    double stddev() const { return sqrt(variance); }
+
+  };
+
+  //! Warm up, size repetitions to take at least 10ms each, then time reps of them
+  BenchmarkTiming timeBenchmark(BenchmarkTarget & target, unsigned int reps);
+
+  struct BenchmarkOptions {
+
+    string        filter;
+    unsigned int  blockSize;
+    unsigned int  reps;
+    bool          listOnly;
+    unsigned int  threads;          // session suite only. 0 means one per core.
+    bool          pinThreads;       // session suite only
+    double        latencySeconds;   // session suite only
+
+    //! True if filter is empty or found in any of the names
+    bool matches(const string & a, const string & b) const {
+      return filter.empty() || a.find(filter) != string::npos || b.find(filter) != string::npos;
+    }
+
+  };
+
+  //! One generator or effect, timed on its own
+  struct NodeBenchmarkResult {
+
+    string          group;
+    string          name;
+    unsigned int    inputChannels;
+    unsigned int    outputChannels;
+    BenchmarkTiming timing;
+
+    double nsPerSample(unsigned int blockSize) const { return timing.mean * 1e9 / blockSize; }
+
+  };
+
+  //! A generated patch of a given shape and size
+  struct GraphBenchmarkResult {
+
+    string          shape;
+    unsigned int    size;
+    unsigned int    nodes;
+    BenchmarkTiming timing;
+
+    double nsPerNode() const { return nodes ? timing.mean * 1e9 / nodes : 0; }
+
+  };
+
+  //! A number of sessions rendered by a SessionHost. timing is per batch.
+  struct SessionBenchmarkResult {
+
+    unsigned int    sessions;
+    unsigned int    threads;
+    BenchmarkTiming timing;
+    double          maxBatchSeconds;
+    double          sessionSeconds;
+    double          missedFraction;
+    double          sessionsPerCore;
+
+  };
+
+  //! One VectorKernels kernel, timed over a stereo block
+  struct KernelBenchmarkResult {
+
+    string          kernels;
+    string          op;
+    BenchmarkTiming timing;
+
+  };
+
+  vector<NodeBenchmarkResult> runNodeBenchmarks(const BenchmarkOptions & options, FILE *out);
+  vector<GraphBenchmarkResult> runGraphBenchmarks(const BenchmarkOptions & options, FILE *out);
+  vector<SessionBenchmarkResult> runSessionBenchmarks(const BenchmarkOptions & options, FILE *out);
+  vector<KernelBenchmarkResult> runKernelBenchmarks(const BenchmarkOptions & options, FILE *out);
+
+  string jsonString(const string & s);
+
+}
+
+#endif
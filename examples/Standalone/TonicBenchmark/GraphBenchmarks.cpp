@@ -0,0 +1,134 @@
+//
+//  GraphBenchmarks.cpp
+//  TonicBenchmark
+//
+//
+
+// Generated patches of growing size, to see how rendering scales with the shape of a graph rather than
+// with the cost of any one node:
+//
+//   deep    a sine wave through a chain of size filters (effect >> effect >> ...)
+//   wide    size sine waves summed by one Adder
+//   bank    the same sine waves as partials of one OscillatorBank
+//   fanout  one sine wave read by size gain stages, summed by one Adder - all but the first read are cache hits
+//   mixer   size Synths, each a filtered sawtooth, in one Mixer
+//
+// nodes counts every generator computed per block, parameters (FixedValue) included.
+
+#include "Benchmark.h"
+
+using namespace Tonic;
+
+static Generator deepPatch(unsigned int size){
+  Generator chain = SineWave().freq(220);
+  for (unsigned int i=0; i<size; i++){
+    chain = chain >> LPF12().cutoff(2000 + 10 * (i % 100));
+  }
+  return chain;
+}
+
+static Generator widePatch(unsigned int size){
+  Adder adder;
+  for (unsigned int i=0; i<size; i++){
+    adder.input(SineWave().freq(100 + i));
+  }
+  return adder;
+}
+
+static Generator bankPatch(unsigned int size){
+  OscillatorBank bank = OscillatorBank().partials(size);
+  for (unsigned int i=0; i<size; i++){
+    bank.freq(i, 100 + i).amp(i, 1);
+  }
+  return bank;
+}
+
+static Generator fanoutPatch(unsigned int size){
+  Generator shared = SineWave().freq(220);
+  Adder adder;
+  for (unsigned int i=0; i<size; i++){
+    adder.input(shared * (1.0f / (i + 1)));
+  }
+  return adder;
+}
+
+static Generator mixerVoice(unsigned int i){
+  return (SawtoothWave().freq(100 + 7 * i) >> LPF12().cutoff(1500)) * 0.05;
+}
+
+struct GraphShape {
+  const char    *name;
+  Generator     (*make)(unsigned int size);
+  unsigned int  sizes[4];
+};
+
+static const GraphShape graphShapes[] = {
+  {"deep",    deepPatch,    {1, 8, 64, 512}},
+  {"wide",    widePatch,    {16, 256, 1024, 4096}},
+  {"bank",    bankPatch,    {16, 256, 1024, 4096}},
+  {"fanout",  fanoutPatch,  {16, 256, 1024, 4096}},
+  {"mixer",   NULL,         {1, 8, 64, 256}},
+};
+
+static const unsigned int numGraphShapes = sizeof(graphShapes) / sizeof(graphShapes[0]);
+static const unsigned int numGraphSizes = sizeof(graphShapes[0].sizes) / sizeof(graphShapes[0].sizes[0]);
+
+namespace Tonic {
+
+  vector<GraphBenchmarkResult> runGraphBenchmarks(const BenchmarkOptions & options, FILE *out){
+
+    vector<GraphBenchmarkResult> results;
+    bool printedHeader = false;
+
+    for (unsigned int s=0; s<numGraphShapes; s++){
+
+      const GraphShape & shape = graphShapes[s];
+      if (!options.matches(shape.name, "graph")) continue;
+
+      if (!printedHeader){
+        fprintf(out, "%-8s %6s %8s %12s %10s %12s\n", "shape", "size", "nodes", "us/block", "+/-", "ns/node");
+        printedHeader = true;
+      }
+
+      for (unsigned int z=0; z<numGraphSizes; z++){
+
+        GraphBenchmarkResult result;
+        result.shape = shape.name;
+        result.size = shape.sizes[z];
+
+        if (options.listOnly){
+          fprintf(out, "%-8s %6u\n", result.shape.c_str(), result.size);
+          continue;
+        }
+
+        if (shape.make){
+          GeneratorBenchmarkTarget target(shape.make(result.size), options.blockSize);
+          result.nodes = target.countNodes();
+          result.timing = timeBenchmark(target, options.reps);
+        }
+        else{
+          Mixer mixer;
+          result.nodes = 0;
+          for (unsigned int i=0; i<result.size; i++){
+            Generator voice = mixerVoice(i);
+            result.nodes += GeneratorBenchmarkTarget(voice, options.blockSize).countNodes();
+            Synth synth;
+            synth.setOutputGen(voice);
+            mixer.addInput(synth);
+          }
+          BufferFillerBenchmarkTarget target(mixer, options.blockSize);
+          result.timing = timeBenchmark(target, options.reps);
+        }
+
+        results.push_back(result);
+
+        fprintf(out, "%-8s %6u %8u %12.2f %10.2f %12.2f\n", result.shape.c_str(), result.size, result.nodes,
+                result.timing.mean * 1e6, result.timing.stddev() * 1e6, result.nsPerNode());
+        fflush(out);
+      }
+    }
+
+    return results;
+  }
+
+}
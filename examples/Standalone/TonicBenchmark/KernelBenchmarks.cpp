@@ -0,0 +1,114 @@
+//
+//  KernelBenchmarks.cpp
+//  TonicBenchmark
+//
+//
+
+// Every VectorKernels implementation this CPU supports (see VectorKernels.h), one kernel at a time, over
+// a stereo block - the arithmetic behind TonicFrames operators. Compare an implementation with "scalar" for
+// the speedup of the kernel alone, and run the other suites with --kernels to see what it does for a patch.
+// The fft ops time a whole FFT of kFFTBenchmarkLength points instead, built on the radix-2 and radix-4 kernels.
+
+#include "Benchmark.h"
+
+using namespace Tonic;
+
+static const char * const kernelOps[] = {"add", "multiply", "divide", "multiplyScalar", "copyScaled", "addScaled", "fill", "fft", "fftReal"};
+static const unsigned int numKernelOps = sizeof(kernelOps) / sizeof(kernelOps[0]);
+static const unsigned int firstFFTOp = 7;
+static const unsigned int kFFTBenchmarkLength = 1024;
+
+//! Applies one kernel to a buffer, in place
+class KernelBenchmarkTarget : public BenchmarkTarget {
+
+protected:
+
+  const VectorKernels &   kernels_;
+  unsigned int            op_;
+  vector<TonicFloat>      dst_;
+  vector<TonicFloat>      src_;
+  vector<TonicFloat>      imag_;
+  FFT                     fft_;
+
+public:
+
+  KernelBenchmarkTarget(const VectorKernels & kernels, unsigned int op, unsigned int length) :
+    kernels_(kernels), op_(op), dst_(length, 1.0f), src_(length, op == 0 ? 0.0f : 1.0f), imag_(length), fft_(length) {}
+
+  void renderBlock(){
+    // dst stays at 1, so nothing drifts into denormals or overflows however long this runs
+    TonicFloat *dst = &dst_[0];
+    const TonicFloat *src = &src_[0];
+    size_t length = dst_.size();
+    switch (op_){
+      case 0: kernels_.add(dst, src, length); break;
+      case 1: kernels_.multiply(dst, src, length); break;
+      case 2: kernels_.divide(dst, src, length); break;
+      case 3: kernels_.multiplyScalar(dst, 1.0f, length); break;
+      case 4: kernels_.copyScaled(dst, src, 1.0f, length); break;
+      case 5: kernels_.addScaled(dst, src, 0.0f, length); break;
+      case 6: kernels_.fill(dst, 1.0f, length); break;
+      // transforms of src, which doesn't change, into dst and imag - the active kernels must be kernels_
+      case 7: fft_.forward(src, src, dst, &imag_[0]); break;
+      case 8: fft_.forwardReal(src, dst, &imag_[0]); break;
+    }
+  }
+
+};
+
+namespace Tonic {
+
+  vector<KernelBenchmarkResult> runKernelBenchmarks(const BenchmarkOptions & options, FILE *out){
+
+    vector<KernelBenchmarkResult> results;
+    bool printedHeader = false;
+
+    vector<const VectorKernels *> kernels = availableVectorKernels();
+    const string initialKernels = vectorKernels().name;
+
+    for (unsigned int k=0; k<kernels.size(); k++){
+      for (unsigned int op=0; op<numKernelOps; op++){
+
+        if (!options.matches(kernels[k]->name, kernelOps[op])) continue;
+
+        if (!printedHeader){
+          fprintf(out, "%-8s %-16s %10s %8s %8s %10s\n", "kernels", "op", "ns/sample", "+/-", "min", "vs scalar");
+          printedHeader = true;
+        }
+
+        KernelBenchmarkResult result;
+        result.kernels = kernels[k]->name;
+        result.op = kernelOps[op];
+
+        if (options.listOnly){
+          fprintf(out, "%-8s %-16s\n", result.kernels.c_str(), result.op.c_str());
+          continue;
+        }
+
+        const unsigned int length = op >= firstFFTOp ? kFFTBenchmarkLength : options.blockSize * 2;
+        setVectorKernels(kernels[k]->name);
+        KernelBenchmarkTarget target(*kernels[k], op, length);
+        result.timing = timeBenchmark(target, options.reps);
+        setVectorKernels(initialKernels);
+
+        // relative to the scalar time for the same op, if it was measured
+        double speedup = 0;
+        for (unsigned int i=0; i<results.size(); i++){
+          if (results[i].kernels == "scalar" && results[i].op == result.op) speedup = results[i].timing.mean / result.timing.mean;
+        }
+
+        results.push_back(result);
+
+        const double nsPerSample = 1e9 / length;
+        fprintf(out, "%-8s %-16s %10.3f %8.3f %8.3f", result.kernels.c_str(), result.op.c_str(),
+                result.timing.mean * nsPerSample, result.timing.stddev() * nsPerSample, result.timing.min * nsPerSample);
+        if (speedup > 0) fprintf(out, " %9.2fx\n", speedup);
+        else fprintf(out, " %10s\n", "-");
+        fflush(out);
+      }
+    }
+
+    return results;
+  }
+
+}
@@ -0,0 +1,255 @@
+//
+//  NodeBenchmarks.cpp
+//  TonicBenchmark
+//
+//
+
+// Every generator and effect, timed on its own. Nodes are fed from inputs which cost nothing to tick, so
+// each time is the node's own. Nodes with an input are run with a mono and with a stereo input.
+
+#include <algorithm>
+#include "Benchmark.h"
+
+using namespace Tonic;
+
+namespace Tonic {
+
+  namespace Tonic_ {
+
+    //! Noise computed once, so it can feed the node being timed without adding to its time
+    class BenchmarkSource_ : public Generator_ {
+
+    public:
+
+      BenchmarkSource_(bool stereo) {
+        setIsStereoOutput(stereo);
+        setBlockSize(kSynthesisBlockSize);
+      }
+
+      void setBlockSize(unsigned int blockSize){
+        Generator_::setBlockSize(blockSize);
+        for (unsigned int i=0; i<outputFrames_.size(); i++){
+          outputFrames_[i] = randomFloat(-0.5f, 0.5f);
+        }
+      }
+
+    };
+
+  }
+
+}
+
+// -- Cases --
+
+// retargeted every block by the RampedValue case
+static ControlValue rampTarget = ControlValue(0);
+
+static SampleTable noiseTable(unsigned int frames){
+  SampleTable table = SampleTable(frames, 1);
+  TonicFloat *data = table.planarDataPointer();
+  for (unsigned long i=0; i<table.size(); i++){
+    data[i] = randomFloat(-0.5f, 0.5f);
+  }
+  return table;
+}
+
+static SampleTable sawTable(unsigned int frames){
+  SampleTable table = SampleTable(frames, 1);
+  TonicFloat *data = table.planarDataPointer();
+  for (unsigned long i=0; i<frames; i++){
+    data[i] = 1.f - 2.f * i / frames;
+  }
+  return table;
+}
+
+static Generator makeSineWave(Generator, Generator){ return SineWave().freq(440); }
+static Generator makeSineWaveFM(Generator a, Generator){ return SineWave().freq(440 + a * 100); }
+static Generator makeTableLookupOsc(Generator, Generator){ return TableLookupOsc().setLookupTable(noiseTable(4097)).freq(440); }
+static Generator makeWavetableOsc(Generator, Generator){ return WavetableOsc().setTable(sawTable(1024)).freq(440); }
+static Generator makeWavetableOscFM(Generator a, Generator){ return WavetableOsc().setTable(sawTable(1024)).freq(440 + a * 100); }
+static Generator makeSawtoothWave(Generator, Generator){ return SawtoothWave().freq(440); }
+static Generator makeTriangleWave(Generator, Generator){ return TriangleWave().freq(440); }
+static Generator makeSquareWave(Generator, Generator){ return SquareWave().freq(440); }
+static Generator makeRectWave(Generator a, Generator){ return RectWave().freq(440).pwm(a * 0.5 + 0.5); }
+static Generator makeSawtoothWaveBL(Generator, Generator){ return SawtoothWaveBL().freq(440); }
+static Generator makeSquareWaveBL(Generator, Generator){ return SquareWaveBL().freq(440); }
+static Generator makeRectWaveBL(Generator a, Generator){ return RectWaveBL().freq(440).pwm(a * 0.5 + 0.5); }
+static Generator makeNoise(Generator, Generator){ return Noise(); }
+static Generator makePinkNoise(Generator, Generator){ return PinkNoise(); }
+static Generator makeLFNoise(Generator, Generator){ return LFNoise().setFreq(100); }
+static Generator makeBufferPlayer(Generator, Generator){
+  ControlTrigger start;
+  BufferPlayer player = BufferPlayer().setBuffer(noiseTable(44100)).loop(true).trigger(start);
+  start.trigger();
+  return player;
+}
+static Generator makeADSR(Generator, Generator){ return ADSR(0.001, 0.01, 0.5, 0.01).doesSustain(false).trigger(ControlMetro().bpm(6000)); }
+static Generator makeRampedValue(Generator, Generator){ return RampedValue(0, 1).target(rampTarget); }
+
+static Generator makeLPF6(Generator a, Generator){ return a >> LPF6().cutoff(1000); }
+static Generator makeHPF6(Generator a, Generator){ return a >> HPF6().cutoff(1000); }
+static Generator makeLPF12(Generator a, Generator){ return a >> LPF12().cutoff(1000).Q(2); }
+static Generator makeHPF12(Generator a, Generator){ return a >> HPF12().cutoff(1000).Q(2); }
+static Generator makeLPF24(Generator a, Generator){ return a >> LPF24().cutoff(1000).Q(2); }
+static Generator makeHPF24(Generator a, Generator){ return a >> HPF24().cutoff(1000).Q(2); }
+static Generator makeBPF12(Generator a, Generator){ return a >> BPF12().cutoff(1000).Q(2); }
+static Generator makeBPF24(Generator a, Generator){ return a >> BPF24().cutoff(1000).Q(2); }
+static Generator makeLPF24Modulated(Generator a, Generator b){ return a >> LPF24().cutoff(1000 + b * 500).Q(2); }
+
+static Generator makeBasicDelay(Generator a, Generator){ return a >> BasicDelay(0.25, 0.5).feedback(0.4); }
+static Generator makeStereoDelay(Generator a, Generator){ return a >> StereoDelay(0.25, 0.3).feedback(0.4); }
+static Generator makeFFCombFilter(Generator a, Generator){ return a >> FFCombFilter(0.01, 0.1).scaleFactor(0.5); }
+static Generator makeFBCombFilter(Generator a, Generator){ return a >> FBCombFilter(0.01, 0.1).scaleFactor(0.5); }
+static Generator makeFilteredFBCombFilter6(Generator a, Generator){ return a >> FilteredFBCombFilter6(0.01, 0.1).scaleFactor(0.5).lowpassCutoff(4000).highpassCutoff(100); }
+static Generator makeReverb(Generator a, Generator){ return a >> Reverb().roomSize(0.5).decayTime(1.5); }
+static Generator makeConvolutionReverb(Generator a, Generator){ return a >> ConvolutionReverb().setImpulseResponse(noiseTable(66150)); }
+static Generator makeCompressor(Generator a, Generator){ return a >> Compressor().threshold(0.1).ratio(4); }
+static Generator makeLimiter(Generator a, Generator){ return a >> Limiter().threshold(0.1); }
+static Generator makeBitCrusher(Generator a, Generator){ return a >> BitCrusher().bitDepth(8); }
+static Generator makeMonoToStereoPanner(Generator a, Generator){ return a >> MonoToStereoPanner().pan(0.25); }
+
+static Generator makeAdder(Generator a, Generator b){ return a + b; }
+static Generator makeSubtractor(Generator a, Generator b){ return a - b; }
+static Generator makeMultiplier(Generator a, Generator b){ return a * b; }
+static Generator makeDivider(Generator a, Generator b){ return a / (b + 2); }
+static Generator makeGain(Generator a, Generator){ return a * 0.5; }
+static Generator makeControlGain(Generator a, Generator){ return a * ControlValue(0.5); }
+
+struct BenchmarkCase {
+  const char  *group;
+  const char  *name;
+  int         numInputs;
+  Generator   (*make)(Generator a, Generator b);
+};
+
+static const BenchmarkCase benchmarkCases[] = {
+
+  {"oscillator",  "SineWave",               0, makeSineWave},
+  {"oscillator",  "SineWave (FM)",          1, makeSineWaveFM},
+  {"oscillator",  "TableLookupOsc",         0, makeTableLookupOsc},
+  {"oscillator",  "WavetableOsc",           0, makeWavetableOsc},
+  {"oscillator",  "WavetableOsc (FM)",      1, makeWavetableOscFM},
+  {"oscillator",  "SawtoothWave",           0, makeSawtoothWave},
+  {"oscillator",  "TriangleWave",           0, makeTriangleWave},
+  {"oscillator",  "SquareWave",             0, makeSquareWave},
+  {"oscillator",  "RectWave (PWM)",         1, makeRectWave},
+  {"blep",        "SawtoothWaveBL",         0, makeSawtoothWaveBL},
+  {"blep",        "SquareWaveBL",           0, makeSquareWaveBL},
+  {"blep",        "RectWaveBL (PWM)",       1, makeRectWaveBL},
+  {"source",      "Noise",                  0, makeNoise},
+  {"source",      "PinkNoise",              0, makePinkNoise},
+  {"source",      "LFNoise",                0, makeLFNoise},
+  {"source",      "BufferPlayer",           0, makeBufferPlayer},
+  {"envelope",    "ADSR",                   0, makeADSR},
+  {"envelope",    "RampedValue",            0, makeRampedValue},
+
+  {"filter",      "LPF6",                   1, makeLPF6},
+  {"filter",      "HPF6",                   1, makeHPF6},
+  {"filter",      "LPF12",                  1, makeLPF12},
+  {"filter",      "HPF12",                  1, makeHPF12},
+  {"filter",      "LPF24",                  1, makeLPF24},
+  {"filter",      "HPF24",                  1, makeHPF24},
+  {"filter",      "BPF12",                  1, makeBPF12},
+  {"filter",      "BPF24",                  1, makeBPF24},
+  {"filter",      "LPF24 (modulated)",      2, makeLPF24Modulated},
+
+  {"delay",       "BasicDelay",             1, makeBasicDelay},
+  {"delay",       "StereoDelay",            1, makeStereoDelay},
+  {"delay",       "FFCombFilter",           1, makeFFCombFilter},
+  {"delay",       "FBCombFilter",           1, makeFBCombFilter},
+  {"delay",       "FilteredFBCombFilter6",  1, makeFilteredFBCombFilter6},
+  {"effect",      "Reverb",                 1, makeReverb},
+  {"effect",      "ConvolutionReverb",      1, makeConvolutionReverb},
+  {"effect",      "Compressor",             1, makeCompressor},
+  {"effect",      "Limiter",                1, makeLimiter},
+  {"effect",      "BitCrusher",             1, makeBitCrusher},
+  {"effect",      "MonoToStereoPanner",     1, makeMonoToStereoPanner},
+
+  {"arithmetic",  "Adder",                  2, makeAdder},
+  {"arithmetic",  "Subtractor",             2, makeSubtractor},
+  {"arithmetic",  "Multiplier",             2, makeMultiplier},
+  {"arithmetic",  "Divider",                2, makeDivider},
+  {"arithmetic",  "Multiplier (constant)",  1, makeGain},
+  {"arithmetic",  "Multiplier (control)",   1, makeControlGain},
+
+};
+
+static const unsigned int numBenchmarkCases = sizeof(benchmarkCases) / sizeof(benchmarkCases[0]);
+
+// -- Running --
+
+//! Retargets the RampedValue case every block, as the old PerformanceTest did
+class RetargetingBenchmarkTarget : public GeneratorBenchmarkTarget {
+
+public:
+
+  RetargetingBenchmarkTarget(Generator gen, unsigned int blockSize) : GeneratorBenchmarkTarget(gen, blockSize) {}
+
+  void renderBlock(){
+    rampTarget.value(randomFloat(0, 100));
+    GeneratorBenchmarkTarget::renderBlock();
+  }
+
+};
+
+static const char * channelsName(unsigned int channels){
+  return channels == 0 ? "-" : (channels == 1 ? "mono" : "stereo");
+}
+
+namespace Tonic {
+
+  vector<NodeBenchmarkResult> runNodeBenchmarks(const BenchmarkOptions & options, FILE *out){
+
+    vector<NodeBenchmarkResult> results;
+    bool printedHeader = false;
+
+    for (unsigned int c=0; c<numBenchmarkCases; c++){
+
+      const BenchmarkCase & benchmarkCase = benchmarkCases[c];
+      if (!options.matches(benchmarkCase.name, benchmarkCase.group)) continue;
+
+      if (!printedHeader){
+        fprintf(out, "%-12s %-24s %-7s %-7s %10s %8s %8s %10s\n", "group", "node", "in", "out", "ns/sample", "+/-", "min", "Msamples/s");
+        printedHeader = true;
+      }
+
+      for (int stereo=0; stereo < (benchmarkCase.numInputs ? 2 : 1); stereo++){
+
+        NodeBenchmarkResult result;
+        result.group = benchmarkCase.group;
+        result.name = benchmarkCase.name;
+        result.inputChannels = benchmarkCase.numInputs ? stereo + 1 : 0;
+
+        if (options.listOnly){
+          fprintf(out, "%-12s %-24s %-7s\n", benchmarkCase.group, benchmarkCase.name, channelsName(result.inputChannels));
+          continue;
+        }
+
+        Generator a = Generator(new Tonic_::BenchmarkSource_(stereo != 0));
+        Generator b = Generator(new Tonic_::BenchmarkSource_(stereo != 0));
+        Generator gen = benchmarkCase.make(a, b);
+        result.outputChannels = gen.numOutputChannels();
+
+        if (benchmarkCase.make == makeRampedValue){
+          RetargetingBenchmarkTarget target(gen, options.blockSize);
+          result.timing = timeBenchmark(target, options.reps);
+        }
+        else{
+          GeneratorBenchmarkTarget target(gen, options.blockSize);
+          result.timing = timeBenchmark(target, options.reps);
+        }
+
+        results.push_back(result);
+
+        const double nsPerSample = result.nsPerSample(options.blockSize);
+        fprintf(out, "%-12s %-24s %-7s %-7s %10.2f %8.2f %8.2f %10.1f\n", result.group.c_str(), result.name.c_str(),
+                channelsName(result.inputChannels), channelsName(result.outputChannels), nsPerSample,
+                result.timing.stddev() * 1e9 / options.blockSize, result.timing.min * 1e9 / options.blockSize, 1e3 / nsPerSample);
+        fflush(out);
+      }
+    }
+
+    return results;
+  }
+
+}
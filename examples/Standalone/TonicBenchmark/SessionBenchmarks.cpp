@@ -0,0 +1,102 @@
+//
+//  SessionBenchmarks.cpp
+//  TonicBenchmark
+//
+//
+
+// Growing numbers of independent sessions rendered by a SessionHost, as on a server hosting one Synth per
+// user. Each session is a filtered sawtooth and a sine wave under an envelope. Every batch renders one block
+// of every session, and each session has the latency target (--latency) as its deadline.
+//
+// sess/core is how many sessions one core renders, on average, within the latency target. missed is the
+// fraction of session renders which finished after it.
+
+#include "Benchmark.h"
+
+using namespace Tonic;
+
+static const unsigned int sessionCounts[] = {16, 256, 1024, 4096};
+static const unsigned int numSessionCounts = sizeof(sessionCounts) / sizeof(sessionCounts[0]);
+
+static Synth sessionPatch(unsigned int i){
+  Synth synth;
+  ControlTrigger gate;
+  ADSR env = ADSR(0.01, 0.1, 0.8, 0.5).trigger(gate);
+  synth.setOutputGen(((SawtoothWave().freq(100 + 7 * (i % 50)) >> LPF12().cutoff(1500)) + SineWave().freq(220 + (i % 30))) * env * 0.05);
+  gate.trigger();
+  return synth;
+}
+
+//! Renders one block of every session
+class SessionHostBenchmarkTarget : public BenchmarkTarget {
+
+protected:
+
+  SessionHost   &host_;
+  unsigned int  blockSize_;
+
+public:
+
+  SessionHostBenchmarkTarget(SessionHost & host, unsigned int blockSize) : host_(host), blockSize_(blockSize) {}
+
+  void renderBlock(){
+    host_.render(blockSize_);
+  }
+
+};
+
+namespace Tonic {
+
+  vector<SessionBenchmarkResult> runSessionBenchmarks(const BenchmarkOptions & options, FILE *out){
+
+    vector<SessionBenchmarkResult> results;
+
+    if (!options.matches("sessions", "session")) return results;
+
+    fprintf(out, "%-8s %8s %8s %12s %10s %12s %12s %8s %10s\n",
+            "suite", "sessions", "threads", "us/batch", "+/-", "max us", "us/session", "missed", "sess/core");
+
+    for (unsigned int z=0; z<numSessionCounts; z++){
+
+      SessionBenchmarkResult result;
+      result.sessions = sessionCounts[z];
+
+      if (options.listOnly){
+        fprintf(out, "%-8s %8u\n", "sessions", result.sessions);
+        continue;
+      }
+
+      SessionHost host(options.threads, options.pinThreads ? 0 : -1);
+      for (unsigned int i=0; i<result.sessions; i++){
+        Synth session = sessionPatch(i);
+        session.setBlockSize(options.blockSize);
+        host.addSession(session, 2, options.latencySeconds);
+      }
+
+      SessionHostBenchmarkTarget target(host, options.blockSize);
+
+      // warm up before resetting, so the first blocks' allocations aren't counted against the deadline
+      target.renderBlock();
+      host.resetStats();
+
+      result.timing = timeBenchmark(target, options.reps);
+
+      SessionHostStats stats = host.stats();
+      result.threads = stats.numThreads;
+      result.maxBatchSeconds = stats.maxBatchSeconds;
+      result.sessionSeconds = stats.meanSessionSeconds();
+      result.missedFraction = stats.sessionBlocks > 0 ? (double)stats.missedDeadlines / stats.sessionBlocks : 0;
+      result.sessionsPerCore = stats.sessionsPerCore(options.latencySeconds);
+
+      results.push_back(result);
+
+      fprintf(out, "%-8s %8u %8u %12.2f %10.2f %12.2f %12.3f %7.2f%% %10.0f\n", "sessions", result.sessions, result.threads,
+              result.timing.mean * 1e6, result.timing.stddev() * 1e6, result.maxBatchSeconds * 1e6,
+              result.sessionSeconds * 1e6, result.missedFraction * 100, result.sessionsPerCore);
+      fflush(out);
+    }
+
+    return results;
+  }
+
+}
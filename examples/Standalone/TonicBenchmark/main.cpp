@@ -0,0 +1,252 @@
+//
+//  main.cpp
+//  TonicBenchmark
+//
+//
+
+// Benchmarks Tonic's generators and effects one by one (see NodeBenchmarks.cpp), generated patches of
+// growing depth, width and fan-out (see GraphBenchmarks.cpp), and growing numbers of sessions rendered
+// by a SessionHost (see SessionBenchmarks.cpp), and the vector kernels behind TonicFrames arithmetic (see
+// KernelBenchmarks.cpp).
+//
+// Usage: benchmark [--suite nodes|graphs|sessions|kernels|all] [--filter text] [--block frames] [--reps n] [--json path] [--label text] [--list]
+//                  [--threads n] [--pin] [--latency ms] [--kernels name]
+//
+// --suite    which benchmarks to run. Defaults to all.
+// --filter   only run nodes whose name or group, graphs whose shape, or kernels whose implementation or op contains text
+// --block    synthesis block size in frames. Defaults to kSynthesisBlockSize.
+// --reps     timed repetitions per case. Defaults to 15.
+// --json     also write the results as JSON to path, or to stdout if path is "-"
+// --label    stored in the JSON, to tell builds apart when comparing runs (e.g. "scalar", "neon")
+// --threads  threads rendering sessions. Defaults to one per core.
+// --pin      pin session threads to cores
+// --latency  deadline for every session, in milliseconds. Defaults to one block at the sample rate (real time).
+// --kernels  render with this VectorKernels implementation (e.g. "scalar", "sse2"). Defaults to the widest this CPU supports.
+//
+// Build with optimisation, e.g. make benchmark CCFLAGS=-O2.
+
+#include <cstdlib>
+#include <algorithm>
+#include "Benchmark.h"
+
+using namespace Tonic;
+
+namespace Tonic {
+
+  static const double kMinRepSeconds = 0.01;
+
+  static double timeBlocks(BenchmarkTarget & target, unsigned long numBlocks){
+    double startTime = monotonicTime();
+    for (unsigned long b=0; b<numBlocks; b++){
+      target.renderBlock();
+    }
+    return monotonicTime() - startTime;
+  }
+
+  BenchmarkTiming timeBenchmark(BenchmarkTarget & target, unsigned int reps){
+
+    BenchmarkTiming timing;
+
+    // warm up, and find how many blocks make a repetition long enough to time
+    timing.blocksPerRep = 16;
+    while (timeBlocks(target, timing.blocksPerRep) < kMinRepSeconds){
+      timing.blocksPerRep *= 2;
+    }
+
+    vector<double> blockSeconds(reps);
+    for (unsigned int r=0; r<reps; r++){
+      blockSeconds[r] = timeBlocks(target, timing.blocksPerRep) / timing.blocksPerRep;
+    }
+
+    timing.mean = 0;
+    for (unsigned int r=0; r<reps; r++) timing.mean += blockSeconds[r];
+    timing.mean /= reps;
+
+    timing.variance = 0;
+    for (unsigned int r=0; r<reps; r++) timing.variance += (blockSeconds[r] - timing.mean) * (blockSeconds[r] - timing.mean);
+    timing.variance /= reps > 1 ? reps - 1 : 1;
+
+    std::sort(blockSeconds.begin(), blockSeconds.end());
+    timing.min = blockSeconds[0];
+    timing.median = blockSeconds[reps / 2];
+
+    return timing;
+  }
+
+  string jsonString(const string & s){
+    string escaped = "\"";
+    for (unsigned int i=0; i<s.size(); i++){
+      if (s[i] == '"' || s[i] == '\\') escaped += '\\';
+      escaped += s[i];
+    }
+    return escaped + "\"";
+  }
+
+}
+
+// Node times are per sample frame, graph times per block - both in nanoseconds, variance in ns squared
+static void writeJson(FILE *file, const vector<NodeBenchmarkResult> & nodes, const vector<GraphBenchmarkResult> & graphs,
+                      const vector<SessionBenchmarkResult> & sessions, const vector<KernelBenchmarkResult> & kernels,
+                      const string & label, const BenchmarkOptions & options){
+
+  const double nsPerSample = 1e9 / options.blockSize;
+
+  fprintf(file, "{\n  \"label\": %s,\n  \"kernels\": %s,\n  \"blockSize\": %u,\n  \"sampleRate\": %g,\n  \"reps\": %u,\n  \"results\": [\n",
+          jsonString(label).c_str(), jsonString(vectorKernels().name).c_str(), options.blockSize, (double)sampleRate(), options.reps);
+
+  for (unsigned int i=0; i<nodes.size(); i++){
+    const NodeBenchmarkResult & r = nodes[i];
+    fprintf(file, "    {\"group\": %s, \"name\": %s, \"inputChannels\": %u, \"outputChannels\": %u, "
+                  "\"nsPerSample\": %.4f, \"variance\": %.6f, \"stddev\": %.4f, \"min\": %.4f, \"median\": %.4f, "
+                  "\"samplesPerSecond\": %.0f, \"blocksPerRep\": %lu}%s\n",
+            jsonString(r.group).c_str(), jsonString(r.name).c_str(), r.inputChannels, r.outputChannels,
+            r.timing.mean * nsPerSample, r.timing.variance * nsPerSample * nsPerSample, r.timing.stddev() * nsPerSample,
+            r.timing.min * nsPerSample, r.timing.median * nsPerSample, options.blockSize / r.timing.mean, r.timing.blocksPerRep,
+            i + 1 < nodes.size() ? "," : "");
+  }
+
+  fprintf(file, "  ],\n  \"graphs\": [\n");
+
+  for (unsigned int i=0; i<graphs.size(); i++){
+    const GraphBenchmarkResult & r = graphs[i];
+    fprintf(file, "    {\"shape\": %s, \"size\": %u, \"nodes\": %u, "
+                  "\"nsPerBlock\": %.1f, \"variance\": %.1f, \"stddev\": %.1f, \"min\": %.1f, \"median\": %.1f, "
+                  "\"nsPerNode\": %.4f, \"blocksPerRep\": %lu}%s\n",
+            jsonString(r.shape).c_str(), r.size, r.nodes,
+            r.timing.mean * 1e9, r.timing.variance * 1e18, r.timing.stddev() * 1e9, r.timing.min * 1e9, r.timing.median * 1e9,
+            r.nsPerNode(), r.timing.blocksPerRep,
+            i + 1 < graphs.size() ? "," : "");
+  }
+
+  fprintf(file, "  ],\n  \"latencyMs\": %g,\n  \"sessions\": [\n", options.latencySeconds * 1e3);
+
+  for (unsigned int i=0; i<sessions.size(); i++){
+    const SessionBenchmarkResult & r = sessions[i];
+    fprintf(file, "    {\"sessions\": %u, \"threads\": %u, "
+                  "\"nsPerBatch\": %.1f, \"variance\": %.1f, \"stddev\": %.1f, \"min\": %.1f, \"median\": %.1f, \"max\": %.1f, "
+                  "\"nsPerSession\": %.2f, \"missedFraction\": %.6f, \"sessionsPerCore\": %.1f, \"blocksPerRep\": %lu}%s\n",
+            r.sessions, r.threads,
+            r.timing.mean * 1e9, r.timing.variance * 1e18, r.timing.stddev() * 1e9, r.timing.min * 1e9, r.timing.median * 1e9,
+            r.maxBatchSeconds * 1e9, r.sessionSeconds * 1e9, r.missedFraction, r.sessionsPerCore, r.timing.blocksPerRep,
+            i + 1 < sessions.size() ? "," : "");
+  }
+
+  // kernel times are per sample
+  const double nsPerKernelSample = 1e9 / (options.blockSize * 2);
+
+  fprintf(file, "  ],\n  \"kernelResults\": [\n");
+
+  for (unsigned int i=0; i<kernels.size(); i++){
+    const KernelBenchmarkResult & r = kernels[i];
+    fprintf(file, "    {\"kernels\": %s, \"op\": %s, "
+                  "\"nsPerSample\": %.4f, \"variance\": %.6f, \"stddev\": %.4f, \"min\": %.4f, \"median\": %.4f, \"blocksPerRep\": %lu}%s\n",
+            jsonString(r.kernels).c_str(), jsonString(r.op).c_str(),
+            r.timing.mean * nsPerKernelSample, r.timing.variance * nsPerKernelSample * nsPerKernelSample, r.timing.stddev() * nsPerKernelSample,
+            r.timing.min * nsPerKernelSample, r.timing.median * nsPerKernelSample, r.timing.blocksPerRep,
+            i + 1 < kernels.size() ? "," : "");
+  }
+
+  fprintf(file, "  ]\n}\n");
+}
+
+int main(int argc, const char * argv[])
+{
+  BenchmarkOptions options;
+  options.blockSize = kSynthesisBlockSize;
+  options.reps = 15;
+  options.listOnly = false;
+  options.threads = 0;
+  options.pinThreads = false;
+  options.latencySeconds = 0;
+
+  string suite = "all";
+  string jsonPath;
+  string label;
+  string kernelsName;
+
+  for (int i=1; i<argc; i++){
+    string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--suite" && hasValue) suite = argv[++i];
+    else if (arg == "--filter" && hasValue) options.filter = argv[++i];
+    else if (arg == "--json" && hasValue) jsonPath = argv[++i];
+    else if (arg == "--label" && hasValue) label = argv[++i];
+    else if (arg == "--block" && hasValue) options.blockSize = (unsigned int)atoi(argv[++i]);
+    else if (arg == "--reps" && hasValue) options.reps = (unsigned int)atoi(argv[++i]);
+    else if (arg == "--threads" && hasValue) options.threads = (unsigned int)atoi(argv[++i]);
+    else if (arg == "--latency" && hasValue) options.latencySeconds = atof(argv[++i]) / 1000.0;
+    else if (arg == "--kernels" && hasValue) kernelsName = argv[++i];
+    else if (arg == "--pin") options.pinThreads = true;
+    else if (arg == "--list") options.listOnly = true;
+    else{
+      fprintf(stderr, "Usage: %s [--suite nodes|graphs|sessions|kernels|all] [--filter text] [--block frames] [--reps n] [--json path] [--label text] [--list]\n"
+                      "       [--threads n] [--pin] [--latency ms] [--kernels name]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  if (options.blockSize == 0 || options.reps == 0){
+    fprintf(stderr, "--block and --reps must be at least 1\n");
+    return 1;
+  }
+
+  if (suite != "nodes" && suite != "graphs" && suite != "sessions" && suite != "kernels" && suite != "all"){
+    fprintf(stderr, "--suite must be nodes, graphs, sessions, kernels or all\n");
+    return 1;
+  }
+
+  if (!kernelsName.empty() && !setVectorKernels(kernelsName)){
+    fprintf(stderr, "--kernels must be one of:");
+    vector<const VectorKernels *> available = availableVectorKernels();
+    for (unsigned int k=0; k<available.size(); k++) fprintf(stderr, " %s", available[k]->name);
+    fprintf(stderr, "\n");
+    return 1;
+  }
+
+  if (options.latencySeconds <= 0){
+    options.latencySeconds = options.blockSize / sampleRate();
+  }
+
+  // the tables go to stderr when the JSON goes to stdout
+  FILE *out = jsonPath == "-" ? stderr : stdout;
+
+#if defined (__GNUC__) && !defined (__OPTIMIZE__)
+  fprintf(out, "Warning: built without optimisation - times will not be representative\n\n");
+#endif
+
+  vector<NodeBenchmarkResult> nodes;
+  vector<GraphBenchmarkResult> graphs;
+  vector<SessionBenchmarkResult> sessions;
+  vector<KernelBenchmarkResult> kernels;
+
+  if (suite == "nodes" || suite == "all"){
+    nodes = runNodeBenchmarks(options, out);
+  }
+
+  if (suite == "graphs" || suite == "all"){
+    if (!nodes.empty()) fprintf(out, "\n");
+    graphs = runGraphBenchmarks(options, out);
+  }
+
+  if (suite == "sessions" || suite == "all"){
+    if (!nodes.empty() || !graphs.empty()) fprintf(out, "\n");
+    sessions = runSessionBenchmarks(options, out);
+  }
+
+  if (suite == "kernels" || suite == "all"){
+    if (!nodes.empty() || !graphs.empty() || !sessions.empty()) fprintf(out, "\n");
+    kernels = runKernelBenchmarks(options, out);
+  }
+
+  if (!jsonPath.empty() && !options.listOnly){
+    FILE *file = jsonPath == "-" ? stdout : fopen(jsonPath.c_str(), "w");
+    if (!file){
+      fprintf(stderr, "Could not open %s for writing\n", jsonPath.c_str());
+      return 1;
+    }
+    writeJson(file, nodes, graphs, sessions, kernels, label, options);
+    if (file != stdout) fclose(file);
+  }
+
+  return 0;
+}
@@ -0,0 +1,100 @@
+//
+//  main.cpp
+//  TonicOfflineRender
+//
+//
+
+// Renders a Tonic synth to a WAV file as fast as the CPU allows and reports the realtime factor (xRT).
+//
+// Usage: offline [seconds] [output.wav] [SynthName] [blockSize]
+//
+// SynthName may be any synth registered with TONIC_REGISTER_SYNTH. Defaults to the demo synth below.
+// Exits with status 1 if the synth isn't registered or the file can't be written.
+// blockSize is the synthesis block size in frames. Large blocks (512, 1024) render fastest.
+//
+// Build with TONIC_CHECK_REALTIME defined to also report allocations and locks made while rendering,
+// or with TONIC_PROFILE defined to report the time spent in each node.
+
+#include <iostream>
+#include <cstdlib>
+#include "Tonic.h"
+
+using namespace Tonic;
+
+class OfflineDemoSynth : public Synth {
+
+public:
+
+  OfflineDemoSynth(){
+
+    ControlMetro metro = ControlMetro().bpm(100);
+    ControlGenerator freq = ControlRandom().trigger(metro).min(0).max(1);
+
+    Generator tone = SquareWaveBL().freq( freq * 0.25 + 100 + 400 ) * SineWave().freq(50);
+
+    ADSR env = ADSR()
+    .attack(0.01)
+    .decay( 0.4 )
+    .sustain(0)
+    .release(0)
+    .doesSustain(false)
+    .trigger(metro);
+
+    StereoDelay delay = StereoDelay(3.0f,3.0f)
+    .delayTimeLeft( 0.5 + SineWave().freq(0.2) * 0.01)
+    .delayTimeRight(0.55 + SineWave().freq(0.23) * 0.01)
+    .feedback(0.3)
+    .dryLevel(0.8)
+    .wetLevel(0.2);
+
+    Generator filterFreq = (SineWave().freq(0.01) + 1) * 200 + 225;
+
+    LPF24 filter = LPF24().Q(2).cutoff( filterFreq );
+
+    setOutputGen( (( tone * env ) >> filter >> delay) * 0.3 );
+  }
+
+};
+
+TONIC_REGISTER_SYNTH(OfflineDemoSynth);
+
+int main(int argc, const char * argv[])
+{
+  double seconds = argc > 1 ? atof(argv[1]) : 60.0;
+  string path = argc > 2 ? argv[2] : "offline.wav";
+  string synthName = argc > 3 ? argv[3] : "OfflineDemoSynth";
+  unsigned int blockSize = argc > 4 ? (unsigned int)atoi(argv[4]) : kSynthesisBlockSize;
+
+  // createInstance lists the registered synths if there's none by this name
+  Synth synth = SynthFactory::createInstance(synthName);
+  if (!SynthFactory::isRegistered(synthName)){
+    return 1;
+  }
+  synth.setBlockSize(blockSize);
+
+  OfflineRenderer renderer = OfflineRenderer(synth);
+
+  // built with TONIC_PROFILE - time one block in 16
+  if (profilerEnabled()){
+    setProfileSampleInterval(16);
+  }
+
+  OfflineRenderStats stats = renderer.renderToWavFile(path, seconds);
+  if (stats.frames == 0 && renderer.framesForDuration(seconds) > 0){
+    return 1;
+  }
+
+  printf("Rendered %.2f s of audio (%lu frames) to %s in %.3f s: %.1fx realtime\n",
+         stats.audioSeconds, stats.frames, path.c_str(), stats.wallSeconds, stats.realtimeFactor);
+
+  // built with TONIC_CHECK_REALTIME - report anything the synth did that could glitch live audio
+  if (realtimeCheckEnabled()){
+    printRealtimeViolations();
+  }
+
+  if (profilerEnabled()){
+    printProfile();
+  }
+
+  return 0;
+}
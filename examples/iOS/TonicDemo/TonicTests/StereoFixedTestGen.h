@@ -38,19 +38,20 @@ namespace Tonic {
     
     inline void StereoFixedTestGen_::computeSynthesisBlock( const SynthesisContext_ & context)
     {
-      float* buffStart = &outputFrames_[0];
+      float* leftStart = outputFrames_.channelData(TONIC_LEFT);
+      float* rightStart = outputFrames_.channelData(TONIC_RIGHT);
       
         
       #ifdef USE_APPLE_ACCELERATE
         
-      vDSP_vfill( &lVal_ , buffStart, 2, outputFrames_.frames());
-      vDSP_vfill( &rVal_ , buffStart+1, 2, outputFrames_.frames());
+      vDSP_vfill( &lVal_ , leftStart, 1, outputFrames_.frames());
+      vDSP_vfill( &rVal_ , rightStart, 1, outputFrames_.frames());
       
       #else
       
       for (unsigned int i=0; i<outputFrames_.frames(); i++){
-        *buffStart++ = lVal_;
-        *buffStart++ = rVal_;
+        *leftStart++ = lVal_;
+        *rightStart++ = rVal_;
       }
       
       #endif
@@ -74,11 +74,11 @@ using namespace Tonic;
 - (void)verifyStereoFixedOutputEqualsLeft:(float)l right:(float)r
 {
   for (unsigned int i=0; i<testFrames.frames(); i++){
-    XCTAssertEqual(l, testFrames[2*i], @"Left channel not produce expected output on frame %i", i);
-    if (testFrames[2*i] != l) break;
+    XCTAssertEqual(l, testFrames(i, 0), @"Left channel not produce expected output on frame %i", i);
+    if (testFrames(i, 0) != l) break;
     
-    XCTAssertEqual(r, testFrames[2*i+1], @"Right channel did not produce expected output on frame %i", i);
-    if (testFrames[2*i+1] != r) break;
+    XCTAssertEqual(r, testFrames(i, 1), @"Right channel did not produce expected output on frame %i", i);
+    if (testFrames(i, 1) != r) break;
   }
 }
 
@@ -356,6 +356,26 @@ using namespace Tonic;
 }
 
 
+-(void)test121TickView{
+  
+  // A view is the generator's own output block, in the generator's channel layout
+  FixedValue monoVal = FixedValue(0.25);
+  const TonicFrames & view = monoVal.tick(testContext);
+  XCTAssertEqual(view.channels(), (unsigned int)1, @"View should have the generator's channel count");
+  XCTAssertEqual(view(kSynthesisBlockSize - 1, 0), 0.25f, @"View should contain the generator's output");
+  
+  // Converting view - no copy when layouts match, channel conversion like tick(frames, context) otherwise
+  TonicFrames monoFrames(kSynthesisBlockSize, 1);
+  TonicFrames stereoFrames(kSynthesisBlockSize, 2);
+  
+  StereoFixedTestGen stereoVal = StereoFixedTestGen(0.5, 1.0);
+  XCTAssertTrue(&stereoVal.tick(testContext, stereoFrames) != &stereoFrames, @"Matching layout should not be copied");
+  
+  const TonicFrames & converted = stereoVal.tick(testContext, monoFrames);
+  XCTAssertTrue(&converted == &monoFrames, @"Different layout should be converted into the given frames");
+  XCTAssertEqual(converted(0, 0), 0.75f, @"Stereo to mono conversion should average channels");
+}
+
 
 #pragma mark - Control Generator Tests
 
@@ -808,6 +828,1201 @@ using namespace Tonic;
 
 }
 
+-(void)test305MixerParallelMatchesSerial{
+  
+  const unsigned int numInputs = 16;
+  const unsigned int numFrames = kTestOutputBlockSize * 16;
+  
+  Mixer serialMixer;
+  Mixer parallelMixer;
+  parallelMixer.setNumThreads(4);
+  
+  for (unsigned int i=0; i<numInputs; i++){
+    TestBufferFiller serialInput;
+    serialInput.setOutputGen( (SineWave().freq(100 + 7*i) * 0.1) >> LPF24().cutoff(800 + 10*i) >> StereoDelay(0.1, 0.15).feedback(0.4) );
+    serialMixer.addInput(serialInput);
+    
+    TestBufferFiller parallelInput;
+    parallelInput.setOutputGen( (SineWave().freq(100 + 7*i) * 0.1) >> LPF24().cutoff(800 + 10*i) >> StereoDelay(0.1, 0.15).feedback(0.4) );
+    parallelMixer.addInput(parallelInput);
+  }
+  
+  float *serialOut = new float[numFrames * 2];
+  float *parallelOut = new float[numFrames * 2];
+  
+  serialMixer.fillBufferOfFloats(serialOut, numFrames, 2);
+  parallelMixer.fillBufferOfFloats(parallelOut, numFrames, 2);
+  
+  XCTAssertTrue(memcmp(serialOut, parallelOut, numFrames * 2 * sizeof(float)) == 0, @"Parallel mixing should be bit-identical to serial mixing");
+  
+  XCTAssertEqual(parallelMixer.parallelStats().blocks, (unsigned long)(numFrames / kSynthesisBlockSize), @"Every block should have been rendered in parallel");
+  
+  delete [] serialOut;
+  delete [] parallelOut;
+}
+
+-(void)test306GraphChangesApplyAtNextBlock{
+  
+  TestBufferFiller testFiller;
+  testFiller.setLimitOutput(false);
+  
+  Generator first = FixedValue(1);
+  Generator second = FixedValue(2);
+  
+  testFiller.setOutputGen(first);
+  testFiller.fillBufferOfFloats(stereoOutBuffer, kTestOutputBlockSize, 2);
+  XCTAssertEqual(*stereoOutBuffer, 1.f, @"Output gen should be applied at the first block");
+  
+  testFiller.setOutputGen(second);
+  XCTAssertTrue(second == testFiller.getOutputGen(), @"getOutputGen should return the most recently set gen");
+  
+  testFiller.fillBufferOfFloats(stereoOutBuffer, kTestOutputBlockSize, 2);
+  XCTAssertEqual(*stereoOutBuffer, 2.f, @"Replacement output gen should be applied at the next block");
+  
+  testFiller.collectGarbage();
+  testFiller.fillBufferOfFloats(stereoOutBuffer, kTestOutputBlockSize, 2);
+  XCTAssertEqual(*stereoOutBuffer, 2.f, @"Collecting garbage should not affect the current graph");
+  
+  XCTAssertEqual(testFiller.blockTimingStats().blocks, (unsigned long)(3 * kTestOutputBlockSize / kSynthesisBlockSize), @"Every block should be timed");
+  
+  Mixer mixer;
+  TestBufferFiller input;
+  input.setLimitOutput(false);
+  input.setOutputGen(FixedValue(0.5));
+  mixer.addInput(input);
+  mixer.fillBufferOfFloats(stereoOutBuffer, kTestOutputBlockSize, 2);
+  XCTAssertEqual(*stereoOutBuffer, 0.5f, @"Mixer input should be applied at the next block");
+  
+  mixer.removeInput(input);
+  mixer.fillBufferOfFloats(stereoOutBuffer, kTestOutputBlockSize, 2);
+  XCTAssertEqual(*stereoOutBuffer, 0.f, @"Removed mixer input should not be heard after the next block");
+}
+
+-(void)test307CompiledGraphMatchesRecursive{
+  
+  const unsigned int numFrames = kTestOutputBlockSize * 16;
+  
+  TestBufferFiller recursiveFiller;
+  TestBufferFiller compiledFiller;
+  compiledFiller.compile();
+  
+  for (unsigned int f=0; f<2; f++){
+    TestBufferFiller & filler = f == 0 ? recursiveFiller : compiledFiller;
+    Generator shared = SineWave().freq(220);
+    Adder adder;
+    for (unsigned int i=0; i<8; i++){
+      adder.input( (shared * (0.1 * i) + SineWave().freq(300 + 50*i) * 0.05) >> LPF12().cutoff(500 + 100*i) );
+    }
+    filler.setOutputGen( adder >> StereoDelay(0.05, 0.08).feedback(0.3) );
+  }
+  
+  float *recursiveOut = new float[numFrames * 2];
+  float *compiledOut = new float[numFrames * 2];
+  
+  recursiveFiller.fillBufferOfFloats(recursiveOut, numFrames, 2);
+  compiledFiller.fillBufferOfFloats(compiledOut, numFrames, 2);
+  
+  XCTAssertTrue(compiledFiller.isCompiled(), @"Graph should be rendering from a schedule");
+  XCTAssertTrue(memcmp(recursiveOut, compiledOut, numFrames * 2 * sizeof(float)) == 0, @"Compiled rendering should be bit-identical to recursive rendering");
+  
+  // graph changes are picked up and recompiled
+  compiledFiller.setOutputGen(FixedValue(0.25));
+  compiledFiller.fillBufferOfFloats(compiledOut, kTestOutputBlockSize, 2);
+  XCTAssertEqual(compiledOut[kTestOutputBlockSize * 2 - 1], 0.25f, @"Compiled graph should follow setOutputGen");
+  XCTAssertTrue(compiledFiller.isCompiled(), @"Graph should be recompiled after a change");
+  
+  // a node dropped from the graph without a command stays alive while the schedule holds it
+  class CountingGen : public Tonic_::Generator_ {
+    int * live_;
+  public:
+    CountingGen(int * live) : live_(live) { (*live_)++; }
+    ~CountingGen() { (*live_)--; }
+    void computeSynthesisBlock(const Tonic_::SynthesisContext_ &context){ outputFrames_.fill(0.5f); }
+  };
+  
+  int live = 0;
+  LPF12 filter = LPF12().cutoff(1000);
+  filter.input(Generator(new CountingGen(&live)));
+  compiledFiller.setOutputGen(filter);
+  compiledFiller.fillBufferOfFloats(compiledOut, kTestOutputBlockSize * 4, 2);
+  XCTAssertTrue(compiledFiller.isCompiled(), @"Graph should be rendering from a schedule");
+  
+  filter.input(FixedValue(0));
+  XCTAssertEqual(live, 1, @"The schedule should keep a node the graph dropped alive");
+  compiledFiller.fillBufferOfFloats(compiledOut, kTestOutputBlockSize * 4, 2);
+  
+  // recording again lets it go, deleted off the audio thread
+  compiledFiller.setOutputGen(filter);
+  compiledFiller.fillBufferOfFloats(compiledOut, kTestOutputBlockSize * 4, 2);
+  compiledFiller.collectGarbage();
+  XCTAssertEqual(live, 0, @"A dropped node should be freed once the schedule is recorded again");
+  
+  delete [] recursiveOut;
+  delete [] compiledOut;
+}
+
+-(void)test308BlockSizeDoesNotChangeOutput{
+  
+  const unsigned int numFrames = 4096;
+  const unsigned int blockSizes[] = {kSynthesisBlockSize, 16, 100, 1024};
+  
+  float *outputs[4];
+  
+  for (unsigned int b=0; b<4; b++){
+    
+    TestBufferFiller filler;
+    filler.setBlockSize(blockSizes[b]);
+    filler.setOutputGen( ((SineWave().freq(220) >> LPF12().cutoff(800)) + SawtoothWave().freq(110) * 0.2) >> StereoDelay(0.01, 0.02).feedback(0.3) );
+    
+    // odd buffer sizes, so blocks straddle buffers
+    outputs[b] = new float[numFrames * 2];
+    for (unsigned int f=0; f<numFrames; f+=256){
+      filler.fillBufferOfFloats(outputs[b] + f * 2, 100, 2);
+      filler.fillBufferOfFloats(outputs[b] + (f + 100) * 2, 156, 2);
+    }
+    
+    XCTAssertEqual(filler.blockSize(), blockSizes[b], @"Blocks should be rendered at the requested size");
+  }
+  
+  for (unsigned int b=1; b<4; b++){
+    float maxDiff = 0;
+    for (unsigned int i=0; i<numFrames * 2; i++){
+      maxDiff = max(maxDiff, fabsf(outputs[b][i] - outputs[0][i]));
+    }
+    XCTAssertTrue(maxDiff < 1.e-5f, @"Audio-rate output should not depend on the block size");
+  }
+  
+  for (unsigned int b=0; b<4; b++){
+    delete [] outputs[b];
+  }
+}
+
+-(void)test309PolySynthVoiceAllocation{
+  
+  const VoiceStealingMode modes[] = {VoiceStealingOldest, VoiceStealingLowestNote, VoiceStealingHighestNote, VoiceStealingNone};
+  
+  // two voices, three notes - each voice outputs its note number while held
+  const float expectedSums[] = {20 + 40, 20 + 40, 10 + 40, 10 + 20};
+  
+  for (unsigned int m=0; m<4; m++){
+    
+    PolySynth poly;
+    poly.setLimitOutput(false);
+    poly.setVoiceStealing(modes[m]);
+    
+    for (int v=0; v<2; v++){
+      Synth voice;
+      ControlParameter note = voice.addParameter("polyNote");
+      ADSR env = ADSR(0, 0, 1, 0).trigger(voice.addParameter("polyGate"));
+      voice.setOutputGen(env * note);
+      poly.addVoice(voice, env);
+    }
+    
+    poly.noteOn(10);
+    poly.noteOn(20);
+    poly.noteOn(40);
+    poly.fillBufferOfFloats(stereoOutBuffer, kTestOutputBlockSize, 2);
+    
+    XCTAssertEqual(stereoOutBuffer[kTestOutputBlockSize * 2 - 1], expectedSums[m], @"Wrong voice stolen");
+    XCTAssertEqual(poly.numSoundingVoices(), 2u, @"Both voices should be sounding");
+    
+    poly.allNotesOff();
+    poly.fillBufferOfFloats(stereoOutBuffer, kTestOutputBlockSize, 2);
+    
+    XCTAssertEqual(stereoOutBuffer[kTestOutputBlockSize * 2 - 1], 0.f, @"Released voices should be silent");
+    XCTAssertEqual(poly.numSoundingVoices(), 0u, @"Voices should stop rendering once their envelopes finish");
+    
+    // a freed voice can be reused
+    poly.noteOn(30);
+    poly.fillBufferOfFloats(stereoOutBuffer, kTestOutputBlockSize, 2);
+    
+    XCTAssertEqual(stereoOutBuffer[kTestOutputBlockSize * 2 - 1], 30.f, @"Note should play on a free voice");
+    XCTAssertEqual(poly.numSoundingVoices(), 1u, @"Only one voice should be rendering");
+  }
+}
+
+-(void)test310SilentSubgraphsSleep{
+  
+  Synth synth;
+  synth.setLimitOutput(false);
+  synth.setSkipSilence(true);
+  
+  ControlParameter gate = synth.addParameter("gate", 0);
+  ADSR env = ADSR(0, 0, 1, 0).trigger(gate);
+  Generator voice = SineWave().freq(1000) * env;
+  
+  // echo 0.05 seconds later, no feedback and no dry signal
+  synth.setOutputGen( (voice + env) >> BasicDelay(0.05).feedback(0).dryLevel(0).wetLevel(1) );
+  
+  synth.fillBufferOfFloats(stereoOutBuffer, kTestOutputBlockSize, 2);
+  XCTAssertTrue(voice.isSilent(), @"Untriggered voice should be silent");
+  XCTAssertTrue(synth.blockTimingStats().lastBlockSkippedNodes > 0, @"Sine wave under an idle envelope should not be computed");
+  
+  // one buffer of sound, then silence
+  synth.setParameter("gate", 1);
+  synth.fillBufferOfFloats(stereoOutBuffer, kTestOutputBlockSize, 2);
+  XCTAssertFalse(voice.isSilent(), @"Triggered voice should not be silent");
+  synth.setParameter("gate", 0);
+  
+  // the delay has to keep running until its echo has played out
+  float echoPeak = 0;
+  for (int i=0; i<20; i++){
+    synth.fillBufferOfFloats(stereoOutBuffer, kTestOutputBlockSize, 2);
+    for (unsigned int s=0; s<kTestOutputBlockSize * 2; s++){
+      echoPeak = max(echoPeak, fabsf(stereoOutBuffer[s]));
+    }
+  }
+  XCTAssertTrue(echoPeak > 0.5f, @"Delay should not sleep before its echo");
+  
+  // and then sleep, outputting silence
+  synth.fillBufferOfFloats(stereoOutBuffer, kTestOutputBlockSize, 2);
+  XCTAssertTrue(synth.isSilent(), @"Synth should be silent once the echo has died away");
+  XCTAssertEqual(stereoOutBuffer[kTestOutputBlockSize * 2 - 1], 0.f, @"Sleeping delay should output silence");
+  XCTAssertEqual(synth.blockTimingStats().lastBlockSkippedNodes, 2ul, @"Delay should sleep along with the sine wave");
+}
+
+-(void)test311ConstantBlocksUseScalarArithmetic{
+  
+  // gain of 6.5, exactly
+  Generator gain = (FixedValue(2) * 3 + 1 - 0.5) / 1;
+  Generator scaled = SineWave().freq(440) * gain;
+  
+  TestBufferFiller testFiller;
+  testFiller.setOutputGen(scaled);
+  
+  TestBufferFiller refFiller;
+  refFiller.setOutputGen(SineWave().freq(440));
+  
+  for (int pass=0; pass<2; pass++){
+    
+    // constants have to survive a change of block size
+    if (pass == 1){
+      testFiller.setBlockSize(16);
+      refFiller.setBlockSize(16);
+    }
+    
+    testFiller.fillBufferOfFloats(monoOutBuffer, kTestOutputBlockSize, 1);
+    refFiller.fillBufferOfFloats(stereoOutBuffer, kTestOutputBlockSize, 1);
+    
+    XCTAssertTrue(gain.isConstant(), @"Arithmetic on fixed values should be constant");
+    XCTAssertFalse(scaled.isConstant(), @"Oscillator times a gain should not be constant");
+    
+    bool matches = true;
+    for (unsigned int i=0; i<kTestOutputBlockSize; i++){
+      matches = matches && monoOutBuffer[i] == stereoOutBuffer[i] * 6.5f;
+    }
+    XCTAssertTrue(matches, @"Scalar gain should give the same output as a block of gains");
+  }
+}
+
+-(void)test312ReleaseWhileRenderingIsDeferred{
+
+  class DeletionProbe : public Tonic_::Generator_ {
+    public:
+    bool *deleted;
+    bool *deletedWhileRendering;
+    ~DeletionProbe(){
+      *deleted = true;
+      *deletedWhileRendering = Tonic_::isRendering();
+    }
+  };
+
+  bool deleted = false;
+  bool deletedWhileRendering = false;
+
+  DeletionProbe *probe = new DeletionProbe;
+  probe->deleted = &deleted;
+  probe->deletedWhileRendering = &deletedWhileRendering;
+
+  {
+    Generator gen(probe);
+    Generator copy = gen;
+
+    Tonic_::RenderScope_ renderScope;
+    gen = Generator();
+    copy = Generator();
+  }
+
+  // the background reclaimer may already have got to it, but never on the rendering thread
+  Tonic_::reclaimDeferredDeletions();
+  XCTAssertTrue(deleted, @"Object released while rendering should be deleted once reclaimed");
+  XCTAssertFalse(deletedWhileRendering, @"Object released while rendering should not be deleted by the rendering thread");
+
+  deleted = false;
+  probe = new DeletionProbe;
+  probe->deleted = &deleted;
+  probe->deletedWhileRendering = &deletedWhileRendering;
+  {
+    Generator gen(probe);
+  }
+  XCTAssertTrue(deleted, @"Object released outside rendering should be deleted straight away");
+}
+
+-(void)test313RealtimeCheckFindsAllocations{
+
+  // only meaningful when built with TONIC_CHECK_REALTIME
+  if (!realtimeCheckEnabled()){
+    XCTAssertEqual(numRealtimeViolations(), 0ul, @"Nothing should be recorded unless realtime checking is built in");
+    return;
+  }
+
+  class AllocatingGen : public Tonic_::Generator_ {
+    TonicFloat * volatile lastScratch; // keeps the compiler from eliding the allocation
+    void computeSynthesisBlock(const Tonic_::SynthesisContext_ &context){
+      vector<TonicFloat> scratch(context.blockSize);
+      lastScratch = &scratch[0];
+      outputFrames_.clear();
+    }
+  };
+
+  TestBufferFiller cleanFiller;
+  cleanFiller.setOutputGen(SineWave().freq(440) * 0.5 >> LPF12().cutoff(1000));
+  cleanFiller.fillBufferOfFloats(stereoOutBuffer, kTestOutputBlockSize, 2);
+
+  resetRealtimeViolations();
+  cleanFiller.fillBufferOfFloats(stereoOutBuffer, kTestOutputBlockSize, 2);
+  XCTAssertEqual(numRealtimeViolations(), 0ul, @"A filtered sine wave should render without allocating");
+
+  TestBufferFiller allocatingFiller;
+  allocatingFiller.setOutputGen(SineWave() + Generator(new AllocatingGen));
+  allocatingFiller.fillBufferOfFloats(stereoOutBuffer, kTestOutputBlockSize, 2);
+
+  resetRealtimeViolations();
+  allocatingFiller.fillBufferOfFloats(stereoOutBuffer, kTestOutputBlockSize, 2);
+
+  vector<RealtimeViolation> violations = realtimeViolations();
+  XCTAssertEqual(violations.size(), 2ul, @"Allocating and freeing scratch space should be two violations");
+
+  for (unsigned int i=0; i<violations.size(); i++){
+    XCTAssertEqual(violations[i].count, (unsigned long)(kTestOutputBlockSize / kSynthesisBlockSize), @"Should be one of each per block");
+    XCTAssertTrue(violations[i].nodeType.find("AllocatingGen") != string::npos, @"Violation should be attributed to the generator making it");
+  }
+}
+
+-(void)test314ProfilerCountsCallsAndCacheHits{
+
+  // only meaningful when built with TONIC_PROFILE
+  if (!profilerEnabled()){
+    XCTAssertTrue(profileByClass().empty(), @"Nothing should be profiled unless the profiler is built in");
+    return;
+  }
+
+  const unsigned long numBlocks = kTestOutputBlockSize / kSynthesisBlockSize;
+
+  class SharedGen : public Tonic_::Generator_ {
+    void computeSynthesisBlock(const Tonic_::SynthesisContext_ &context){
+      fillConstant(1);
+    }
+  };
+
+  // one node, ticked twice per block
+  Generator shared = Generator(new SharedGen);
+  TestBufferFiller testFiller;
+  testFiller.setOutputGen(shared * 0.5 + shared * 0.25);
+  testFiller.fillBufferOfFloats(stereoOutBuffer, kTestOutputBlockSize, 2);
+
+  setProfileSampleInterval(1);
+  resetProfile();
+  testFiller.fillBufferOfFloats(stereoOutBuffer, kTestOutputBlockSize, 2);
+  setProfileSampleInterval(0);
+
+  XCTAssertEqual(profiledBlocks(), numBlocks, @"Every block should be profiled with an interval of 1");
+
+  vector<NodeProfile> profiles = profileByClass();
+  const NodeProfile * sharedProfile = NULL;
+  for (unsigned int i=0; i<profiles.size(); i++){
+    if (profiles[i].className.find("SharedGen") != string::npos) sharedProfile = &profiles[i];
+  }
+
+  XCTAssertTrue(sharedProfile != NULL, @"The shared node should be profiled");
+  if (!sharedProfile) return;
+
+  XCTAssertEqual(sharedProfile->numNodes, 1u, @"There is only one SharedGen");
+  XCTAssertEqual(sharedProfile->calls, 2 * numBlocks, @"The shared node should be ticked twice per block");
+  XCTAssertEqual(sharedProfile->cacheHits, numBlocks, @"The second tick of each block should be a cache hit");
+  XCTAssertTrue(sharedProfile->selfSeconds <= sharedProfile->seconds, @"Self time should be part of the total");
+}
+
+-(void)test315SampleRatePerBufferFiller{
+
+  class ImpulseGen : public Tonic_::Generator_ {
+    void computeSynthesisBlock(const Tonic_::SynthesisContext_ &context){
+      outputFrames_.clear();
+      if (context.elapsedFrames == 0) outputFrames_[0] = 1;
+    }
+  };
+
+  const TonicFloat rates[2] = {44100, 48000};
+  const unsigned int numFrames = 2 * kTestOutputBlockSize;
+  TonicFloat echoBuffer[numFrames];
+  TonicFloat sineBuffer[kTestOutputBlockSize];
+
+  // two engines at different rates, rendering side by side
+  TestBufferFiller echoFillers[2];
+  TestBufferFiller sineFillers[2];
+  for (unsigned int r=0; r<2; r++){
+    echoFillers[r].setSampleRate(rates[r]);
+    echoFillers[r].setOutputGen(Generator(new ImpulseGen) >> BasicDelay(0.01, 0.02).feedback(0).dryLevel(0).wetLevel(1));
+    sineFillers[r].setSampleRate(rates[r]);
+    sineFillers[r].setOutputGen(SineWave().freq(1000));
+    XCTAssertEqual(echoFillers[r].sampleRate(), rates[r], @"BufferFiller should report the rate it was given");
+  }
+
+  for (unsigned int r=0; r<2; r++){
+    echoFillers[r].fillBufferOfFloats(echoBuffer, kTestOutputBlockSize, 1);
+    echoFillers[r].fillBufferOfFloats(echoBuffer + kTestOutputBlockSize, kTestOutputBlockSize, 1);
+
+    unsigned int echoFrame = 0;
+    while (echoFrame < numFrames && echoBuffer[echoFrame] == 0) echoFrame++;
+    XCTAssertEqual(echoFrame, (unsigned int)(0.01f * rates[r] + 0.5f), @"Delay time should be measured at the BufferFiller's rate");
+
+    // a quarter period of 1kHz is 11.025 frames at 44.1kHz, 12 at 48kHz
+    sineFillers[r].fillBufferOfFloats(sineBuffer, kTestOutputBlockSize, 1);
+    XCTAssertEqualWithAccuracy(sineBuffer[12], sinf(TWO_PI * 1000 * 12 / rates[r]), 1.e-4, @"Oscillator frequency should follow the BufferFiller's rate");
+  }
+
+  XCTAssertEqual(sampleRate(), 44100.f, @"Setting a BufferFiller's rate should leave the default alone");
+}
+
+-(void)test316SessionHostRendersEverySession{
+
+  SessionHost host(2);
+
+  TestBufferFiller quiet, loud, late;
+  quiet.setOutputGen(FixedValue(0.25));
+  loud.setOutputGen(FixedValue(0.5));
+  late.setOutputGen(FixedValue(0.75));
+
+  host.addSession(quiet, 1);
+  host.addSession(loud, 2, 1);
+  host.addSession(late, 2, 1.e-12);
+
+  XCTAssertEqual(host.numSessions(), 3u, @"Every added session should be hosted");
+  XCTAssertTrue(host.session(0) == late && host.session(1) == loud && host.session(2) == quiet,
+                @"Sessions should be in order of their deadlines, those without one last");
+
+  host.render(kTestOutputBlockSize);
+
+  const TonicFloat * quietOutput = host.sessionOutput(2);
+  const TonicFloat * loudOutput = host.sessionOutput(1);
+  bool outputsMatch = true;
+  for (unsigned int i=0; i<kTestOutputBlockSize; i++){
+    outputsMatch &= quietOutput[i] == 0.25f;
+    outputsMatch &= loudOutput[2*i] == 0.5f && loudOutput[2*i + 1] == 0.5f;
+  }
+  XCTAssertTrue(outputsMatch, @"Each session should render into its own buffer with its own channel count");
+
+  XCTAssertEqual(host.sessionStats(0).missedDeadlines, 1ul, @"A session finishing after its deadline should be counted as missed");
+  XCTAssertEqual(host.sessionStats(2).missedDeadlines, 0ul, @"A session without a deadline should never miss it");
+
+  SessionHostStats stats = host.stats();
+  XCTAssertEqual(stats.batches, 1ul, @"One render should be one batch");
+  XCTAssertEqual(stats.sessionBlocks, 3ul, @"Every session should render once per batch");
+
+  host.removeSession(late);
+  XCTAssertEqual(host.numSessions(), 2u, @"Removed sessions should no longer be hosted");
+  XCTAssertEqual(host.stats().missedDeadlines, 1ul, @"A removed session's stats should stay in the host's totals");
+
+  host.resetStats();
+  XCTAssertEqual(host.stats().sessionBlocks, 0ul, @"Resetting should clear the stats");
+
+  // asking for more channels than a session renders gets the channels it has
+  TestBufferFiller mono;
+  mono.setNumChannels(1);
+  mono.setOutputGen(FixedValue(0.125));
+  mono.fillBufferOfFloats(stereoOutBuffer, kTestOutputBlockSize, 1);
+  host.addSession(mono, 4);
+  unsigned int monoIndex = host.session(0) == mono ? 0 : (host.session(1) == mono ? 1 : 2);
+  XCTAssertEqual(host.sessionNumChannels(monoIndex), 1u, @"A session should be clamped to the channels it renders");
+  host.render(kTestOutputBlockSize);
+  const TonicFloat * monoOutput = host.sessionOutput(monoIndex);
+  bool monoMatches = true;
+  for (unsigned int i=0; i<kTestOutputBlockSize; i++){
+    monoMatches &= monoOutput[i] == 0.125f;
+  }
+  XCTAssertTrue(monoMatches, @"A clamped session should render its own channels");
+}
+
+-(void)test317PlanarAndBlockAlignedFills{
+
+  const unsigned int numFrames = 4 * kTestOutputBlockSize;
+  TonicFloat interleaved[2 * numFrames];
+  TonicFloat left[numFrames], right[numFrames];
+  TonicFloat planarMono[numFrames], interleavedMono[numFrames];
+
+  // panned, so the channels differ
+  TestBufferFiller fillers[4];
+  for (unsigned int i=0; i<4; i++){
+    fillers[i].setOutputGen(SineWave().freq(441) >> MonoToStereoPanner().pan(-0.5));
+  }
+
+  // whole blocks, straight through
+  fillers[0].fillBufferOfFloats(interleaved, numFrames, 2);
+
+  // chunks straddling block boundaries
+  const unsigned int chunkSizes[3] = {1, kSynthesisBlockSize + 3, 2 * kSynthesisBlockSize - 5};
+  for (unsigned int offset = 0, i = 0; offset < numFrames; i++){
+    const unsigned int chunk = std::min(chunkSizes[i % 3], numFrames - offset);
+    TonicFloat * planar[2] = {left + offset, right + offset};
+    fillers[1].fillPlanarBuffersOfFloats(planar, chunk, 2);
+    offset += chunk;
+  }
+
+  TonicFloat * planar[1] = {planarMono};
+  fillers[2].fillPlanarBuffersOfFloats(planar, numFrames, 1);
+
+  fillers[3].fillBufferOfFloats(interleavedMono, kSynthesisBlockSize / 2, 1);
+  fillers[3].fillBufferOfFloats(interleavedMono + kSynthesisBlockSize / 2, numFrames - kSynthesisBlockSize / 2, 1);
+
+  bool planarMatches = true;
+  bool monoMatches = true;
+  for (unsigned int i=0; i<numFrames; i++){
+    planarMatches &= left[i] == interleaved[2*i] && right[i] == interleaved[2*i + 1];
+    monoMatches &= planarMono[i] == (interleaved[2*i] + interleaved[2*i + 1]) * 0.5f && interleavedMono[i] == planarMono[i];
+  }
+  XCTAssertTrue(left[10] != right[10], @"Test signal should differ between channels");
+  XCTAssertTrue(planarMatches, @"Planar fills in any chunk size should deinterleave the same output");
+  XCTAssertTrue(monoMatches, @"Mono fills should average the channels");
+}
+
+-(void)test318MultichannelFrames{
+
+  const unsigned int numChannels = 6;
+  const unsigned int numFrames = 4 * kSynthesisBlockSize;
+
+  // planar layout, and conversion to and from fewer channels
+  TonicFrames frames(kSynthesisBlockSize, numChannels);
+  for (unsigned int c=0; c<numChannels; c++){
+    for (unsigned int i=0; i<kSynthesisBlockSize; i++){
+      frames(i, c) = c + 1;
+    }
+  }
+  XCTAssertEqual(frames.channelData(3)[0], 4.f, @"Each channel's frames should be contiguous");
+  XCTAssertEqual(frames[kSynthesisBlockSize], 2.f, @"Channels should follow one another");
+
+  TonicFrames mono(kSynthesisBlockSize, 1), stereo(kSynthesisBlockSize, 2), spread(kSynthesisBlockSize, numChannels);
+  mono.copy(frames);
+  stereo.copy(frames);
+  XCTAssertEqual(mono(5, 0), 3.5f, @"Mono copy should average every channel");
+  XCTAssertTrue(stereo(5, 0) == 1.f && stereo(5, 1) == 2.f, @"Stereo copy should take the first two channels");
+
+  spread.copy(mono);
+  spread += stereo;
+  XCTAssertTrue(spread(7, 0) == 4.5f && spread(7, 1) == 5.5f && spread(7, 5) == 3.5f, @"Mono should fill every channel, stereo add to the first two");
+
+  // a six channel graph - each channel of the ring buffer holds its own level
+  RingBufferWriter writer("test318", kSynthesisBlockSize * 8, numChannels);
+  TonicFloat interleavedIn[kSynthesisBlockSize * numChannels];
+  for (unsigned int i=0; i<kSynthesisBlockSize * numChannels; i++){
+    interleavedIn[i] = 0.1f * (i % numChannels + 1);
+  }
+
+  TestBufferFiller testFiller;
+  testFiller.setNumChannels(numChannels);
+  testFiller.setOutputGen(RingBufferReader().bufferName("test318") >> LPF12().cutoff(1000) >> BasicDelay(0.001).wetLevel(0).dryLevel(1));
+
+  TonicFloat planarOut[numChannels][numFrames];
+  TonicFloat * planar[numChannels];
+  for (unsigned int c=0; c<numChannels; c++) planar[c] = planarOut[c];
+
+  for (unsigned int b=0; b<numFrames / kSynthesisBlockSize; b++){
+    writer.write(interleavedIn, kSynthesisBlockSize, numChannels);
+    for (unsigned int c=0; c<numChannels; c++) planar[c] = planarOut[c] + b * kSynthesisBlockSize;
+    testFiller.fillPlanarBuffersOfFloats(planar, kSynthesisBlockSize, numChannels);
+  }
+
+  XCTAssertEqual(testFiller.numChannels(), numChannels, @"BufferFiller should render the requested number of channels");
+  XCTAssertTrue(planarOut[0][numFrames - 1] > 0.05f, @"Graph should pass the signal through");
+  for (unsigned int c=1; c<numChannels; c++){
+    // same filter on every channel, so the levels keep their ratios
+    XCTAssertEqualWithAccuracy(planarOut[c][numFrames - 1], planarOut[0][numFrames - 1] * (c + 1), 1.e-5f, @"Channel %i should carry its own signal", c);
+  }
+
+  // more channels than are rendered - mono fills every channel, and the others are silent
+  TestBufferFiller monoFiller, stereoFiller;
+  monoFiller.setNumChannels(1);
+  monoFiller.setOutputGen(FixedValue(0.5));
+  stereoFiller.setNumChannels(2);
+  stereoFiller.setOutputGen(StereoFixedTestGen(0.5, 1.0));
+
+  TonicFloat interleavedOut[kSynthesisBlockSize * 3];
+  monoFiller.fillBufferOfFloats(interleavedOut, kSynthesisBlockSize, 3);
+  for (unsigned int i=0; i<kSynthesisBlockSize * 3; i++){
+    XCTAssertEqual(interleavedOut[i], 0.5f, @"A mono output should fill every channel");
+  }
+
+  for (unsigned int c=0; c<numChannels; c++){
+    planar[c] = planarOut[c];
+    for (unsigned int i=0; i<kSynthesisBlockSize; i++) planarOut[c][i] = 1.f;
+  }
+  stereoFiller.fillPlanarBuffersOfFloats(planar, kSynthesisBlockSize, numChannels);
+  XCTAssertTrue(planarOut[0][0] == 0.5f && planarOut[1][kSynthesisBlockSize - 1] == 1.f, @"Rendered channels should be matched by index");
+  for (unsigned int c=2; c<numChannels; c++){
+    XCTAssertEqual(planarOut[c][kSynthesisBlockSize - 1], 0.f, @"Channel %i isn't rendered, so should be silent", c);
+  }
+}
+
+// Runs one kernel of scalar and of kernels on the same random input, len samples from a misaligned offset
+static bool vectorKernelMatchesScalar(const VectorKernels & scalar, const VectorKernels & kernels, unsigned int op, unsigned int offset, unsigned int len){
+
+  TonicFloat dstA[1040], dstB[1040], src[1040];
+  TonicFloat dstImagA[1040], dstImagB[1040], srcImag[1040], otherReal[1040], otherImag[1040];
+  for (unsigned int i=0; i<1040; i++){
+    dstA[i] = dstB[i] = randomFloat(-1.f, 1.f);
+    src[i] = randomFloat(0.1f, 2.f) * (i % 2 ? 1.f : -1.f);
+    dstImagA[i] = dstImagB[i] = randomFloat(-1.f, 1.f);
+    srcImag[i] = randomFloat(-1.f, 1.f);
+    otherReal[i] = randomFloat(-1.f, 1.f);
+    otherImag[i] = randomFloat(-1.f, 1.f);
+  }
+  TonicFloat value = randomFloat(0.1f, 2.f);
+
+  // sineBank partials, 8 to 32 of them depending on offset
+  const unsigned int numPartials = (offset + 1) * VectorKernels::kSineBankLanes;
+  TonicFloat phase[2][32], amplitude[2][32], increment[32], amplitudeStep[32];
+  for (unsigned int p=0; p<32; p++){
+    phase[0][p] = phase[1][p] = randomFloat(0.f, 0.999f);
+    amplitude[0][p] = amplitude[1][p] = randomFloat(-1.f, 1.f);
+    increment[p] = randomFloat(0.f, 0.999f);
+    amplitudeStep[p] = randomFloat(-0.01f, 0.01f);
+  }
+
+  const VectorKernels * impl[2] = {&scalar, &kernels};
+  TonicFloat * dst[2] = {dstA + offset, dstB + offset};
+  TonicFloat * dstImag[2] = {dstImagA + offset, dstImagB + offset};
+  for (unsigned int k=0; k<2; k++){
+    switch (op){
+      case 0: impl[k]->add(dst[k], src + offset, len); break;
+      case 1: impl[k]->subtract(dst[k], src + offset, len); break;
+      case 2: impl[k]->multiply(dst[k], src + offset, len); break;
+      case 3: impl[k]->divide(dst[k], src + offset, len); break;
+      case 4: impl[k]->addScalar(dst[k], value, len); break;
+      case 5: impl[k]->subtractScalar(dst[k], value, len); break;
+      case 6: impl[k]->multiplyScalar(dst[k], value, len); break;
+      case 7: impl[k]->divideScalar(dst[k], value, len); break;
+      case 8: impl[k]->copyScaled(dst[k], src + offset, value, len); break;
+      case 9: impl[k]->addScaled(dst[k], src + offset, value, len); break;
+      case 10: impl[k]->fill(dst[k], value, len); break;
+      case 11: impl[k]->add(dst[k], dst[k], len); break;
+      case 12: impl[k]->sineBank(dst[k], len, phase[k], increment, amplitude[k], amplitudeStep, numPartials); break;
+      case 13: impl[k]->complexMultiplyAdd(dst[k], dstImag[k], src + offset, srcImag + offset, otherReal + offset, otherImag + offset, len); break;
+    }
+  }
+
+  if (op == 12 && (memcmp(phase[0], phase[1], sizeof(phase[0])) != 0 || memcmp(amplitude[0], amplitude[1], sizeof(amplitude[0])) != 0)){
+    return false;
+  }
+
+  // the samples either side of the range must be untouched, so compare the whole buffer
+  for (unsigned int i=0; i<1040; i++){
+    // allow addScaled and complexMultiplyAdd the rounding of a multiply-add the compiler may fuse in the scalar version
+    TonicFloat tolerance = op == 9 || op == 13 ? 1.e-6f * (fabsf(dstA[i]) + 1.f) : 0.f;
+    if (fabsf(dstA[i] - dstB[i]) > tolerance) return false;
+    if (fabsf(dstImagA[i] - dstImagB[i]) > (op == 13 ? 1.e-6f * (fabsf(dstImagA[i]) + 1.f) : 0.f)) return false;
+  }
+  return true;
+}
+
+- (void)test319VectorKernelsMatchScalar
+{
+  vector<const VectorKernels *> kernels = availableVectorKernels();
+  string initial = vectorKernels().name;
+
+  XCTAssertTrue(kernels.size() >= 1 && string(kernels[0]->name) == "scalar", @"Scalar kernels should always be available, first");
+  XCTAssertTrue(initial == kernels.back()->name, @"The widest kernels should be in use by default");
+  XCTAssertFalse(setVectorKernels("no such kernels"), @"Unknown kernels should be rejected");
+  XCTAssertTrue(initial == vectorKernels().name, @"Rejected kernels should leave the current ones in use");
+
+  const unsigned int lengths[] = {0, 1, 3, 4, 7, 8, 9, 15, 16, 17, 31, 33, 64, 255, 1024};
+  const unsigned int numOps = 14;
+
+  for (unsigned int k=1; k<kernels.size(); k++){
+    for (unsigned int op=0; op<numOps; op++){
+      for (unsigned int l=0; l<sizeof(lengths)/sizeof(lengths[0]); l++){
+        for (unsigned int offset=0; offset<4; offset++){
+          XCTAssertTrue(vectorKernelMatchesScalar(*kernels[0], *kernels[k], op, offset, lengths[l]),
+                        @"%s kernel %u should match scalar for %u samples at offset %u", kernels[k]->name, op, lengths[l], offset);
+        }
+      }
+    }
+  }
+
+  // a whole graph renders identically with every kernel set
+  vector<TonicFloat> reference;
+  for (unsigned int k=0; k<kernels.size(); k++){
+    XCTAssertTrue(setVectorKernels(kernels[k]->name), @"Available kernels should be selectable");
+
+    TestBufferFiller testFiller;
+    testFiller.setOutputGen(((SawtoothWave().freq(300) * 0.5 + SineWave().freq(500) / 3) >> MonoToStereoPanner().pan(0.3)) - 0.1);
+
+    vector<TonicFloat> output(kSynthesisBlockSize * 2 * 8);
+    for (unsigned int b=0; b<8; b++){
+      testFiller.fillBufferOfFloats(&output[b * kSynthesisBlockSize * 2], kSynthesisBlockSize, 2);
+    }
+    if (k == 0) reference = output;
+    XCTAssertTrue(output == reference, @"%s kernels should render the same output as scalar", kernels[k]->name);
+  }
+
+  setVectorKernels(initial);
+}
+
+- (void)test320BufferPool
+{
+  BufferPool pool(4096);
+  const TonicFloat * firstBuffer;
+  
+  {
+    BufferPoolScope scope(pool);
+    
+    TonicFrames frames(kSynthesisBlockSize, 2);
+    TonicFrames odd(37, 3);
+    TonicFrames big(100000, 1);
+    XCTAssertEqual(pool.buffersInUse(), (size_t)3, @"Frames in a scope should allocate from its pool");
+    XCTAssertTrue(((uintptr_t)frames.data() % 64) == 0 && ((uintptr_t)odd.data() % 64) == 0 && ((uintptr_t)big.data() % 64) == 0,
+                  @"Frames should be aligned to 64 bytes");
+    XCTAssertTrue(odd(36, 2) == 0 && big(99999, 0) == 0, @"New frames should be silent");
+    firstBuffer = frames.data();
+    
+    // a graph built in the scope keeps all of its buffers in the pool
+    Generator gen = SineWave().freq(440) >> LPF12().cutoff(1000);
+    XCTAssertTrue(pool.buffersInUse() > 3, @"Generators built in a scope should allocate from its pool");
+  }
+  
+  XCTAssertEqual(pool.buffersInUse(), (size_t)0, @"Every buffer should go back to the pool");
+  size_t reserved = pool.bytesReserved();
+  
+  {
+    BufferPoolScope scope(pool);
+    TonicFrames frames(kSynthesisBlockSize, 2);
+    XCTAssertTrue(frames.data() == firstBuffer, @"A freed buffer should be reused for the next of its size");
+    
+    for (unsigned int i=0; i<100; i++){
+      Generator gen = SineWave().freq(440) >> LPF12().cutoff(1000);
+    }
+    XCTAssertEqual(pool.bytesReserved(), reserved, @"Building and dropping the same graph again should not grow the pool");
+  }
+  
+  // frames allocated outside any scope come from the shared pool, even when they grow inside one
+  TonicFrames shared(kSynthesisBlockSize, 1);
+  {
+    BufferPoolScope scope(pool);
+    shared.resize(kSynthesisBlockSize * 64, 4);
+    XCTAssertEqual(pool.buffersInUse(), (size_t)0, @"Frames should keep the pool they were first allocated from");
+  }
+
+#if TONIC_HAS_CPP_11
+  // threads taking and returning buffers of the same classes never get one another's
+  struct PoolStress {
+    BufferPool pool;
+    std::atomic<unsigned int> clashes;
+    static void task(void * userData, unsigned int taskIndex, unsigned int){
+      PoolStress * stress = (PoolStress*)userData;
+      BufferPoolScope scope(stress->pool);
+      for (unsigned int i=0; i<2000; i++){
+        TonicFrames frames(kSynthesisBlockSize * (1 + i % 3), 1);
+        TonicFloat mark = (TonicFloat)(taskIndex * 2000 + i);
+        for (unsigned int s=0; s<frames.size(); s++) frames[s] = mark;
+        std::this_thread::yield();
+        for (unsigned int s=0; s<frames.size(); s++){
+          if (frames[s] != mark){
+            stress->clashes++;
+            break;
+          }
+        }
+      }
+    }
+  };
+
+  PoolStress stress;
+  stress.clashes = 0;
+  Tonic_::WorkerPool workers(3);
+  workers.run(PoolStress::task, &stress, 16);
+  XCTAssertEqual(stress.clashes.load(), 0u, @"No buffer should be handed to two threads at once");
+  XCTAssertEqual(stress.pool.buffersInUse(), (size_t)0, @"Every buffer should go back to the pool from any thread");
+#endif
+}
+
+- (void)test321SynthBufferPool
+{
+  BufferPool pool;
+  Generator kept;
+
+  {
+    Synth heapSynth, pooledSynth;
+    heapSynth.setOutputGen(SineWave().freq(440) >> LPF12().cutoff(1000));
+    {
+      BufferPoolScope scope(pooledSynth.bufferPool());
+      pooledSynth.setOutputGen(SineWave().freq(440) >> LPF12().cutoff(1000));
+      kept = Noise() * 0.5;
+    }
+    pool = pooledSynth.bufferPool();
+    XCTAssertTrue(pooledSynth.bufferPool() == pool, @"A Synth should make its pool once and keep it");
+    XCTAssertTrue(pool.buffersInUse() > 3, @"Buffers of generators built in the scope should come from the synth's pool");
+
+    // nothing outside the scope comes from the pool
+    size_t buffers = pool.buffersInUse();
+    Generator outside = SineWave();
+    XCTAssertEqual(pool.buffersInUse(), buffers, @"Generators built outside the scope should not use the synth's pool");
+
+    // where the buffers live makes no difference to what it plays
+    TonicFloat heapBuffer[kSynthesisBlockSize * 2], pooledBuffer[kSynthesisBlockSize * 2];
+    for (unsigned int i=0; i<4; i++){
+      heapSynth.fillBufferOfFloats(heapBuffer, kSynthesisBlockSize, 2);
+      pooledSynth.fillBufferOfFloats(pooledBuffer, kSynthesisBlockSize, 2);
+      XCTAssertTrue(memcmp(heapBuffer, pooledBuffer, sizeof(heapBuffer)) == 0, @"A graph with its own pool should render like one using the shared pool");
+    }
+  }
+
+  // the Synth is gone, but a handle still holds buffers from its pool
+  XCTAssertTrue(pool.buffersInUse() > 0, @"Handles should keep their generators' buffers, and the pool, alive");
+  TonicFrames frames(kSynthesisBlockSize, 1);
+  kept.tick(frames, testContext);
+
+  kept = Generator();
+  XCTAssertEqual(pool.buffersInUse(), (size_t)0, @"Every buffer should go once the last handle is dropped");
+}
+
+- (void)test322OscillatorBank
+{
+  OscillatorBank bank = OscillatorBank().partials(3);
+  XCTAssertEqual(bank.numPartials(), 3u, @"The bank should have the partials asked for");
+
+  ControlValue level = ControlValue(0.25);
+  bank.freq(0, 220).amp(0, 0.5);
+  bank.freq(1, 1000).amp(1, level);
+  bank.freq(2, -5000).amp(2, 0.1);
+
+  // against sines computed in double precision, for long enough that a drifting phase would show
+  TonicFrames frames(kSynthesisBlockSize, 1);
+  Tonic_::SynthesisContext_ context;
+  double maxError = 0;
+  unsigned long n = 0;
+  for (unsigned int b=0; b<1000; b++){
+    context.tick();
+    bank.tick(frames, context);
+    for (unsigned int i=0; i<frames.frames(); i++, n++){
+      double t = n / (double)Tonic::sampleRate();
+      double expected = 0.5 * sin(2 * M_PI * 220 * t) + 0.25 * sin(2 * M_PI * 1000 * t) - 0.1 * sin(2 * M_PI * 5000 * t);
+      maxError = max(maxError, fabs(expected - frames[i]));
+    }
+  }
+  XCTAssertTrue(maxError < 1.e-5, @"The bank should match a sum of sines");
+
+  // an amplitude change ramps across the next block
+  level.value(0);
+  bank.freq(0, 0).amp(0, 0).amp(2, 0);
+  context.tick();
+  bank.tick(frames, context);
+  for (unsigned int i=1; i<frames.frames(); i++){
+    XCTAssertTrue(fabsf(frames[i] - frames[i-1]) < 0.1f, @"Amplitude changes should not click");
+  }
+  context.tick();
+  bank.tick(frames, context);
+  for (unsigned int i=0; i<frames.frames(); i++){
+    XCTAssertEqual(frames[i], 0.f, @"Silent partials should sum to silence");
+  }
+
+  // a bank of SineWaves' worth of partials, in groups which don't fill the kernel's lanes
+  OscillatorBank big = OscillatorBank().partials(100);
+  for (unsigned int p=0; p<100; p++){
+    big.freq(p, 100 + p * 10).amp(p, 0.01);
+  }
+  context.tick();
+  big.tick(frames, context);
+  XCTAssertTrue(fabsf(frames[0]) < 1.e-5f, @"Every partial should start at phase 0");
+  XCTAssertTrue(frames[1] > 0, @"Partials should rise from phase 0");
+
+  XCTAssertEqual(OscillatorBank().numPartials(), 0u, @"A bank should start empty");
+}
+
+- (void)test323WavetableOsc
+{
+  SampleTable saw = SampleTable(1024, 1);
+  for (unsigned int i=0; i<1024; i++){
+    saw.planarDataPointer()[i] = 1.f - 2.f * i / 1024;
+  }
+
+  // levels are built once and shared, also with a TableLookupOsc-style copy ending in a wraparound sample
+  SampleTable guarded = SampleTable(1025, 1);
+  for (unsigned int i=0; i<1025; i++){
+    guarded.planarDataPointer()[i] = saw.planarDataPointer()[i % 1024];
+  }
+  SampleTable levels = Tonic_::mipMappedWavetable(saw);
+  XCTAssertTrue(Tonic_::mipMappedWavetable(saw).planarDataPointer() == levels.planarDataPointer(), @"Levels should be shared between tables with the same samples");
+  XCTAssertTrue(Tonic_::mipMappedWavetable(guarded).planarDataPointer() == levels.planarDataPointer(), @"A wraparound sample should be ignored");
+  XCTAssertEqual(levels.channels(), Tonic_::kWavetableLevels, @"There should be a level per octave");
+
+  // 3 kHz repeats every 14.7 samples, so 882 samples hold 60 whole cycles: everything not on a
+  // multiple of bin 60 of their DFT is aliasing
+  for (unsigned int crossfade=0; crossfade<2; crossfade++){
+
+    Generator osc = WavetableOsc().setTable(saw).freq(3000).crossfade(crossfade);
+    TonicFrames frames(kSynthesisBlockSize, 1);
+    vector<float> output;
+    while (output.size() < 882){
+      testContext.tick();
+      osc.tick(frames, testContext);
+      output.insert(output.end(), &frames[0], &frames[0] + frames.frames());
+    }
+    output.resize(882);
+
+    double harmonic = 0, aliased = 0;
+    for (unsigned int k=1; k<441; k++){
+      double re = 0, im = 0;
+      for (unsigned int i=0; i<882; i++){
+        re += output[i] * cos(2 * M_PI * k * i / 882);
+        im -= output[i] * sin(2 * M_PI * k * i / 882);
+      }
+      double energy = re * re + im * im;
+      if (k % 60 == 0) harmonic += energy;
+      else aliased += energy;
+    }
+    XCTAssertTrue(harmonic > 0, @"The oscillator should play the table");
+    XCTAssertTrue(aliased < harmonic * 1.e-4, @"Nothing should alias, crossfaded or not");
+  }
+
+  // silent until it has a table
+  Generator silent = WavetableOsc().freq(440);
+  TonicFrames frames(kSynthesisBlockSize, 1);
+  testContext.tick();
+  silent.tick(frames, testContext);
+  for (unsigned int i=0; i<frames.frames(); i++){
+    XCTAssertEqual(frames[i], 0.f, @"An oscillator without a table should be silent");
+  }
+}
+
+- (void)test324FFT
+{
+  // powers of two, mixed radices, a prime and a length with a large prime factor
+  const unsigned int lengths[] = {1, 2, 3, 4, 8, 12, 15, 60, 97, 100, 256, 1000, 1024, 2 * 509};
+
+  for (unsigned int l=0; l<sizeof(lengths)/sizeof(lengths[0]); l++){
+
+    const unsigned int n = lengths[l];
+    vector<TonicFloat> real(n), imag(n), realOut(n), imagOut(n), realBack(n), imagBack(n);
+    for (unsigned int i=0; i<n; i++){
+      real[i] = randomFloat(-1.f, 1.f);
+      imag[i] = randomFloat(-1.f, 1.f);
+    }
+
+    FFT fft(n);
+    fft.forward(&real[0], &imag[0], &realOut[0], &imagOut[0]);
+
+    const unsigned int bins = n / 2 + 1;
+    vector<TonicFloat> realBins(bins), imagBins(bins), realSignal(n);
+    fft.forwardReal(&real[0], &realBins[0], &imagBins[0]);
+
+    // against a DFT in double precision - errors grow with the square root of the length
+    double complexError = 0, realError = 0;
+    for (unsigned int k=0; k<n; k++){
+      double re = 0, im = 0, realOnlyRe = 0, realOnlyIm = 0;
+      for (unsigned int i=0; i<n; i++){
+        double phase = -2 * M_PI * ((k * i) % n) / n;
+        re += real[i] * cos(phase) - imag[i] * sin(phase);
+        im += real[i] * sin(phase) + imag[i] * cos(phase);
+        realOnlyRe += real[i] * cos(phase);
+        realOnlyIm += real[i] * sin(phase);
+      }
+      complexError = max(complexError, max(fabs(realOut[k] - re), fabs(imagOut[k] - im)));
+      if (k < bins) realError = max(realError, max(fabs(realBins[k] - realOnlyRe), fabs(imagBins[k] - realOnlyIm)));
+    }
+    XCTAssertTrue(complexError < 1.e-6 * sqrt((double)n) * 4, @"A complex FFT of %u should match the DFT", n);
+    XCTAssertTrue(realError < 1.e-6 * sqrt((double)n) * 4, @"A real FFT of %u should match the DFT", n);
+
+    // inverses, in place
+    fft.inverse(&realOut[0], &imagOut[0], &realOut[0], &imagOut[0]);
+    fft.inverseReal(&realBins[0], &imagBins[0], &realSignal[0]);
+    double inverseError = 0;
+    for (unsigned int i=0; i<n; i++){
+      inverseError = max(inverseError, (double)max(fabsf(realOut[i] - real[i]), fabsf(imagOut[i] - imag[i])));
+      inverseError = max(inverseError, (double)fabsf(realSignal[i] - real[i]));
+    }
+    XCTAssertTrue(inverseError < 1.e-5, @"Inverse FFTs of %u should undo the forward ones", n);
+  }
+
+  // every kernel set computes the same transform
+  vector<const VectorKernels *> kernels = availableVectorKernels();
+  string initial = vectorKernels().name;
+  vector<TonicFloat> signal(4096), reference;
+  for (unsigned int i=0; i<signal.size(); i++) signal[i] = randomFloat(-1.f, 1.f);
+
+  for (unsigned int k=0; k<kernels.size(); k++){
+    setVectorKernels(kernels[k]->name);
+    vector<TonicFloat> real(2049), imag(2049);
+    FFT(4096).forwardReal(&signal[0], &real[0], &imag[0]);
+    real.insert(real.end(), imag.begin(), imag.end());
+    if (k == 0) reference = real;
+    XCTAssertTrue(real == reference, @"%s kernels should give the same FFT as scalar", kernels[k]->name);
+  }
+  setVectorKernels(initial);
+
+  // the DSPUtils transforms are FFTs too
+  float timeReal[6] = {1, 2, 3, 4, 5, 6}, timeImag[6] = {0}, freqReal[6], freqImag[6], backReal[6], backImag[6];
+  DFT(6, timeReal, timeImag, freqReal, freqImag);
+  XCTAssertEqualWithAccuracy(freqReal[0], 21.f, 1.e-5f, @"DFT bin 0 should be the sum");
+  XCTAssertEqualWithAccuracy(freqReal[3], -3.f, 1.e-5f, @"DFT Nyquist bin should alternate");
+  InverseDFT(6, freqReal, freqImag, backReal, backImag);
+  for (unsigned int i=0; i<6; i++){
+    XCTAssertEqualWithAccuracy(backReal[i], timeReal[i], 1.e-5f, @"InverseDFT should undo DFT");
+  }
+
+  // a minBLEP's spectrum has bins an FFT leaves at exactly zero, which the cepstrum must survive
+  float *minBLEP = GenerateMinBLEP(16, 32);
+  bool finite = true;
+  for (unsigned int i=0; i<=1024; i++) finite = finite && minBLEP[i] == minBLEP[i];
+  XCTAssertTrue(finite, @"A minBLEP should have no NaNs");
+  XCTAssertEqualWithAccuracy(minBLEP[1024], 1.f, 1.e-6f, @"A minBLEP should step to 1");
+  XCTAssertEqualWithAccuracy(minBLEP[0], 0.f, 1.e-3f, @"A minBLEP should start at 0");
+  delete [] minBLEP;
+}
+
+- (void)test325ConvolutionReverb
+{
+  // long enough for taps in the first tier and in three later ones, the last with its transforms done in pieces
+  const unsigned int responseFrames = 10000, inputFrames = 200 * kSynthesisBlockSize;
+  SampleTable response(responseFrames, 1), input(inputFrames, 1);
+  for (unsigned int i=0; i<responseFrames; i++){
+    response.planarDataPointer()[i] = randomFloat(-1.f, 1.f) * expf(-4.f * i / responseFrames);
+  }
+  for (unsigned int i=0; i<inputFrames; i++){
+    input.planarDataPointer()[i] = randomFloat(-1.f, 1.f);
+  }
+
+  ControlTrigger play;
+  play.trigger();
+  ConvolutionReverb reverb = ConvolutionReverb().setImpulseResponse(response).input(BufferPlayer().setBuffer(input).trigger(play)).wetLevel(1).dryLevel(0);
+
+  Tonic_::SynthesisContext_ context;
+  TonicFrames frames(kSynthesisBlockSize, 1);
+  vector<TonicFloat> output;
+  for (unsigned int b=0; b<inputFrames / kSynthesisBlockSize; b++){
+    reverb.tick(frames, context);
+    context.tick();
+    output.insert(output.end(), &frames[0], &frames[0] + kSynthesisBlockSize);
+  }
+
+  // the same as convolving directly, with no latency
+  vector<double> expected(inputFrames, 0);
+  double error = 0, peak = 0;
+  for (unsigned int n=0; n<inputFrames; n++){
+    for (unsigned int k=0; k<=n && k<responseFrames; k++){
+      expected[n] += (double)input.planarDataPointer()[n - k] * response.planarDataPointer()[k];
+    }
+    error = max(error, fabs(output[n] - expected[n]));
+    peak = max(peak, fabs(expected[n]));
+  }
+  XCTAssertTrue(error < 1.e-5 * peak, @"ConvolutionReverb should match direct convolution");
+
+  // the tail from before a change of block size plays out alongside what comes after
+  Synth synth;
+  synth.setLimitOutput(false);
+  ControlTrigger replay;
+  replay.trigger();
+  synth.setOutputGen(ConvolutionReverb().setImpulseResponse(response).input(BufferPlayer().setBuffer(input).trigger(replay)).wetLevel(1).dryLevel(0));
+  vector<float> rendered(inputFrames);
+  synth.fillBufferOfFloats(&rendered[0], inputFrames / 2, 1);
+  synth.setBlockSize(2 * kSynthesisBlockSize);
+  synth.fillBufferOfFloats(&rendered[inputFrames / 2], inputFrames / 2, 1);
+  error = 0;
+  for (unsigned int n=0; n<inputFrames; n++){
+    error = max(error, fabs(rendered[n] - expected[n]));
+  }
+  XCTAssertTrue(error < 1.e-5 * peak, @"ConvolutionReverb should match direct convolution across a change of block size");
+
+  // responses are partitioned once per block size, whichever table holds them
+  SampleTable copy(responseFrames, 1);
+  memcpy(copy.planarDataPointer(), response.planarDataPointer(), responseFrames * sizeof(TonicFloat));
+  Tonic_::PartitionedImpulseResponse shared = Tonic_::partitionedImpulseResponse(response, kSynthesisBlockSize);
+  XCTAssertTrue(shared == Tonic_::partitionedImpulseResponse(copy, kSynthesisBlockSize), @"The same response should be partitioned once");
+  XCTAssertFalse(shared == Tonic_::partitionedImpulseResponse(response, 2 * kSynthesisBlockSize), @"Each block size should have its own partitions");
+  XCTAssertEqual(shared.response()->tiers[0].partitionFrames, (unsigned int)kSynthesisBlockSize, @"The first partitions should be a block long");
+
+  // a stereo response makes a mono input stereo
+  SampleTable stereoResponse(100, 2);
+  memset(stereoResponse.planarDataPointer(), 0, stereoResponse.size() * sizeof(TonicFloat));
+  stereoResponse.channelPointer(0)[0] = 1.f;
+  stereoResponse.channelPointer(1)[1] = 0.5f;
+  ConvolutionReverb stereo = ConvolutionReverb().setImpulseResponse(stereoResponse).input(FixedValue(1)).wetLevel(1).dryLevel(0);
+  XCTAssertTrue(stereo.isStereoOutput(), @"A stereo response should give stereo output");
+  testFrames.resize(kSynthesisBlockSize, 2, 0);
+  stereo.tick(testFrames, testContext);
+  XCTAssertEqualWithAccuracy(testFrames(0, 0), 1.f, 1.e-5f, @"The left channel should use the left response");
+  XCTAssertEqualWithAccuracy(testFrames(0, 1), 0.f, 1.e-5f, @"The right response should be delayed a frame");
+  XCTAssertEqualWithAccuracy(testFrames(kSynthesisBlockSize - 1, 1), 0.5f, 1.e-5f, @"The right channel should use the right response");
+
+  // with no response there is only the dry signal
+  ConvolutionReverb empty = ConvolutionReverb().input(FixedValue(1)).wetLevel(1).dryLevel(0.5);
+  [self configureStereo:NO];
+  empty.tick(testFrames, testContext);
+  [self verifyFixedOutputEquals:0.5f];
+}
+
+// A 441 Hz sine at half amplitude - a period every 100 frames at 44.1 kHz
+class OfflineTestSynth : public Synth {
+public:
+  OfflineTestSynth(){
+    setLimitOutput(false);
+    setOutputGen(SineWave().freq(441) * 0.5);
+  }
+};
+
+TONIC_REGISTER_SYNTH(OfflineTestSynth);
+
+- (void)test326OfflineRenderer
+{
+  OfflineRenderer renderer = OfflineRenderer("OfflineTestSynth");
+  XCTAssertTrue(renderer.isValid(), @"A registered synth should be renderable by name");
+
+  // not a whole number of chunks or blocks
+  const unsigned long numFrames = 10000;
+  renderer.setChunkFrames(1000);
+  vector<TonicFloat> rendered(numFrames * 2);
+  OfflineRenderStats stats = renderer.renderInterleaved(&rendered[0], numFrames);
+  XCTAssertEqual(stats.frames, numFrames, @"Every frame asked for should be rendered");
+
+  double error = 0;
+  for (unsigned long n=0; n<numFrames; n++){
+    double expected = 0.5 * sin(2 * M_PI * 441 * n / 44100.0);
+    error = max(error, max(fabs(rendered[2 * n] - expected), fabs(rendered[2 * n + 1] - expected)));
+  }
+  XCTAssertTrue(error < 1.e-3, @"The render should be the synth's output in both channels");
+
+  SampleTable table = OfflineRenderer("OfflineTestSynth", 1).renderToSampleTable(0.5);
+  XCTAssertEqual(table.frames(), (unsigned int)22050, @"Half a second should be 22050 frames");
+  XCTAssertEqualWithAccuracy(table.channelPointer(0)[25], 0.5f, 1.e-3f, @"A quarter period in should be the peak");
+
+  // more channels than the synth's two - the rest are silent
+  OfflineRenderer surround = OfflineRenderer("OfflineTestSynth", 6);
+  XCTAssertEqual(surround.numChannels(), (unsigned int)6, @"Any number of channels should be rendered");
+  SampleTable surroundTable = surround.renderToSampleTable(0.01);
+  XCTAssertEqualWithAccuracy(surroundTable.channelPointer(1)[25], 0.5f, 1.e-3f, @"The synth's channels should come first");
+  XCTAssertEqual(surroundTable.channelPointer(5)[25], 0.f, @"Channels the synth doesn't have should be silent");
+
+  // which as a WAV file takes WAVE_FORMAT_EXTENSIBLE, six channels being 5.1
+  string path = [[NSTemporaryDirectory() stringByAppendingPathComponent:@"test326.wav"] UTF8String];
+  surround.renderToWavFile(path, 0.01);
+  unsigned char header[80];
+  FILE *file = fopen(path.c_str(), "rb");
+  XCTAssertEqual(fread(header, 1, sizeof(header), file), sizeof(header), @"The WAV file should have a whole header");
+  fseek(file, 0, SEEK_END);
+  const long fileBytes = ftell(file);
+  fclose(file);
+  remove(path.c_str());
+  XCTAssertTrue(header[20] == 0xFE && header[21] == 0xFF && header[22] == 6, @"The format should be WAVE_FORMAT_EXTENSIBLE with six channels");
+  XCTAssertEqual(header[40], 0x3F, @"The channel mask should be 5.1");
+  XCTAssertEqual(header[44], 3, @"The sub-format should be float");
+  const long dataBytes = header[76] | (header[77] << 8) | (header[78] << 16) | (header[79] << 24);
+  XCTAssertEqual(dataBytes, 441L * 6 * sizeof(float), @"The data chunk should hold every sample");
+  XCTAssertEqual(fileBytes, 80 + dataBytes, @"The data should follow the header");
+
+  // a misspelled synth is an error, not a silent render
+  OfflineRenderer missing = OfflineRenderer("NoSuchSynth");
+  XCTAssertFalse(missing.isValid(), @"An unregistered synth name should make an invalid renderer");
+  vector<TonicFloat> untouched(200, 2.f);
+  XCTAssertEqual(missing.renderInterleaved(&untouched[0], 100).frames, 0UL, @"An invalid renderer should render nothing");
+  XCTAssertEqual(untouched[0], 2.f, @"An invalid renderer should leave the buffer alone");
+}
+
 #pragma mark operator tests
 
 -(void)test400CombineGeneratorControlGenerator{
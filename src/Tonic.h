@@ -21,6 +21,9 @@
 // ------- Core Objects --------
 
 #include "Tonic/TonicCore.h"
+#include "Tonic/VectorKernels.h"
+#include "Tonic/DSPUtils.h"
+#include "Tonic/BufferPool.h"
 #include "Tonic/TonicFrames.h"
 #include "Tonic/SampleTable.h"
 #include "Tonic/FixedValue.h"
@@ -34,12 +37,15 @@
 #include "Tonic/RampedValue.h"
 #include "Tonic/Synth.h"
 #include "Tonic/Mixer.h"
+#include "Tonic/PolySynth.h"
 
 // -------- Generators ---------
 
 // Oscillators
 #include "Tonic/TableLookupOsc.h"
 #include "Tonic/SineWave.h"
+#include "Tonic/OscillatorBank.h"
+#include "Tonic/WavetableOsc.h"
 
 #include "Tonic/SawtoothWave.h"   // Aliasing
 #include "Tonic/TriangleWave.h"   // Aliasing
@@ -54,6 +60,7 @@
 #include "Tonic/StereoDelay.h"
 #include "Tonic/BasicDelay.h"
 #include "Tonic/Reverb.h"
+#include "Tonic/ConvolutionReverb.h"
 #include "Tonic/FilterUtils.h"
 #include "Tonic/DelayUtils.h"
 #include "Tonic/Reverb.h"
@@ -63,6 +70,8 @@
 #include "Tonic/ADSR.h"
 #include "Tonic/RingBuffer.h"
 #include "Tonic/LFNoise.h"
+#include "Tonic/RealtimeCheck.h"
+#include "Tonic/Profiler.h"
 
 // Non-Oscillator Audio Sources
 #include "Tonic/BufferPlayer.h"
@@ -90,5 +99,7 @@
 // -------- Util ---------
 
 #include "Tonic/AudioFileUtils.h"
+#include "Tonic/OfflineRenderer.h"
+#include "Tonic/SessionHost.h"
 
 #endif
@@ -83,6 +83,9 @@ namespace Tonic {
       //! Controls whether or not the envelope pauses on the SUSTAIN stage
       void setDoesSustain(ControlGenerator gen){doesSustain = gen;};
       
+      //! True until first triggered, and again once fully released
+      bool isIdle() const {return state == NEUTRAL;}
+      
     };
     
     inline void ADSR_::computeSynthesisBlock(const SynthesisContext_ &context){
@@ -102,6 +105,9 @@ namespace Tonic {
       
       TonicFloat * fdata = &outputFrames_[0];
       
+      // idle for the whole block means the block is all zeros
+      const bool wasIdle = (state == NEUTRAL);
+      
       if(triggerOutput.triggered){
         
         if(triggerOutput.value != 0){
@@ -112,7 +118,16 @@ namespace Tonic {
         
       }
       
-      int samplesRemaining = kSynthesisBlockSize;
+      int samplesRemaining = outputFrames_.frames();
+      
+      // idle or sustaining for the whole block - a constant, only rewritten when it changes
+      if (state == NEUTRAL || state == SUSTAIN){
+        fillConstant(lastValue);
+        samplesRemaining = 0;
+      }
+      else{
+        isConstant_ = false;
+      }
       
       while (samplesRemaining > 0)
       {
@@ -233,6 +248,8 @@ namespace Tonic {
         
       }
       
+      isSilent_ = wasIdle && state == NEUTRAL;
+      
     }
     
   }
@@ -258,6 +275,9 @@ namespace Tonic {
       TONIC_MAKE_CTRL_GEN_SETTERS(ADSR, exponential, setIsExponential);
       TONIC_MAKE_CTRL_GEN_SETTERS(ADSR, doesSustain, setDoesSustain);
       TONIC_MAKE_CTRL_GEN_SETTERS(ADSR, legato, setIsLegato);
+    
+      //! True before the envelope is first triggered, and from the end of its release until the next trigger
+      bool isIdle(){ return gen()->isIdle(); }
 
   };
   
@@ -23,15 +23,15 @@ namespace Tonic{ namespace Tonic_ {
   
   void Adder_::input(Generator generator){
     inputs_.push_back( generator );
-    if ( generator.isStereoOutput() && !this->isStereoOutput() ){
-      setIsStereoOutput(true);
+    if ( generator.numOutputChannels() > numOutputChannels() ){
+      setNumOutputChannels(generator.numOutputChannels());
     }
   }
   
-  void Adder_::setIsStereoOutput( bool stereo )
+  void Adder_::setNumOutputChannels( unsigned int numChannels )
   {
-    Generator_::setIsStereoOutput(stereo);
-    workSpace_.resize(kSynthesisBlockSize, stereo ? 2 : 1, 0);
+    Generator_::setNumOutputChannels(numChannels);
+    workSpace_.resize(workSpace_.frames(), numChannels, 0);
   }
 
   
@@ -44,25 +44,23 @@ namespace Tonic{ namespace Tonic_ {
   }
   
   void Subtractor_::setLeft(Generator arg){
-    if (arg.isStereoOutput() && !isStereoOutput())
-    {
-      setIsStereoOutput(true);
+    if ( arg.numOutputChannels() > numOutputChannels() ){
+      setNumOutputChannels(arg.numOutputChannels());
     }
     left_ = arg;
   }
   
   void Subtractor_::setRight(Generator arg){
-    if (arg.isStereoOutput() && !isStereoOutput())
-    {
-      setIsStereoOutput(true);
+    if ( arg.numOutputChannels() > numOutputChannels() ){
+      setNumOutputChannels(arg.numOutputChannels());
     }
     right_ = arg;
   }
   
-  void Subtractor_::setIsStereoOutput( bool stereo )
+  void Subtractor_::setNumOutputChannels( unsigned int numChannels )
   {
-    Generator_::setIsStereoOutput(stereo);
-    workSpace_.resize(kSynthesisBlockSize, stereo ? 2 : 1, 0);
+    Generator_::setNumOutputChannels(numChannels);
+    workSpace_.resize(workSpace_.frames(), numChannels, 0);
   }
 
   
@@ -76,15 +74,15 @@ namespace Tonic{ namespace Tonic_ {
   
   void Multiplier_::input(Generator generator){
     inputs_.push_back(generator);
-    if ( generator.isStereoOutput() && !isStereoOutput() ){
-      setIsStereoOutput(true);
+    if ( generator.numOutputChannels() > numOutputChannels() ){
+      setNumOutputChannels(generator.numOutputChannels());
     }
   }
   
-  void Multiplier_::setIsStereoOutput( bool stereo )
+  void Multiplier_::setNumOutputChannels( unsigned int numChannels )
   {
-    Generator_::setIsStereoOutput(stereo);
-    workSpace_.resize(kSynthesisBlockSize, stereo ? 2 : 1, 0);
+    Generator_::setNumOutputChannels(numChannels);
+    workSpace_.resize(workSpace_.frames(), numChannels, 0);
   }
   
   
@@ -97,25 +95,23 @@ namespace Tonic{ namespace Tonic_ {
   }
   
   void Divider_::setLeft(Generator arg){
-    if (arg.isStereoOutput() && !isStereoOutput())
-    {
-      setIsStereoOutput(true);
+    if ( arg.numOutputChannels() > numOutputChannels() ){
+      setNumOutputChannels(arg.numOutputChannels());
     }
     left_ = arg;
   }
   
   void Divider_::setRight(Generator arg){
-    if (arg.isStereoOutput() && !isStereoOutput())
-    {
-      setIsStereoOutput(true);
+    if ( arg.numOutputChannels() > numOutputChannels() ){
+      setNumOutputChannels(arg.numOutputChannels());
     }
     right_ = arg;
   }
   
-  void Divider_::setIsStereoOutput( bool stereo )
+  void Divider_::setNumOutputChannels( unsigned int numChannels )
   {
-    Generator_::setIsStereoOutput(stereo);
-    workSpace_.resize(kSynthesisBlockSize, stereo ? 2 : 1, 0);
+    Generator_::setNumOutputChannels(numChannels);
+    workSpace_.resize(workSpace_.frames(), numChannels, 0);
   }
   
 }}
\ No newline at end of file
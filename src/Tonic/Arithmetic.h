@@ -35,7 +35,7 @@ namespace Tonic {
       Adder_();
       
       void input(Generator generator);
-      void setIsStereoOutput( bool stereo );
+      void setNumOutputChannels( unsigned int numChannels );
       
       Generator getInput(unsigned int index) { return inputs_[index]; };
       unsigned int numInputs() { return (unsigned int)inputs_.size(); };
@@ -44,17 +44,48 @@ namespace Tonic {
     
     inline void Adder_::computeSynthesisBlock( const SynthesisContext_ &context ){
       
-      TonicFloat *framesData =  &outputFrames_[0];
-      
-      memset(framesData, 0, sizeof(TonicFloat) * outputFrames_.size());
+      // Constant inputs are summed as scalars until the first input which varies, which is copied straight
+      // into the output. After that they're added with a scalar kernel. If nothing varies, neither does the sum.
+      TonicFloat offset = 0;
+      bool varies = false;
+      bool silent = true;
       
       for (int j =0; j < inputs_.size(); j++) {
-        inputs_[j].tick(workSpace_, context);
-        outputFrames_ += workSpace_; // add each sample in frames to each sample in workspace
+        // workSpace_ is only written if the input's channel layout differs from ours
+        const TonicFrames & inputFrames = inputs_[j].tick(context, workSpace_);
+        
+        // nothing to add
+        if (inputs_[j].isSilent()) continue;
+        
+        silent = false;
+        
+        if (inputs_[j].isConstant()){
+          if (varies){
+            outputFrames_ += inputFrames[0];
+          }
+          else{
+            offset += inputFrames[0];
+          }
+        }
+        else if (varies){
+          outputFrames_ += inputFrames;
+        }
+        else{
+          outputFrames_.copy(inputFrames);
+          if (offset != 0) outputFrames_ += offset;
+          isConstant_ = false;
+          varies = true;
+        }
+      }
+      
+      if (!varies){
+        fillConstant(offset);
       }
       
+      isSilent_ = silent;
+      
     }
-	
+    
   }
   
   class Adder : public TemplatedGenerator<Tonic_::Adder_>{
@@ -143,14 +174,33 @@ namespace Tonic {
       
       void setLeft(Generator arg);
       void setRight(Generator arg);
-      void setIsStereoOutput( bool stereo );
+      void setNumOutputChannels( unsigned int numChannels );
       
     };
     
     inline void Subtractor_::computeSynthesisBlock(const SynthesisContext_ &context){
-      left_.tick(outputFrames_, context);
-      right_.tick(workSpace_, context);
-      outputFrames_ -= workSpace_;
+      
+      const TonicFrames & leftFrames = left_.tick(context, workSpace_);
+      TonicFloat leftValue = leftFrames[0];
+      bool leftIsConstant = left_.isConstant();
+      if (!leftIsConstant){
+        outputFrames_.copy(leftFrames);
+      }
+      
+      const TonicFrames & rightFrames = right_.tick(context, workSpace_);
+      
+      if (!right_.isConstant()){
+        if (leftIsConstant) outputFrames_.fill(leftValue);
+        outputFrames_ -= rightFrames;
+        isConstant_ = false;
+      }
+      else if (leftIsConstant){
+        fillConstant(leftValue - rightFrames[0]);
+      }
+      else{
+        outputFrames_ -= rightFrames[0];
+        isConstant_ = false;
+      }
     }
     
   }
@@ -215,7 +265,7 @@ namespace Tonic {
       Multiplier_();
       
       void input(Generator generator);
-      void setIsStereoOutput( bool stereo );
+      void setNumOutputChannels( unsigned int numChannels );
       
       Generator getInput(unsigned int index) { return inputs_[index]; };
       unsigned int numInputs() { return (unsigned int)inputs_.size(); };
@@ -225,15 +275,74 @@ namespace Tonic {
     
     inline void Multiplier_::computeSynthesisBlock( const SynthesisContext_ & context ){
       
-      memset(&outputFrames_[0], 0, sizeof(TonicFloat) * outputFrames_.size());
+      // Inputs which were silent last block (typically envelopes between notes) are ticked first. If one still is,
+      // so is the product - and when skipping silence, the other inputs don't need computing at all.
+      bool silent = false;
+      unsigned int numTicked = 0;
+      for (int i = 0; i < inputs_.size() && !silent; i++){
+        if (inputs_[i].isSilent()){
+          inputs_[i].tick(context);
+          silent = inputs_[i].isSilent();
+          numTicked++;
+        }
+      }
+      
+      if (silent){
+        if (context.skipSilence){
+          for (unsigned int i = numTicked; i < inputs_.size(); i++){
+            context.countSkippedNode();
+          }
+        }
+        else{
+          // keep every input in step
+          for (int i = 0; i < inputs_.size(); i++){
+            inputs_[i].tick(context);
+          }
+        }
+        fillConstant(0);
+        isSilent_ = true;
+        return;
+      }
       
-      // for the first generator, store the value in the block
-      inputs_[0].tick(outputFrames_, context);
+      isSilent_ = false;
+      
+      // Constant inputs (typically gains) are multiplied as scalars until the first input which varies, which is
+      // scaled straight into the output. After that they're applied with a scalar kernel.
+      TonicFloat gain = 1;
+      bool scaled = false;
+      bool varies = false;
+      
+      // multiply in each generator's output directly, converting in workSpace_ only if channel layouts differ
+      for(int i = 0; i < inputs_.size(); i++) {
+        
+        const TonicFrames & inputFrames = inputs_[i].tick(context, workSpace_);
+        
+        if (inputs_[i].isConstant()){
+          if (varies){
+            outputFrames_ *= inputFrames[0];
+          }
+          else{
+            gain = scaled ? gain * inputFrames[0] : inputFrames[0];
+            scaled = true;
+          }
+        }
+        else if (varies){
+          outputFrames_ *= inputFrames;
+        }
+        else{
+          if (scaled){
+            outputFrames_.copyScaled(inputFrames, gain);
+          }
+          else{
+            outputFrames_.copy(inputFrames);
+          }
+          isConstant_ = false;
+          varies = true;
+        }
+      }
       
-      // for additional generators, use the workspace stkframes for tick, and multiply it into the frames argument
-      for(int i = 1; i < inputs_.size(); i++) {
-        inputs_[i].tick(workSpace_, context);
-        outputFrames_ *= workSpace_;
+      if (!varies){
+        fillConstant(gain);
       }
       
     }
@@ -314,14 +423,33 @@ namespace Tonic {
       
       void setLeft(Generator arg);
       void setRight(Generator arg);
-      void setIsStereoOutput( bool stereo );
+      void setNumOutputChannels( unsigned int numChannels );
       
     };
     
     inline void Divider_::computeSynthesisBlock(const SynthesisContext_ &context){
-      left_.tick(outputFrames_, context);
-      right_.tick(workSpace_, context);
-      outputFrames_ /= workSpace_;
+      
+      const TonicFrames & leftFrames = left_.tick(context, workSpace_);
+      TonicFloat leftValue = leftFrames[0];
+      bool leftIsConstant = left_.isConstant();
+      if (!leftIsConstant){
+        outputFrames_.copy(leftFrames);
+      }
+      
+      const TonicFrames & rightFrames = right_.tick(context, workSpace_);
+      
+      if (!right_.isConstant()){
+        if (leftIsConstant) outputFrames_.fill(leftValue);
+        outputFrames_ /= rightFrames;
+        isConstant_ = false;
+      }
+      else if (leftIsConstant){
+        fillConstant(leftValue / rightFrames[0]);
+      }
+      else{
+        outputFrames_ /= rightFrames[0];
+        isConstant_ = false;
+      }
       
     }
     
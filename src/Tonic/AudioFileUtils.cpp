@@ -53,10 +53,11 @@ namespace Tonic {
     memset(&outputFormat, 0, sizeof(outputFormat));
     outputFormat.mSampleRate = 44100.0;
     outputFormat.mFormatID = kAudioFormatLinearPCM;
-    outputFormat.mFormatFlags = kAudioFormatFlagIsFloat;
-    outputFormat.mBytesPerPacket = BYTES_PER_SAMPLE * numChannels;
+    // non-interleaved, to match SampleTable's layout of one channel after another
+    outputFormat.mFormatFlags = kAudioFormatFlagIsFloat | kAudioFormatFlagIsNonInterleaved;
+    outputFormat.mBytesPerPacket = BYTES_PER_SAMPLE;
     outputFormat.mFramesPerPacket = 1;
-    outputFormat.mBytesPerFrame = BYTES_PER_SAMPLE * numChannels;
+    outputFormat.mBytesPerFrame = BYTES_PER_SAMPLE;
     outputFormat.mChannelsPerFrame = numChannels;
     outputFormat.mBitsPerChannel = 32;
     OSStatus error = ExtAudioFileSetProperty(inputFile, kExtAudioFileProperty_ClientDataFormat, sizeof(AudioStreamBasicDescription), &outputFormat);
@@ -71,16 +72,19 @@ namespace Tonic {
     // change sampleTable numframes to long long
     SampleTable destinationTable = SampleTable((int)numFrames, numChannels);
     
-    // wrap the destination buffer in an AudioBufferList
-    AudioBufferList convertedData;
-    convertedData.mNumberBuffers = 1;
-    convertedData.mBuffers[0].mNumberChannels = outputFormat.mChannelsPerFrame;
-    convertedData.mBuffers[0].mDataByteSize = (UInt32)destinationTable.size() * BYTES_PER_SAMPLE;
-    convertedData.mBuffers[0].mData = destinationTable.dataPointer();
+    // wrap each channel of the destination table in an AudioBufferList
+    AudioBufferList *convertedData = (AudioBufferList*)malloc(offsetof(AudioBufferList, mBuffers) + numChannels * sizeof(AudioBuffer));
+    convertedData->mNumberBuffers = numChannels;
+    for (int c=0; c<numChannels; c++){
+      convertedData->mBuffers[c].mNumberChannels = 1;
+      convertedData->mBuffers[c].mDataByteSize = (UInt32)destinationTable.frames() * BYTES_PER_SAMPLE;
+      convertedData->mBuffers[c].mData = destinationTable.channelPointer(c);
+    }
     
     UInt32 numFrames32 = (UInt32)numFrames;
-    ExtAudioFileRead(inputFile, &numFrames32, &convertedData);
+    ExtAudioFileRead(inputFile, &numFrames32, convertedData);
     
+    free(convertedData);
     ExtAudioFileDispose(inputFile);
     
     return destinationTable;
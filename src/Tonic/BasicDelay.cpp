@@ -25,11 +25,11 @@ namespace Tonic { namespace Tonic_{
   
   void BasicDelay_::setInput(Generator input){
     Effect_::setInput(input);
-    setIsStereoInput(input.isStereoOutput());
-    setIsStereoOutput(input.isStereoOutput());
+    setNumInputChannels(input.numOutputChannels());
+    setNumOutputChannels(input.numOutputChannels());
     
     // can safely resize as TonicFrames subclass - calling functions account for channel offset
-    delayLine_.resize(delayLine_.frames(), input.isStereoOutput() ? 2 : 1, 0);
+    delayLine_.resize(delayLine_.frames(), input.numOutputChannels(), 0);
   }
   
   void BasicDelay_::initialize(float delayTime, float maxDelayTime)
@@ -39,6 +39,12 @@ namespace Tonic { namespace Tonic_{
     delayTimeGen_ = FixedValue(delayTime);
   }
   
+  void BasicDelay_::setSampleRate(TonicFloat sampleRate)
+  {
+    WetDryEffect_::setSampleRate(sampleRate);
+    delayLine_.setSampleRate(sampleRate);
+  }
+  
 } // Namespace Tonic_
   
   BasicDelay::BasicDelay(float initialDelayTime, float maxDelayTime){
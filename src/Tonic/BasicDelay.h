@@ -33,6 +33,11 @@ namespace Tonic {
       
       void computeSynthesisBlock( const SynthesisContext_ &context );
       
+      unsigned long tailFrames( const SynthesisContext_ &context ){
+        const TonicFrames & fbkFrames = fbkGen_.tick(context, fbkFrames_);
+        return delayLine_.tailFrames(fbkFrames(fbkFrames.frames()-1, 0));
+      };
+      
     public:
       
       BasicDelay_();
@@ -43,6 +48,8 @@ namespace Tonic {
       
       void initialize(float delayTime, float maxDelayTime);
       
+      void setSampleRate( TonicFloat sampleRate );
+      
       void setDelayTimeGen( Generator gen ) { delayTimeGen_ = gen; };
             
       void setFeedbackGen( Generator gen ) { fbkGen_ = gen; };
@@ -51,30 +58,33 @@ namespace Tonic {
     
     inline void BasicDelay_::computeSynthesisBlock(const SynthesisContext_ &context){
       
-      delayTimeGen_.tick(delayTimeFrames_, context);
-      fbkGen_.tick(fbkFrames_, context);
+      // read modulations in place. Constant ones are read from their first sample throughout.
+      const TonicFloat *delptr = delayTimeGen_.tick(context, delayTimeFrames_).data();
+      const TonicFloat *fbkptr = fbkGen_.tick(context, fbkFrames_).data();
+      const unsigned int delStride = delayTimeGen_.isConstant() ? 0 : 1;
+      const unsigned int fbkStride = fbkGen_.isConstant() ? 0 : 1;
       
       // input->output always has same channel layout
-      unsigned int nChannels = isStereoInput() ? 2 : 1;
+      unsigned int nChannels = numInputChannels();
       
       TonicFloat fbk, outSamp;
-      TonicFloat *dryptr = &dryFrames_[0];
+      const TonicFloat *dryptr = dryInput_->data();
       TonicFloat *outptr = &outputFrames_[0];
-      TonicFloat *fbkptr = &fbkFrames_[0];
-      TonicFloat *delptr = &delayTimeFrames_[0];
+      const unsigned long nFrames = outputFrames_.frames();
       
-      for (unsigned int i=0; i<kSynthesisBlockSize; i++){
+      for (unsigned int i=0; i<nFrames; i++){
         
         // Don't clamp feeback - be careful! Negative feedback could be interesting.
-        fbk = *fbkptr++;
+        fbk = *fbkptr;
+        fbkptr += fbkStride;
         
         for (unsigned int c=0; c<nChannels; c++){
           outSamp = delayLine_.tickOut(*delptr, c);
-          delayLine_.tickIn(*dryptr++ + outSamp * fbk, c);
-          *outptr++ = outSamp;
+          delayLine_.tickIn(dryptr[c*nFrames + i] + outSamp * fbk, c);
+          outptr[c*nFrames + i] = outSamp;
         }
         
-        delptr++;
+        delptr += delStride;
         delayLine_.advance();
       }
     }
@@ -17,16 +17,12 @@ namespace Tonic{
     
       void BitCrusher_::setInput( Generator input ) {
         input_ = input;
-        setIsStereoInput(input_.isStereoOutput());
+        setNumInputChannels(input_.numOutputChannels());
       };
     
-      void BitCrusher_::setIsStereoInput( bool stereo ) {
-        if (stereo != isStereoInput_){
-          dryFrames_.resize(kSynthesisBlockSize, stereo ? 2 : 1, 0);
-          outputFrames_.resize(kSynthesisBlockSize, stereo ? 2 : 1, 0);
-        }
-        isStereoInput_ = stereo;
-        isStereoOutput_ = stereo;
+      void BitCrusher_::setNumInputChannels( unsigned int numChannels ) {
+        Effect_::setNumInputChannels(numChannels);
+        setNumOutputChannels(numChannels);
       };
     
       void BitCrusher_::setBitDepth(ControlGenerator bitDepthArg){
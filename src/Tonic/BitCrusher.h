@@ -29,14 +29,14 @@ namespace Tonic {
       BitCrusher_();
       void setBitDepth(ControlGenerator);
       void setInput( Generator input );
-      void setIsStereoInput(bool stereo);
+      void setNumInputChannels(unsigned int numChannels);
       
     };
     
     inline void BitCrusher_::computeSynthesisBlock(const SynthesisContext_ &context){
       
       TonicFloat *synthBlockWriteHead = &outputFrames_[0];
-      TonicFloat *dryFramesReadHead = &dryFrames_[0];
+      const TonicFloat *dryFramesReadHead = dryInput_->data();
       
       unsigned int nSamples = (unsigned int)outputFrames_.size();
       float bitDepthValue = clamp(bitDepth.tick(context).value, 0, 16) ;
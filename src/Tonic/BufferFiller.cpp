@@ -15,13 +15,189 @@ namespace Tonic {
   
   namespace Tonic_{
     
-    BufferFiller_::BufferFiller_() :  bufferReadPosition_(0) {
-      TONIC_MUTEX_INIT(mutex_);
+    BufferFiller_::BufferFiller_() :
+      bufferReadPosition_(0),
+      commandHead_(&stubCommand_),
+      commandTail_(&stubCommand_),
+      commandFirst_(&stubCommand_),
+      resetBlockTimingStats_(false),
+      skippedNodes_(0),
+      compiled_(false),
+      scheduleRunning_(false),
+      sampleRateSetting_(Tonic::sampleRate())
+#ifdef TONIC_PROFILE
+      , profileBlockCounter_(0)
+#endif
+    {
+      TONIC_MUTEX_INIT(producerMutex_);
       setIsStereoOutput(true);
+      // nested BufferFillers render with the outer context, so count into the outermost one
+      synthContext_.skippedNodes = &skippedNodes_;
+      startReclaimerThread();
     }
     
     BufferFiller_::~BufferFiller_(){
-      TONIC_MUTEX_DESTROY(mutex_);
+      // nothing can be rendering now, so every command can go, executed or not
+      BufferFillerCommand_ * command = commandFirst_;
+      while (command){
+        BufferFillerCommand_ * next = command->next_;
+        if (command != &stubCommand_) delete command;
+        command = next;
+      }
+      TONIC_MUTEX_DESTROY(producerMutex_);
+    }
+    
+    void BufferFiller_::postCommand(BufferFillerCommand_ * command){
+      TONIC_MUTEX_LOCK(producerMutex_);
+      freeExecutedCommands();
+      command->next_ = NULL;
+      TONIC_ATOMIC_STORE(commandTail_->next_, command);
+      commandTail_ = command;
+      TONIC_MUTEX_UNLOCK(producerMutex_);
+      reclaimDeferredDeletions();
+    }
+    
+    void BufferFiller_::collectGarbage(){
+      TONIC_MUTEX_LOCK(producerMutex_);
+      freeExecutedCommands();
+      TONIC_MUTEX_UNLOCK(producerMutex_);
+      reclaimDeferredDeletions();
+    }
+    
+    void BufferFiller_::freeExecutedCommands(){
+      // The audio thread may still follow commandHead_->next_, so the head itself has to stay
+      BufferFillerCommand_ * head = TONIC_ATOMIC_LOAD(commandHead_);
+      while (commandFirst_ != head){
+        BufferFillerCommand_ * next = commandFirst_->next_;
+        if (commandFirst_ != &stubCommand_) delete commandFirst_;
+        commandFirst_ = next;
+      }
+    }
+    
+    class ForceNewOutputCommand_ : public BufferFillerCommand_ {
+      
+      SynthesisContext_ * context_;
+      
+    public:
+      
+      ForceNewOutputCommand_(SynthesisContext_ * context) : context_(context) {}
+      
+      void execute(){ context_->forceNewOutput = true; }
+      
+    };
+    
+    void BufferFiller_::forceNewOutput(){
+      postCommand(new ForceNewOutputCommand_(&synthContext_));
+    }
+    
+    // Installs schedule storage allocated off the audio thread
+    class CompileCommand_ : public BufferFillerCommand_ {
+      
+      BufferFiller_ * bufferFiller_;
+      GraphSchedule_ schedule_;
+      
+    public:
+      
+      CompileCommand_(BufferFiller_ * bufferFiller, unsigned int maxNodes) : bufferFiller_(bufferFiller) {
+        schedule_.reserve(maxNodes);
+      }
+      
+      void execute(){
+        bufferFiller_->schedule_.swap(schedule_);
+        bufferFiller_->compiled_ = bufferFiller_->schedule_.capacity() > 0;
+      }
+      
+    };
+    
+    void BufferFiller_::compile(unsigned int maxNodes){
+      postCommand(new CompileCommand_(this, maxNodes));
+    }
+    
+    class SetBlockSizeCommand_ : public BufferFillerCommand_ {
+      
+      SynthesisContext_ * context_;
+      unsigned int blockSize_;
+      
+    public:
+      
+      SetBlockSizeCommand_(SynthesisContext_ * context, unsigned int blockSize) : context_(context), blockSize_(blockSize) {}
+      
+      void execute(){ context_->blockSize = blockSize_; }
+      
+    };
+    
+    void BufferFiller_::setSynthesisBlockSize(unsigned int blockSize){
+      if (blockSize == 0){
+        error("BufferFiller::setBlockSize - block size must be at least one frame");
+        return;
+      }
+      // so generators can get ready for it here, rather than on the audio thread
+      announceBlockSize(blockSize);
+      postCommand(new SetBlockSizeCommand_(&synthContext_, blockSize));
+    }
+    
+    class SetSampleRateCommand_ : public BufferFillerCommand_ {
+      
+      SynthesisContext_ * context_;
+      TonicFloat sampleRate_;
+      
+    public:
+      
+      SetSampleRateCommand_(SynthesisContext_ * context, TonicFloat sampleRate) : context_(context), sampleRate_(sampleRate) {}
+      
+      void execute(){
+        context_->sampleRate = sampleRate_;
+        // keep elapsedTime consistent with the new rate
+        context_->elapsedTime = (double)context_->elapsedFrames / sampleRate_;
+      }
+      
+    };
+    
+    void BufferFiller_::setSynthesisSampleRate(TonicFloat sampleRate){
+      if (!(sampleRate > 0)){
+        error("BufferFiller::setSampleRate - sample rate must be greater than zero");
+        return;
+      }
+      sampleRateSetting_ = sampleRate;
+      postCommand(new SetSampleRateCommand_(&synthContext_, sampleRate));
+    }
+    
+    class SetNumChannelsCommand_ : public BufferFillerCommand_ {
+      
+      BufferFiller_ * bufferFiller_;
+      unsigned int numChannels_;
+      
+    public:
+      
+      SetNumChannelsCommand_(BufferFiller_ * bufferFiller, unsigned int numChannels) : bufferFiller_(bufferFiller), numChannels_(numChannels) {}
+      
+      void execute(){ bufferFiller_->setNumOutputChannels(numChannels_); }
+      
+    };
+    
+    void BufferFiller_::setSynthesisNumChannels(unsigned int numChannels){
+      if (numChannels == 0){
+        error("BufferFiller::setNumChannels - there must be at least one channel");
+        return;
+      }
+      postCommand(new SetNumChannelsCommand_(this, numChannels));
+    }
+    
+    class SetSkipSilenceCommand_ : public BufferFillerCommand_ {
+      
+      SynthesisContext_ * context_;
+      bool skipSilence_;
+      
+    public:
+      
+      SetSkipSilenceCommand_(SynthesisContext_ * context, bool skipSilence) : context_(context), skipSilence_(skipSilence) {}
+      
+      void execute(){ context_->skipSilence = skipSilence_; }
+      
+    };
+    
+    void BufferFiller_::setSkipSilence(bool skipSilence){
+      postCommand(new SetSkipSilenceCommand_(&synthContext_, skipSilence));
     }
     
   }
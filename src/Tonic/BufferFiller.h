@@ -18,32 +18,155 @@ namespace Tonic{
   
   namespace Tonic_ {
     
+    //! Deferred change to a BufferFiller's synthesis graph, executed on the audio thread
+    /*!
+        Commands are queued with BufferFiller_::postCommand and executed in order at the start of
+        the next synthesis block. execute() must not block, allocate or free memory - typically it
+        just swaps a value prepared on the posting thread into place. Whatever it swaps out is
+        destroyed with the command, later, on a non-audio thread.
+     */
+    class BufferFillerCommand_ {
+      
+      friend class BufferFiller_;
+      
+    public:
+      
+      BufferFillerCommand_() : next_(NULL) {}
+      virtual ~BufferFillerCommand_() {}
+      
+      virtual void execute() {}
+      
+    private:
+      
+      BufferFillerCommand_ * next_;
+      
+    };
+    
+    //! Command which exchanges *target with a prepared value
+    /*!
+        T must provide a swap() which neither allocates nor frees, such as std::vector or TonicSmartPointer.
+        The previous contents of *target are released when the command is destroyed.
+     */
+    template<class T>
+    class SwapCommand_ : public BufferFillerCommand_ {
+      
+    protected:
+      
+      T * target_;
+      T   value_;
+      
+    public:
+      
+      SwapCommand_(T * target, const T & value) : target_(target), value_(value) {}
+      
+      void execute(){ target_->swap(value_); }
+      
+    };
+    
+    //! Time spent rendering synthesis blocks, and work skipped because of silence
+    struct BlockTimingStats {
+      
+      unsigned long blocks;
+      double        totalSeconds;
+      double        maxSeconds;
+      
+      //! Generators (each with everything upstream of it) not computed because they were silent
+      unsigned long skippedNodes;
+      unsigned long lastBlockSkippedNodes;
+      
+      BlockTimingStats() : blocks(0), totalSeconds(0), maxSeconds(0), skippedNodes(0), lastBlockSkippedNodes(0) {}
+      
+      double meanSeconds() const { return blocks > 0 ? totalSeconds / blocks : 0; }
+      
+      double meanSkippedNodes() const { return blocks > 0 ? (double)skippedNodes / blocks : 0; }
+      
+    };
+    
     //! Base class for any generator expected to produce output for a buffer fill.
     /*!
      BufferFillers provide a high-level interface for combinations of generators, and can be used to fill
      arbitraryly large buffers.
      
      Subclasses to include mixer, channel, synth, etc.
+     
+     The audio thread never takes a lock. Changes to the graph are posted as commands to an intrusive
+     single-producer/single-consumer queue which is drained at the start of each block. Executed commands,
+     along with anything they replaced, are freed by the next postCommand() or collectGarbage() call.
+     
+     Nor does it free memory: objects whose last reference is dropped while rendering are queued with
+     deferDeletion() and deleted by a background thread (C++11), or by the next postCommand() or collectGarbage().
      */
     class BufferFiller_ : public Generator_ {
       
     private:
       
       unsigned long               bufferReadPosition_;
-      TONIC_MUTEX_T               mutex_;
+      
+      // Serialises posting threads against each other. Never taken by the audio thread.
+      TONIC_MUTEX_T               producerMutex_;
+      
+      // commandHead_ is the last command executed by the audio thread (initially the stub).
+      // Everything from commandFirst_ up to, but not including, commandHead_ can be freed.
+      BufferFillerCommand_        stubCommand_;
+      BufferFillerCommand_        *commandHead_;
+      BufferFillerCommand_        *commandTail_;
+      BufferFillerCommand_        *commandFirst_;
+      
+      BlockTimingStats            blockTimingStats_;
+      bool                        resetBlockTimingStats_;
+      
+      // Generators skipped for silence in the block being rendered (see SynthesisContext_::skippedNodes)
+      unsigned long               skippedNodes_;
+      
+      // Flattened graph, re-recorded after every graph change while compiled_ is set
+      GraphSchedule_              schedule_;
+      bool                        compiled_;
+      bool                        scheduleRunning_;
+      
+      // Most recent rate passed to setSynthesisSampleRate. Only touched by posting threads.
+      TonicFloat                  sampleRateSetting_;
+      
+#ifdef TONIC_PROFILE
+      // blocks rendered, for sampling which are profiled
+      unsigned long               profileBlockCounter_;
+#endif
+      
+      friend class CompileCommand_;
+      
+      void freeExecutedCommands();
+      
+      //! Render the next block into outputFrames_, with timing
+      void renderBlock();
+      
+      //! Frames available to copy from outputFrames_, up to numFrames, rendering a new block first if needed
+      unsigned int nextOutputFrames(unsigned int numFrames);
+      
+      //! Mark numFrames of outputFrames_ as read
+      void advanceOutput(unsigned int numFrames);
       
     protected:
       
       Tonic_::SynthesisContext_   synthContext_;
       
+      //! Execute commands posted since the last block. Audio thread only.
+      void executePendingCommands();
+      
+      //! Hold off posting and garbage collection, e.g. while reading state a command might free. Never call on the audio thread.
+      void lockCommandQueue() { TONIC_MUTEX_LOCK(producerMutex_); }
+      void unlockCommandQueue() { TONIC_MUTEX_UNLOCK(producerMutex_); }
+      
     public:
       
       BufferFiller_();
       ~BufferFiller_();
       
-      // mutex for swapping inputs, etc
-      void lockMutex();
-      void unlockMutex();
+      //! Queue a command for execution on the audio thread. Takes ownership of command.
+      void postCommand(BufferFillerCommand_ * command);
+      
+      //! Free executed commands and whatever they replaced. Never call from the audio thread.
+      void collectGarbage();
+      
+      using Generator_::tick;
       
       //! Process a single synthesis vector, output to frames
       /*!
@@ -51,23 +174,153 @@ namespace Tonic{
        */
       void tick( TonicFrames& frames );
       
+      //! Applies pending commands first, so nested BufferFillers (e.g. mixer inputs) pick up changes too
+      /*!
+          Nested BufferFillers are opaque to an enclosing schedule - they are not recorded, and keep their own.
+       */
+      void updateOutput( const SynthesisContext_ &context );
+      
       void fillBufferOfFloats(float *outData,  unsigned int numFrames, unsigned int numChannels);
+      
+      void fillPlanarBuffersOfFloats(float * const *outData, unsigned int numFrames, unsigned int numChannels);
+      
+      //! Force all generators to compute new output on the next block
+      void forceNewOutput();
+      
+      //! Timing of blocks rendered by tick(frames). May be momentarily inconsistent while audio is running.
+      BlockTimingStats blockTimingStats() { return blockTimingStats_; }
+      
+      //! Clear block timing stats at the start of the next block
+      void resetBlockTimingStats() { TONIC_ATOMIC_STORE(resetBlockTimingStats_, true); }
+      
+      //! Render from a flat schedule of up to maxNodes generators. maxNodes == 0 reverts to recursive ticking.
+      void compile(unsigned int maxNodes);
+      
+      //! Render blocks of blockSize frames, starting with the next block
+      void setSynthesisBlockSize(unsigned int blockSize);
+      
+      //! Render at sampleRate, starting with the next block
+      void setSynthesisSampleRate(TonicFloat sampleRate);
+      
+      //! Render numChannels channels, starting with the next block
+      void setSynthesisNumChannels(unsigned int numChannels);
+      
+      //! Rate most recently set with setSynthesisSampleRate, or the default rate when this was created
+      TonicFloat synthesisSampleRate() const { return sampleRateSetting_; }
+      
+      //! Let silent subgraphs sleep, starting with the next block
+      void setSkipSilence(bool skipSilence);
+      
+      //! True while blocks are being rendered from a schedule
+      bool isCompiled() { return TONIC_ATOMIC_LOAD(scheduleRunning_); }
 
     };
     
-    inline void BufferFiller_::lockMutex(){
-      TONIC_MUTEX_LOCK(mutex_);
+    inline void BufferFiller_::executePendingCommands(){
+      BufferFillerCommand_ * next = TONIC_ATOMIC_LOAD(commandHead_->next_);
+      if (!next) return;
+      
+      while (next){
+        next->execute();
+        // tell the producer everything up to here is finished with
+        TONIC_ATOMIC_STORE(commandHead_, next);
+        next = TONIC_ATOMIC_LOAD(next->next_);
+      }
+      
+      // the graph may have changed
+      schedule_.invalidate();
     }
     
-    inline void BufferFiller_::unlockMutex(){
-      TONIC_MUTEX_UNLOCK(mutex_);
+    inline void BufferFiller_::updateOutput( const SynthesisContext_ &context ){
+      
+      TONIC_CHECK_REALTIME_NODE(this);
+      TONIC_PROFILE_NODE(profileCounters_, context, !context.forceNewOutput && lastFrameIndex_ == context.elapsedFrames);
+      
+      executePendingCommands();
+      
+      if (!context.forceNewOutput && lastFrameIndex_ == context.elapsedFrames) return;
+      
+      matchBlockSize(context);
+      matchSampleRate(context);
+      
+      SynthesisContext_ localContext = context;
+      localContext.recordSchedule = NULL;
+      
+      if (schedule_.isValid() && !context.forceNewOutput){
+        schedule_.run(localContext);
+        // every generator in the graph is up to date - this only collects their output
+        computeSynthesisBlock(localContext);
+      }
+      else if (compiled_ && !context.forceNewOutput && context.elapsedFrames > 0){
+        // Render this block recursively, as usual, recording the order generators compute in.
+        // Frame 0 is skipped since some generators recompute on every tick at frame 0.
+        localContext.recordSchedule = &schedule_;
+        schedule_.beginRecording();
+        computeSynthesisBlock(localContext);
+        schedule_.endRecording();
+      }
+      else{
+        computeSynthesisBlock(localContext);
+      }
+      
+      lastFrameIndex_ = context.elapsedFrames;
+      
+      if (scheduleRunning_ != schedule_.isValid()){
+        TONIC_ATOMIC_STORE(scheduleRunning_, schedule_.isValid());
+      }
     }
     
-    inline void BufferFiller_::tick( TonicFrames& frames ){
-      lockMutex();
-      Generator_::tick(frames, synthContext_);
+    inline void BufferFiller_::renderBlock(){
+      
+      // anything released while rendering is deleted later, off this thread
+      RenderScope_ renderScope;
+      
+      const double startTime = monotonicTime();
+      
+      skippedNodes_ = 0;
+#ifdef TONIC_PROFILE
+      synthContext_.profile = profileNextBlock(profileBlockCounter_);
+#endif
+      updateOutput(synthContext_);
       synthContext_.tick();
-      unlockMutex();
+      
+      const double blockSeconds = monotonicTime() - startTime;
+      
+      if (TONIC_ATOMIC_LOAD(resetBlockTimingStats_)){
+        blockTimingStats_ = BlockTimingStats();
+        TONIC_ATOMIC_STORE(resetBlockTimingStats_, false);
+      }
+      blockTimingStats_.blocks++;
+      blockTimingStats_.skippedNodes += skippedNodes_;
+      blockTimingStats_.lastBlockSkippedNodes = skippedNodes_;
+      blockTimingStats_.totalSeconds += blockSeconds;
+      if (blockSeconds > blockTimingStats_.maxSeconds){
+        blockTimingStats_.maxSeconds = blockSeconds;
+      }
+    }
+    
+    inline void BufferFiller_::tick( TonicFrames& frames ){
+      renderBlock();
+      if (&frames != &outputFrames_){
+        if (frames.frames() != outputFrames_.frames()) frames.resize(outputFrames_.frames(), frames.channels(), 0);
+        frames.copy(outputFrames_);
+      }
+    }
+    
+    inline unsigned int BufferFiller_::nextOutputFrames(unsigned int numFrames){
+      if (bufferReadPosition_ == 0){
+        renderBlock();
+      }
+      // the block size may have changed
+      const unsigned long framesLeft = outputFrames_.frames() - bufferReadPosition_;
+      return numFrames < framesLeft ? numFrames : (unsigned int)framesLeft;
+    }
+    
+    inline void BufferFiller_::advanceOutput(unsigned int numFrames){
+      bufferReadPosition_ += numFrames;
+      if (bufferReadPosition_ >= outputFrames_.frames()){
+        bufferReadPosition_ = 0;
+      }
     }
     
     inline void BufferFiller_::fillBufferOfFloats(float *outData,  unsigned int numFrames, unsigned int numChannels)
@@ -76,34 +329,85 @@ namespace Tonic{
       // flush denormals on this thread
       TONIC_ENABLE_DENORMAL_ROUNDING();
       
-#ifdef TONIC_DEBUG
-      if(numChannels > outputFrames_.channels()) error("Mismatch in channels sent to Synth::fillBufferOfFloats", true);
-#endif
+      // Copied a block (or what's left of one) at a time, interleaving the output channels into outData
+      while (numFrames > 0){
+        
+        const unsigned int chunkFrames = nextOutputFrames(numFrames);
+        const unsigned int outputChannels = outputFrames_.channels();
+        
+        if (numChannels == 1 && outputChannels > 1){
+          // average into mono
+          const TonicFloat scale = 1.0f / outputChannels;
+          for (unsigned int i=0; i<chunkFrames; i++){
+            TonicFloat sum = 0;
+            for (unsigned int c=0; c<outputChannels; c++){
+              sum += outputFrames_(bufferReadPosition_ + i, c);
+            }
+            outData[i] = sum * scale;
+          }
+        }
+        else{
+          // matched by index - a mono output goes to every channel, and channels the output doesn't have are silent
+          for (unsigned int c=0; c<numChannels; c++){
+            float *channelOut = outData + c;
+            if (outputChannels == 1 || c < outputChannels){
+              const TonicFloat *channelIn = outputFrames_.channelData(outputChannels == 1 ? 0 : c) + bufferReadPosition_;
+              for (unsigned int i=0; i<chunkFrames; i++, channelOut += numChannels){
+                *channelOut = channelIn[i];
+              }
+            }
+            else{
+              for (unsigned int i=0; i<chunkFrames; i++, channelOut += numChannels){
+                *channelOut = 0;
+              }
+            }
+          }
+        }
+        
+        outData += chunkFrames * numChannels;
+        advanceOutput(chunkFrames);
+        numFrames -= chunkFrames;
+      }
+    }
+    
+    inline void BufferFiller_::fillPlanarBuffersOfFloats(float * const *outData, unsigned int numFrames, unsigned int numChannels)
+    {
       
-      const unsigned long sampleCount = outputFrames_.size();
-      const unsigned int channelsPerSample = (outputFrames_.channels() - numChannels) + 1;
+      TONIC_ENABLE_DENORMAL_ROUNDING();
       
-      TonicFloat sample = 0.0f;
-      TonicFloat *outputSamples = &outputFrames_[bufferReadPosition_];
+      // Each channel of a block (or what's left of one) goes straight into its buffer in one copy
+      unsigned int frameOffset = 0;
       
-      for(unsigned int i = 0; i<numFrames * numChannels; i++){
+      while (frameOffset < numFrames){
         
-        sample = 0;
+        const unsigned int chunkFrames = nextOutputFrames(numFrames - frameOffset);
+        const unsigned int outputChannels = outputFrames_.channels();
         
-        for (unsigned int c = 0; c<channelsPerSample; c++){
-          if(bufferReadPosition_ == 0){
-            tick(outputFrames_);
+        if (numChannels == 1 && outputChannels > 1){
+          // average into mono
+          float *channelOut = outData[0] + frameOffset;
+          const TonicFloat scale = 1.0f / outputChannels;
+          for (unsigned int i=0; i<chunkFrames; i++){
+            TonicFloat sum = 0;
+            for (unsigned int c=0; c<outputChannels; c++){
+              sum += outputFrames_(bufferReadPosition_ + i, c);
+            }
+            channelOut[i] = sum * scale;
           }
-          
-          sample += *outputSamples++;
-          
-          if(++bufferReadPosition_ == sampleCount){
-            bufferReadPosition_ = 0;
-            outputSamples = &outputFrames_[0];
+        }
+        else{
+          for (unsigned int c=0; c<numChannels; c++){
+            if (outputChannels == 1 || c < outputChannels){
+              memcpy(outData[c] + frameOffset, outputFrames_.channelData(outputChannels == 1 ? 0 : c) + bufferReadPosition_, chunkFrames * sizeof(TonicFloat));
+            }
+            else{
+              memset(outData[c] + frameOffset, 0, chunkFrames * sizeof(TonicFloat));
+            }
           }
         }
         
-        *outData++ = sample / (float)channelsPerSample;
+        advanceOutput(chunkFrames);
+        frameOffset += chunkFrames;
       }
     }
     
@@ -117,11 +421,151 @@ namespace Tonic{
         
     //! Fill an arbitrarily-sized, interleaved buffer of audio samples as floats
     /*!
-     This BufferFiller's outputGen is used to fill an interleaved buffer starting at outData.
+     This BufferFiller's outputGen is used to fill an interleaved buffer starting at outData. Channels
+     are handled as by TonicFrames::copy: a mono output fills every channel, one channel gets the average
+     of the output's, and channels the output doesn't have are silent.
      */
     inline void fillBufferOfFloats(float *outData,  unsigned int numFrames, unsigned int numChannels){
       static_cast<Tonic_::BufferFiller_*>(obj)->fillBufferOfFloats(outData, numFrames, numChannels);
     }
+    
+    //! Fill one buffer per channel (non-interleaved), e.g. for hosts which take deinterleaved floats
+    /*!
+     outData holds numChannels pointers, each to numFrames samples, and channels are handled as by
+     fillBufferOfFloats. Reads from the same stream as fillBufferOfFloats, so the two can be mixed.
+     
+     Both are fastest when numFrames is a multiple of the block size: each block is then rendered once
+     and copied out whole.
+     */
+    inline void fillPlanarBuffersOfFloats(float * const *outData, unsigned int numFrames, unsigned int numChannels){
+      static_cast<Tonic_::BufferFiller_*>(obj)->fillPlanarBuffersOfFloats(outData, numFrames, numChannels);
+    }
+    
+    //! Free parts of the graph replaced since the last change
+    /*!
+        Replaced generators are never destroyed on the audio thread. They are freed the next time
+        the graph is changed, or when this is called from a non-audio thread. Also deletes anything
+        released by the audio thread that the background reclaimer hasn't got to yet.
+     */
+    void collectGarbage(){
+      static_cast<Tonic_::BufferFiller_*>(obj)->collectGarbage();
+    }
+    
+    //! Worst-case and mean time spent rendering a block, and generators skipped for silence, as seen by the audio thread
+    Tonic_::BlockTimingStats blockTimingStats(){
+      return static_cast<Tonic_::BufferFiller_*>(obj)->blockTimingStats();
+    }
+    
+    void resetBlockTimingStats(){
+      static_cast<Tonic_::BufferFiller_*>(obj)->resetBlockTimingStats();
+    }
+    
+    //! Force all generators to compute new output on the next block
+    void forceNewOutput(){
+      static_cast<Tonic_::BufferFiller_*>(obj)->forceNewOutput();
+    }
+    
+    //! Flatten the synthesis graph into a linear schedule, removing recursion from per-block rendering
+    /*!
+        The graph is recorded during the next block, in the order generators compute, and later blocks
+        compute every generator in that order before this BufferFiller collects the output. Changes made
+        through this BufferFiller (setOutputGen, addInput, ...) trigger a new recording automatically.
+        
+        Graphs of more than maxNodes generators are rendered recursively, as if not compiled. Call compile()
+        again after changing the inputs of a generator already in the graph, and don't compile graphs
+        which only tick some generators on some blocks.
+     */
+    void compile(unsigned int maxNodes = 1024){
+      static_cast<Tonic_::BufferFiller_*>(obj)->compile(maxNodes);
+    }
+    
+    //! Revert to rendering the graph recursively
+    void uncompile(){
+      static_cast<Tonic_::BufferFiller_*>(obj)->compile(0);
+    }
+    
+    //! True while blocks are being rendered from a flattened schedule
+    bool isCompiled(){
+      return static_cast<Tonic_::BufferFiller_*>(obj)->isCompiled();
+    }
+    
+    //! Set the number of frames computed per synthesis block. Defaults to kSynthesisBlockSize.
+    /*!
+        Control generators update, and graph changes take effect, once per block. Larger blocks lower the
+        per-sample cost of rendering, e.g. 512 or 1024 frames for offline rendering, smaller ones (16 or 32)
+        lower latency. Any size runs the same SIMD kernels, picked for the CPU at startup (see VectorKernels),
+        with a scalar loop for the frames left over after the last whole vector.
+        
+        Takes effect at the next block. Generators resize their buffers on the audio thread as they first
+        render at a new size, which allocates if the block grows, so prefer setting this before starting audio.
+        The block size of a BufferFiller nested in another one (e.g. a Mixer input) is set by the outer one.
+     */
+    void setBlockSize(unsigned int blockSize){
+      static_cast<Tonic_::BufferFiller_*>(obj)->setSynthesisBlockSize(blockSize);
+    }
+    
+    //! Number of frames in the most recently rendered block
+    unsigned int blockSize(){
+      return obj->blockSize();
+    }
+    
+    //! Set the number of output channels. Defaults to 2.
+    /*!
+        Inputs with fewer channels are converted as by TonicFrames::copy(): mono is copied to every channel,
+        a stereo output gen fills the first two channels of a multichannel BufferFiller. Filling a mono host
+        buffer averages every channel.
+        
+        Takes effect at the next block. The output buffer is resized on the audio thread, which allocates
+        if it grows, so prefer setting this before starting audio.
+     */
+    void setNumChannels(unsigned int numChannels){
+      static_cast<Tonic_::BufferFiller_*>(obj)->setSynthesisNumChannels(numChannels);
+    }
+    
+    //! Number of channels in the most recently rendered block
+    unsigned int numChannels(){
+      return obj->numOutputChannels();
+    }
+    
+    //! Set the sample rate this BufferFiller renders at. Defaults to the value of Tonic::sampleRate() when it was created.
+    /*!
+        BufferFillers at different rates can run side by side, e.g. a 44.1kHz and a 48kHz session in one
+        process. Every generator in the graph follows the rate of the context it's rendered in: oscillators,
+        filters and envelopes recompute their coefficients, and delay lines are resized for the same delay
+        time at the new rate (and cleared) before the next block.
+        
+        Takes effect at the next block. Resizing delay lines allocates on the audio thread, so prefer setting
+        this before starting audio. The rate of a BufferFiller nested in another one (e.g. a Mixer input) is
+        set by the outer one.
+     */
+    void setSampleRate(TonicFloat sampleRate){
+      static_cast<Tonic_::BufferFiller_*>(obj)->setSynthesisSampleRate(sampleRate);
+    }
+    
+    //! The rate set with setSampleRate
+    TonicFloat sampleRate() const {
+      return static_cast<Tonic_::BufferFiller_*>(obj)->synthesisSampleRate();
+    }
+    
+    //! Stop computing parts of the graph while they are silent. Defaults to false.
+    /*!
+        Generators report when their output is known to be all zeros - idle envelopes, products with a
+        silent input, Adders and Mixers whose inputs are all silent. With this on, a Multiplier with a
+        silent input no longer computes its other inputs, and an effect whose input is silent goes to
+        sleep once its tail (delay repeats, reverb decay...) has died away below kSilenceThreshold.
+        blockTimingStats() reports how many generators were skipped.
+        
+        Sleeping generators don't advance, so oscillators resume from the phase they stopped at and
+        control generators only reachable through a sleeping subgraph (e.g. a ControlStepper setting
+        a silent voice's frequency) miss triggers. Leave this off for graphs which depend on those
+        running continuously. Takes effect at the next block. Nested BufferFillers (e.g. Mixer inputs)
+        follow the outer one. A compiled graph computes every generator it recorded, so there only
+        effects sleep.
+     */
+    void setSkipSilence(bool skipSilence){
+      static_cast<Tonic_::BufferFiller_*>(obj)->setSkipSilence(skipSilence);
+    }
+    
   
   };
   
@@ -131,6 +575,8 @@ namespace Tonic{
     GenType* gen(){
       return static_cast<GenType*>(obj);
     }
+    //! For subclasses whose implementation derives from GenType
+    TemplatedBufferFiller(GenType * newGen) : BufferFiller(newGen) {}
   public:
     TemplatedBufferFiller() : BufferFiller(new GenType) {}
   };
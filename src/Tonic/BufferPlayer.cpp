@@ -11,7 +11,7 @@
 
 namespace Tonic { namespace Tonic_{
   
-  BufferPlayer_::BufferPlayer_() : currentSample(0), isFinished_(true){
+  BufferPlayer_::BufferPlayer_() : currentFrame(0), isFinished_(true){
     doesLoop_ = ControlValue(false);
     trigger_ = ControlTrigger();
     startPosition_ = ControlValue(0);
@@ -23,8 +23,13 @@ namespace Tonic { namespace Tonic_{
   
   void  BufferPlayer_::setBuffer(SampleTable buffer){
     buffer_ = buffer;
-    setIsStereoOutput(buffer.channels() == 2);
-    samplesPerSynthesisBlock = kSynthesisBlockSize * buffer_.channels();
+    setNumOutputChannels(buffer.channels());
+    framesPerSynthesisBlock = outputFrames_.frames();
+  }
+  
+  void BufferPlayer_::setBlockSize(unsigned int blockSize){
+    Generator_::setBlockSize(blockSize);
+    framesPerSynthesisBlock = outputFrames_.frames();
   }
   
   inline void BufferPlayer_::computeSynthesisBlock(const SynthesisContext_ &context){
@@ -35,23 +40,23 @@ namespace Tonic { namespace Tonic_{
     
     if(trigger){
       isFinished_ = false;
-      currentSample = startPosition * sampleRate() * buffer_.channels();
+      currentFrame = startPosition * sampleRate_;
     }
     
     if(isFinished_){
       outputFrames_.clear();
     }else{
-      int samplesLeftInBuf = (int)buffer_.size() - currentSample;
-      int samplesToCopy = min(samplesPerSynthesisBlock, samplesLeftInBuf);
-      copySamplesToOutputBuffer(currentSample, samplesToCopy);
-      if (samplesToCopy < samplesPerSynthesisBlock) {
+      int framesLeftInBuf = (int)buffer_.frames() - currentFrame;
+      int framesToCopy = min(framesPerSynthesisBlock, framesLeftInBuf);
+      copyFramesToOutputBuffer(currentFrame, framesToCopy);
+      if (framesToCopy < framesPerSynthesisBlock) {
         if(doesLoop){
-          currentSample = 0;
+          currentFrame = 0;
         }else{
           isFinished_ = true;
         }
       }else{
-        currentSample += samplesPerSynthesisBlock;
+        currentFrame += framesPerSynthesisBlock;
       }
     }
   }
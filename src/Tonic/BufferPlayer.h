@@ -27,14 +27,14 @@ namespace Tonic {
     
     SampleTable buffer_;
     int testVar;
-    int currentSample;
-    int samplesPerSynthesisBlock;
+    int currentFrame;
+    int framesPerSynthesisBlock;
     ControlGenerator doesLoop_;
     ControlGenerator trigger_;
     ControlGenerator startPosition_;
     bool isFinished_;
     
-    void copySamplesToOutputBuffer(int startSample, int numSamples);
+    void copyFramesToOutputBuffer(int startFrame, int numFrames);
     
     public:
       BufferPlayer_();
@@ -42,14 +42,17 @@ namespace Tonic {
       void computeSynthesisBlock( const SynthesisContext_ &context );
       
       void setBuffer(SampleTable sampleTable);
+      void setBlockSize(unsigned int blockSize);
       void setDoesLoop(ControlGenerator doesLoop){doesLoop_ = doesLoop;}
       void setTrigger(ControlGenerator trigger){trigger_ = trigger;}
       void setStartPosition(ControlGenerator startPosition){startPosition_ = startPosition;}
       
     };
     
-    inline void BufferPlayer_::copySamplesToOutputBuffer(int startSample, int numSamples){
-      memcpy(&outputFrames_[0], &buffer_.dataPointer()[startSample], numSamples * sizeof(TonicFloat));
+    inline void BufferPlayer_::copyFramesToOutputBuffer(int startFrame, int numFrames){
+      for (unsigned int c=0; c<outputFrames_.channels(); c++){
+        memcpy(outputFrames_.channelData(c), buffer_.channelPointer(c) + startFrame, numFrames * sizeof(TonicFloat));
+      }
     }
     
     
@@ -57,7 +60,7 @@ namespace Tonic {
   
   /*!
     Simply plays back a buffer. "loop" parameter works, but doesn't wrap between ticks, so mostly likely you'll wind up with a few zeroes at the end of 
-    the last buffer if you're looping. In other words, buffer lenghts are rounded up to the nearest kSynthesisBlockSize 
+    the last buffer if you're looping. In other words, buffer lenghts are rounded up to the nearest synthesis block size 
    
     Usage:
     
@@ -0,0 +1,300 @@
+//
+//  BufferPool.cpp
+//  Tonic
+//
+//
+// See LICENSE.txt for license and usage information.
+//
+
+#include "BufferPool.h"
+
+#if defined (_WIN32) || defined (__WIN32__)
+  #include <malloc.h>
+#else
+  #include <stdlib.h>
+#endif
+
+namespace Tonic {
+
+  namespace Tonic_ {
+
+    void * alignedMalloc( size_t bytes, size_t alignment ){
+#if defined (_WIN32) || defined (__WIN32__)
+      return _aligned_malloc(bytes, alignment);
+#else
+      void * ptr = NULL;
+      if (posix_memalign(&ptr, alignment, bytes) != 0) return NULL;
+      return ptr;
+#endif
+    }
+
+    void alignedFree( void * ptr ){
+#if defined (_WIN32) || defined (__WIN32__)
+      _aligned_free(ptr);
+#else
+      free(ptr);
+#endif
+    }
+
+    // Slabs of pools that have gone, kept for the next pools - a voice built in its own pool then
+    // never reaches malloc either. Capped, so a burst of pools doesn't pin memory for good.
+    struct SlabCache_ {
+
+      static const unsigned int kNumSizes = 8;    // 4 KB (kFirstSlabBytes) to 512 KB
+      static const size_t kMaxCachedBytes = 1024 * 1024;
+
+      TONIC_MUTEX_T   mutex;
+      vector<void*>   slabs[kNumSizes];
+      size_t          cachedBytes;
+
+      SlabCache_() : cachedBytes(0) { TONIC_MUTEX_INIT(mutex); }
+
+      //! Index of the cached size bytes is, or kNumSizes if slabs of that size aren't cached
+      static unsigned int sizeIndex( size_t bytes ){
+        for (unsigned int i=0; i<kNumSizes; i++){
+          if (bytes == (BufferPool_::kFirstSlabBytes << i)) return i;
+        }
+        return kNumSizes;
+      }
+
+    };
+
+    // never freed, so pools destroyed during static destruction can still use it
+    static SlabCache_ & slabCache(){
+      static SlabCache_ * cache = new SlabCache_;
+      return *cache;
+    }
+
+    static void * acquireSlab( size_t bytes ){
+      unsigned int index = SlabCache_::sizeIndex(bytes);
+      if (index < SlabCache_::kNumSizes){
+        SlabCache_ & cache = slabCache();
+        void * slab = NULL;
+        TONIC_MUTEX_LOCK(cache.mutex);
+        if (!cache.slabs[index].empty()){
+          slab = cache.slabs[index].back();
+          cache.slabs[index].pop_back();
+          cache.cachedBytes -= bytes;
+        }
+        TONIC_MUTEX_UNLOCK(cache.mutex);
+        if (slab) return slab;
+      }
+      return alignedMalloc(bytes, BufferPool_::kBufferAlignment);
+    }
+
+    static void releaseSlab( void * slab, size_t bytes ){
+      unsigned int index = SlabCache_::sizeIndex(bytes);
+      if (index < SlabCache_::kNumSizes){
+        SlabCache_ & cache = slabCache();
+        bool cached = false;
+        TONIC_MUTEX_LOCK(cache.mutex);
+        if (cache.cachedBytes + bytes <= SlabCache_::kMaxCachedBytes){
+          cache.slabs[index].push_back(slab);
+          cache.cachedBytes += bytes;
+          cached = true;
+        }
+        TONIC_MUTEX_UNLOCK(cache.mutex);
+        if (cached) return;
+      }
+      alignedFree(slab);
+    }
+
+    // the innermost BufferPoolScope's pool on this thread, if any
+    static TONIC_THREAD_LOCAL BufferPool_ * scopedBufferPool_ = NULL;
+
+    BufferPool_ * currentBufferPool(){
+
+      if (scopedBufferPool_) return scopedBufferPool_;
+
+      // never freed - frames in static objects may outlive any other owner
+      static BufferPool_ * sharedPool = NULL;
+      if (!sharedPool){
+        BufferPool_ * pool = new BufferPool_(BufferPool::kDefaultSlabBytes);
+        pool->retain();
+        if (!TONIC_ATOMIC_COMPARE_EXCHANGE_PTR(sharedPool, (BufferPool_*)NULL, pool)){
+          pool->release();
+        }
+      }
+      return sharedPool;
+    }
+
+    BufferPool_::BufferPool_( size_t slabBytes ) :
+      slabHead_(NULL),
+      slabEnd_(NULL),
+      bytesReserved_(0),
+      buffersInUse_(0)
+    {
+      // whole size classes only - the largest class a slab serves is a quarter of it, so little is left unused
+      slabBytes_ = kBufferAlignment * 4;
+      numSizeClasses_ = 1;
+      while (slabBytes_ < slabBytes && numSizeClasses_ < kMaxSizeClasses){
+        slabBytes_ *= 2;
+        numSizeClasses_++;
+      }
+
+      nextSlabBytes_ = slabBytes_ < kFirstSlabBytes ? slabBytes_ : kFirstSlabBytes;
+
+      for (unsigned int i=0; i<kMaxSizeClasses; i++) freeLists_[i] = NULL;
+
+      TONIC_MUTEX_INIT(mutex_);
+    }
+
+    BufferPool_::~BufferPool_(){
+      for (unsigned int i=0; i<slabs_.size(); i++){
+        releaseSlab(slabs_[i].memory, slabs_[i].bytes);
+      }
+      TONIC_MUTEX_DESTROY(mutex_);
+    }
+
+    unsigned int BufferPool_::sizeClass( size_t bytes ) const {
+      unsigned int c = 0;
+      while (c < numSizeClasses_ && sizeClassBytes(c) < bytes) c++;
+      return c;
+    }
+
+    void * BufferPool_::carve( size_t bytes ){
+
+      // slabs are aligned and everything cut from them is a multiple of the alignment, so the head always is too
+      if (slabHead_ + bytes > slabEnd_){
+
+        // give the rest of the old slab to the free lists, largest classes first
+        while (slabHead_ && slabHead_ < slabEnd_){
+          unsigned int rc = numSizeClasses_ - 1;
+          while (sizeClassBytes(rc) > (size_t)(slabEnd_ - slabHead_)) rc--;
+          FreeBuffer_ * remainder = (FreeBuffer_*)slabHead_;
+          pushFree(rc, remainder);
+          slabHead_ += sizeClassBytes(rc);
+        }
+
+        // slabs start small and double up to slabBytes_, so a pool for a small patch stays small
+        size_t newSlabBytes = nextSlabBytes_;
+        while (newSlabBytes < bytes) newSlabBytes *= 2;
+        nextSlabBytes_ = newSlabBytes * 2 < slabBytes_ ? newSlabBytes * 2 : slabBytes_;
+
+        char * slab = (char*)acquireSlab(newSlabBytes);
+        if (!slab) return NULL;
+        Slab_ record = {slab, newSlabBytes};
+        slabs_.push_back(record);
+        bytesReserved_ += newSlabBytes;
+        slabHead_ = slab;
+        slabEnd_ = slab + newSlabBytes;
+      }
+
+      void * block = slabHead_;
+      slabHead_ += bytes;
+      return block;
+    }
+
+    void BufferPool_::pushFree( unsigned int c, FreeBuffer_ * buffer ){
+      FreeBuffer_ * head;
+      do {
+        head = TONIC_ATOMIC_LOAD(freeLists_[c]);
+        buffer->next = head;
+      } while (!TONIC_ATOMIC_COMPARE_EXCHANGE_PTR(freeLists_[c], head, buffer));
+    }
+
+    BufferPool_::FreeBuffer_ * BufferPool_::popFree( unsigned int c ){
+
+      // Take the whole list, so no other thread can pop the buffer under us and push it back - no ABA problem.
+      // Meanwhile other threads see the list empty and cut a new buffer instead, which costs a little memory.
+      FreeBuffer_ * buffer = (FreeBuffer_*)TONIC_ATOMIC_EXCHANGE_PTR(freeLists_[c], NULL);
+      if (!buffer) return NULL;
+
+      // Put the rest back. If buffers were pushed in the meantime, take those too and link the rest behind them.
+      FreeBuffer_ * rest = buffer->next;
+      while (rest && !TONIC_ATOMIC_COMPARE_EXCHANGE_PTR(freeLists_[c], (FreeBuffer_*)NULL, rest)){
+        FreeBuffer_ * pushed = (FreeBuffer_*)TONIC_ATOMIC_EXCHANGE_PTR(freeLists_[c], NULL);
+        if (!pushed) continue;
+        FreeBuffer_ * last = pushed;
+        while (last->next) last = last->next;
+        last->next = rest;
+        rest = pushed;
+      }
+
+      return buffer;
+    }
+
+    TonicFloat * BufferPool_::allocate( size_t nSamples, size_t & capacity ){
+
+      size_t bytes = nSamples * sizeof(TonicFloat);
+      unsigned int c = sizeClass(bytes);
+      void * buffer = NULL;
+
+      if (c == numSizeClasses_){
+
+        // too big for a slab - rounded up to the alignment, so the capacity is whole
+        size_t roundedBytes = (bytes + kBufferAlignment - 1) & ~(kBufferAlignment - 1);
+        buffer = alignedMalloc(roundedBytes, kBufferAlignment);
+        if (!buffer) return NULL;
+        capacity = roundedBytes / sizeof(TonicFloat);
+
+        TONIC_MUTEX_LOCK(mutex_);
+        bytesReserved_ += roundedBytes;
+        TONIC_MUTEX_UNLOCK(mutex_);
+      }
+      else{
+
+        capacity = sizeClassBytes(c) / sizeof(TonicFloat);
+
+        buffer = popFree(c);
+        if (!buffer){
+          TONIC_MUTEX_LOCK(mutex_);
+          buffer = carve(sizeClassBytes(c));
+          TONIC_MUTEX_UNLOCK(mutex_);
+          if (!buffer) return NULL;
+        }
+      }
+
+      TONIC_ATOMIC_INCREMENT(buffersInUse_);
+
+      retain();
+      return (TonicFloat*)buffer;
+    }
+
+    void BufferPool_::deallocate( TonicFloat * buffer, size_t capacity ){
+
+      if (!buffer) return;
+
+      size_t bytes = capacity * sizeof(TonicFloat);
+      unsigned int c = sizeClass(bytes);
+
+      if (c == numSizeClasses_){
+        alignedFree(buffer);
+        TONIC_MUTEX_LOCK(mutex_);
+        bytesReserved_ -= bytes;
+        TONIC_MUTEX_UNLOCK(mutex_);
+      }
+      else{
+        FreeBuffer_ * freed = (FreeBuffer_*)buffer;
+        pushFree(c, freed);
+      }
+
+      TONIC_ATOMIC_DECREMENT(buffersInUse_);
+
+      // last, as it may delete the pool
+      release();
+    }
+
+    size_t BufferPool_::bytesReserved(){
+      TONIC_MUTEX_LOCK(mutex_);
+      size_t bytes = bytesReserved_;
+      TONIC_MUTEX_UNLOCK(mutex_);
+      return bytes;
+    }
+
+    size_t BufferPool_::buffersInUse(){
+      return (size_t)TONIC_ATOMIC_LOAD(buffersInUse_);
+    }
+
+  }
+
+  BufferPoolScope::BufferPoolScope( BufferPool pool ) : pool_(pool) {
+    previous_ = Tonic_::scopedBufferPool_;
+    Tonic_::scopedBufferPool_ = pool_.obj;
+  }
+
+  BufferPoolScope::~BufferPoolScope(){
+    Tonic_::scopedBufferPool_ = previous_;
+  }
+
+}
@@ -0,0 +1,172 @@
+//
+//  BufferPool.h
+//  Tonic
+//
+//
+// See LICENSE.txt for license and usage information.
+//
+
+#ifndef TONIC_BUFFERPOOL_H
+#define TONIC_BUFFERPOOL_H
+
+#include "TonicCore.h"
+
+namespace Tonic {
+
+  namespace Tonic_ {
+
+    //! Allocates sample buffers for TonicFrames, aligned to kBufferAlignment, from large slabs
+    /*!
+        Buffers are rounded up to a power-of-two size class and cut one after another from the current slab,
+        so the buffers of a patch built in one go sit together in memory. Slabs start at 4 KB and double up to
+        the pool's slab size, so a pool serving one small patch stays small. A returned buffer goes on its size
+        class's free list and is handed to the next allocation of that class - creating and destroying voices
+        of the same shape never reaches malloc once the pool has grown to fit them. Slabs are only given up with
+        the pool, and a few are then kept for the next pools to be made. Buffers too big for a quarter of a slab
+        are allocated on their own, still aligned.
+
+        Every buffer in use holds a reference to its pool, so a pool lives until the last of its buffers
+        is returned. allocate() and deallocate() may be called from any thread. The free lists are lock-free,
+        so frames resized on the audio thread don't wait on a patch being built elsewhere - the pool's mutex
+        is only taken to cut a new buffer when its class's free list is empty, and for buffers too big for a slab.
+     */
+    class BufferPool_ : public ReferenceCounted_ {
+
+    public:
+
+      static const size_t kBufferAlignment = 64;
+
+      BufferPool_( size_t slabBytes );
+      ~BufferPool_();
+
+      //! A buffer of at least nSamples samples. capacity is set to the number it really holds.
+      TonicFloat * allocate( size_t nSamples, size_t & capacity );
+
+      //! Return a buffer from allocate(), with the capacity allocate() gave it
+      void deallocate( TonicFloat * buffer, size_t capacity );
+
+      size_t slabBytes() const { return slabBytes_; }
+
+      //! Bytes taken from the system - slabs and buffers too big for them
+      size_t bytesReserved();
+
+      //! Buffers allocated and not yet returned
+      size_t buffersInUse();
+
+      static const size_t kFirstSlabBytes = 4096;
+
+    protected:
+
+      struct FreeBuffer_ {
+        FreeBuffer_ * next;
+      };
+
+      // size classes are kBufferAlignment << n bytes
+      static const unsigned int kMaxSizeClasses = 32;
+
+      //! Cut bytes, a multiple of kBufferAlignment no bigger than a quarter slab, from the current slab. Call with mutex_ held.
+      void * carve( size_t bytes );
+
+      //! Push a buffer onto a free list. Lock-free.
+      void pushFree( unsigned int sizeClass, FreeBuffer_ * buffer );
+
+      //! Pop a buffer from a free list, or NULL if it is empty (or another thread is popping from it). Lock-free.
+      FreeBuffer_ * popFree( unsigned int sizeClass );
+
+      unsigned int sizeClass( size_t bytes ) const;
+      size_t sizeClassBytes( unsigned int sizeClass ) const { return kBufferAlignment << sizeClass; }
+
+      size_t                slabBytes_;
+      size_t                nextSlabBytes_;
+      unsigned int          numSizeClasses_;
+      FreeBuffer_ *         freeLists_[kMaxSizeClasses];
+
+      struct Slab_ {
+        void *  memory;
+        size_t  bytes;
+      };
+
+      vector<Slab_>         slabs_;
+      char *                slabHead_;
+      char *                slabEnd_;
+
+      size_t                bytesReserved_;
+      long                  buffersInUse_;
+
+      TONIC_MUTEX_T         mutex_;
+
+    private:
+
+      BufferPool_( const BufferPool_ & );
+      BufferPool_ & operator=( const BufferPool_ & );
+
+    };
+
+    //! Memory aligned to alignment, a power of two of at least sizeof(void*). NULL if it could not be allocated.
+    void * alignedMalloc( size_t bytes, size_t alignment );
+    void alignedFree( void * ptr );
+
+    //! The pool TonicFrames allocated on this thread use - the innermost BufferPoolScope's, or the shared one
+    BufferPool_ * currentBufferPool();
+
+  }
+
+  //! A pool of aligned sample buffers for a graph, or several (see Tonic_::BufferPool_)
+  /*!
+      Every TonicFrames allocates its samples from a pool. By default that is one shared by the whole
+      process. To keep a patch's buffers to itself - together in memory, and given back to the system
+      as a whole once it and the patch are gone - build the patch inside a BufferPoolScope:
+
+        BufferPool pool;
+        {
+          BufferPoolScope scope(pool);
+          synth.setOutputGen(SineWave().freq(440) >> LPF12().cutoff(1000));
+        }
+
+      The pool lives on until the last buffer allocated from it is freed, whatever happens to the handle.
+   */
+  class BufferPool : public TonicSmartPointer<Tonic_::BufferPool_> {
+
+  public:
+
+    static const size_t kDefaultSlabBytes = 64 * 1024;
+
+    BufferPool( size_t slabBytes = kDefaultSlabBytes ) : TonicSmartPointer<Tonic_::BufferPool_>(new Tonic_::BufferPool_(slabBytes)) {}
+
+    //! A handle to an existing pool
+    BufferPool( Tonic_::BufferPool_ * pool ) : TonicSmartPointer<Tonic_::BufferPool_>(pool) {}
+
+    size_t bytesReserved() const { return obj->bytesReserved(); }
+    size_t buffersInUse() const { return obj->buffersInUse(); }
+
+    friend class BufferPoolScope;
+
+  };
+
+  //! While it exists, TonicFrames allocated on the creating thread take their samples from pool
+  /*!
+      Scopes may be nested, and must be destroyed on the thread that created them. Frames keep the
+      pool they were allocated from when they grow later, outside the scope.
+   */
+  class BufferPoolScope {
+
+  public:
+
+    BufferPoolScope( BufferPool pool );
+    ~BufferPoolScope();
+
+  protected:
+
+    BufferPool              pool_;
+    Tonic_::BufferPool_ *   previous_;
+
+  private:
+
+    BufferPoolScope( const BufferPoolScope & );
+    BufferPoolScope & operator=( const BufferPoolScope & );
+
+  };
+
+}
+
+#endif
@@ -22,6 +22,11 @@ namespace Tonic { namespace Tonic_{
     delayTimeGen_ = FixedValue(initialDelayTime);
   }
   
+  void CombFilter_::setSampleRate(TonicFloat sampleRate){
+    Effect_::setSampleRate(sampleRate);
+    delayLine_.setSampleRate(sampleRate);
+  }
+  
   FilteredFBCombFilter6_::FilteredFBCombFilter6_() : lastOutLow_(0), lastOutHigh_(0)
   {
     // don't care about interpolation here, since this is optimized for reverb (faster)
@@ -30,12 +30,18 @@ namespace Tonic {
       
       TonicFrames         delayTimeFrames_;
       
+      unsigned long tailFrames( const SynthesisContext_ &context ){
+        return delayLine_.tailFrames(scaleFactorCtrlGen_.tick(context).value);
+      };
+      
     public:
       
       CombFilter_();
       
       void initialize(float initialDelayTime, float maxDelayTime);
       
+      void setSampleRate( TonicFloat sampleRate );
+      
       void setDelayTimeGen(Generator gen){ delayTimeGen_ = gen; };
       
       void setScaleFactorGen(ControlGenerator gen){ scaleFactorCtrlGen_ = gen; };
@@ -49,18 +55,19 @@ namespace Tonic {
       
       inline void computeSynthesisBlock( const SynthesisContext_ &context ){
         
-        // tick modulations
-        delayTimeGen_.tick(delayTimeFrames_, context);
+        // tick modulations, reading a constant delay time from its first sample throughout
+        const TonicFloat * dtptr = delayTimeGen_.tick(context, delayTimeFrames_).data();
+        const unsigned int dtStride = delayTimeGen_.isConstant() ? 0 : 1;
         
-        TonicFloat * inptr = &dryFrames_[0];
+        const TonicFloat * inptr = dryInput_->data();
         TonicFloat * outptr = &outputFrames_[0];
-        TonicFloat * dtptr = &delayTimeFrames_[0];
         TonicFloat sf = scaleFactorCtrlGen_.tick(context).value;
         TonicFloat norm = (1.0f/(1.0f + sf));
         
-        for (unsigned int i=0; i<kSynthesisBlockSize; i++){
+        for (unsigned int i=0; i<outputFrames_.frames(); i++){
           delayLine_.tickIn(*inptr);
-          *outptr++ = (*inptr++ + delayLine_.tickOut(*dtptr++) * sf) * norm;
+          *outptr++ = (*inptr++ + delayLine_.tickOut(*dtptr) * sf) * norm;
+          dtptr += dtStride;
           delayLine_.advance();
         }
       }
@@ -75,18 +82,19 @@ namespace Tonic {
 
       inline void computeSynthesisBlock( const SynthesisContext_ &context ){
         
-        // tick modulations
-        delayTimeGen_.tick(delayTimeFrames_, context);
+        // tick modulations, reading a constant delay time from its first sample throughout
+        const TonicFloat * dtptr = delayTimeGen_.tick(context, delayTimeFrames_).data();
+        const unsigned int dtStride = delayTimeGen_.isConstant() ? 0 : 1;
         
         TonicFloat y = 0;
-        TonicFloat * inptr = &dryFrames_[0];
+        const TonicFloat * inptr = dryInput_->data();
         TonicFloat * outptr = &outputFrames_[0];
-        TonicFloat * dtptr = &delayTimeFrames_[0];
         TonicFloat sf = scaleFactorCtrlGen_.tick(context).value;
         TonicFloat norm = (1.0f/(1.0f + sf));
         
-        for (unsigned int i=0; i<kSynthesisBlockSize; i++){
-          y = ((delayLine_.tickOut(*dtptr++) * sf) + *inptr++) * norm;
+        for (unsigned int i=0; i<outputFrames_.frames(); i++){
+          y = ((delayLine_.tickOut(*dtptr) * sf) + *inptr++) * norm;
+          dtptr += dtStride;
           delayLine_.tickIn(y);
           *outptr++ = y;
           delayLine_.advance();
@@ -126,21 +134,22 @@ namespace Tonic {
     
     inline void FilteredFBCombFilter6_::computeSynthesisBlock( const SynthesisContext_ &context ){
       
-      // tick modulations
-      delayTimeGen_.tick(delayTimeFrames_, context);
+      // tick modulations, reading a constant delay time from its first sample throughout
+      const TonicFloat * dtptr = delayTimeGen_.tick(context, delayTimeFrames_).data();
+      const unsigned int dtStride = delayTimeGen_.isConstant() ? 0 : 1;
       
       TonicFloat y = 0;
-      TonicFloat * inptr = &dryFrames_[0];
+      const TonicFloat * inptr = dryInput_->data();
       TonicFloat * outptr = &outputFrames_[0];
-      TonicFloat * dtptr = &delayTimeFrames_[0];
       
       TonicFloat sf = scaleFactorCtrlGen_.tick(context).value;
       
-      TonicFloat lowCoef = cutoffToOnePoleCoef(lowCutoffGen_.tick(context).value);
-      TonicFloat hiCoef = 1.0f - cutoffToOnePoleCoef(highCutoffGen_.tick(context).value);
+      TonicFloat lowCoef = cutoffToOnePoleCoef(lowCutoffGen_.tick(context).value, sampleRate_);
+      TonicFloat hiCoef = 1.0f - cutoffToOnePoleCoef(highCutoffGen_.tick(context).value, sampleRate_);
       
-      for (unsigned int i=0; i<kSynthesisBlockSize; i++){
-        onePoleLPFTick(delayLine_.tickOut(*dtptr++), lastOutLow_, lowCoef);
+      for (unsigned int i=0; i<outputFrames_.frames(); i++){
+        onePoleLPFTick(delayLine_.tickOut(*dtptr), lastOutLow_, lowCoef);
+        dtptr += dtStride;
         onePoleHPFTick(lastOutLow_, lastOutHigh_, hiCoef);
         y = ((lastOutHigh_ * sf) + *inptr++); // no normalization on purpose
         delayLine_.tickIn(y);
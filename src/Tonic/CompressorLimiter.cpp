@@ -26,19 +26,31 @@ namespace Tonic { namespace Tonic_{
   
   void Compressor_::setAudioInput( Generator gen ) {
     input_ = gen;
-    setIsStereoInput(gen.isStereoOutput());
-    setIsStereoOutput(gen.isStereoOutput());
+    setNumInputChannels(gen.numOutputChannels());
+    setNumOutputChannels(gen.numOutputChannels());
+    lookaheadDelayLine_.resize(lookaheadDelayLine_.frames(), gen.numOutputChannels(), 0);
   }
   
   void Compressor_::setAmplitudeInput( Generator gen ) {
     amplitudeInput_ = gen;
-    ampInputFrames_.resize(kSynthesisBlockSize, amplitudeInput_.isStereoOutput() ? 2 : 1, 0);
+    ampInputFrames_.resize(ampInputFrames_.frames(), amplitudeInput_.numOutputChannels(), 0);
   }
   
-  void Compressor_::setIsStereo(bool isStereo){
-    setIsStereoInput(isStereo);
-    setIsStereoOutput(isStereo);
-    ampInputFrames_.resize(kSynthesisBlockSize, isStereo ? 2 : 1, 0);
+  void Compressor_::setNumChannels(unsigned int numChannels){
+    setNumInputChannels(numChannels);
+    setNumOutputChannels(numChannels);
+    ampInputFrames_.resize(ampInputFrames_.frames(), numChannels, 0);
+    lookaheadDelayLine_.resize(lookaheadDelayLine_.frames(), numChannels, 0);
+  }
+  
+  void Compressor_::setBlockSize(unsigned int blockSize){
+    Effect_::setBlockSize(blockSize);
+    ampInputFrames_.resize(blockSize, ampInputFrames_.channels(), 0);
+  }
+  
+  void Compressor_::setSampleRate(TonicFloat sampleRate){
+    Effect_::setSampleRate(sampleRate);
+    lookaheadDelayLine_.setSampleRate(sampleRate);
   }
   
 } // Namespace Tonic_
@@ -45,14 +45,16 @@ namespace Tonic {
       
       void computeSynthesisBlock( const SynthesisContext_ &context );
       
+      unsigned long tailFrames( const SynthesisContext_ &context ) { return lookaheadDelayLine_.frames(); };
+      
     public:
       
       Compressor_();
 
       // Base class methods overridden here for specialized input behavior
       void setInput( Generator input );
-      void tick(TonicFrames &frames, const SynthesisContext_ & context );
-      void tickThrough(TonicFrames & inFrames, TonicFrames & outFrames, const SynthesisContext_ & context);
+      void updateOutput( const SynthesisContext_ & context );
+      void tickThrough(const TonicFrames & inFrames, TonicFrames & outFrames, const SynthesisContext_ & context);
       
       // setters
       void setAudioInput( Generator gen );
@@ -68,21 +70,34 @@ namespace Tonic {
       //! Set whether is a limiter - limiters will hard clip to threshold in worst case
       void setIsLimiter( bool isLimiter ) { isLimiter_ = isLimiter; };
       
+      //! Externally set the number of channels operated on
+      void setNumChannels( unsigned int numChannels );
+      
       //! Externally set whether operates on one or two channels
-      void setIsStereo( bool isStereo );
+      void setIsStereo( bool isStereo ) { setNumChannels(isStereo ? 2 : 1); };
+      
+      void setBlockSize( unsigned int blockSize );
+      
+      void setSampleRate( TonicFloat sampleRate );
       
     };
     
-    inline void Compressor_::tick(TonicFrames &frames, const SynthesisContext_ &context ){
+    inline void Compressor_::updateOutput( const SynthesisContext_ &context ){
+      
+      TONIC_CHECK_REALTIME_NODE(this);
       
       if (context.forceNewOutput || lastFrameIndex_ != context.elapsedFrames){
+        matchBlockSize(context);
+        matchSampleRate(context);
         amplitudeInput_.tick(ampInputFrames_, context); // get amp input frames
       }
-      Effect_::tick(frames, context);
+      Effect_::updateOutput(context);
       
     }
     
-    inline void Compressor_::tickThrough(TonicFrames & inFrames, TonicFrames & outFrames, const SynthesisContext_ & context){
+    inline void Compressor_::tickThrough(const TonicFrames & inFrames, TonicFrames & outFrames, const SynthesisContext_ & context){
+      matchBlockSize(context);
+      matchSampleRate(context);
       ampInputFrames_.copy(inFrames);
       Effect_::tickThrough(inFrames, outFrames, context);
     }
@@ -90,8 +105,8 @@ namespace Tonic {
     inline void Compressor_::computeSynthesisBlock(const SynthesisContext_ &context){
       
       // Tick all scalar parameters
-      float attackCoef = t60ToOnePoleCoef(max(0,attackGen_.tick(context).value));
-      float releaseCoef = t60ToOnePoleCoef(max(0, releaseGen_.tick(context).value));
+      float attackCoef = t60ToOnePoleCoef(max(0,attackGen_.tick(context).value), sampleRate_);
+      float releaseCoef = t60ToOnePoleCoef(max(0, releaseGen_.tick(context).value), sampleRate_);
       float threshold = max(0,threshGen_.tick(context).value);
       float ratio = max(0,ratioGen_.tick(context).value);
       float lookaheadTime = max(0,lookaheadGen_.tick(context).value);
@@ -109,18 +124,22 @@ namespace Tonic {
       
       // Iterate through samples
       unsigned int nChannels = outputFrames_.channels();
+      unsigned int nAmpChannels = ampInputFrames_.channels();
+      const unsigned long nFrames = outputFrames_.frames();
       TonicFloat ampInputValue, gainValue, gainTarget;
       TonicFloat * outptr = &outputFrames_[0];
-      TonicFloat * dryptr = &dryFrames_[0];
+      const TonicFloat * dryptr = dryInput_->data();
       ampData = &ampInputFrames_[0];
       
-      for (unsigned int i=0; i<kSynthesisBlockSize; i++){
+      for (unsigned int i=0; i<nFrames; i++){
         
-        // Tick input into lookahead delay and get amplitude input value - max of left/right
+        // Tick input into lookahead delay and get amplitude input value - max of all channels
         ampInputValue = 0;
-        for (unsigned int i=0; i<nChannels; i++){
-          lookaheadDelayLine_.tickIn(*dryptr++, i);
-          ampInputValue = max(ampInputValue,*ampData++);
+        for (unsigned int c=0; c<nChannels; c++){
+          lookaheadDelayLine_.tickIn(dryptr[c*nFrames + i], c);
+        }
+        for (unsigned int c=0; c<nAmpChannels; c++){
+          ampInputValue = max(ampInputValue, ampData[c*nFrames + i]);
         }
         
         // Smooth amplitude input
@@ -151,8 +170,8 @@ namespace Tonic {
         }
         
         // apply gain
-        for (unsigned int i=0; i<nChannels; i++){
-          *outptr++ = lookaheadDelayLine_.tickOut(lookaheadTime,i) * gainEnvValue_;
+        for (unsigned int c=0; c<nChannels; c++){
+          outptr[c*nFrames + i] = lookaheadDelayLine_.tickOut(lookaheadTime,c) * gainEnvValue_;
         }
         
         lookaheadDelayLine_.advance();
@@ -210,6 +229,10 @@ namespace Tonic {
       this->gen()->setIsStereo(isStereo);
     }
     
+    void setNumChannels( unsigned int numChannels ){
+      this->gen()->setNumChannels(numChannels);
+    }
+    
     TONIC_MAKE_CTRL_GEN_SETTERS(Compressor, attack, setAttack);
     TONIC_MAKE_CTRL_GEN_SETTERS(Compressor, release, setRelease);
     TONIC_MAKE_CTRL_GEN_SETTERS(Compressor, threshold, setThreshold); // LINEAR - use dBToLin to convert from dB
@@ -234,6 +257,10 @@ namespace Tonic {
       this->gen()->setIsStereo(isStereo);
     }
     
+    void setNumChannels( unsigned int numChannels ){
+      this->gen()->setNumChannels(numChannels);
+    }
+    
     TONIC_MAKE_CTRL_GEN_SETTERS(Limiter, release, setRelease);
     TONIC_MAKE_CTRL_GEN_SETTERS(Limiter, threshold, setThreshold);
     TONIC_MAKE_CTRL_GEN_SETTERS(Limiter, lookahead, setLookahead);
@@ -14,15 +14,27 @@ namespace Tonic {
     ControlDelay_::ControlDelay_() :
       readHead_(0),
       writeHead_(0),
-      maxDelay_(0)
+      maxDelay_(0),
+      maxDelayTime_(0),
+      sampleRate_(Tonic::sampleRate())
     {
     }
 
     void ControlDelay_::initialize(float maxDelayTime){
-      maxDelay_ = max(maxDelayTime * sampleRate() / kSynthesisBlockSize, 1);
+      maxDelayTime_ = maxDelayTime;
+      maxDelay_ = max(maxDelayTime * sampleRate_ / kSynthesisBlockSize, 1);
       delayLine_.resize(maxDelay_);
       readHead_ = maxDelay_ - 1;
     }
+    
+    void ControlDelay_::setSampleRate(TonicFloat sampleRate){
+      sampleRate_ = sampleRate;
+      long maxDelay = max(maxDelayTime_ * sampleRate_ / kSynthesisBlockSize, 1);
+      if (maxDelay != maxDelay_){
+        initialize(maxDelayTime_);
+        writeHead_ = 0;
+      }
+    }
 
   } // Namespace Tonic_
   
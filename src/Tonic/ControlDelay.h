@@ -25,6 +25,9 @@ namespace Tonic {
           
       long maxDelay_; // # synthesis blocks of delay
       
+      float maxDelayTime_;
+      TonicFloat sampleRate_; // rate maxDelay_ was computed for
+      
       std::vector<ControlGeneratorOutput> delayLine_;
       
       ControlGenerator delayTimeCtrlGen_;
@@ -37,24 +40,32 @@ namespace Tonic {
       
       void initialize(float maxDelayTime);
       
+      void setSampleRate(TonicFloat sampleRate);
+      
       void setDelayTimeGen( ControlGenerator gen ){ delayTimeCtrlGen_ = gen; };
       
     };
     
     inline void ControlDelay_::computeOutput(const SynthesisContext_ & context){
       
+      // resized for the context's rate the first time it's computed, or if the rate changes
+      bool rateChanged = context.sampleRate != sampleRate_;
+      if (rateChanged) setSampleRate(context.sampleRate);
+      
       delayLine_[writeHead_] = input_.tick(context);
       
       ControlGeneratorOutput delayTimeOutput = delayTimeCtrlGen_.tick(context);
-      if (delayTimeOutput.triggered){
+      if (delayTimeOutput.triggered || rateChanged){
         
-        unsigned delayBlocks = max(delayTimeOutput.value * sampleRate() / kSynthesisBlockSize, 1);
+        unsigned delayBlocks = max(delayTimeOutput.value * sampleRate_ / context.blockSize, 1);
         
-#ifdef TONIC_DEBUG
         if (delayBlocks >= maxDelay_){
+#ifdef TONIC_DEBUG
           debug("ControlDelay: delay time greater than maximum delay (defaults to 1 scond). Use constructor to set max delay -- ex. ControlDelay(2.0))");
-        }
 #endif
+          // the delay line holds maxDelay_ blocks of the default size - fewer at smaller block sizes
+          delayBlocks = maxDelay_ - 1;
+        }
         
         readHead_ = writeHead_ - delayBlocks;
         if (readHead_ < 0) readHead_ += maxDelay_;
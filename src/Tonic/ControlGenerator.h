@@ -12,6 +12,7 @@
 #define TONIC_CONTROLGENERATOR_H
 
 #include "TonicCore.h"
+#include "Profiler.h"
 
 namespace Tonic {
   
@@ -25,7 +26,7 @@ namespace Tonic {
 
   namespace Tonic_{
 
-    class ControlGenerator_{
+    class ControlGenerator_ : public ReferenceCounted_ {
       
     public:
     
@@ -54,10 +55,17 @@ namespace Tonic {
       ControlGeneratorOutput  output_;
       unsigned long           lastFrameIndex_;
       
+#ifdef TONIC_PROFILE
+      NodeProfileCounters_    profileCounters_;
+#endif
+      
     };
     
     inline ControlGeneratorOutput ControlGenerator_::tick(const SynthesisContext_ & context){
       
+      TONIC_CHECK_REALTIME_NODE(this);
+      TONIC_PROFILE_NODE(profileCounters_, context, !(context.forceNewOutput || lastFrameIndex_ != context.elapsedFrames));
+      
       if (context.forceNewOutput || lastFrameIndex_ != context.elapsedFrames){
         lastFrameIndex_ = context.elapsedFrames;
         computeOutput(context);
@@ -0,0 +1,564 @@
+//
+//  ConvolutionReverb.cpp
+//  Tonic
+//
+//
+// See LICENSE.txt for license and usage information.
+//
+
+#include "ConvolutionReverb.h"
+#include "FixedValue.h"
+#include <sstream>
+
+namespace Tonic {
+
+  namespace Tonic_ {
+
+    PartitionedImpulseResponse_::PartitionedImpulseResponse_( SampleTable response, unsigned int blockSize ) :
+      frames((unsigned int)response.frames()),
+      channels((unsigned int)response.channels()),
+      blockSize(blockSize)
+    {
+      unsigned int offset = 0;
+      unsigned int partitionFrames = blockSize;
+
+      while (offset < frames){
+
+        Tier_ tier;
+        tier.partitionFrames = partitionFrames;
+        tier.offset = offset;
+
+        // up to where the next tier, four times longer, can start - or the end, if it can't be longer
+        unsigned int nextPartitionFrames = partitionFrames * 4;
+        unsigned int end = frames;
+        if (nextPartitionFrames <= max(kMaxPartitionFrames, blockSize)){
+          end = min(frames, 2 * nextPartitionFrames);
+        }
+        tier.numPartitions = (end - offset + partitionFrames - 1) / partitionFrames;
+
+        FFT fft(2 * partitionFrames);
+        vector<TonicFloat> padded(2 * partitionFrames);
+        const unsigned int bins = tier.bins();
+        tier.spectraReal.resize(channels, vector<TonicFloat>(tier.numPartitions * bins));
+        tier.spectraImag.resize(channels, vector<TonicFloat>(tier.numPartitions * bins));
+
+        for (unsigned int c=0; c<channels; c++){
+          const TonicFloat *data = response.channelPointer(c);
+          for (unsigned int p=0; p<tier.numPartitions; p++){
+            unsigned int start = offset + p * partitionFrames;
+            unsigned int count = min(partitionFrames, frames - start);
+            std::fill(padded.begin(), padded.end(), 0.f);
+            std::copy(data + start, data + start + count, padded.begin());
+            fft.forwardReal(&padded[0], &tier.spectraReal[c][p * bins], &tier.spectraImag[c][p * bins]);
+          }
+        }
+
+        tiers.push_back(tier);
+        offset += tier.numPartitions * partitionFrames;
+        partitionFrames = nextPartitionFrames;
+      }
+    }
+
+    // Partitioned responses are kept for good, like oscillator tables, under their content and block size
+    struct ImpulseResponseRegistry_ {
+      TONIC_MUTEX_T mutex;
+      std::map<string, PartitionedImpulseResponse> responses;
+      ImpulseResponseRegistry_() { TONIC_MUTEX_INIT(mutex); }
+    };
+
+    static string impulseResponseName( SampleTable response, unsigned int blockSize ){
+      unsigned long long hash = 14695981039346656037ULL;
+      const unsigned char * bytes = (const unsigned char *)response.planarDataPointer();
+      for (size_t i=0; i<response.size() * sizeof(TonicFloat); i++){
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+      }
+      std::ostringstream name;
+      name << response.frames() << "_" << response.channels() << "_" << blockSize << "_" << std::hex << hash;
+      return name.str();
+    }
+
+    PartitionedImpulseResponse partitionedImpulseResponse( SampleTable response, unsigned int blockSize ){
+
+      static ImpulseResponseRegistry_ * registry = new ImpulseResponseRegistry_;
+      string name = impulseResponseName(response, blockSize);
+
+      TONIC_MUTEX_LOCK(registry->mutex);
+      std::map<string, PartitionedImpulseResponse>::iterator found = registry->responses.find(name);
+      PartitionedImpulseResponse partitioned;
+      if (found != registry->responses.end()){
+        partitioned = found->second;
+      }
+      else{
+        partitioned = PartitionedImpulseResponse(new PartitionedImpulseResponse_(response, blockSize));
+        registry->responses[name] = partitioned;
+      }
+      TONIC_MUTEX_UNLOCK(registry->mutex);
+
+      return partitioned;
+    }
+
+    ConvolutionReverb_::ConvolutionReverb_() : convolvers_(NULL), active_(NULL), numDraining_(0) {
+      setWetLevelGen(FixedValue(0.5f));
+      setDryLevelGen(FixedValue(0.5f));
+      TONIC_MUTEX_INIT(prepareMutex_);
+      addBlockSizeListener(this);
+    }
+
+    ConvolutionReverb_::~ConvolutionReverb_(){
+      removeBlockSizeListener(this);
+      deleteConvolvers();
+      TONIC_MUTEX_DESTROY(prepareMutex_);
+    }
+
+    void ConvolutionReverb_::setImpulseResponse( SampleTable response ){
+      if (response.frames() == 0){
+        error("ConvolutionReverb::setImpulseResponse - the impulse response is empty");
+        return;
+      }
+      response_ = response;
+      configure();
+    }
+
+    void ConvolutionReverb_::setNumInputChannels( unsigned int numChannels ){
+      WetDryEffect_::setNumInputChannels(numChannels);
+      configure();
+    }
+
+    void ConvolutionReverb_::setBlockSize( unsigned int blockSize ){
+
+      WetDryEffect_::setBlockSize(blockSize);
+      if (response_.frames() == 0 || (active_ && active_->blockSize == blockSize)) return;
+
+      Convolver_ * convolver = findConvolver(blockSize);
+      if (!convolver){
+        convolver = buildConvolver(blockSize);
+        addConvolver(convolver);
+      }
+
+      // A convolver still draining goes on from where it is, if it has no tail computed ahead of time.
+      // Otherwise it starts again, and whatever it had left of a tail is dropped.
+      if (convolver->drainFramesLeft > 0){
+        convolver->drainFramesLeft = 0;
+        numDraining_--;
+        if (convolver->aheadPlayed < convolver->blockSize) resetConvolver(*convolver);
+      }
+      else if (!convolver->clean){
+        resetConvolver(*convolver);
+      }
+
+      // the tail lasts no longer than the response after the last block of input
+      if (active_){
+        active_->aheadPlayed = active_->blockSize;
+        active_->drainFramesLeft = response_.frames();
+        numDraining_++;
+      }
+
+      active_ = convolver;
+      active_->clean = false;
+    }
+
+    void ConvolutionReverb_::prepareBlockSize( unsigned int blockSize ){
+      TONIC_MUTEX_LOCK(prepareMutex_);
+      if (response_.frames() > 0 && !findConvolver(blockSize)){
+        addConvolver(buildConvolver(blockSize));
+      }
+      TONIC_MUTEX_UNLOCK(prepareMutex_);
+    }
+
+    void ConvolutionReverb_::configure(){
+
+      // before locking, as announcing a block size locks the listeners, then calls prepareBlockSize
+      vector<unsigned int> blockSizes = announcedBlockSizes();
+
+      TONIC_MUTEX_LOCK(prepareMutex_);
+
+      deleteConvolvers();
+
+      const unsigned int inputChannels = numInputChannels();
+      if (response_.frames() == 0){
+        setNumOutputChannels(inputChannels);
+      }
+      else{
+        setNumOutputChannels(max(inputChannels, (unsigned int)response_.channels()));
+
+        active_ = buildConvolver(outputFrames_.frames());
+        active_->clean = false;
+        addConvolver(active_);
+        for (unsigned int i=0; i<blockSizes.size(); i++){
+          if (!findConvolver(blockSizes[i])) addConvolver(buildConvolver(blockSizes[i]));
+        }
+      }
+
+      TONIC_MUTEX_UNLOCK(prepareMutex_);
+    }
+
+    ConvolutionReverb_::Convolver_ * ConvolutionReverb_::buildConvolver( unsigned int blockSize ){
+
+      Convolver_ * convolver = new Convolver_;
+      convolver->blockSize = blockSize;
+      convolver->partitioned = partitionedImpulseResponse(response_, blockSize);
+      convolver->blockCount = 0;
+      convolver->clean = true;
+      convolver->aheadPlayed = blockSize;
+      convolver->drainFramesLeft = 0;
+      convolver->next = NULL;
+
+      const PartitionedImpulseResponse_ * partitioned = convolver->partitioned.response();
+      const unsigned int inputChannels = numInputChannels();
+      const unsigned int outputChannels = outputFrames_.channels();
+      convolver->ahead.resize(blockSize, outputChannels, 0);
+
+      // Each tier's steps are four times the last's, so with every tier starting its partitions on the same
+      // block, all their FFTs would land together. Each tier starts halfway between the FFTs of the one before
+      // instead - and so between those of all the tiers before.
+      unsigned int phase = 0;
+
+      for (unsigned int t=0; t<partitioned->tiers.size(); t++){
+
+        const PartitionedImpulseResponse_::Tier_ & partitionedTier = partitioned->tiers[t];
+        const unsigned int partitionFrames = partitionedTier.partitionFrames;
+        const unsigned int bins = partitionedTier.bins();
+
+        // halved while the halves are of even length, for real transforms
+        unsigned int pieces = 1;
+        while (2 * partitionFrames / pieces > kMaxTransformLength && (2 * partitionFrames / pieces) % 4 == 0) pieces *= 2;
+        TierState_ tier(2 * partitionFrames / pieces);
+        tier.pieces = pieces;
+        tier.steps = partitionFrames / blockSize;
+        tier.phase = phase;
+        if (t > 0) phase += tier.steps / ((inputChannels + outputChannels) * pieces) / 2;
+        tier.window.resize(inputChannels * 3 * partitionFrames, 0);
+        tier.newest = 0;
+        tier.historyReal.resize(inputChannels * partitionedTier.numPartitions * bins, 0);
+        tier.historyImag.resize(inputChannels * partitionedTier.numPartitions * bins, 0);
+        tier.head = 0;
+        tier.sumReal.resize(outputChannels * bins, 0);
+        tier.sumImag.resize(outputChannels * bins, 0);
+        tier.result.resize(2 * outputChannels * partitionFrames, 0);
+        tier.transform.resize(2 * partitionFrames);
+        if (pieces > 1){
+          tier.pieceReal.resize(2 * partitionFrames / pieces);
+          tier.pieceImag.resize(2 * partitionFrames / pieces);
+          tier.binsReal.resize(bins);
+          tier.binsImag.resize(bins);
+          tier.twiddleReal.resize((pieces - 1) * bins);
+          tier.twiddleImag.resize((pieces - 1) * bins);
+          tier.conjugateTwiddleImag.resize((pieces - 1) * bins);
+          for (unsigned int m=1; m<pieces; m++){
+            for (unsigned int k=0; k<bins; k++){
+              const double angle = (double)PI * ((m * k) % (2 * partitionFrames)) / partitionFrames;
+              const size_t i = (m - 1) * bins + k;
+              tier.twiddleReal[i] = (TonicFloat)cos(angle);
+              tier.twiddleImag[i] = (TonicFloat)-sin(angle);
+              tier.conjugateTwiddleImag[i] = (TonicFloat)sin(angle);
+            }
+          }
+        }
+        scheduleTier(tier, partitionedTier);
+
+        convolver->tiers.push_back(tier);
+      }
+
+      return convolver;
+    }
+
+    void ConvolutionReverb_::addConvolver( Convolver_ * convolver ){
+      Convolver_ * head;
+      do {
+        head = TONIC_ATOMIC_LOAD(convolvers_);
+        convolver->next = head;
+      } while (!TONIC_ATOMIC_COMPARE_EXCHANGE_PTR(convolvers_, head, convolver));
+    }
+
+    ConvolutionReverb_::Convolver_ * ConvolutionReverb_::findConvolver( unsigned int blockSize ){
+      for (Convolver_ * convolver = TONIC_ATOMIC_LOAD(convolvers_); convolver; convolver = convolver->next){
+        if (convolver->blockSize == blockSize) return convolver;
+      }
+      return NULL;
+    }
+
+    void ConvolutionReverb_::deleteConvolvers(){
+      Convolver_ * convolver = (Convolver_*)TONIC_ATOMIC_EXCHANGE_PTR(convolvers_, NULL);
+      while (convolver){
+        Convolver_ * next = convolver->next;
+        delete convolver;
+        convolver = next;
+      }
+      active_ = NULL;
+      numDraining_ = 0;
+    }
+
+    void ConvolutionReverb_::resetConvolver( Convolver_ & convolver ){
+      for (unsigned int t=0; t<convolver.tiers.size(); t++){
+        TierState_ & tier = convolver.tiers[t];
+        std::fill(tier.window.begin(), tier.window.end(), 0.f);
+        std::fill(tier.historyReal.begin(), tier.historyReal.end(), 0.f);
+        std::fill(tier.historyImag.begin(), tier.historyImag.end(), 0.f);
+        std::fill(tier.sumReal.begin(), tier.sumReal.end(), 0.f);
+        std::fill(tier.sumImag.begin(), tier.sumImag.end(), 0.f);
+        std::fill(tier.result.begin(), tier.result.end(), 0.f);
+        tier.newest = 0;
+        tier.head = 0;
+      }
+      convolver.blockCount = 0;
+      convolver.clean = true;
+      convolver.aheadPlayed = convolver.blockSize;
+      convolver.drainFramesLeft = 0;
+    }
+
+    void ConvolutionReverb_::drain( Convolver_ & convolver ){
+
+      const unsigned int frames = outputFrames_.frames();
+      const unsigned int outputChannels = outputFrames_.channels();
+
+      unsigned int played = 0;
+      while (played < frames){
+        if (convolver.aheadPlayed == convolver.blockSize){
+          convolve(convolver, NULL, convolver.ahead);
+          convolver.aheadPlayed = 0;
+        }
+        const unsigned int count = min(frames - played, convolver.blockSize - convolver.aheadPlayed);
+        for (unsigned int c=0; c<outputChannels; c++){
+          vectorKernels().add(outputFrames_.channelData(c) + played, convolver.ahead.channelData(c) + convolver.aheadPlayed, count);
+        }
+        convolver.aheadPlayed += count;
+        played += count;
+      }
+
+      if (convolver.drainFramesLeft <= frames){
+        convolver.drainFramesLeft = 0;
+        numDraining_--;
+      }
+      else{
+        convolver.drainFramesLeft -= frames;
+      }
+    }
+
+    void ConvolutionReverb_::spreadProducts( vector< vector<WorkItem_> > & stepWork, unsigned int channel, unsigned int bins,
+                                             size_t begin, size_t end, unsigned int first, unsigned int last ){
+      const unsigned int numSteps = last - first + 1;
+      const size_t count = end - begin;
+      for (unsigned int s=0; s<numSteps; s++){
+        size_t product = begin + count * s / numSteps;
+        const size_t stepEnd = begin + count * (s + 1) / numSteps;
+        while (product < stepEnd){
+          const unsigned int firstBin = (unsigned int)(product % bins);
+          WorkItem_ item = { WorkItem_::kMultiply, channel, (unsigned int)(product / bins), firstBin, (unsigned int)min((size_t)(bins - firstBin), stepEnd - product), 0 };
+          stepWork[3 * (first + s) + 1].push_back(item);
+          product += item.numBins;
+        }
+      }
+    }
+
+    void ConvolutionReverb_::scheduleTier( TierState_ & tier, const PartitionedImpulseResponse_::Tier_ & partitionedTier ){
+
+      const unsigned int inputChannels = numInputChannels();
+      const unsigned int outputChannels = outputFrames_.channels();
+      const unsigned int bins = partitionedTier.bins();
+      const size_t products = (size_t)partitionedTier.numPartitions * bins;
+
+      // The pieces of the FFTs - forward for each input channel, then inverse for each output channel - are
+      // spaced evenly across the steps, one to a step while there are enough steps. An output channel's
+      // products with the first partition need this round's input spectrum, so are spread over the steps
+      // from the last piece of its input's forward FFT to the first of its inverse one. Those with the
+      // later partitions use the spectra of earlier rounds and are spread over every step up to the inverse.
+      // Within a step the forward pieces go first, then the products, then the inverse pieces.
+      const unsigned int pieces = tier.pieces;
+      const unsigned int numPieces = (inputChannels + outputChannels) * pieces;
+      vector< vector<WorkItem_> > stepWork(3 * tier.steps);
+
+      for (unsigned int c=0; c<inputChannels; c++){
+        for (unsigned int m=0; m<pieces; m++){
+          WorkItem_ item = { WorkItem_::kForward, c, 0, 0, 0, m };
+          stepWork[3 * ((c * pieces + m) * tier.steps / numPieces)].push_back(item);
+        }
+      }
+
+      for (unsigned int c=0; c<outputChannels; c++){
+
+        const unsigned int forwarded = ((min(c, inputChannels - 1) + 1) * pieces - 1) * tier.steps / numPieces;
+        const unsigned int inverse = (inputChannels + c) * pieces * tier.steps / numPieces;
+        spreadProducts(stepWork, c, bins, bins, products, 0, inverse);
+        spreadProducts(stepWork, c, bins, 0, bins, forwarded, inverse);
+
+        for (unsigned int m=0; m<pieces; m++){
+          WorkItem_ item = { WorkItem_::kInverse, c, 0, 0, 0, m };
+          stepWork[3 * (((inputChannels + c) * pieces + m) * tier.steps / numPieces) + 2].push_back(item);
+        }
+      }
+
+      for (unsigned int s=0; s<tier.steps; s++){
+        tier.stepStart.push_back((unsigned int)tier.work.size());
+        for (unsigned int k=0; k<3; k++){
+          tier.work.insert(tier.work.end(), stepWork[3 * s + k].begin(), stepWork[3 * s + k].end());
+        }
+      }
+      tier.stepStart.push_back((unsigned int)tier.work.size());
+    }
+
+    // The spectrum X of the window x is the sum over pieces m of W^(m k) S_m(k), S_m being the spectrum of
+    // x(m), x(m + R), x(m + 2R)... for R pieces, and W = e^(-2 pi i / length)
+    void ConvolutionReverb_::forwardPiece( TierState_ & tier, unsigned int partitionFrames, const TonicFloat * older, const TonicFloat * newer,
+                                           unsigned int piece, TonicFloat * spectrumReal, TonicFloat * spectrumImag ){
+
+      const unsigned int pieces = tier.pieces;
+      const unsigned int bins = partitionFrames + 1;
+      const unsigned int pieceLength = 2 * partitionFrames / pieces;
+
+      const unsigned int half = pieceLength / 2;
+      for (unsigned int q=0; q<half; q++){
+        tier.transform[q] = older[q * pieces + piece];
+        tier.transform[half + q] = newer[q * pieces + piece];
+      }
+      tier.fft.forwardReal(&tier.transform[0], &tier.pieceReal[0], &tier.pieceImag[0]);
+
+      // S_m repeats every pieceLength bins, and above its own Nyquist bin is the conjugate of what's below
+      for (unsigned int k=pieceLength / 2 + 1; k<pieceLength; k++){
+        tier.pieceReal[k] = tier.pieceReal[pieceLength - k];
+        tier.pieceImag[k] = -tier.pieceImag[pieceLength - k];
+      }
+
+      const size_t twiddles = (size_t)(piece - 1) * bins;
+      for (unsigned int k=0; k<bins; k+=pieceLength){
+        const unsigned int count = min(pieceLength, bins - k);
+        if (piece == 0){
+          memcpy(spectrumReal + k, &tier.pieceReal[0], count * sizeof(TonicFloat));
+          memcpy(spectrumImag + k, &tier.pieceImag[0], count * sizeof(TonicFloat));
+        }
+        else{
+          vectorKernels().complexMultiplyAdd(spectrumReal + k, spectrumImag + k, &tier.twiddleReal[twiddles + k], &tier.twiddleImag[twiddles + k],
+                                             &tier.pieceReal[0], &tier.pieceImag[0], count);
+        }
+      }
+    }
+
+    // Samples x(R q + m) of the inverse of X are the inverse transform, of length / R, of
+    // Z_m(k) = 1/R sum over j of X(k + j length / R) W^(-m (k + j length / R))
+    void ConvolutionReverb_::inversePiece( TierState_ & tier, unsigned int partitionFrames, const TonicFloat * spectrumReal, const TonicFloat * spectrumImag,
+                                           unsigned int piece, TonicFloat * out ){
+
+      const unsigned int pieces = tier.pieces;
+      const unsigned int bins = partitionFrames + 1;
+      const unsigned int pieceLength = 2 * partitionFrames / pieces;
+      const unsigned int pieceBins = pieceLength / 2 + 1;
+
+      // V(k) = X(k) W^(-m k), up to the Nyquist bin
+      const TonicFloat *vr = spectrumReal;
+      const TonicFloat *vi = spectrumImag;
+      if (piece > 0){
+        const size_t twiddles = (size_t)(piece - 1) * bins;
+        memset(&tier.binsReal[0], 0, bins * sizeof(TonicFloat));
+        memset(&tier.binsImag[0], 0, bins * sizeof(TonicFloat));
+        vectorKernels().complexMultiplyAdd(&tier.binsReal[0], &tier.binsImag[0], spectrumReal, spectrumImag,
+                                           &tier.twiddleReal[twiddles], &tier.conjugateTwiddleImag[twiddles], bins);
+        vr = &tier.binsReal[0];
+        vi = &tier.binsImag[0];
+      }
+
+      // Above the Nyquist bin, V is the conjugate of V below it. The imaginary parts of V at 0 Hz and Nyquist
+      // only reach those of Z_m(0), which the real transform ignores.
+      memcpy(&tier.pieceReal[0], vr, pieceBins * sizeof(TonicFloat));
+      memcpy(&tier.pieceImag[0], vi, pieceBins * sizeof(TonicFloat));
+      for (unsigned int j=1; j<pieces / 2; j++){
+        vectorKernels().add(&tier.pieceReal[0], vr + j * pieceLength, pieceBins);
+        vectorKernels().add(&tier.pieceImag[0], vi + j * pieceLength, pieceBins);
+      }
+      for (unsigned int j=pieces / 2; j<pieces; j++){
+        const unsigned int mirror = (pieces - j) * pieceLength;
+        for (unsigned int k=0; k<pieceBins; k++){
+          tier.pieceReal[k] += vr[mirror - k];
+          tier.pieceImag[k] -= vi[mirror - k];
+        }
+      }
+      vectorKernels().multiplyScalar(&tier.pieceReal[0], 1.f / pieces, pieceBins);
+      vectorKernels().multiplyScalar(&tier.pieceImag[0], 1.f / pieces, pieceBins);
+
+      tier.fft.inverseReal(&tier.pieceReal[0], &tier.pieceImag[0], &tier.transform[0]);
+
+      for (unsigned int q=pieceLength / 2; q<pieceLength; q++){
+        out[q * pieces + piece - partitionFrames] = tier.transform[q];
+      }
+    }
+
+    void ConvolutionReverb_::runTierStep( Convolver_ & convolver, unsigned int t, unsigned int step, unsigned int resultIndex ){
+
+      TierState_ & tier = convolver.tiers[t];
+      const PartitionedImpulseResponse_::Tier_ & partitionedTier = convolver.partitioned.response()->tiers[t];
+      const unsigned int partitionFrames = partitionedTier.partitionFrames;
+      const unsigned int numPartitions = partitionedTier.numPartitions;
+      const unsigned int bins = partitionedTier.bins();
+      const unsigned int inputChannels = numInputChannels();
+      const unsigned int outputChannels = outputFrames_.channels();
+      const unsigned int responseChannels = convolver.partitioned.response()->channels;
+
+      // a new partition of input is complete
+      if (step == 0){
+        tier.head = (tier.head + 1) % numPartitions;
+        tier.newest = (tier.newest + 1) % 3;
+      }
+
+      for (unsigned int i=tier.stepStart[step]; i<tier.stepStart[step+1]; i++){
+
+        const WorkItem_ & item = tier.work[i];
+        const unsigned int c = item.channel;
+
+        switch (item.kind) {
+
+          // the spectrum of the latest complete partition, overlapped with the one before
+          case WorkItem_::kForward: {
+            const TonicFloat *window = &tier.window[c * 3 * partitionFrames];
+            const TonicFloat *older = window + ((tier.newest + 2) % 3) * partitionFrames;
+            const TonicFloat *newer = window + tier.newest * partitionFrames;
+            const size_t slot = (c * numPartitions + tier.head) * bins;
+            if (tier.pieces > 1){
+              forwardPiece(tier, partitionFrames, older, newer, item.piece, &tier.historyReal[slot], &tier.historyImag[slot]);
+            }
+            else{
+              memcpy(&tier.transform[0], older, partitionFrames * sizeof(TonicFloat));
+              memcpy(&tier.transform[partitionFrames], newer, partitionFrames * sizeof(TonicFloat));
+              tier.fft.forwardReal(&tier.transform[0], &tier.historyReal[slot], &tier.historyImag[slot]);
+            }
+            break;
+          }
+
+          // partition p times the spectrum from p partitions ago
+          case WorkItem_::kMultiply: {
+            const unsigned int p = item.partition;
+            const unsigned int history = (tier.head + numPartitions - p) % numPartitions;
+            const size_t slot = (min(c, inputChannels - 1) * numPartitions + history) * bins + item.firstBin;
+            const unsigned int responseChannel = min(c, responseChannels - 1);
+            vectorKernels().complexMultiplyAdd(&tier.sumReal[c * bins + item.firstBin], &tier.sumImag[c * bins + item.firstBin],
+                                               &tier.historyReal[slot], &tier.historyImag[slot],
+                                               &partitionedTier.spectraReal[responseChannel][p * bins + item.firstBin],
+                                               &partitionedTier.spectraImag[responseChannel][p * bins + item.firstBin], item.numBins);
+            break;
+          }
+
+          // overlap-save: the second half of the inverse transform is the convolution of the latest partition
+          case WorkItem_::kInverse: {
+            TonicFloat *result = &tier.result[(resultIndex * outputChannels + c) * partitionFrames];
+            if (tier.pieces > 1){
+              inversePiece(tier, partitionFrames, &tier.sumReal[c * bins], &tier.sumImag[c * bins], item.piece, result);
+            }
+            else{
+              tier.fft.inverseReal(&tier.sumReal[c * bins], &tier.sumImag[c * bins], &tier.transform[0]);
+              memcpy(result, &tier.transform[partitionFrames], partitionFrames * sizeof(TonicFloat));
+            }
+            if (item.piece == tier.pieces - 1){
+              memset(&tier.sumReal[c * bins], 0, bins * sizeof(TonicFloat));
+              memset(&tier.sumImag[c * bins], 0, bins * sizeof(TonicFloat));
+            }
+            break;
+          }
+        }
+      }
+    }
+
+  }
+
+  ConvolutionReverb & ConvolutionReverb::setImpulseResponse( SampleTable response ){
+    gen()->setImpulseResponse(response);
+    return *this;
+  }
+
+}
@@ -0,0 +1,363 @@
+//
+//  ConvolutionReverb.h
+//  Tonic
+//
+//
+// See LICENSE.txt for license and usage information.
+//
+
+#ifndef TONIC_CONVOLUTIONREVERB_H
+#define TONIC_CONVOLUTIONREVERB_H
+
+#include "Effect.h"
+#include "SampleTable.h"
+#include "DSPUtils.h"
+
+namespace Tonic {
+
+  namespace Tonic_ {
+
+    //! An impulse response cut into partitions for ConvolutionReverb_, with the spectra of the partitions
+    /*!
+        The response is split into tiers of partitions, each four times as long as the last: blockSize
+        frames for the first 8 blocks, then 4 blocks for the next 24 and so on, up to kMaxPartitionFrames.
+        Every tier after the first starts at twice its partition length into the response, which leaves
+        its convolution a whole partition's time to be computed in. Each partition's spectrum is the
+        2 * partitionFrames point FFT of its frames, zero-padded.
+
+        Never changed once built, and shared by every ConvolutionReverb_ with the same response and block size.
+     */
+    class PartitionedImpulseResponse_ : public ReferenceCounted_ {
+
+    public:
+
+      static const unsigned int kMaxPartitionFrames = 4096;
+
+      struct Tier_ {
+
+        unsigned int  partitionFrames;
+        unsigned int  numPartitions;
+
+        //! Response frame the first partition starts at
+        unsigned int  offset;
+
+        // partitionFrames + 1 bins per partition, partition after partition, one array per channel of the response
+        vector< vector<TonicFloat> > spectraReal;
+        vector< vector<TonicFloat> > spectraImag;
+
+        unsigned int bins() const { return partitionFrames + 1; }
+
+      };
+
+      unsigned int    frames;
+      unsigned int    channels;
+      unsigned int    blockSize;
+      vector<Tier_>   tiers;
+
+      PartitionedImpulseResponse_( SampleTable response, unsigned int blockSize );
+
+    };
+
+    class PartitionedImpulseResponse : public TonicSmartPointer<PartitionedImpulseResponse_> {
+
+    public:
+
+      PartitionedImpulseResponse() {}
+      PartitionedImpulseResponse( PartitionedImpulseResponse_ * partitioned ) : TonicSmartPointer<PartitionedImpulseResponse_>(partitioned) {}
+
+      const PartitionedImpulseResponse_ * response() const { return obj; }
+
+    };
+
+    //! The partitioned response for response at blockSize - built the first time, then shared. Not for the audio thread.
+    PartitionedImpulseResponse partitionedImpulseResponse( SampleTable response, unsigned int blockSize );
+
+    //! Convolution with a sampled impulse response, partitioned and in the frequency domain
+    /*!
+        Uniformly partitioned overlap-save convolution per tier of the PartitionedImpulseResponse_. The first
+        tier's partitions are one block long and are convolved as each block arrives, so the effect adds no
+        latency. A later tier collects a whole partition of input, then spreads its work across the blocks of
+        the next partition. Its FFTs - a forward one per input channel, then an inverse one per output channel -
+        are spaced evenly across those blocks, and each output channel's products with every partition's
+        spectrum are shared between the blocks from its input's FFT to its own. FFTs longer than
+        kMaxTransformLength are done in pieces of that length, each in a block of its own: a transform of
+        every R-th sample, combined with the others' by twiddle factors. The tiers start their partitions at
+        different blocks, placing each tier's FFTs between those of the tier before, so a long tail costs
+        about the same every block rather than all at once.
+
+        Output channel c is input channel c convolved with channel c of the response, the last channel of
+        either standing in for any missing: a mono response on stereo input convolves each side with it,
+        and a stereo response on mono input makes it stereo.
+
+        The partitions and state depend on the block size, so they are built ahead for every block size
+        announced by BufferFiller::setBlockSize, and setBlockSize() only swaps them in. The state for the
+        old size then plays out the tail of what came before, fed silence, alongside the new.
+     */
+    class ConvolutionReverb_ : public WetDryEffect_, public BlockSizeListener_ {
+
+    public:
+
+      //! Longest FFT done in one block. Longer ones are split into pieces of this length.
+      static const unsigned int kMaxTransformLength = 2048;
+
+    protected:
+
+      // One piece of a tier's work: a piece of the forward transform of an input channel, the products of one
+      // partition with its input spectrum over a range of bins for an output channel, or a piece of an output
+      // channel's inverse transform
+      struct WorkItem_ {
+        enum Kind { kForward, kMultiply, kInverse };
+        Kind          kind;
+        unsigned int  channel;
+        unsigned int  partition;
+        unsigned int  firstBin;
+        unsigned int  numBins;
+        unsigned int  piece;
+      };
+
+      struct TierState_ {
+
+        //! Of the length of a piece - 2 * partitionFrames / pieces
+        FFT             fft;
+
+        //! Pieces each transform is split into, a power of two
+        unsigned int    pieces;
+
+        //! Blocks per partition - the number of steps the tier's work is spread across
+        unsigned int    steps;
+
+        //! Blocks the tier's partitions start ahead of the first tier's, so different tiers' FFTs fall in different blocks
+        unsigned int    phase;
+
+        // the tier's work in order, and the first item of each step, plus the end
+        vector<WorkItem_>     work;
+        vector<unsigned int>  stepStart;
+
+        // the last three partitions of input, per input channel - the two transformed this round, whenever
+        // their turn comes, and the one being filled - in turn, the latest complete one at newest
+        vector<TonicFloat>  window;
+        unsigned int        newest;
+
+        // spectra of the last numPartitions windows, per input channel, newest at head
+        vector<TonicFloat>  historyReal;
+        vector<TonicFloat>  historyImag;
+        unsigned int        head;
+
+        // sum of products for the partition being computed, per output channel
+        vector<TonicFloat>  sumReal;
+        vector<TonicFloat>  sumImag;
+
+        // two partitions of convolved output per output channel - one played a block at a time while the
+        // other is computed, in turn
+        vector<TonicFloat>  result;
+
+        // two partitions for the transform being done
+        vector<TonicFloat>  transform;
+
+        // When split: the spectrum of a piece, a spectrum's bins, and W^(m k) for piece m > 0 and each bin k,
+        // piece after piece, to combine the pieces - W = e^(-2 pi i / 2 * partitionFrames)
+        vector<TonicFloat>  pieceReal;
+        vector<TonicFloat>  pieceImag;
+        vector<TonicFloat>  binsReal;
+        vector<TonicFloat>  binsImag;
+        vector<TonicFloat>  twiddleReal;
+        vector<TonicFloat>  twiddleImag;
+        vector<TonicFloat>  conjugateTwiddleImag;
+
+        TierState_( unsigned int fftLength ) : fft(fftLength) {}
+
+      };
+
+      //! Everything needed to convolve at one block size
+      struct Convolver_ {
+
+        unsigned int                blockSize;
+        PartitionedImpulseResponse  partitioned;
+        vector<TierState_>          tiers;
+        unsigned int                blockCount;
+
+        //! Nothing convolved since built or reset
+        bool                        clean;
+
+        // While draining, after the block size has changed from its own: a block of the tail computed ahead,
+        // to be played in blocks of the new size, how much of it has been played, and how much of the tail is
+        // left - none once drained
+        TonicFrames                 ahead;
+        unsigned int                aheadPlayed;
+        unsigned long               drainFramesLeft;
+
+        Convolver_ *                next;
+
+      };
+
+      SampleTable     response_;
+
+      // One per block size prepared, newest first. Only ever added to while playing.
+      Convolver_ *    convolvers_;
+
+      // The one convolving the input, and how many are playing out tails from before the block size changed
+      Convolver_ *    active_;
+      unsigned int    numDraining_;
+
+      // Held while building convolvers, off the audio thread
+      TONIC_MUTEX_T   prepareMutex_;
+
+      //! Rebuild the convolvers for the response and channels, at the block size and every one announced
+      void configure();
+
+      //! Partition the response for blockSize and set up the state to convolve with it. Allocates.
+      Convolver_ * buildConvolver( unsigned int blockSize );
+
+      //! Add to convolvers_ without locking, as the audio thread may be reading it
+      void addConvolver( Convolver_ * convolver );
+
+      //! The convolver prepared for blockSize, or NULL
+      Convolver_ * findConvolver( unsigned int blockSize );
+
+      void deleteConvolvers();
+
+      //! Clear a used convolver's state, to start again from silence
+      void resetConvolver( Convolver_ & convolver );
+
+      //! Plan a tier's work across its steps (see buildConvolver)
+      void scheduleTier( TierState_ & tier, const PartitionedImpulseResponse_::Tier_ & partitionedTier );
+
+      //! Share products begin to end of an output channel's - partition after partition, bin after bin - evenly between steps first to last
+      static void spreadProducts( vector< vector<WorkItem_> > & stepWork, unsigned int channel, unsigned int bins,
+                                  size_t begin, size_t end, unsigned int first, unsigned int last );
+
+      //! Convolve the next block of input - or of silence, if input is NULL - into out
+      void convolve( Convolver_ & convolver, const TonicFrames * input, TonicFrames & out );
+
+      //! Do one step's items of a tier's work, the inverse transforms writing to result buffer resultIndex
+      void runTierStep( Convolver_ & convolver, unsigned int tier, unsigned int step, unsigned int resultIndex );
+
+      //! Copy the input block, or silence, into the partition of a tier's window being filled
+      void fillTierWindow( TierState_ & tier, unsigned int blockSize, unsigned int step, const TonicFrames * input );
+
+      //! Add the next block of a draining convolver's tail to outputFrames_
+      void drain( Convolver_ & convolver );
+
+      //! Add piece piece of the spectrum of the window older, newer to spectrumReal, spectrumImag - or start it, for piece 0
+      void forwardPiece( TierState_ & tier, unsigned int partitionFrames, const TonicFloat * older, const TonicFloat * newer,
+                         unsigned int piece, TonicFloat * spectrumReal, TonicFloat * spectrumImag );
+
+      //! The samples of the second half of the inverse of spectrumReal, spectrumImag in piece piece - every pieces-th, from piece
+      void inversePiece( TierState_ & tier, unsigned int partitionFrames, const TonicFloat * spectrumReal, const TonicFloat * spectrumImag,
+                         unsigned int piece, TonicFloat * out );
+
+      void computeSynthesisBlock( const SynthesisContext_ &context );
+
+      unsigned long tailFrames( const SynthesisContext_ &context ){
+        return response_.frames() + outputFrames_.frames();
+      }
+
+    public:
+
+      ConvolutionReverb_();
+      ~ConvolutionReverb_();
+
+      //! Any number of channels, at the graph's sample rate. Partitions the response (see partitionedImpulseResponse), so not while playing.
+      void setImpulseResponse( SampleTable response );
+
+      void setNumInputChannels( unsigned int numChannels );
+
+      //! Swap in the convolver prepared for blockSize, the one it replaces playing out its tail
+      /*!
+          Only a block size never announced by BufferFiller::setBlockSize - when ticking with a context of
+          one's own - has its convolver built here, on the audio thread. Going back to a size whose convolver
+          is still draining picks up where it left off, unless it has part of a block of tail computed ahead:
+          then, as for one already drained, its state is cleared and the rest of its tail dropped.
+       */
+      void setBlockSize( unsigned int blockSize );
+
+      void prepareBlockSize( unsigned int blockSize );
+
+    };
+
+    inline void ConvolutionReverb_::fillTierWindow( TierState_ & tier, unsigned int blockSize, unsigned int step, const TonicFrames * input ){
+      const unsigned int partitionFrames = blockSize * tier.steps;
+      const size_t filling = ((tier.newest + 1) % 3) * partitionFrames + step * blockSize;
+      const unsigned int inputChannels = numInputChannels();
+      for (unsigned int c=0; c<inputChannels; c++){
+        if (input){
+          memcpy(&tier.window[c * 3 * partitionFrames + filling], input->channelData(c), blockSize * sizeof(TonicFloat));
+        }
+        else{
+          memset(&tier.window[c * 3 * partitionFrames + filling], 0, blockSize * sizeof(TonicFloat));
+        }
+      }
+    }
+
+    inline void ConvolutionReverb_::convolve( Convolver_ & convolver, const TonicFrames * input, TonicFrames & out ){
+
+      const unsigned int blockSize = convolver.blockSize;
+      const unsigned int outputChannels = out.channels();
+
+      for (unsigned int t=0; t<convolver.tiers.size(); t++){
+
+        TierState_ & tier = convolver.tiers[t];
+        const unsigned int partitionFrames = blockSize * tier.steps;
+        const unsigned int position = convolver.blockCount + tier.phase;
+        const unsigned int step = position % tier.steps;
+        const unsigned int round = position / tier.steps;
+
+        // the first tier convolves the block it has just been given
+        if (t == 0){
+          fillTierWindow(tier, blockSize, 0, input);
+          runTierStep(convolver, 0, 0, 0);
+          for (unsigned int c=0; c<outputChannels; c++){
+            memcpy(out.channelData(c), &tier.result[c * partitionFrames], blockSize * sizeof(TonicFloat));
+          }
+        }
+
+        // a later tier plays the partition it finished last round while computing the next into the other buffer
+        else{
+          const size_t played = (round % 2) * outputChannels * partitionFrames;
+          for (unsigned int c=0; c<outputChannels; c++){
+            vectorKernels().add(out.channelData(c), &tier.result[played + c * partitionFrames + step * blockSize], blockSize);
+          }
+          runTierStep(convolver, t, step, (round + 1) % 2);
+          fillTierWindow(tier, blockSize, step, input);
+        }
+      }
+
+      convolver.blockCount++;
+    }
+
+    inline void ConvolutionReverb_::computeSynthesisBlock( const SynthesisContext_ &context ){
+
+      if (!active_){
+        outputFrames_.clear();
+        return;
+      }
+
+      convolve(*active_, dryInput_, outputFrames_);
+      if (numDraining_ > 0){
+        for (Convolver_ * convolver = TONIC_ATOMIC_LOAD(convolvers_); convolver; convolver = convolver->next){
+          if (convolver->drainFramesLeft > 0) drain(*convolver);
+        }
+      }
+    }
+
+  }
+
+  //! Convolution reverb, for sampled rooms, halls, plates, speaker cabinets...
+  /*!
+      Plays the input through any impulse response with no added latency, and with the cost of a long
+      response spread evenly across blocks. Reverbs given the same response share its spectra.
+
+        SampleTable hall = loadAudioFile("hall.wav", 2);
+        Generator wet = ConvolutionReverb().setImpulseResponse(hall).input(voice).wetLevel(0.3).dryLevel(0.7);
+   */
+  class ConvolutionReverb : public TemplatedWetDryEffect<ConvolutionReverb, Tonic_::ConvolutionReverb_> {
+
+  public:
+
+    ConvolutionReverb & setImpulseResponse( SampleTable response );
+
+  };
+
+}
+
+#endif
@@ -9,148 +9,423 @@
 //
 
 #include "DSPUtils.h"
+#include "VectorKernels.h"
 
 namespace Tonic
 {
+  // --------------- Fast Fourier Transform ---------------
+
+  namespace Tonic_ {
+
+    /*
+      A mixed-radix Stockham FFT: every pass reads one buffer and writes the other, in order, so no
+      bit-reversal is needed. A pass of radix p over a remaining length n, stride s (the product of the
+      radices before it) and span m = n / p takes the p-point DFT of x[k + s(q + mj)], j < p, multiplies
+      output r by e^(-2 pi i qr / n) and writes it to y[k + s(pq + r)].
+
+      Odd factors come first, where the stride is smallest, since they aren't vectorized anyway, then the
+      4s, then a last 2 - leaving the longest strides for the vector kernels.
+     */
+    class FFTPlan_ {
+
+    public:
+
+      struct Pass_ {
+        unsigned int        radix;
+        size_t              stride;
+        size_t              span;
+
+        // twiddle[(radix - 1) q + r - 1] multiplies output r of butterfly q
+        vector<TonicFloat>  twiddleReal;
+        vector<TonicFloat>  twiddleImag;
+
+        // e^(-2 pi i t / radix), for the DFTs of odd radices
+        vector<TonicFloat>  rootReal;
+        vector<TonicFloat>  rootImag;
+      };
+
+      unsigned int    length;
+      vector<Pass_>   passes;
+
+      // e^(-2 pi i k / length) for k <= length / 4, to split a real transform from a complex one of half the length
+      vector<TonicFloat> realTwiddleReal;
+      vector<TonicFloat> realTwiddleImag;
+
+      FFTPlan_( unsigned int length );
+
+      //! Complex transform into out, using work, which like out holds length values per part.
+      void transform( const TonicFloat * inReal, const TonicFloat * inImag, TonicFloat * outReal, TonicFloat * outImag,
+                      TonicFloat * workReal, TonicFloat * workImag ) const;
+
+    protected:
+
+      void runPass( const Pass_ & pass, const TonicFloat * xReal, const TonicFloat * xImag, TonicFloat * yReal, TonicFloat * yImag ) const;
+
+    };
+
+    static const double kFFTTwoPi = 6.283185307179586476925;
+
+    FFTPlan_::FFTPlan_( unsigned int length ) : length(length) {
+
+      vector<unsigned int> odd;
+      unsigned int n = length;
+      for (unsigned int p = 3; p * p <= n; p += 2){
+        while (n % p == 0){
+          odd.push_back(p);
+          n /= p;
+        }
+      }
+      unsigned int fours = 0;
+      while (n % 4 == 0){
+        fours++;
+        n /= 4;
+      }
+      bool two = n % 2 == 0;
+      if (two) n /= 2;
+      if (n > 1) odd.push_back(n);
+
+      vector<unsigned int> radices = odd;
+      radices.insert(radices.end(), fours, 4);
+      if (two) radices.push_back(2);
+
+      size_t stride = 1;
+      size_t remaining = length;
+      for (unsigned int i = 0; i < radices.size(); i++){
+
+        Pass_ pass;
+        pass.radix = radices[i];
+        pass.stride = stride;
+        pass.span = remaining / pass.radix;
+
+        // in double precision, and reduced to one turn, so each is the nearest float to the exact value
+        for (size_t q = 0; q < pass.span; q++){
+          for (unsigned int r = 1; r < pass.radix; r++){
+            double angle = -kFFTTwoPi * (double)((q * r) % remaining) / remaining;
+            pass.twiddleReal.push_back((TonicFloat)cos(angle));
+            pass.twiddleImag.push_back((TonicFloat)sin(angle));
+          }
+        }
+        if (pass.radix % 2){
+          for (unsigned int t = 0; t < pass.radix; t++){
+            double angle = -kFFTTwoPi * t / pass.radix;
+            pass.rootReal.push_back((TonicFloat)cos(angle));
+            pass.rootImag.push_back((TonicFloat)sin(angle));
+          }
+        }
+
+        passes.push_back(pass);
+        stride *= pass.radix;
+        remaining = pass.span;
+      }
+
+      if (length % 2 == 0){
+        for (unsigned int k = 0; k <= length / 4; k++){
+          double angle = -kFFTTwoPi * k / length;
+          realTwiddleReal.push_back((TonicFloat)cos(angle));
+          realTwiddleImag.push_back((TonicFloat)sin(angle));
+        }
+      }
+    }
+
+    void FFTPlan_::runPass( const Pass_ & pass, const TonicFloat * xReal, const TonicFloat * xImag, TonicFloat * yReal, TonicFloat * yImag ) const {
+
+      const TonicFloat * twiddleReal = pass.twiddleReal.empty() ? NULL : &pass.twiddleReal[0];
+      const TonicFloat * twiddleImag = pass.twiddleImag.empty() ? NULL : &pass.twiddleImag[0];
+
+      if (pass.radix == 4){
+        vectorKernels().fftRadix4(xReal, xImag, yReal, yImag, pass.stride, pass.span, twiddleReal, twiddleImag);
+        return;
+      }
+      if (pass.radix == 2){
+        vectorKernels().fftRadix2(xReal, xImag, yReal, yImag, pass.stride, pass.span, twiddleReal, twiddleImag);
+        return;
+      }
+
+      // any odd radix, as a plain DFT - at most 32 points are kept on the stack
+      const unsigned int p = pass.radix;
+      const size_t s = pass.stride;
+      TonicFloat stackReal[32], stackImag[32];
+      vector<TonicFloat> heapReal, heapImag;
+      TonicFloat * aReal = stackReal, * aImag = stackImag;
+      if (p > 32){
+        heapReal.resize(p);
+        heapImag.resize(p);
+        aReal = &heapReal[0];
+        aImag = &heapImag[0];
+      }
+
+      for (size_t q = 0; q < pass.span; q++){
+        for (size_t k = 0; k < s; k++){
+
+          for (unsigned int j = 0; j < p; j++){
+            aReal[j] = xReal[k + s * (q + pass.span * j)];
+            aImag[j] = xImag[k + s * (q + pass.span * j)];
+          }
+
+          for (unsigned int r = 0; r < p; r++){
+            TonicFloat sumReal = aReal[0], sumImag = aImag[0];
+            unsigned int t = 0;
+            for (unsigned int j = 1; j < p; j++){
+              t += r;
+              if (t >= p) t -= p;
+              sumReal += aReal[j] * pass.rootReal[t] - aImag[j] * pass.rootImag[t];
+              sumImag += aReal[j] * pass.rootImag[t] + aImag[j] * pass.rootReal[t];
+            }
+            size_t out = k + s * (p * q + r);
+            if (r == 0){
+              yReal[out] = sumReal;
+              yImag[out] = sumImag;
+            }
+            else{
+              TonicFloat wr = twiddleReal[(p - 1) * q + r - 1], wi = twiddleImag[(p - 1) * q + r - 1];
+              yReal[out] = sumReal * wr - sumImag * wi;
+              yImag[out] = sumReal * wi + sumImag * wr;
+            }
+          }
+        }
+      }
+    }
+
+    void FFTPlan_::transform( const TonicFloat * inReal, const TonicFloat * inImag, TonicFloat * outReal, TonicFloat * outImag,
+                              TonicFloat * workReal, TonicFloat * workImag ) const {
+
+      const size_t numPasses = passes.size();
+      if (numPasses == 0){
+        if (outReal != inReal) memmove(outReal, inReal, length * sizeof(TonicFloat));
+        if (outImag != inImag) memmove(outImag, inImag, length * sizeof(TonicFloat));
+        return;
+      }
+
+      // passes alternate between out and work, ending in out. If the first writes to out, and out is
+      // the input, the input goes to work first.
+      const TonicFloat * srcReal = inReal, * srcImag = inImag;
+      bool toOut = numPasses % 2 == 1;
+      if (toOut && (inReal == outReal || inImag == outImag || inReal == outImag || inImag == outReal)){
+        memcpy(workReal, inReal, length * sizeof(TonicFloat));
+        memcpy(workImag, inImag, length * sizeof(TonicFloat));
+        srcReal = workReal;
+        srcImag = workImag;
+      }
+
+      for (size_t i = 0; i < numPasses; i++){
+        TonicFloat * dstReal = toOut ? outReal : workReal;
+        TonicFloat * dstImag = toOut ? outImag : workImag;
+        runPass(passes[i], srcReal, srcImag, dstReal, dstImag);
+        srcReal = dstReal;
+        srcImag = dstImag;
+        toOut = !toOut;
+      }
+    }
+
+    // Plans are made once per length and kept for good
+    struct FFTPlanCache_ {
+      TONIC_MUTEX_T mutex;
+      std::map<unsigned int, const FFTPlan_ *> plans;
+      FFTPlanCache_() { TONIC_MUTEX_INIT(mutex); }
+    };
+
+    static const FFTPlan_ * fftPlan( unsigned int length ){
+      static FFTPlanCache_ * cache = new FFTPlanCache_;
+      TONIC_MUTEX_LOCK(cache->mutex);
+      const FFTPlan_ *& plan = cache->plans[length];
+      if (!plan) plan = new FFTPlan_(length);
+      const FFTPlan_ * result = plan;
+      TONIC_MUTEX_UNLOCK(cache->mutex);
+      return result;
+    }
+
+    FFT_::FFT_( unsigned int length ) : length_(length), halfPlan_(NULL) {
+      if (length_ < 1){
+        error("FFT - the length must be at least 1");
+        length_ = 1;
+      }
+      plan_ = fftPlan(length_);
+      if (length_ % 2 == 0) halfPlan_ = fftPlan(length_ / 2);
+
+      // a complex transform needs two parts of work space; an even real one three, to untangle the two
+      // halves; an odd real one six, as it is done as a complex one
+      work_.resize(length_ * (length_ % 2 == 0 ? 3 : 6));
+    }
+
+    void FFT_::forward( const TonicFloat * realIn, const TonicFloat * imagIn, TonicFloat * realOut, TonicFloat * imagOut ){
+      plan_->transform(realIn, imagIn, realOut, imagOut, &work_[0], &work_[length_]);
+    }
+
+    void FFT_::inverse( const TonicFloat * realIn, const TonicFloat * imagIn, TonicFloat * realOut, TonicFloat * imagOut ){
+      // swapping the real and imaginary parts conjugates, scaled by i - the forward transform of that, swapped back, is the inverse
+      plan_->transform(imagIn, realIn, imagOut, realOut, &work_[length_], &work_[0]);
+      vectorKernels().multiplyScalar(realOut, 1.f / length_, length_);
+      vectorKernels().multiplyScalar(imagOut, 1.f / length_, length_);
+    }
+
+    void FFT_::forwardReal( const TonicFloat * in, TonicFloat * realOut, TonicFloat * imagOut ){
+
+      const unsigned int bins = length_ / 2 + 1;
+
+      if (length_ % 2){
+        TonicFloat * zeros = &work_[0];
+        TonicFloat * real = &work_[length_], * imag = &work_[2 * length_];
+        memset(zeros, 0, length_ * sizeof(TonicFloat));
+        plan_->transform(in, zeros, real, imag, &work_[3 * length_], &work_[4 * length_]);
+        memcpy(realOut, real, bins * sizeof(TonicFloat));
+        memcpy(imagOut, imag, bins * sizeof(TonicFloat));
+        return;
+      }
+
+      // the even samples as the real part and the odd ones as the imaginary part of a half-length transform
+      const unsigned int half = length_ / 2;
+      TonicFloat * zReal = &work_[0], * zImag = &work_[half];
+      for (unsigned int k = 0; k < half; k++){
+        zReal[k] = in[2 * k];
+        zImag[k] = in[2 * k + 1];
+      }
+      halfPlan_->transform(zReal, zImag, realOut, imagOut, &work_[length_], &work_[2 * length_]);
+
+      // its bins k and half - k give the spectra of the even and odd samples, E and O, at k and X[k] = E + e^(-2 pi i k / length) O
+      const TonicFloat z0Real = realOut[0], z0Imag = imagOut[0];
+      for (unsigned int k = 1; k <= half / 2; k++){
+        const unsigned int j = half - k;
+        const TonicFloat evenReal = 0.5f * (realOut[k] + realOut[j]);
+        const TonicFloat evenImag = 0.5f * (imagOut[k] - imagOut[j]);
+        const TonicFloat oddReal = 0.5f * (imagOut[k] + imagOut[j]);
+        const TonicFloat oddImag = 0.5f * (realOut[j] - realOut[k]);
+        const TonicFloat wr = plan_->realTwiddleReal[k], wi = plan_->realTwiddleImag[k];
+        const TonicFloat turnedReal = oddReal * wr - oddImag * wi;
+        const TonicFloat turnedImag = oddReal * wi + oddImag * wr;
+        realOut[k] = evenReal + turnedReal;
+        imagOut[k] = evenImag + turnedImag;
+        realOut[j] = evenReal - turnedReal;
+        imagOut[j] = turnedImag - evenImag;
+      }
+      realOut[0] = z0Real + z0Imag;
+      imagOut[0] = 0;
+      realOut[half] = z0Real - z0Imag;
+      imagOut[half] = 0;
+    }
+
+    void FFT_::inverseReal( const TonicFloat * realIn, const TonicFloat * imagIn, TonicFloat * out ){
+
+      if (length_ % 2){
+        // the whole spectrum, the upper half the conjugate of the lower
+        TonicFloat * real = &work_[0], * imag = &work_[length_];
+        real[0] = realIn[0];
+        imag[0] = 0;
+        for (unsigned int k = 1; k <= length_ / 2; k++){
+          real[k] = real[length_ - k] = realIn[k];
+          imag[k] = imagIn[k];
+          imag[length_ - k] = -imagIn[k];
+        }
+        TonicFloat * resultImag = &work_[2 * length_];
+        plan_->transform(imag, real, resultImag, out, &work_[3 * length_], &work_[4 * length_]);
+        vectorKernels().multiplyScalar(out, 1.f / length_, length_);
+        return;
+      }
+
+      // the reverse of forwardReal: E and O from bins k and half - k, then the half-length transform of E + iO
+      const unsigned int half = length_ / 2;
+      TonicFloat * zReal = &work_[0], * zImag = &work_[half];
+      zReal[0] = 0.5f * (realIn[0] + realIn[half]);
+      zImag[0] = 0.5f * (realIn[0] - realIn[half]);
+      for (unsigned int k = 1; k <= half / 2; k++){
+        const unsigned int j = half - k;
+        const TonicFloat evenReal = 0.5f * (realIn[k] + realIn[j]);
+        const TonicFloat evenImag = 0.5f * (imagIn[k] - imagIn[j]);
+        const TonicFloat differenceReal = 0.5f * (realIn[k] - realIn[j]);
+        const TonicFloat differenceImag = 0.5f * (imagIn[k] + imagIn[j]);
+        const TonicFloat wr = plan_->realTwiddleReal[k], wi = plan_->realTwiddleImag[k];
+        const TonicFloat oddReal = differenceReal * wr + differenceImag * wi;
+        const TonicFloat oddImag = differenceImag * wr - differenceReal * wi;
+        zReal[k] = evenReal - oddImag;
+        zImag[k] = evenImag + oddReal;
+        zReal[j] = evenReal + oddImag;
+        zImag[j] = oddReal - evenImag;
+      }
+
+      TonicFloat * resultReal = &work_[length_], * resultImag = &work_[length_ + half];
+      halfPlan_->transform(zImag, zReal, resultImag, resultReal, &work_[2 * length_ + half], &work_[2 * length_]);
+      const TonicFloat scale = 1.f / half;
+      for (unsigned int k = 0; k < half; k++){
+        out[2 * k] = resultReal[k] * scale;
+        out[2 * k + 1] = resultImag[k] * scale;
+      }
+    }
+
+  }
+
   // --------------- Time/Frequency Analysis --------------
   
   // Discrete Fourier Transform
   void DFT(int length, float *realTimeIn, float *imagTimeIn, float *realFreqOut, float *imagFreqOut)
   {
-    
-    int k, i;
-    float sr, si, p;
-    
-    memset(realFreqOut, 0, sizeof(float) * length);
-    memset(imagFreqOut, 0, sizeof(float) * length);
-    
-    for(k = 0; k < length; k++)
-      for(i = 0; i < length; i++)
-      {
-        p = (2.0f * PI * (float)(k * i)) / length;
-        sr = cosf(p);
-        si = -sinf(p);
-        realFreqOut[k] += (realTimeIn[i] * sr) - (imagTimeIn[i] * si);
-        imagFreqOut[k] += (realTimeIn[i] * si) + (imagTimeIn[i] * sr);
-      }
+    if (length < 1) return;
+    FFT(length).forward(realTimeIn, imagTimeIn, realFreqOut, imagFreqOut);
   }
   
   // Inverse Discrete Fourier Transform
   void InverseDFT(int length, float *realFreqIn, float *imagFreqIn, float *realTimeOut, float *imagTimeOut)
   {
-    int k, i;
-    float sr, si, p;
-    
-    memset(realTimeOut, 0, sizeof(float) * length);
-    memset(imagTimeOut, 0, sizeof(float) * length);
-    
-    for(k = 0; k < length; k++)
-    {
-      for(i = 0; i < length; i++)
-      {
-        p = (2.0f * PI * (float)(k * i)) / length;
-        sr = cosf(p);
-        si = -sinf(p);
-        realTimeOut[k] += (realFreqIn[i] * sr) + (imagFreqIn[i] * si);
-        imagTimeOut[k] += (realFreqIn[i] * si) - (imagFreqIn[i] * sr);
-      }
-      realTimeOut[k] /= (float)length;
-      imagTimeOut[k] /= (float)length;
-    }
+    if (length < 1) return;
+    FFT(length).inverse(realFreqIn, imagFreqIn, realTimeOut, imagTimeOut);
   }
   
   // Real Cepstrum
   void RealCepstrum(int length, float *signalIn, float *realCepstrumOut)
   {
-    float *realTime, *imagTime, *realFreq, *imagFreq;
-    int i;
+    if (length < 1) return;
     
-    realTime = new float[length];
-    imagTime = new float[length];
-    realFreq = new float[length];
-    imagFreq = new float[length];
+    FFT fft(length);
+    int bins = length / 2 + 1;
+    vector<float> realFreq(bins), imagFreq(bins);
     
-    // Compose Complex FFT Input
+    fft.forwardReal(signalIn, &realFreq[0], &imagFreq[0]);
     
-    for(i = 0; i < length; i++)
+    // Calculate Log Of Absolute Value, floored 180 dB below the peak - an FFT leaves stopband bins
+    // at exactly zero often enough, and their log would make the whole cepstrum NaN
+    
+    float peak = 0.0f;
+    for(int i = 0; i < bins; i++)
     {
-      realTime[i] = signalIn[i];
-      imagTime[i] = 0.0f;
+      realFreq[i] = cabs(realFreq[i], imagFreq[i]);
+      peak = max(peak, realFreq[i]);
     }
+    float minimum = max(peak * 1.e-9f, std::numeric_limits<float>::min());
     
-    // Perform DFT
-    
-    DFT(length, realTime, imagTime, realFreq, imagFreq);
-    
-    // Calculate Log Of Absolute Value
-    
-    for(i = 0; i < length; i++)
+    for(int i = 0; i < bins; i++)
     {
-      realFreq[i] = logf(cabs(realFreq[i], imagFreq[i]));
+      realFreq[i] = logf(max(realFreq[i], minimum));
       imagFreq[i] = 0.0f;
     }
     
-    // Perform Inverse FFT
-    
-    InverseDFT(length, realFreq, imagFreq, realTime, imagTime);
-    
-    // Output Real Part Of FFT
-    for(i = 0; i < length; i++)
-      realCepstrumOut[i] = realTime[i];
-    
-    delete realTime;
-    delete imagTime;
-    delete realFreq;
-    delete imagFreq;
+    fft.inverseReal(&realFreq[0], &imagFreq[0], realCepstrumOut);
   }
   
   // Compute Minimum Phase Reconstruction Of Signal
   void MinimumPhase(int length, float *realCepstrum, float *minimumPhase)
   {
+    if (length < 1) return;
+    
     int i, nd2;
-    float *realTime, *imagTime, *realFreq, *imagFreq;
+    vector<float> realTime(length, 0.0f);
     
     nd2 = length / 2;
-    realTime = new float[length];
-    imagTime = new float[length];
-    realFreq = new float[length];
-    imagFreq = new float[length];
-    
-    if((length % 2) == 1)
-    {
-      realTime[0] = realCepstrum[0];
-      for(i = 1; i < nd2; i++)
-        realTime[i] = 2.0f * realCepstrum[i];
-      for(i = nd2; i < length; i++)
-        realTime[i] = 0.0f;
-    }
-    else
-    {
-      realTime[0] = realCepstrum[0];
-      for(i = 1; i < nd2; i++)
-        realTime[i] = 2.0f * realCepstrum[i];
+    realTime[0] = realCepstrum[0];
+    for(i = 1; i < nd2; i++)
+      realTime[i] = 2.0f * realCepstrum[i];
+    if((length % 2) == 0)
       realTime[nd2] = realCepstrum[nd2];
-      for(i = nd2 + 1; i < length; i++)
-        realTime[i] = 0.0f;
-    }
     
-    for(i = 0; i < length; i++)
-      imagTime[i] = 0.0f;
+    // the folded cepstrum is real, so its spectrum and the exponential of that are conjugate-symmetric
+    // and the real transforms suffice
+    FFT fft(length);
+    int bins = nd2 + 1;
+    vector<float> realFreq(bins), imagFreq(bins);
     
-    DFT(length, realTime, imagTime, realFreq, imagFreq);
+    fft.forwardReal(&realTime[0], &realFreq[0], &imagFreq[0]);
     
-    for(i = 0; i < length; i++)
+    for(i = 0; i < bins; i++)
       cexp(realFreq[i], imagFreq[i], &realFreq[i], &imagFreq[i]);
     
-    InverseDFT(length, realFreq, imagFreq, realTime, imagTime);
-    
-    for(i = 0; i < length; i++)
-      minimumPhase[i] = realTime[i];
-    
-    delete realTime;
-    delete imagTime;
-    delete realFreq;
-    delete imagFreq;
+    fft.inverseReal(&realFreq[0], &imagFreq[0], minimumPhase);
   }
   
   // ---------------- minBLEP Generation --------------------
@@ -170,8 +445,7 @@ namespace Tonic
     float r, a, b;
     float *buffer1, *buffer2, *minBLEP;
     
-    // use power-of-two for DFT/Cepstrum for potential future
-    // speed boost
+    // a power of two if zeroCrossings and overSampling are, the fastest length for the FFTs
     n = (zeroCrossings * 2 * overSampling) + 1;
     m = n-1;
     
@@ -220,8 +494,8 @@ namespace Tonic
       minBLEP[i] *= a;
     }
         
-    delete buffer1;
-    delete buffer2;
+    delete [] buffer1;
+    delete [] buffer2;
     return minBLEP;
   }
 
@@ -79,19 +79,107 @@ namespace Tonic
     }
   }
   
+  // --------------- Fast Fourier Transform ---------------
+
+  namespace Tonic_ {
+
+    // Factors and twiddles for one transform length, built once per length and shared
+    class FFTPlan_;
+
+    class FFT_ : public ReferenceCounted_ {
+
+    protected:
+
+      unsigned int      length_;
+      const FFTPlan_ *  plan_;
+
+      // length / 2, for real transforms of even lengths
+      const FFTPlan_ *  halfPlan_;
+
+      vector<TonicFloat> work_;
+
+    public:
+
+      FFT_( unsigned int length );
+
+      unsigned int length() const { return length_; }
+
+      void forward( const TonicFloat * realIn, const TonicFloat * imagIn, TonicFloat * realOut, TonicFloat * imagOut );
+      void inverse( const TonicFloat * realIn, const TonicFloat * imagIn, TonicFloat * realOut, TonicFloat * imagOut );
+
+      void forwardReal( const TonicFloat * in, TonicFloat * realOut, TonicFloat * imagOut );
+      void inverseReal( const TonicFloat * realIn, const TonicFloat * imagIn, TonicFloat * out );
+
+    };
+
+  }
+
+  //! Fast Fourier transform of a fixed length, complex or real
+  /*!
+      Any length works. The length is split into factors of 4, 2 and odd primes, and each factor is
+      one pass over the data, with its twiddle factors worked out in advance. Passes of 4 and 2 run
+      on the vector kernels (see vectorKernels()), so powers of two are fastest. Each odd factor p
+      costs p times as much as a factor of 2, so a length with a large prime factor is slow - as slow
+      as a plain DFT if the length is itself prime.
+
+      Complex data is split into arrays of real and imaginary parts. The forward transform is unscaled,
+      X[k] = sum x[n] e^(-2 pi i k n / length). The inverse divides by the length, so it undoes the forward
+      transform. Inputs and outputs may be the same arrays, but must not otherwise overlap.
+
+      The real transforms take length real samples to the length / 2 + 1 bins from 0 Hz to Nyquist, and
+      back. An even length costs half as much as the complex transform.
+
+      The twiddles are shared by every FFT of the same length. Each FFT also has its own work space,
+      so transforms never allocate and are safe on the audio thread - but copies of an FFT share
+      that work space, so use a separate one on each thread.
+
+        FFT fft(1024);
+        fft.forwardReal(samples, real, imag);   // real and imag hold 513 bins
+        fft.inverseReal(real, imag, samples);
+   */
+  class FFT : public TonicSmartPointer<Tonic_::FFT_> {
+
+  public:
+
+    FFT( unsigned int length ) : TonicSmartPointer<Tonic_::FFT_>(new Tonic_::FFT_(length)) {}
+
+    unsigned int length() const { return obj->length(); }
+
+    //! Complex transform of length values in each of realIn and imagIn
+    void forward( const TonicFloat * realIn, const TonicFloat * imagIn, TonicFloat * realOut, TonicFloat * imagOut ) const {
+      obj->forward(realIn, imagIn, realOut, imagOut);
+    }
+
+    //! Inverse complex transform, divided by the length
+    void inverse( const TonicFloat * realIn, const TonicFloat * imagIn, TonicFloat * realOut, TonicFloat * imagOut ) const {
+      obj->inverse(realIn, imagIn, realOut, imagOut);
+    }
+
+    //! Transform of length real samples. realOut and imagOut receive length / 2 + 1 bins.
+    void forwardReal( const TonicFloat * in, TonicFloat * realOut, TonicFloat * imagOut ) const {
+      obj->forwardReal(in, realOut, imagOut);
+    }
+
+    //! Inverse of forwardReal, from length / 2 + 1 bins. The imaginary parts of the 0 Hz and Nyquist bins are ignored.
+    void inverseReal( const TonicFloat * realIn, const TonicFloat * imagIn, TonicFloat * out ) const {
+      obj->inverseReal(realIn, imagIn, out);
+    }
+
+  };
+
   // --------------- Time/Frequency Analysis --------------
   
   //! Discrete Fourier Transform
   /*!
-      Non-FFT, brute force approach intended for wavetable generation.
-      Do not use for real-time processing.
+      Computed with an FFT of the given length, set up for this call. For repeated transforms,
+      keep an FFT instead.
    */
   void DFT(int length, float *realTimeIn, float *imagTimeIn, float *realFreqOut, float *imagFreqOut);
   
   //! Inverse Discrete Fourier Transform
   /*!
-      Non-FFT, brute force approach intended for wavetable generation.
-      Do not use for real-time processing.
+      Computed with an FFT of the given length, set up for this call. For repeated transforms,
+      keep an FFT instead.
    */
   void InverseDFT(int length, float *realFreqIn, float *imagFreqIn, float *realTimeOut, float *imagTimeOut);
   
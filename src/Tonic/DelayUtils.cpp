@@ -15,18 +15,40 @@ namespace Tonic {
     readHead_(0),
     writeHead_(0),
     isInitialized_(false),
-    interpolates_(true)
+    interpolates_(true),
+    maxDelay_(0),
+    sampleRate_(Tonic::sampleRate())
   {
     resize(kSynthesisBlockSize, 1, 0);
   }
   
   void DelayLine::initialize(float maxDelay, unsigned int channels)
   {
-    unsigned int nFrames = max(2, maxDelay * Tonic::sampleRate());
+    maxDelay_ = maxDelay;
+    unsigned int nFrames = max(2, maxDelay * sampleRate_);
     resize(nFrames, channels, 0);
     isInitialized_ = true;
   }
   
+  void DelayLine::setSampleRate(float sampleRate)
+  {
+    if (sampleRate == sampleRate_) return;
+    
+    sampleRate_ = sampleRate;
+    
+    if (isInitialized_){
+      unsigned int nFrames = max(2, maxDelay_ * sampleRate_);
+      if (nFrames != nFrames_){
+        resize(nFrames, nChannels_, 0);
+        writeHead_ = 0;
+        readHead_ = 0;
+      }
+    }
+    
+    // recompute the read head from the delay time on the next tickOut()
+    lastDelayTime_ = -1.f;
+  }
+  
   void DelayLine::clear()
   {
     if (isInitialized_){
@@ -12,6 +12,7 @@
 
 #include "TonicFrames.h"
 #include <cmath>
+#include <climits>
 
 namespace Tonic {
   
@@ -27,23 +28,49 @@ namespace Tonic {
     float readHead_;
     float lastDelayTime_;
     
+    float maxDelay_;
+    float sampleRate_;
+    
   public:
     
     //! Allocation parameters are binding. No post-allocation resizing or modifying channel layout (for now anyway).
     /*!
-        Samples are interleaved if allocated with multiple channels.
+        Each channel's samples are contiguous if allocated with multiple channels.
     */
     DelayLine();
     
     //! MUST be called prior to usage
+    /*!
+        Sized for maxDelay seconds at the default sample rate until setSampleRate() is called.
+     */
     void initialize(float maxDelay = 1.0f, unsigned int channels = 1);
     
+    //! Resize for the same maximum delay at a new sample rate. Clears the line if the size changes.
+    /*!
+        Owners call this from Generator_::setSampleRate(). Allocates if the line grows.
+     */
+    void setSampleRate(float sampleRate);
+    
     //! Set whether interpolates or not
     void setInterpolates( bool doesInterpolate ) { interpolates_ = doesInterpolate; };
     
     //! Zero delay line
     void clear();
     
+    //! Frames until the line's contents decay below kSilenceThreshold once its input stops, with the given feedback
+    /*!
+        Assumes the longest possible delay. Effectively forever for feedback of magnitude 1 or more.
+     */
+    unsigned long tailFrames(TonicFloat feedback) const {
+      feedback = fabsf(feedback);
+      if (feedback >= 1.f) return ULONG_MAX;
+      unsigned long repeats = 1;
+      if (feedback > kSilenceThreshold){
+        repeats += (unsigned long)ceilf(logf(kSilenceThreshold) / logf(feedback));
+      }
+      return nFrames_ * repeats;
+    }
+    
     // !!!: ND
     // The below functions are single-sample and very one-purposed for a reason:
     // as a helper class this will allow the most flexibility for feedback  and more complex
@@ -57,7 +84,7 @@ namespace Tonic {
     inline TonicFloat tickOut(float delayTime, unsigned int channel = 0) {
       
       if (delayTime != lastDelayTime_){
-        float dSamp = clamp(delayTime * Tonic::sampleRate(), 0, nFrames_);
+        float dSamp = clamp(delayTime * sampleRate_, 0, nFrames_);
         readHead_ = (float)writeHead_ - dSamp;
         if (readHead_ < 0) {
           readHead_ += (float)nFrames_;
@@ -69,17 +96,18 @@ namespace Tonic {
         // Fractional and integral part of read head
         float fidx;
         float frac = modff(readHead_, &fidx);
-        int idx_a = ((int)fidx * nChannels_ + channel);
-        if (idx_a >= size_) idx_a -= size_; // this happens occasionally due to floating point rounding
-        int idx_b = idx_a + nChannels_;
-        if (idx_b >= size_) idx_b -= size_;
+        const TonicFloat *cdata = data_ + channel * nFrames_;
+        int idx_a = (int)fidx;
+        if (idx_a >= nFrames_) idx_a -= nFrames_; // this happens occasionally due to floating point rounding
+        int idx_b = idx_a + 1;
+        if (idx_b >= nFrames_) idx_b -= nFrames_;
         
         // Linear interpolation
-        return (data_[idx_a] + frac * (data_[idx_b] - data_[idx_a]));
+        return (cdata[idx_a] + frac * (cdata[idx_b] - cdata[idx_a]));
       }
       else{
         
-        return (data_[((int)(readHead_))*nChannels_ + channel]);
+        return (data_[channel * nFrames_ + (int)(readHead_)]);
       }
     }
     
@@ -89,7 +117,7 @@ namespace Tonic {
     */
     inline void tickIn(TonicFloat sample, unsigned int channel = 0){
       
-      data_[writeHead_*nChannels_+channel] = sample;
+      data_[channel * nFrames_ + writeHead_] = sample;
     }
     
     //! Advance read/write heads
@@ -17,8 +17,9 @@ namespace Tonic
   namespace Tonic_
   {
    
-    Effect_::Effect_() : isStereoInput_(false)
+    Effect_::Effect_() : silentInputFrames_(0), isAsleep_(false)
     {
+      dryInput_ = &dryFrames_;
       dryFrames_.resize(kSynthesisBlockSize, 1, 0);
       bypassGen_ = ControlValue(0);
     }
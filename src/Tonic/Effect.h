@@ -23,10 +23,33 @@ namespace Tonic {
       protected:
         
         Generator input_;
+        
+        // Input channel layout. Holds the dry input only when it has to be converted or copied.
         TonicFrames dryFrames_;
         
+        // Dry input for the block being computed - the input generator's own output where possible, otherwise dryFrames_
+        const TonicFrames * dryInput_;
+        
         ControlGenerator bypassGen_;
-        bool isStereoInput_;
+        
+        // Frames since the input was last known to be non-silent
+        unsigned long silentInputFrames_;
+        bool isAsleep_;
+        
+        //! Number of frames the effect can go on producing output for once its input falls silent
+        /*!
+            An effect whose input has been silent for longer than this, and whose output has decayed below
+            kSilenceThreshold, goes to sleep while the context skips silence: it outputs silence without
+            computing until its input makes a sound again. The output check covers filters' ringing, so
+            only effects which can be quiet for a while and then sound again (delays, reverbs) override.
+         */
+        virtual unsigned long tailFrames( const SynthesisContext_ &context ) { return 0; };
+        
+        // Called after ticking the input. True if the effect is asleep and the block can be skipped.
+        bool sleepsThisBlock( const SynthesisContext_ &context );
+        
+        // Called after computing a block. Puts the effect to sleep once its tail has died away.
+        void updateSleepState( const SynthesisContext_ &context );
         
       public:
         
@@ -36,79 +59,149 @@ namespace Tonic {
 
         virtual void setInput( Generator input ) { input_ = input; };
         
-        //! set stereo/mono - changes number of channels in dryFrames_
+        //! set number of input channels - changes number of channels in dryFrames_
         /*!
-            subclasses should call in constructor to determine input channel layout
+            subclasses should call in constructor to determine input channel layout.
+            Input with a different number of channels is converted as by TonicFrames::copy().
         */
-        virtual void setIsStereoInput( bool stereo );
+        virtual void setNumInputChannels( unsigned int numChannels );
+        
+        unsigned int numInputChannels() const { return dryFrames_.channels(); };
+        
+        //! set stereo/mono - shorthand for setNumInputChannels(2 or 1)
+        void setIsStereoInput( bool stereo ){ setNumInputChannels(stereo ? 2 : 1); };
         
-        bool isStereoInput() { return isStereoInput_; };
+        bool isStereoInput() const { return numInputChannels() == 2; };
+        
+        virtual void setBlockSize( unsigned int blockSize );
 
         // --- Tick methods ---
         
-        virtual void tick(TonicFrames &frames, const SynthesisContext_ &context );
+        virtual void updateOutput( const SynthesisContext_ &context );
         
         //! Apply effect directly to passed in frames (output in-place)
         /*!
             DO NOT mix calls to tick() with calls to tickThrough().
         */
-        virtual void tickThrough( TonicFrames & inFrames, TonicFrames & outFrames, const SynthesisContext_ & context );
+        virtual void tickThrough( const TonicFrames & inFrames, TonicFrames & outFrames, const SynthesisContext_ & context );
 
     };
     
     
-    inline void Effect_::setIsStereoInput(bool stereo)
+    inline void Effect_::setNumInputChannels(unsigned int numChannels)
+    {
+      if (numChannels != dryFrames_.channels()){
+        dryFrames_.resize(dryFrames_.frames(), numChannels, 0);
+      }
+    }
+    
+    inline void Effect_::setBlockSize(unsigned int blockSize)
     {
-      if (stereo != isStereoInput_){
-        dryFrames_.resize(kSynthesisBlockSize, stereo ? 2 : 1, 0);
+      Generator_::setBlockSize(blockSize);
+      dryFrames_.resize(blockSize, dryFrames_.channels(), 0);
+    }
+    
+    inline bool Effect_::sleepsThisBlock( const SynthesisContext_ &context ){
+      
+      if (!input_.isSilent()){
+        silentInputFrames_ = 0;
+        isAsleep_ = false;
+        return false;
+      }
+      
+      silentInputFrames_ += outputFrames_.frames();
+      
+      if (!isAsleep_ || !context.skipSilence){
+        isAsleep_ = false;
+        return false;
+      }
+      
+      fillConstant(0);
+      isSilent_ = true;
+      context.countSkippedNode();
+      return true;
+    }
+    
+    inline void Effect_::updateSleepState( const SynthesisContext_ &context ){
+      
+      isSilent_ = false;
+      isConstant_ = false;
+      
+      if (!context.skipSilence || silentInputFrames_ <= tailFrames(context)) return;
+      
+      const TonicFloat *outptr = outputFrames_.data();
+      for (unsigned int i=0; i<outputFrames_.size(); i++){
+        if (fabsf(*outptr++) >= kSilenceThreshold) return;
       }
-      isStereoInput_ = stereo;
+      
+      isAsleep_ = true;
     }
     
-    // Overridden tick - pre-ticks input to fill dryFrames_.
-    // subclasses don't need to tick input - dryFrames_ contains "dry" input by the time
+    // Overridden updateOutput - pre-ticks input and points dryInput_ at the result.
+    // subclasses don't need to tick input - dryInput_ contains "dry" input by the time
     // computeSynthesisBlock() is called
-    inline void Effect_::tick(TonicFrames &frames, const SynthesisContext_ &context ){
+    inline void Effect_::updateOutput(const SynthesisContext_ &context ){
+      
+      TONIC_CHECK_REALTIME_NODE(this);
+      TONIC_PROFILE_NODE(profileCounters_, context, !(context.elapsedFrames == 0 || lastFrameIndex_ != context.elapsedFrames));
       
       // check context to see if we need new frames
       if (context.elapsedFrames == 0 || lastFrameIndex_ != context.elapsedFrames){
         
-        // get dry input frames
-        input_.tick(dryFrames_, context);
+        matchBlockSize(context);
+        matchSampleRate(context);
         
-        computeSynthesisBlock(context);
+        // get dry input frames, copied only if the channel layout needs converting
+        dryInput_ = &input_.tick(context, dryFrames_);
+        
+        if (!sleepsThisBlock(context)){
+        
+          computeSynthesisBlock(context);
 
-        // bypass processing - still need to compute block so all generators stay in sync
-        bool bypass = bypassGen_.tick(context).value != 0.f;
-        if (bypass){
-          outputFrames_.copy(dryFrames_);
+          // bypass processing - still need to compute block so all generators stay in sync
+          bool bypass = bypassGen_.tick(context).value != 0.f;
+          if (bypass){
+            outputFrames_.copy(*dryInput_);
+          }
+          
+          updateSleepState(context);
         }
         
         lastFrameIndex_ = context.elapsedFrames;
-      }
-      
-      // copy synthesis block to frames passed in
-      frames.copy(outputFrames_);
-      
+        
+        if (context.recordSchedule) context.recordSchedule->append(this);
+        
 #ifdef TONIC_DEBUG
-      if(!isfinite(frames(0,0))){
-        Tonic::error("Effect_::tick NaN or inf detected.");
-      }
+        if(!isfinite(outputFrames_(0,0))){
+          Tonic::error("Effect_::tick NaN or inf detected.");
+        }
 #endif
+      }
       
     }
     
-    inline void Effect_::tickThrough(TonicFrames & inFrames, TonicFrames & outFrames, const SynthesisContext_ & context){
+    inline void Effect_::tickThrough(const TonicFrames & inFrames, TonicFrames & outFrames, const SynthesisContext_ & context){
 
         // Do not check context here, assume each call should produce new output.
         
-        dryFrames_.copy(inFrames);
+        matchBlockSize(context);
+        matchSampleRate(context);
+        
+        if (inFrames.channels() == dryFrames_.channels()){
+          dryInput_ = &inFrames;
+        }
+        else{
+          dryFrames_.copy(inFrames);
+          dryInput_ = &dryFrames_;
+        }
+        
         computeSynthesisBlock(context);
+        isConstant_ = false;
         
         // bypass processing - still need to compute block so all generators stay in sync
         bool bypass = bypassGen_.tick(context).value != 0.f;
         if (bypass){
-          outFrames.copy(dryFrames_);
+          outFrames.copy(*dryInput_);
         }
         else{
           outFrames.copy(outputFrames_);
@@ -133,7 +226,7 @@ namespace Tonic {
         this->gen()->tickThrough(inFrames, inFrames, context);
       }
       
-      void tickThrough(TonicFrames & inFrames, TonicFrames & outFrames, const Tonic_::SynthesisContext_ & context){
+      void tickThrough(const TonicFrames & inFrames, TonicFrames & outFrames, const Tonic_::SynthesisContext_ & context){
         this->gen()->tickThrough(inFrames, outFrames, context);
       }
       
@@ -141,6 +234,10 @@ namespace Tonic {
         this->gen()->setIsStereoInput(isStereoInput);
       }
       
+      void setNumInputChannels( unsigned int numChannels ){
+        this->gen()->setNumInputChannels(numChannels);
+      }
+      
       TONIC_MAKE_CTRL_GEN_SETTERS(EffectType, bypass, setBypassCtrlGen);
 
   };
@@ -177,76 +274,123 @@ namespace Tonic {
       
       // --- Tick methods ---
       
-      virtual void tick(TonicFrames &frames, const SynthesisContext_ &context );
+      virtual void updateOutput( const SynthesisContext_ &context );
       
       //! Apply effect directly to passed in frames (output in-place)
       /*!
           DO NOT mix calls to tick() with calls to tickThrough().
        */
-      virtual void tickThrough( TonicFrames & inFrames, TonicFrames & outFrames, const SynthesisContext_ & context );
+      virtual void tickThrough( const TonicFrames & inFrames, TonicFrames & outFrames, const SynthesisContext_ & context );
+      
+    protected:
+      
+      // outputFrames_ = wet * outputFrames_ + dry * dryInput_, without modifying the dry input
+      void mixWetDry( const SynthesisContext_ & context );
 
     };
     
-    // Overridden tick - pre-ticks input to fill dryFrames_.
-    // subclasses don't need to tick input - dryFrames_ contains "dry" input by the time
+    inline void WetDryEffect_::mixWetDry( const SynthesisContext_ & context ){
+      
+      // levels are usually fixed, in which case they're applied as scalars
+      const TonicFrames & wetLevel = wetLevelGen_.tick(context, mixWorkspace_);
+      if (wetLevelGen_.isConstant()){
+        outputFrames_ *= wetLevel[0];
+      }
+      else{
+        outputFrames_ *= wetLevel;
+      }
+      
+      const TonicFrames & dryLevel = dryLevelGen_.tick(context, mixWorkspace_);
+      if (dryLevelGen_.isConstant()){
+        if (dryLevel[0] != 0) outputFrames_.addScaled(*dryInput_, dryLevel[0]);
+        return;
+      }
+      
+      dryLevelGen_.tick(mixWorkspace_, context);
+      
+      if (mixWorkspace_.channels() == dryInput_->channels()){
+        mixWorkspace_ *= *dryInput_;
+        outputFrames_ += mixWorkspace_;
+      }
+      else{
+        if (dryInput_ != &dryFrames_) dryFrames_.copy(*dryInput_);
+        dryFrames_ *= mixWorkspace_;
+        outputFrames_ += dryFrames_;
+      }
+      
+    }
+    
+    // Overridden updateOutput - pre-ticks input and points dryInput_ at the result.
+    // subclasses don't need to tick input - dryInput_ contains "dry" input by the time
     // computeSynthesisBlock() is called
-    inline void WetDryEffect_::tick(TonicFrames &frames, const SynthesisContext_ &context ){
+    inline void WetDryEffect_::updateOutput(const SynthesisContext_ &context ){
+      
+      TONIC_CHECK_REALTIME_NODE(this);
+      TONIC_PROFILE_NODE(profileCounters_, context, !(context.elapsedFrames == 0 || lastFrameIndex_ != context.elapsedFrames));
       
       // check context to see if we need new frames
       if (context.elapsedFrames == 0 || lastFrameIndex_ != context.elapsedFrames){
         
-        // get dry input frames
-        input_.tick(dryFrames_, context);
+        matchBlockSize(context);
+        matchSampleRate(context);
         
-        computeSynthesisBlock(context);
+        // get dry input frames, copied only if the channel layout needs converting
+        dryInput_ = &input_.tick(context, dryFrames_);
         
-        // bypass processing - still need to compute block so all generators stay in sync
-        bool bypass = bypassGen_.tick(context).value != 0.f;
-        if (bypass){
-          outputFrames_.copy(dryFrames_);
-        }
-        else{
-          // do not apply dry/wet levels if always wet flag is set
-          // offers minor CPU usage optimization
-          wetLevelGen_.tick(mixWorkspace_, context);
-          outputFrames_ *= mixWorkspace_;
-          dryLevelGen_.tick(mixWorkspace_, context);
-          dryFrames_ *= mixWorkspace_;
-          outputFrames_ += dryFrames_;
+        if (!sleepsThisBlock(context)){
+        
+          computeSynthesisBlock(context);
+          
+          // bypass processing - still need to compute block so all generators stay in sync
+          bool bypass = bypassGen_.tick(context).value != 0.f;
+          if (bypass){
+            outputFrames_.copy(*dryInput_);
+          }
+          else{
+            mixWetDry(context);
+          }
+          
+          updateSleepState(context);
         }
         
         lastFrameIndex_ = context.elapsedFrames;
-      }
-      
-      // copy synthesis block to frames passed in
-      frames.copy(outputFrames_);
-      
+        
+        if (context.recordSchedule) context.recordSchedule->append(this);
+        
 #ifdef TONIC_DEBUG
-      if(!isfinite(frames(0,0))){
-        Tonic::error("Effect_::tick NaN or inf detected.");
-      }
+        if(!isfinite(outputFrames_(0,0))){
+          Tonic::error("Effect_::tick NaN or inf detected.");
+        }
 #endif
+      }
       
     }
     
-    inline void WetDryEffect_::tickThrough(TonicFrames & inFrames, TonicFrames & outFrames, const SynthesisContext_ & context){
+    inline void WetDryEffect_::tickThrough(const TonicFrames & inFrames, TonicFrames & outFrames, const SynthesisContext_ & context){
       
       // Do not check context here, assume each call should produce new output.
       
-      dryFrames_.copy(inFrames);
+      matchBlockSize(context);
+      matchSampleRate(context);
+      
+      if (inFrames.channels() == dryFrames_.channels()){
+        dryInput_ = &inFrames;
+      }
+      else{
+        dryFrames_.copy(inFrames);
+        dryInput_ = &dryFrames_;
+      }
+      
       computeSynthesisBlock(context);
+      isConstant_ = false;
       
       // bypass processing - still need to compute block so all generators stay in sync
       bool bypass = bypassGen_.tick(context).value != 0.f;
       if (bypass){
-        outFrames.copy(dryFrames_);
+        outFrames.copy(*dryInput_);
       }
       else {
-        wetLevelGen_.tick(mixWorkspace_, context);
-        outputFrames_ *= mixWorkspace_;
-        dryLevelGen_.tick(mixWorkspace_, context);
-        dryFrames_ *= mixWorkspace_;
-        outputFrames_ += dryFrames_;
+        mixWetDry(context);
         outFrames.copy(outputFrames_);
       }
             
@@ -269,13 +413,17 @@ namespace Tonic {
         this->gen()->tickThrough(inFrames, inFrames, context);
       }
       
-      void tickThrough(TonicFrames & inFrames, TonicFrames & outFrames, const Tonic_::SynthesisContext_ & context){
+      void tickThrough(const TonicFrames & inFrames, TonicFrames & outFrames, const Tonic_::SynthesisContext_ & context){
         this->gen()->tickThrough(inFrames, outFrames, context);
       }
       
       void setIsStereoInput( bool isStereoInput ){
         this->gen()->setIsStereoInput(isStereoInput);
       }
+      
+      void setNumInputChannels( unsigned int numChannels ){
+        this->gen()->setNumInputChannels(numChannels);
+      }
     
       TONIC_MAKE_CTRL_GEN_SETTERS(EffectType, bypass, setBypassCtrlGen);
       
@@ -15,14 +15,14 @@
 namespace Tonic {
   
   //! Calculate coefficient for a pole with given time constant to reach -60dB delta in t60s seconds
-  inline static TonicFloat t60ToOnePoleCoef( TonicFloat t60s ){
-    float coef = expf(-1.0f/((t60s/6.91f) * sampleRate()));
+  inline static TonicFloat t60ToOnePoleCoef( TonicFloat t60s, TonicFloat rate = sampleRate() ){
+    float coef = expf(-1.0f/((t60s/6.91f) * rate));
     return (coef == coef) ? coef : 0.f; // catch NaN
   }
   
   //! Calculate coefficient for a pole with a given desired cutoff in hz
-  inline static TonicFloat cutoffToOnePoleCoef( TonicFloat cutoffHz ){
-    return clamp(expf(-TWO_PI*cutoffHz/sampleRate()), 0.f, 1.f);
+  inline static TonicFloat cutoffToOnePoleCoef( TonicFloat cutoffHz, TonicFloat rate = sampleRate() ){
+    return clamp(expf(-TWO_PI*cutoffHz/rate), 0.f, 1.f);
   }
   
   //! Tick one sample through one-pole lowpass filter
@@ -45,14 +45,14 @@ namespace Tonic {
  
       And be normalized for a cutoff of 1 rad/s.
    
-      fc is the desired frequency cutoff in Hz.
+      fc is the desired frequency cutoff in Hz, at a sample rate of rate Hz.
    
       coef_out is a pointer to a TonicFloat array of length 5. No bounds checking is performed.
  
   */
-  inline static void bltCoef( TonicFloat b2, TonicFloat b1, TonicFloat b0, TonicFloat a1, TonicFloat a0, TonicFloat fc, TonicFloat *coef_out)
+  inline static void bltCoef( TonicFloat b2, TonicFloat b1, TonicFloat b0, TonicFloat a1, TonicFloat a0, TonicFloat fc, TonicFloat *coef_out, TonicFloat rate = sampleRate())
   {
-      TonicFloat sf = 1.0f/tanf(PI*fc/Tonic::sampleRate());
+      TonicFloat sf = 1.0f/tanf(PI*fc/rate);
       TonicFloat sfsq = sf*sf;
       TonicFloat norm = a0 + a1*sf + sfsq;
       coef_out[0] = (b0 + b1*sf + b2*sfsq)/norm;
@@ -77,10 +77,10 @@ namespace Tonic {
     
     Biquad();
     
-    void setIsStereo(bool stereo){
+    void setNumChannels(unsigned int numChannels){
       // resize vectors to match number of channels
-      inputVec_.resize(kSynthesisBlockSize + 4, stereo ? 2 : 1, 0);
-      outputVec_.resize(kSynthesisBlockSize + 4, stereo ? 2 : 1, 0);
+      inputVec_.resize(inputVec_.frames(), numChannels, 0);
+      outputVec_.resize(outputVec_.frames(), numChannels, 0);
     }
     
     //! Set the coefficients for the filtering operation.
@@ -92,7 +92,7 @@ namespace Tonic {
     void setCoefficients( TonicFloat b0, TonicFloat b1, TonicFloat b2, TonicFloat a1, TonicFloat a2 );
     void setCoefficients( TonicFloat *newCoef );
     
-    void filter( TonicFrames &inFrames, TonicFrames &outFrames );
+    void filter( const TonicFrames &inFrames, TonicFrames &outFrames );
   };
   
   inline void Biquad::setCoefficients(TonicFloat b0, TonicFloat b1, TonicFloat b2, TonicFloat a1, TonicFloat a2){
@@ -107,45 +107,56 @@ namespace Tonic {
     memcpy(coef_, newCoef, 5 * sizeof(TonicFloat));
   }
   
-  inline void Biquad::filter( TonicFrames &inFrames, TonicFrames &outFrames ){
+  inline void Biquad::filter( const TonicFrames &inFrames, TonicFrames &outFrames ){
     
-    // initialize vectors
-    memcpy(&inputVec_[0], &inputVec_(kSynthesisBlockSize, 0), 2 * inputVec_.channels() * sizeof(TonicFloat));
-    memcpy(&inputVec_(2, 0), &inFrames[0], inFrames.size() * sizeof(TonicFloat));
-    memcpy(&outputVec_[0], &outputVec_(kSynthesisBlockSize, 0), 2 * outputVec_.channels() * sizeof(TonicFloat));
+    const unsigned long nFrames = inFrames.frames();
+    const unsigned int nChannels = inFrames.channels();
     
-    // perform IIR filter
-    
-    unsigned int stride = inFrames.channels();
+    // each channel of the vectors holds two frames of history from the end of the last block, then this block
+    const unsigned long lastFrame = inputVec_.frames() - 1;
+    for (unsigned int c=0; c<nChannels; c++){
+      TonicFloat *in = inputVec_.channelData(c);
+      TonicFloat *out = outputVec_.channelData(c);
+      in[0] = in[lastFrame - 1];
+      in[1] = in[lastFrame];
+      out[0] = out[lastFrame - 1];
+      out[1] = out[lastFrame];
+    }
     
-#ifdef USE_APPLE_ACCELERATE
-    for (unsigned int c=0; c<stride; c++){
-      vDSP_deq22(&inputVec_[0] + c, stride, coef_, &outputVec_[0] + c, stride, kSynthesisBlockSize);
+    if (inputVec_.frames() != nFrames + 2){
+      // block size changed - resizing keeps the history at the start of each channel
+      inputVec_.resize(nFrames + 2, nChannels);
+      outputVec_.resize(nFrames + 2, nChannels);
     }
-#else
     
-    for (unsigned int c=0; c<stride; c++){
+    // perform IIR filter
+    
+    for (unsigned int c=0; c<nChannels; c++){
       
-      TonicFloat* in = &inputVec_(2, c);
-      TonicFloat* out = &outputVec_(2, c);
+      memcpy(inputVec_.channelData(c) + 2, inFrames.channelData(c), nFrames * sizeof(TonicFloat));
       
-      for (unsigned int i=0; i<kSynthesisBlockSize; i++){
-        *out = *(in)*coef_[0] + *(in-stride)*coef_[1] + *(in-2*stride)*coef_[2] - *(out-stride)*coef_[3] - *(out-2*stride)*coef_[4];
-        in += stride;
-        out += stride;
+#ifdef USE_APPLE_ACCELERATE
+      vDSP_deq22(inputVec_.channelData(c), 1, coef_, outputVec_.channelData(c), 1, nFrames);
+#else
+      const TonicFloat* in = inputVec_.channelData(c) + 2;
+      TonicFloat* out = outputVec_.channelData(c) + 2;
+      
+      for (unsigned int i=0; i<nFrames; i++){
+        *out = *(in)*coef_[0] + *(in-1)*coef_[1] + *(in-2)*coef_[2] - *(out-1)*coef_[3] - *(out-2)*coef_[4];
+        in++;
+        out++;
       }
+#endif
       
+      // copy to synthesis block
+      memcpy(outFrames.channelData(c), outputVec_.channelData(c) + 2, nFrames * sizeof(TonicFloat));
     }
-#endif
 
 #ifdef TONIC_DEBUG
     if(outFrames(0,0) != outFrames(0,0)){
       Tonic::error("Biquad::filter NaN detected.", false);
     }
 #endif
-    
-    // copy to synthesis block
-    memcpy(&outFrames[0], &outputVec_(2,0), kSynthesisBlockSize * stride * sizeof(TonicFloat));
   }
   
   
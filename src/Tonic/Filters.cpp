@@ -25,8 +25,8 @@ namespace Tonic { namespace Tonic_{
   
   void Filter_::setInput(Generator input){
     Effect_::setInput(input);
-    setIsStereoInput(input.isStereoOutput());
-    setIsStereoOutput(input.isStereoOutput());
+    setNumInputChannels(input.numOutputChannels());
+    setNumOutputChannels(input.numOutputChannels());
   }
   
 } // Namespace Tonic_
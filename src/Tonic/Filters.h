@@ -82,11 +82,9 @@ namespace Tonic {
       // For now only using first frame of output. Setting coefficients each frame is very inefficient.
       // Updating cutoff every 64-samples is typically fast enough to avoid audible artifacts when sweeping filters.
       
-      cutoff_.tick(workspace_, context);
-      cCutoff = clamp(workspace_(0,0), 20, sampleRate()/2); // clamp to reasonable range
-      
-      Q_.tick(workspace_, context);
-      cQ = max(workspace_(0,0), 0.7071); // clamp to reasonable range
+      // read in place, converting in workspace_ only if the channel layout differs
+      cCutoff = clamp(cutoff_.tick(context, workspace_)(0,0), 20, sampleRate_/2); // clamp to reasonable range
+      cQ = max(Q_.tick(context, workspace_)(0,0), 0.7071); // clamp to reasonable range
       
       applyFilter(cCutoff, cQ, context);
       
@@ -101,31 +99,38 @@ namespace Tonic {
       
     private:
       
-      TonicFloat lastOut_[2];
+      // last output of each channel
+      vector<TonicFloat> lastOut_;
       
     protected:
       inline void applyFilter( TonicFloat cutoff, TonicFloat Q, const SynthesisContext_ & context )
       {
         
-        TonicFloat *inptr = &dryFrames_[0];
+        const TonicFloat *inptr = dryInput_->data();
         TonicFloat *outptr = &outputFrames_[0];
-        TonicFloat coef = cutoffToOnePoleCoef(cutoff);
+        TonicFloat coef = cutoffToOnePoleCoef(cutoff, sampleRate_);
         TonicFloat norm = bNormalizeGain_ ? 1.0f - coef : 1.0f;
-        unsigned int nChannels = dryFrames_.channels();
+        unsigned int nChannels = dryInput_->channels();
+        unsigned int nFrames = (unsigned int)outputFrames_.frames();
         
-        for (unsigned int i=0; i<kSynthesisBlockSize; i++){
-          for (unsigned int c=0; c<nChannels; c++){
-            lastOut_[c] = (norm * (*inptr++)) + (coef * lastOut_[c]);
-            *outptr++ = lastOut_[c];
+        for (unsigned int c=0; c<nChannels; c++){
+          TonicFloat lastOut = lastOut_[c];
+          for (unsigned int i=0; i<nFrames; i++){
+            lastOut = (norm * (*inptr++)) + (coef * lastOut);
+            *outptr++ = lastOut;
           }
+          lastOut_[c] = lastOut;
         }
       }
       
     public:
       
-      LPF6_(){
-        lastOut_[0] = 0;
-        lastOut_[1] = 0;
+      LPF6_() : lastOut_(1, 0) {}
+      
+      void setNumInputChannels( unsigned int numChannels )
+      {
+        Filter_::setNumInputChannels(numChannels);
+        lastOut_.resize(numChannels, 0);
       }
       
     };
@@ -139,35 +144,40 @@ namespace Tonic {
       
     private:
       
-      TonicFloat lastOut_[2];
+      // last output of each channel
+      vector<TonicFloat> lastOut_;
       
     protected:
-      
       inline void applyFilter( TonicFloat cutoff, TonicFloat Q, const SynthesisContext_ & context )
       {
         
-        TonicFloat *inptr = &dryFrames_[0];
+        const TonicFloat *inptr = dryInput_->data();
         TonicFloat *outptr = &outputFrames_[0];
-        TonicFloat coef = 1.0f - cutoffToOnePoleCoef(cutoff);
+        TonicFloat coef = 1.0f - cutoffToOnePoleCoef(cutoff, sampleRate_);
         TonicFloat norm = bNormalizeGain_ ? 1.0f - coef : 1.0f;
-        unsigned int nChannels = dryFrames_.channels();
+        unsigned int nChannels = dryInput_->channels();
+        unsigned int nFrames = (unsigned int)outputFrames_.frames();
         
-        for (unsigned int i=0; i<kSynthesisBlockSize; i++){
-          for (unsigned int c=0; c<nChannels; c++){
-            lastOut_[c] = (norm * (*inptr++)) - (coef * lastOut_[c]);
-            *outptr++ = lastOut_[c];
+        for (unsigned int c=0; c<nChannels; c++){
+          TonicFloat lastOut = lastOut_[c];
+          for (unsigned int i=0; i<nFrames; i++){
+            lastOut = (norm * (*inptr++)) - (coef * lastOut);
+            *outptr++ = lastOut;
           }
+          lastOut_[c] = lastOut;
         }
-
       }
       
     public:
       
-      HPF6_(){
-        lastOut_[0] = 0;
-        lastOut_[1] = 0;
+      HPF6_() : lastOut_(1, 0) {}
+      
+      void setNumInputChannels( unsigned int numChannels )
+      {
+        Filter_::setNumInputChannels(numChannels);
+        lastOut_.resize(numChannels, 0);
       }
-
+      
     };
     
     
@@ -187,19 +197,19 @@ namespace Tonic {
       inline void applyFilter( TonicFloat cutoff, TonicFloat Q, const SynthesisContext_ & context ){
         // set coefficients
         TonicFloat newCoef[5];
-        bltCoef(0, 0, bNormalizeGain_ ? 1.0f/Q : 1.0f, 1.0f/Q, 1, cutoff, newCoef);
+        bltCoef(0, 0, bNormalizeGain_ ? 1.0f/Q : 1.0f, 1.0f/Q, 1, cutoff, newCoef, sampleRate_);
         biquad_.setCoefficients(newCoef);
         
         // compute
-        biquad_.filter(dryFrames_, outputFrames_);
+        biquad_.filter(*dryInput_, outputFrames_);
       }
       
     public:
       
-      void setIsStereoInput( bool isStereoInput )
+      void setNumInputChannels( unsigned int numChannels )
       {
-        Filter_::setIsStereoInput(isStereoInput);
-        biquad_.setIsStereo(isStereoInput);
+        Filter_::setNumInputChannels(numChannels);
+        biquad_.setNumChannels(numChannels);
       }
 
     };
@@ -222,25 +232,25 @@ namespace Tonic {
         TonicFloat newCoef[5];
         
         // stage 1
-        bltCoef(0, 0, bNormalizeGain_ ? 1.0f/Q : 1.0f, 0.5412f/Q, 1, cutoff, newCoef);
+        bltCoef(0, 0, bNormalizeGain_ ? 1.0f/Q : 1.0f, 0.5412f/Q, 1, cutoff, newCoef, sampleRate_);
         biquads_[0].setCoefficients(newCoef);
         
         // stage 2
-        bltCoef(0, 0, bNormalizeGain_ ? 1.0f/Q : 1.0f, 1.3066f/Q, 1, cutoff, newCoef);
+        bltCoef(0, 0, bNormalizeGain_ ? 1.0f/Q : 1.0f, 1.3066f/Q, 1, cutoff, newCoef, sampleRate_);
         biquads_[1].setCoefficients(newCoef);
         
         // compute
-        biquads_[0].filter(dryFrames_, outputFrames_);
+        biquads_[0].filter(*dryInput_, outputFrames_);
         biquads_[1].filter(outputFrames_, outputFrames_);
       }
       
     public:
       
-      void setIsStereoInput( bool isStereoInput )
+      void setNumInputChannels( unsigned int numChannels )
       {
-        Filter_::setIsStereoInput(isStereoInput);
-        biquads_[0].setIsStereo(isStereoInput);
-        biquads_[1].setIsStereo(isStereoInput);
+        Filter_::setNumInputChannels(numChannels);
+        biquads_[0].setNumChannels(numChannels);
+        biquads_[1].setNumChannels(numChannels);
       }
 
       
@@ -263,19 +273,19 @@ namespace Tonic {
         
         // set coefficients
         TonicFloat newCoef[5];
-        bltCoef(bNormalizeGain_ ? 1.0f/Q : 1.0f, 0, 0, 1.0f/Q, 1, cutoff, newCoef);
+        bltCoef(bNormalizeGain_ ? 1.0f/Q : 1.0f, 0, 0, 1.0f/Q, 1, cutoff, newCoef, sampleRate_);
         biquad_.setCoefficients(newCoef);
         
         // compute
-        biquad_.filter(dryFrames_, outputFrames_);
+        biquad_.filter(*dryInput_, outputFrames_);
       }
       
     public:
       
-      void setIsStereoInput( bool isStereoInput )
+      void setNumInputChannels( unsigned int numChannels )
       {
-        Filter_::setIsStereoInput(isStereoInput);
-        biquad_.setIsStereo(isStereoInput);
+        Filter_::setNumInputChannels(numChannels);
+        biquad_.setNumChannels(numChannels);
       }
       
     };
@@ -298,25 +308,25 @@ namespace Tonic {
         TonicFloat newCoef[5];
         
         // stage 1
-        bltCoef(bNormalizeGain_ ? 1.0f/Q : 1.0f, 0, 0, 0.5412f/Q, 1, cutoff, newCoef);
+        bltCoef(bNormalizeGain_ ? 1.0f/Q : 1.0f, 0, 0, 0.5412f/Q, 1, cutoff, newCoef, sampleRate_);
         biquads_[0].setCoefficients(newCoef);
         
         // stage 2
-        bltCoef(bNormalizeGain_ ? 1.0f/Q : 1.0f, 0, 0, 1.3066f/Q, 1, cutoff, newCoef);
+        bltCoef(bNormalizeGain_ ? 1.0f/Q : 1.0f, 0, 0, 1.3066f/Q, 1, cutoff, newCoef, sampleRate_);
         biquads_[1].setCoefficients(newCoef);
         
         // compute
-        biquads_[0].filter(dryFrames_, outputFrames_);
+        biquads_[0].filter(*dryInput_, outputFrames_);
         biquads_[1].filter(outputFrames_, outputFrames_);
       }
       
     public:
       
-      void setIsStereoInput( bool isStereoInput )
+      void setNumInputChannels( unsigned int numChannels )
       {
-        Filter_::setIsStereoInput(isStereoInput);
-        biquads_[0].setIsStereo(isStereoInput);
-        biquads_[1].setIsStereo(isStereoInput);
+        Filter_::setNumInputChannels(numChannels);
+        biquads_[0].setNumChannels(numChannels);
+        biquads_[1].setNumChannels(numChannels);
       }
       
     };
@@ -339,19 +349,19 @@ namespace Tonic {
         
         // set coefficients
         TonicFloat newCoef[5];
-        bltCoef(0, bNormalizeGain_ ? 1.0f/Q : 1.0f, 0, 1.0f/Q, 1, cutoff, newCoef);
+        bltCoef(0, bNormalizeGain_ ? 1.0f/Q : 1.0f, 0, 1.0f/Q, 1, cutoff, newCoef, sampleRate_);
         biquad_.setCoefficients(newCoef);
         
         // compute
-        biquad_.filter(dryFrames_, outputFrames_);
+        biquad_.filter(*dryInput_, outputFrames_);
       }
       
     public:
       
-      virtual void setIsStereoInput( bool isStereoInput )
+      virtual void setNumInputChannels( unsigned int numChannels )
       {
-        Filter_::setIsStereoInput(isStereoInput);
-        biquad_.setIsStereo(isStereoInput);
+        Filter_::setNumInputChannels(numChannels);
+        biquad_.setNumChannels(numChannels);
       }
       
     };
@@ -374,25 +384,25 @@ namespace Tonic {
         TonicFloat newCoef[5];
         
         // stage 1
-        bltCoef(0, bNormalizeGain_ ? 1.0f/Q : 1.0f, 0, 0.5412f/Q, 1, cutoff, newCoef);
+        bltCoef(0, bNormalizeGain_ ? 1.0f/Q : 1.0f, 0, 0.5412f/Q, 1, cutoff, newCoef, sampleRate_);
         biquads_[0].setCoefficients(newCoef);
         
         // stage 2
-        bltCoef(0, bNormalizeGain_ ? 1.0f/Q : 1.0f, 0, 1.3066f/Q, 1, cutoff, newCoef);
+        bltCoef(0, bNormalizeGain_ ? 1.0f/Q : 1.0f, 0, 1.3066f/Q, 1, cutoff, newCoef, sampleRate_);
         biquads_[1].setCoefficients(newCoef);
         
         // compute
-        biquads_[0].filter(dryFrames_, outputFrames_);
+        biquads_[0].filter(*dryInput_, outputFrames_);
         biquads_[1].filter(outputFrames_, outputFrames_);
       }
       
     public:
       
-      void setIsStereoInput( bool isStereoInput )
+      void setNumInputChannels( unsigned int numChannels )
       {
-        Filter_::setIsStereoInput(isStereoInput);
-        biquads_[0].setIsStereo(isStereoInput);
-        biquads_[1].setIsStereo(isStereoInput);
+        Filter_::setNumInputChannels(numChannels);
+        biquads_[0].setNumChannels(numChannels);
+        biquads_[1].setNumChannels(numChannels);
       }
       
     };
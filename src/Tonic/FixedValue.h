@@ -40,22 +40,10 @@ namespace Tonic {
     
     inline void FixedValue_::computeSynthesisBlock( const SynthesisContext_ & context ){
       
-      float* buffStart = &outputFrames_[0];
-      
-      ControlGeneratorOutput valueOutput = valueGen.tick(context);
-      
-      if (valueOutput.triggered){
-        
-#ifdef USE_APPLE_ACCELERATE
-        
-        vDSP_vfill( &valueOutput.value , buffStart, 1, outputFrames_.size());
-        
-#else
-        
-        std::fill(buffStart, buffStart + outputFrames_.size(), valueOutput.value);
-        
-#endif
-      }
+      // only rewrites the block when the value changes
+      TonicFloat value = valueGen.tick(context).value;
+      fillConstant(value);
+      isSilent_ = (value == 0);
     }
 
   }
@@ -13,17 +13,73 @@
 
 namespace Tonic{ namespace Tonic_{
   
-  Generator_::Generator_() : lastFrameIndex_(0), isStereoOutput_(false){
+  Generator_::Generator_() : lastFrameIndex_(0), isSilent_(false), isConstant_(false), sampleRate_(Tonic::sampleRate()){
     outputFrames_.resize(kSynthesisBlockSize, 1, 0);
   }
   
   Generator_::~Generator_() {}
   
-  void Generator_::setIsStereoOutput(bool stereo){
-    if (stereo != isStereoOutput_){
-      outputFrames_.resize(kSynthesisBlockSize, stereo ? 2 : 1, 0);
+  void Generator_::setNumOutputChannels(unsigned int numChannels){
+    if (numChannels != outputFrames_.channels()){
+      outputFrames_.resize(outputFrames_.frames(), numChannels, 0);
+      isConstant_ = false;
     }
-    isStereoOutput_ = stereo;
+  }
+  
+  void Generator_::setBlockSize(unsigned int blockSize){
+    outputFrames_.resize(blockSize, outputFrames_.channels(), 0);
+    isConstant_ = false;
+  }
+  
+  void Generator_::setSampleRate(TonicFloat sampleRate){
+    sampleRate_ = sampleRate;
+  }
+
+  // Kept for good, so listeners destroyed during static destruction can still remove themselves
+  struct BlockSizeListeners_ {
+    TONIC_MUTEX_T mutex;
+    vector<BlockSizeListener_*> listeners;
+    vector<unsigned int> blockSizes;
+    BlockSizeListeners_() { TONIC_MUTEX_INIT(mutex); }
+  };
+
+  static BlockSizeListeners_ & blockSizeListeners(){
+    static BlockSizeListeners_ * listeners = new BlockSizeListeners_;
+    return *listeners;
+  }
+
+  void addBlockSizeListener(BlockSizeListener_ * listener){
+    BlockSizeListeners_ & registry = blockSizeListeners();
+    TONIC_MUTEX_LOCK(registry.mutex);
+    registry.listeners.push_back(listener);
+    TONIC_MUTEX_UNLOCK(registry.mutex);
+  }
+
+  void removeBlockSizeListener(BlockSizeListener_ * listener){
+    BlockSizeListeners_ & registry = blockSizeListeners();
+    TONIC_MUTEX_LOCK(registry.mutex);
+    registry.listeners.erase(std::remove(registry.listeners.begin(), registry.listeners.end(), listener), registry.listeners.end());
+    TONIC_MUTEX_UNLOCK(registry.mutex);
+  }
+
+  void announceBlockSize(unsigned int blockSize){
+    BlockSizeListeners_ & registry = blockSizeListeners();
+    TONIC_MUTEX_LOCK(registry.mutex);
+    if (std::find(registry.blockSizes.begin(), registry.blockSizes.end(), blockSize) == registry.blockSizes.end()){
+      registry.blockSizes.push_back(blockSize);
+    }
+    for (size_t i=0; i<registry.listeners.size(); i++){
+      registry.listeners[i]->prepareBlockSize(blockSize);
+    }
+    TONIC_MUTEX_UNLOCK(registry.mutex);
+  }
+
+  vector<unsigned int> announcedBlockSizes(){
+    BlockSizeListeners_ & registry = blockSizeListeners();
+    TONIC_MUTEX_LOCK(registry.mutex);
+    vector<unsigned int> blockSizes = registry.blockSizes;
+    TONIC_MUTEX_UNLOCK(registry.mutex);
+    return blockSizes;
   }
 
 }}
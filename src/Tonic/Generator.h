@@ -13,46 +13,166 @@
 #define TONIC_GENERATOR_H
 
 #include "TonicFrames.h"
+#include "GraphSchedule.h"
+#include "Profiler.h"
 #include <cmath>
 namespace Tonic {
 
   namespace Tonic_{
 
-    class Generator_{
+    //! Told, off the audio thread, of each block size a BufferFiller is about to render at
+    /*!
+        BufferFiller::setBlockSize announces the size before posting it to the audio thread, so a generator
+        with costly state per block size can build it in advance, and have setBlockSize() only swap it in.
+        Listeners are called with the list of listeners locked, so must not add or remove any.
+     */
+    class BlockSizeListener_ {
+
+    public:
+
+      virtual ~BlockSizeListener_() {}
+
+      virtual void prepareBlockSize( unsigned int blockSize ) = 0;
+
+    };
+
+    void addBlockSizeListener( BlockSizeListener_ * listener );
+    void removeBlockSizeListener( BlockSizeListener_ * listener );
+
+    //! Have every listener prepare for blockSize, and remember it for those added later. Not for the audio thread.
+    void announceBlockSize( unsigned int blockSize );
+
+    //! Every block size announced so far
+    vector<unsigned int> announcedBlockSizes();
+
+    class Generator_ : public ReferenceCounted_ {
       
     public:
       
       Generator_();
       virtual ~Generator_();
       
+        //! Compute a block if needed and copy it into frames, resizing frames if it has a different block size
       virtual void tick( TonicFrames& frames, const SynthesisContext_ &context );
       
-      bool isStereoOutput(){ return isStereoOutput_; };
+      //! Compute a new block into outputFrames_, unless one has already been computed for context
+      /*!
+          Subclasses which need to do work around computeSynthesisBlock() (pulling inputs, bypass, etc)
+          should override this rather than tick(), so they behave the same when run from a GraphSchedule_.
+       */
+      virtual void updateOutput( const SynthesisContext_ &context );
+      
+      //! Most recently computed block. Valid until the next block is computed.
+      const TonicFrames & output() const { return outputFrames_; };
+      
+      //! Number of channels in outputFrames_
+      unsigned int numOutputChannels() const { return outputFrames_.channels(); };
       
-      // set stereo/mono - changes number of channels in outputFrames_
+      bool isStereoOutput() const { return numOutputChannels() == 2; };
+      
+      // set number of output channels - changes number of channels in outputFrames_
       // subclasses should call in constructor to determine channel output
-      virtual void setIsStereoOutput( bool stereo );
+      virtual void setNumOutputChannels( unsigned int numChannels );
+      
+      // set stereo/mono - shorthand for setNumOutputChannels(2 or 1)
+      void setIsStereoOutput( bool stereo ){ setNumOutputChannels(stereo ? 2 : 1); };
+      
+      //! Number of frames computed per block
+      unsigned int blockSize() const { return (unsigned int)outputFrames_.frames(); };
+      
+      //! True if the most recent block is known to be all zeros
+      /*!
+          Generators which can tell cheaply (an idle envelope, a product with a silent input, a sleeping
+          effect...) set isSilent_ when computing a block, so consumers can skip work on it. Most never do,
+          so false only means "not known to be silent".
+       */
+      bool isSilent() const { return isSilent_; };
+      
+      //! True if every sample of the most recent block has the same value
+      /*!
+          The whole block still holds the value, so consumers which don't check can read it as usual.
+          Those which do can read output()[0] and use scalar arithmetic in place of a block operation.
+       */
+      bool isConstant() const { return isConstant_; };
+      
+      //! Change the number of frames in outputFrames_
+      /*!
+          Called from updateOutput() whenever the context's block size differs from blockSize(), so on the
+          audio thread, before the first block at the new size. Workspaces filled by ticking an input into
+          them resize themselves. Subclasses with other block-sized buffers should override, resize those
+          too, and call up. Growing a buffer allocates, shrinking never does.
+       */
+      virtual void setBlockSize( unsigned int blockSize );
+      
+      //! Change the sample rate the generator computes at
+      /*!
+          Called from updateOutput() whenever the context's sample rate differs from the one the generator
+          last computed at (initially the default, Tonic::sampleRate()). Most generators read sampleRate_ as
+          they compute. Subclasses holding state derived from the rate (delay lines, precomputed
+          coefficients...) should override, recompute it, and call up. Resizing a delay line allocates.
+       */
+      virtual void setSampleRate( TonicFloat sampleRate );
       
     protected:
       
       // override point for defining generator behavior
       // subclasses should implment to fill frames with new data
       virtual void computeSynthesisBlock( const SynthesisContext_ &context ) {};
+      
+      // call before computing a block - resizes buffers if the context's block size has changed
+      void matchBlockSize( const SynthesisContext_ &context ){
+        if (outputFrames_.frames() != context.blockSize) setBlockSize(context.blockSize);
+      }
+      
+      // call before computing a block - updates rate-dependent state if the context's sample rate has changed
+      void matchSampleRate( const SynthesisContext_ &context ){
+        if (sampleRate_ != context.sampleRate) setSampleRate(context.sampleRate);
+      }
 
       
-      bool            isStereoOutput_;
       TonicFrames     outputFrames_;
       unsigned long   lastFrameIndex_;
+      bool            isSilent_;
+      bool            isConstant_;
+      TonicFloat      sampleRate_;
+      
+#ifdef TONIC_PROFILE
+      NodeProfileCounters_  profileCounters_;
+#endif
+      
+      //! Make the block a constant value. The buffer is only rewritten when the value changes.
+      void fillConstant( TonicFloat value ){
+        if (!isConstant_ || outputFrames_[0] != value){
+          outputFrames_.fill(value);
+          isConstant_ = true;
+        }
+      }
       
     };
     
-    inline void Generator_::tick(TonicFrames &frames, const SynthesisContext_ &context ){
+    inline void Generator_::updateOutput(const SynthesisContext_ &context){
+      
+      TONIC_CHECK_REALTIME_NODE(this);
+      TONIC_PROFILE_NODE(profileCounters_, context, !(context.forceNewOutput || lastFrameIndex_ != context.elapsedFrames));
       
       // check context to see if we need new frames
       if (context.forceNewOutput || lastFrameIndex_ != context.elapsedFrames){
+        matchBlockSize(context);
+        matchSampleRate(context);
         computeSynthesisBlock(context);
         lastFrameIndex_ = context.elapsedFrames;
+        
+        if (context.recordSchedule) context.recordSchedule->append(this);
       }
+      
+    }
+    
+    inline void Generator_::tick(TonicFrames &frames, const SynthesisContext_ &context ){
+      
+      updateOutput(context);
+      
+      // workspaces follow the block size of the context they're ticked in
+      if (frames.frames() != outputFrames_.frames()) frames.resize(outputFrames_.frames(), frames.channels(), 0);
     
       // copy synthesis block to frames passed in
       frames.copy(outputFrames_);
@@ -72,9 +192,46 @@ namespace Tonic {
       return obj->isStereoOutput();
     }
     
+    inline unsigned int numOutputChannels(){
+      return obj->numOutputChannels();
+    }
+    
+    //! True if the most recently computed block is known to be all zeros
+    inline bool isSilent(){
+      return obj->isSilent();
+    }
+    
+    //! True if every sample of the most recently computed block has the same value
+    inline bool isConstant(){
+      return obj->isConstant();
+    }
+    
     virtual void tick(TonicFrames& frames, const Tonic_::SynthesisContext_ & context){
       obj->tick(frames, context);
     }
+    
+    //! Compute a block if needed and return a read-only view of it, without copying
+    /*!
+        The view is the generator's own output buffer, so it is only valid until the generator computes
+        its next block, and has the generator's channel count rather than the caller's.
+     */
+    const TonicFrames & tick(const Tonic_::SynthesisContext_ & context){
+      obj->updateOutput(context);
+      return obj->output();
+    }
+    
+    //! View of the output in the channel layout of conversionFrames
+    /*!
+        Returns the generator's own output buffer if its channel count matches conversionFrames,
+        otherwise copies it into conversionFrames (with the usual channel conversion) and returns that.
+     */
+    const TonicFrames & tick(const Tonic_::SynthesisContext_ & context, TonicFrames & conversionFrames){
+      const TonicFrames & view = tick(context);
+      if (view.channels() == conversionFrames.channels()) return view;
+      if (conversionFrames.frames() != view.frames()) conversionFrames.resize(view.frames(), conversionFrames.channels(), 0);
+      conversionFrames.copy(view);
+      return conversionFrames;
+    }
 
   };
   
@@ -0,0 +1,43 @@
+//
+//  GraphSchedule.cpp
+//  Tonic
+//
+//
+// See LICENSE.txt for license and usage information.
+//
+
+#include "GraphSchedule.h"
+#include "Generator.h"
+
+namespace Tonic {
+  
+  namespace Tonic_ {
+    
+    void GraphSchedule_::releaseNodes(){
+      for (size_t i=0; i<nodes_.size(); i++){
+        nodes_[i]->release();
+      }
+      nodes_.clear();
+    }
+    
+    void GraphSchedule_::append(Generator_ * node){
+      if (nodes_.size() < nodes_.capacity()){
+        node->retain();
+        nodes_.push_back(node);
+      }
+      else{
+        overflowed_ = true;
+      }
+    }
+    
+    void GraphSchedule_::run(const SynthesisContext_ & context){
+      Generator_ ** node = nodes_.empty() ? NULL : &nodes_[0];
+      Generator_ ** end = node + nodes_.size();
+      for (; node != end; node++){
+        (*node)->updateOutput(context);
+      }
+    }
+    
+  }
+  
+}
@@ -0,0 +1,100 @@
+//
+//  GraphSchedule.h
+//  Tonic
+//
+//
+// See LICENSE.txt for license and usage information.
+//
+
+#ifndef TONIC_GRAPHSCHEDULE_H
+#define TONIC_GRAPHSCHEDULE_H
+
+#include "TonicCore.h"
+
+namespace Tonic {
+  
+  namespace Tonic_ {
+    
+    class Generator_;
+    
+    //! Flat, topologically ordered list of the generators in a synthesis graph
+    /*!
+        A schedule is recorded by rendering one block with SynthesisContext_::recordSchedule pointing at it.
+        Every generator appends itself after computing, so inputs always precede the generators reading them.
+        Running the schedule computes each node in that order, leaving every tick() inside the graph a cache hit
+        instead of a recursive descent.
+     
+        Storage is allocated up front with reserve(), off the audio thread. Recording a graph with more nodes
+        than were reserved fails, and the owner falls back to recursive ticking.
+     
+        The schedule holds a reference to every node it records, until it is recorded again or destroyed, so
+        a graph changed while it plays can leave it running a node that is no longer used, but never one that
+        has been freed. Releasing those references while rendering defers any deletion off the audio thread.
+     */
+    class GraphSchedule_ {
+      
+    protected:
+      
+      vector<Generator_*> nodes_;
+      bool                recording_;
+      bool                overflowed_;
+      bool                valid_;
+      
+      // drop the references to every recorded node
+      void releaseNodes();
+      
+    public:
+      
+      GraphSchedule_() : recording_(false), overflowed_(false), valid_(false) {}
+      ~GraphSchedule_(){ releaseNodes(); }
+      
+      //! Allocate room for maxNodes. Not realtime-safe.
+      void reserve(unsigned int maxNodes){ releaseNodes(); nodes_.reserve(maxNodes); valid_ = false; }
+      
+      unsigned int capacity() const { return (unsigned int)nodes_.capacity(); }
+      unsigned int size() const { return (unsigned int)nodes_.size(); }
+      
+      //! True once a complete recording has been made, until invalidated
+      bool isValid() const { return valid_; }
+      
+      void invalidate() { valid_ = false; }
+      
+      void beginRecording(){
+        releaseNodes();
+        recording_ = true;
+        overflowed_ = false;
+        valid_ = false;
+      }
+      
+      void endRecording(){
+        recording_ = false;
+        valid_ = !overflowed_ && capacity() > 0;
+      }
+      
+      //! Add node, and a reference to it, to the end of the schedule being recorded
+      void append(Generator_ * node);
+      
+      //! Compute every scheduled generator which has not already computed a block for context
+      void run(const SynthesisContext_ & context);
+      
+      //! Exchange storage with another schedule. Neither allocates nor frees.
+      void swap(GraphSchedule_ & other){
+        nodes_.swap(other.nodes_);
+        std::swap(recording_, other.recording_);
+        std::swap(overflowed_, other.overflowed_);
+        std::swap(valid_, other.valid_);
+      }
+      
+    private:
+      
+      // copies would release the same nodes twice
+      GraphSchedule_(const GraphSchedule_ &);
+      GraphSchedule_ & operator=(const GraphSchedule_ &);
+      
+    };
+    
+  }
+  
+}
+
+#endif
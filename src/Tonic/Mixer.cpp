@@ -11,23 +11,163 @@
 namespace Tonic {
   
   namespace Tonic_ { 
+    
+    // Installs a new list of inputs, prepared off the audio thread
+    class SetInputsCommand_ : public BufferFillerCommand_ {
+      
+      Mixer_ * mixer_;
+      vector<BufferFiller> inputs_;
+#if TONIC_HAS_CPP_11
+      vector<TonicFrames> inputFrames_;
+#endif
+      
+    public:
+      
+      SetInputsCommand_(Mixer_ * mixer, const vector<BufferFiller> & inputs) : mixer_(mixer), inputs_(inputs)
+      {
+#if TONIC_HAS_CPP_11
+        // sized for the current block size, so the audio thread doesn't have to
+        inputFrames_.resize(inputs.size(), TonicFrames(mixer->blockSize(), mixer->numOutputChannels()));
+#endif
+      }
+      
+      void execute(){
+        mixer_->inputs_.swap(inputs_);
+#if TONIC_HAS_CPP_11
+        mixer_->inputFrames_.swap(inputFrames_);
+        // the channel count may have changed since this command was posted
+        for (unsigned int i=0; i<mixer_->inputFrames_.size(); i++){
+          TonicFrames & frames = mixer_->inputFrames_[i];
+          if (frames.channels() != mixer_->numOutputChannels()) frames.resize(frames.frames(), mixer_->numOutputChannels(), 0);
+        }
+#endif
+      }
+      
+    };
+    
+#if TONIC_HAS_CPP_11
+    // Installs a new worker pool. The replaced pool is shut down when the command is freed.
+    class SetWorkerPoolCommand_ : public BufferFillerCommand_ {
+      
+      Mixer_ * mixer_;
+      ParallelMixState_ * parallelState_;
+      
+    public:
+      
+      SetWorkerPoolCommand_(Mixer_ * mixer, unsigned int numThreads) :
+        mixer_(mixer),
+        parallelState_(new ParallelMixState_(numThreads))
+      {}
+      
+      ~SetWorkerPoolCommand_(){
+        delete parallelState_;
+      }
+      
+      void execute(){
+        ParallelMixState_ * previous = mixer_->parallelState_;
+        TONIC_ATOMIC_STORE(mixer_->parallelState_, parallelState_);
+        parallelState_ = previous;
+      }
+      
+    };
+    
+    class ResetParallelStatsCommand_ : public BufferFillerCommand_ {
+      
+      Mixer_ * mixer_;
+      
+    public:
+      
+      ResetParallelStatsCommand_(Mixer_ * mixer) : mixer_(mixer) {}
+      
+      void execute(){
+        ParallelMixState_ * state = mixer_->parallelState_;
+        state->stats = ParallelMixStats();
+        state->stats.numThreads = (unsigned int)state->workerBusySeconds.size();
+        std::fill(state->workerBusySeconds.begin(), state->workerBusySeconds.end(), 0);
+      }
+      
+    };
+#endif
   
-    Mixer_::Mixer_() {
+    Mixer_::Mixer_() : pendingNumThreads_(1) {
       workSpace_.resize(kSynthesisBlockSize, 2, 0);
+#if TONIC_HAS_CPP_11
+      parallelState_ = new ParallelMixState_(1);
+      taskContext_ = NULL;
+#endif
+    }
+    
+    Mixer_::~Mixer_(){
+#if TONIC_HAS_CPP_11
+      delete parallelState_;
+#endif
+    }
+    
+    void Mixer_::setNumOutputChannels(unsigned int numChannels){
+      BufferFiller_::setNumOutputChannels(numChannels);
+      workSpace_.resize(workSpace_.frames(), numChannels, 0);
+#if TONIC_HAS_CPP_11
+      for (unsigned int i=0; i<inputFrames_.size(); i++){
+        inputFrames_[i].resize(inputFrames_[i].frames(), numChannels, 0);
+      }
+#endif
     }
     
     void Mixer_::addInput(BufferFiller input)
     {
       // no checking for duplicates, maybe we should
-      inputs_.push_back(input);
+      pendingInputs_.push_back(input);
+      postCommand(new SetInputsCommand_(this, pendingInputs_));
     }
     
     void Mixer_::removeInput(BufferFiller input)
     {
-      vector<BufferFiller>::iterator it = std::find(inputs_.begin(), inputs_.end(), input);
-      if (it != inputs_.end()){
-        inputs_.erase(it);
+      vector<BufferFiller>::iterator it = std::find(pendingInputs_.begin(), pendingInputs_.end(), input);
+      if (it != pendingInputs_.end()){
+        pendingInputs_.erase(it);
+        postCommand(new SetInputsCommand_(this, pendingInputs_));
+      }
+    }
+    
+    void Mixer_::setNumThreads(unsigned int numThreads){
+#if TONIC_HAS_CPP_11
+      numThreads = numThreads > 0 ? numThreads : 1;
+      if (numThreads == pendingNumThreads_) return;
+      
+      pendingNumThreads_ = numThreads;
+      postCommand(new SetWorkerPoolCommand_(this, numThreads));
+#else
+      if (numThreads > 1){
+        warning("Mixer::setNumThreads requires C++11. Inputs will be mixed serially.");
       }
+#endif
+    }
+    
+    unsigned int Mixer_::numThreads(){
+      return pendingNumThreads_;
+    }
+    
+    ParallelMixStats Mixer_::parallelStats(){
+#if TONIC_HAS_CPP_11
+      // stop a replaced state being freed while we read it
+      lockCommandQueue();
+      ParallelMixState_ * state = TONIC_ATOMIC_LOAD(parallelState_);
+      ParallelMixStats stats = state->stats;
+      stats.busySeconds = 0;
+      for (unsigned int i=0; i<state->workerBusySeconds.size(); i++){
+        stats.busySeconds += state->workerBusySeconds[i];
+      }
+      unlockCommandQueue();
+      return stats;
+#else
+      return ParallelMixStats();
+#endif
+    }
+    
+    void Mixer_::resetParallelStats(){
+#if TONIC_HAS_CPP_11
+      postCommand(new ResetParallelStatsCommand_(this));
+#endif
     }
   }
   
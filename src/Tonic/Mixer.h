@@ -16,12 +16,59 @@
 
 #include "Synth.h"
 #include "CompressorLimiter.h"
+#include "WorkerPool.h"
 
 using std::vector;
 
 namespace Tonic {
+  
+  //! Accumulated timing for a Mixer rendering its inputs in parallel
+  struct ParallelMixStats {
+    
+    //! Number of threads (including the audio thread) rendering inputs
+    unsigned int  numThreads;
+    
+    //! Number of blocks rendered in parallel since the last reset
+    unsigned long blocks;
+    
+    //! Wall-clock time spent rendering inputs, in seconds
+    double        wallSeconds;
+    
+    //! Sum of the time each thread spent rendering inputs, in seconds
+    double        busySeconds;
+    
+    ParallelMixStats() : numThreads(1), blocks(0), wallSeconds(0), busySeconds(0) {}
+    
+    //! Average number of inputs rendering concurrently. Equal to numThreads for perfect scaling.
+    double speedup() const { return wallSeconds > 0 ? busySeconds / wallSeconds : 0; }
+    
+    //! Fraction of available thread time spent rendering inputs (1.0 = perfect scaling)
+    double efficiency() const { return numThreads > 0 ? speedup() / numThreads : 0; }
+    
+  };
 
   namespace Tonic_ {
+    
+#if TONIC_HAS_CPP_11
+    //! Worker pool and timing for a parallel Mixer_, replaced as a unit when the thread count changes
+    struct ParallelMixState_ {
+      
+      WorkerPool          *workerPool;
+      vector<double>      workerBusySeconds;
+      ParallelMixStats    stats;
+      
+      ParallelMixState_(unsigned int numThreads) :
+        workerPool(numThreads > 1 ? new WorkerPool(numThreads - 1) : NULL),
+        workerBusySeconds(numThreads, 0)
+      {
+        stats.numThreads = numThreads;
+      }
+      
+      ~ParallelMixState_(){ delete workerPool; }
+      
+    };
+#endif
+    
     class Mixer_ : public BufferFiller_ {
       
     private:
@@ -29,30 +76,96 @@ namespace Tonic {
       TonicFrames workSpace_;
       vector<BufferFiller> inputs_;
       
+      // Inputs as last set from the UI thread, ahead of the audio thread until the next block
+      vector<BufferFiller> pendingInputs_;
+      unsigned int pendingNumThreads_;
+      
+#if TONIC_HAS_CPP_11
+      // parallel mode - each input renders into its own frames, then summed in input order
+      ParallelMixState_   *parallelState_;
+      vector<TonicFrames> inputFrames_;
+      const SynthesisContext_ *taskContext_;
+      
+      static void renderInputTask(void *mixer, unsigned int inputIndex, unsigned int workerIndex);
+      
+      friend class SetWorkerPoolCommand_;
+      friend class ResetParallelStatsCommand_;
+#endif
+      
+      friend class SetInputsCommand_;
+      
       void computeSynthesisBlock(const SynthesisContext_ &context);
       
     public:
       
       Mixer_();
+      ~Mixer_();
+      
+      // Overridden so inputs are ticked with the mixer's channel layout
+      void setNumOutputChannels(unsigned int numChannels);
       
       void addInput(BufferFiller input);
       void removeInput(BufferFiller input);
       
+      void setNumThreads(unsigned int numThreads);
+      unsigned int numThreads();
+      
+      ParallelMixStats parallelStats();
+      void resetParallelStats();
+      
     };
     
     inline void Mixer_::computeSynthesisBlock(const SynthesisContext_ &context)
     {
+      
+#if TONIC_HAS_CPP_11
+      if (parallelState_->workerPool && inputs_.size() > 1){
+        
+        const double startTime = monotonicTime();
+        
+        taskContext_ = &context;
+        parallelState_->workerPool->run(&Mixer_::renderInputTask, this, (unsigned int)inputs_.size());
+        
+        parallelState_->stats.wallSeconds += monotonicTime() - startTime;
+        parallelState_->stats.blocks++;
+        
+        // Reduce in input order so the result is bit-identical to the serial path below
+        outputFrames_.clear();
+        isSilent_ = true;
+        for (unsigned int i=0; i<inputs_.size(); i++){
+          if (inputs_[i].isSilent()) continue;
+          outputFrames_ += inputFrames_[i];
+          isSilent_ = false;
+        }
+        
+        return;
+      }
+#endif
+      
       // Clear buffer
       outputFrames_.clear();
+      isSilent_ = true;
       
-      // Tick and add inputs
+      // Tick and add inputs, skipping the sum for silent ones
       for (unsigned int i=0; i<inputs_.size(); i++){
         // Tick each bufferFiller every time, with our context (for now).
         inputs_[i].tick(workSpace_, context);
+        if (inputs_[i].isSilent()) continue;
         outputFrames_ += workSpace_;
+        isSilent_ = false;
       }
       
     }
+    
+#if TONIC_HAS_CPP_11
+    inline void Mixer_::renderInputTask(void *mixer, unsigned int inputIndex, unsigned int workerIndex){
+      Mixer_ *self = static_cast<Mixer_*>(mixer);
+      RenderScope_ renderScope;
+      const double startTime = monotonicTime();
+      self->inputs_[inputIndex].tick(self->inputFrames_[inputIndex], *self->taskContext_);
+      self->parallelState_->workerBusySeconds[workerIndex] += monotonicTime() - startTime;
+    }
+#endif
 
   }
   
@@ -61,15 +174,38 @@ namespace Tonic {
   public:
     
     void addInput(BufferFiller input){
-      gen()->lockMutex();
       gen()->addInput(input);
-      gen()->unlockMutex();
     }
     
     void removeInput(BufferFiller input){
-      gen()->lockMutex();
       gen()->removeInput(input);
-      gen()->unlockMutex();
+    }
+    
+    //! Render inputs on numThreads threads (including the audio thread). Defaults to 1 (serial).
+    /*!
+        Inputs are rendered concurrently by a persistent worker pool and summed in input order, so
+        output is bit-identical to serial mixing. Inputs must not share Generators or ControlGenerators
+        with each other when numThreads > 1. Requires C++11; ignored otherwise.
+     */
+    void setNumThreads(unsigned int numThreads){
+      gen()->setNumThreads(numThreads);
+    }
+    
+    unsigned int numThreads(){
+      return gen()->numThreads();
+    }
+    
+    //! Timing of parallel rendering since the last reset, for measuring scaling efficiency
+    /*!
+        Read without synchronisation while audio is running, so values may be momentarily inconsistent.
+     */
+    ParallelMixStats parallelStats(){
+      return gen()->parallelStats();
+    }
+    
+    //! Clear parallel timing stats at the start of the next block
+    void resetParallelStats(){
+      gen()->resetParallelStats();
     }
     
   };
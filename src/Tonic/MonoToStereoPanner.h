@@ -37,17 +37,20 @@ namespace Tonic {
     
     inline void MonoToStereoPanner_::computeSynthesisBlock(const SynthesisContext_ &context){
       
-      TonicFloat *synthBlockWriteHead = &outputFrames_[0];
-      TonicFloat *dryFramesReadHead = &dryFrames_[0];
+      const TonicFloat *dryFramesReadHead = dryInput_->data();
       
-      unsigned int nSamples = kSynthesisBlockSize;
+      unsigned int nSamples = outputFrames_.frames();
       float panValue = panControlGen.tick(context).value;
       float leftVol = 1. - max(0., panValue);
       float rightVol = 1 + min(0., panValue);
-      while (nSamples--){
-          *(synthBlockWriteHead++) = *dryFramesReadHead * leftVol;
-          *(synthBlockWriteHead++) = *dryFramesReadHead++ * rightVol;
-      }
+      
+#ifdef USE_APPLE_ACCELERATE
+      vDSP_vsmul(dryFramesReadHead, 1, &leftVol, outputFrames_.channelData(TONIC_LEFT), 1, nSamples);
+      vDSP_vsmul(dryFramesReadHead, 1, &rightVol, outputFrames_.channelData(TONIC_RIGHT), 1, nSamples);
+#else
+      vectorKernels().copyScaled(outputFrames_.channelData(TONIC_LEFT), dryFramesReadHead, leftVol, nSamples);
+      vectorKernels().copyScaled(outputFrames_.channelData(TONIC_RIGHT), dryFramesReadHead, rightVol, nSamples);
+#endif
     }
     
   }
@@ -66,7 +66,7 @@ namespace Tonic {
       
       TonicFloat* outptr = &outputFrames_[0];
       
-      for (unsigned int i=0; i<kSynthesisBlockSize; i++){
+      for (unsigned int i=0; i<outputFrames_.frames(); i++){
         
         binidx = countTrailingZeros(pinkCount_);
         binidx = binidx & (kNumPinkNoiseBins-1);
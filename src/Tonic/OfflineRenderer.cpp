@@ -0,0 +1,288 @@
+//
+//  OfflineRenderer.cpp
+//  Tonic
+//
+//
+// See LICENSE.txt for license and usage information.
+//
+
+#include "OfflineRenderer.h"
+
+namespace Tonic {
+
+  // -----------------------------------------
+  //              MEMORY SINK
+  // -----------------------------------------
+
+  OfflineBufferSink::OfflineBufferSink(TonicFloat *outData, unsigned long capacityFrames) :
+    interleaved_(outData), planar_(NULL), capacity_(capacityFrames), written_(0)
+  {}
+
+  OfflineBufferSink::OfflineBufferSink(TonicFloat **channelData, unsigned long capacityFrames) :
+    interleaved_(NULL), planar_(channelData), capacity_(capacityFrames), written_(0)
+  {}
+
+  void OfflineBufferSink::consume(const TonicFloat *interleaved, unsigned int numFrames, unsigned int numChannels){
+
+    if (written_ + numFrames > capacity_){
+      numFrames = (unsigned int)(capacity_ - written_);
+    }
+
+    if (interleaved_){
+      memcpy(interleaved_ + written_ * numChannels, interleaved, numFrames * numChannels * sizeof(TonicFloat));
+    }
+    else if (planar_){
+      // deinterleave
+      for (unsigned int c=0; c<numChannels; c++){
+        vcopy(planar_[c] + written_, 1, interleaved + c, numChannels, numFrames);
+      }
+    }
+
+    written_ += numFrames;
+  }
+
+  // -----------------------------------------
+  //              WAV FILE SINK
+  // -----------------------------------------
+
+  // WAV is little-endian regardless of host byte order
+  static void writeLE32(FILE *file, TonicUInt32 value){
+    unsigned char bytes[4] = {
+      (unsigned char)(value & 0xFF),
+      (unsigned char)((value >> 8) & 0xFF),
+      (unsigned char)((value >> 16) & 0xFF),
+      (unsigned char)((value >> 24) & 0xFF)
+    };
+    fwrite(bytes, 1, 4, file);
+  }
+
+  static void writeLE16(FILE *file, unsigned short value){
+    unsigned char bytes[2] = {
+      (unsigned char)(value & 0xFF),
+      (unsigned char)((value >> 8) & 0xFF)
+    };
+    fwrite(bytes, 1, 2, file);
+  }
+
+  // Byte offsets of the size fields which are patched once the render completes
+  static const long kWavRiffSizeOffset = 4;
+  static const long kWavFactFramesOffset = 46;
+  static const long kWavDataSizeOffset = 54;
+  static const long kWavHeaderSize = 58;
+
+  // More than two channels need WAVE_FORMAT_EXTENSIBLE, whose fmt chunk is longer by this much,
+  // moving everything after it along
+  static const long kWavExtensibleBytes = 22;
+
+  static long wavExtraFormatBytes(unsigned int numChannels){
+    return numChannels > 2 ? kWavExtensibleBytes : 0;
+  }
+
+  // KSDATAFORMAT_SUBTYPE_IEEE_FLOAT
+  static const unsigned char kWavFloatSubFormat[16] = {
+    0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71
+  };
+
+  // Channels take the speaker positions in WAVEFORMATEXTENSIBLE order - front left, front right, centre,
+  // LFE, back left, back right... so six channels are 5.1. There are 18 positions; past that, none is given.
+  static const unsigned int kWavSpeakerPositions = 18;
+
+  OfflineWavFileSink::OfflineWavFileSink(string path) : path_(path), file_(NULL), bytesWritten_(0), numChannels_(0) {}
+
+  OfflineWavFileSink::~OfflineWavFileSink(){
+    end();
+  }
+
+  bool OfflineWavFileSink::begin(unsigned int numChannels, TonicFloat sampleRate){
+
+    end();
+
+    file_ = fopen(path_.c_str(), "wb");
+    if (!file_){
+      error("OfflineWavFileSink: could not open " + path_ + " for writing");
+      return false;
+    }
+
+    numChannels_ = numChannels;
+    bytesWritten_ = 0;
+
+    const TonicUInt32 bytesPerFrame = numChannels * sizeof(float);
+
+    fwrite("RIFF", 1, 4, file_);
+    writeLE32(file_, 0); // patched in end()
+    fwrite("WAVE", 1, 4, file_);
+
+    // WAVE_FORMAT_IEEE_FLOAT, or WAVE_FORMAT_EXTENSIBLE with a float sub-format
+    const bool extensible = numChannels > 2;
+    fwrite("fmt ", 1, 4, file_);
+    writeLE32(file_, (TonicUInt32)(18 + wavExtraFormatBytes(numChannels)));
+    writeLE16(file_, extensible ? 0xFFFE : 3);
+    writeLE16(file_, (unsigned short)numChannels);
+    writeLE32(file_, (TonicUInt32)sampleRate);
+    writeLE32(file_, (TonicUInt32)sampleRate * bytesPerFrame);
+    writeLE16(file_, (unsigned short)bytesPerFrame);
+    writeLE16(file_, 32);
+    writeLE16(file_, (unsigned short)wavExtraFormatBytes(numChannels));
+    if (extensible){
+      writeLE16(file_, 32); // valid bits per sample
+      writeLE32(file_, numChannels <= kWavSpeakerPositions ? (TonicUInt32)((1 << numChannels) - 1) : 0);
+      fwrite(kWavFloatSubFormat, 1, sizeof(kWavFloatSubFormat), file_);
+    }
+
+    // non-PCM formats should carry a fact chunk
+    fwrite("fact", 1, 4, file_);
+    writeLE32(file_, 4);
+    writeLE32(file_, 0); // patched in end()
+
+    fwrite("data", 1, 4, file_);
+    writeLE32(file_, 0); // patched in end()
+
+    return true;
+  }
+
+  void OfflineWavFileSink::consume(const TonicFloat *interleaved, unsigned int numFrames, unsigned int numChannels){
+
+    if (!file_) return;
+
+    const unsigned int numSamples = numFrames * numChannels;
+
+    union { float f; TonicUInt32 i; } sample;
+    unsigned char bytes[4096];
+    unsigned int byteIdx = 0;
+
+    for (unsigned int i=0; i<numSamples; i++){
+      sample.f = interleaved[i];
+      bytes[byteIdx++] = (unsigned char)(sample.i & 0xFF);
+      bytes[byteIdx++] = (unsigned char)((sample.i >> 8) & 0xFF);
+      bytes[byteIdx++] = (unsigned char)((sample.i >> 16) & 0xFF);
+      bytes[byteIdx++] = (unsigned char)((sample.i >> 24) & 0xFF);
+      if (byteIdx == sizeof(bytes)){
+        fwrite(bytes, 1, byteIdx, file_);
+        byteIdx = 0;
+      }
+    }
+
+    if (byteIdx > 0){
+      fwrite(bytes, 1, byteIdx, file_);
+    }
+
+    bytesWritten_ += numSamples * sizeof(float);
+  }
+
+  void OfflineWavFileSink::end(){
+
+    if (!file_) return;
+
+    const long extraFormatBytes = wavExtraFormatBytes(numChannels_);
+
+    fseek(file_, kWavRiffSizeOffset, SEEK_SET);
+    writeLE32(file_, (TonicUInt32)(kWavHeaderSize + extraFormatBytes - 8 + bytesWritten_));
+
+    fseek(file_, kWavFactFramesOffset + extraFormatBytes, SEEK_SET);
+    writeLE32(file_, (TonicUInt32)(bytesWritten_ / (numChannels_ * sizeof(float))));
+
+    fseek(file_, kWavDataSizeOffset + extraFormatBytes, SEEK_SET);
+    writeLE32(file_, (TonicUInt32)bytesWritten_);
+
+    fclose(file_);
+    file_ = NULL;
+  }
+
+  // -----------------------------------------
+  //              RENDERER
+  // -----------------------------------------
+
+  OfflineRenderer::OfflineRenderer(BufferFiller source, unsigned int numChannels) :
+    source_(source), numChannels_(numChannels), chunkFrames_(4096), valid_(true)
+  {
+    if (numChannels_ < 1){
+      error("OfflineRenderer needs at least one output channel. Rendering in stereo.");
+      numChannels_ = 2;
+    }
+  }
+
+  OfflineRenderer::OfflineRenderer(string synthName, unsigned int numChannels) :
+    source_(SynthFactory::createInstance(synthName)), numChannels_(numChannels), chunkFrames_(4096),
+    valid_(SynthFactory::isRegistered(synthName))
+  {
+    if (numChannels_ < 1){
+      error("OfflineRenderer needs at least one output channel. Rendering in stereo.");
+      numChannels_ = 2;
+    }
+  }
+
+  void OfflineRenderer::setChunkFrames(unsigned int chunkFrames){
+    chunkFrames_ = chunkFrames > kSynthesisBlockSize ? chunkFrames : kSynthesisBlockSize;
+  }
+
+  unsigned long OfflineRenderer::framesForDuration(double seconds) const {
+    return seconds > 0 ? (unsigned long)(seconds * source_.sampleRate() + 0.5) : 0;
+  }
+
+  OfflineRenderStats OfflineRenderer::renderFrames(OfflineRenderSink & sink, unsigned long numFrames){
+
+    OfflineRenderStats stats;
+
+    if (!valid_){
+      error("OfflineRenderer: no synth to render");
+      return stats;
+    }
+
+    if (!sink.begin(numChannels_, source_.sampleRate())){
+      return stats;
+    }
+
+    vector<TonicFloat> chunk(chunkFrames_ * numChannels_);
+
+    const double startTime = monotonicTime();
+
+    unsigned long remaining = numFrames;
+    while (remaining > 0){
+      unsigned int framesThisChunk = remaining < chunkFrames_ ? (unsigned int)remaining : chunkFrames_;
+      source_.fillBufferOfFloats(&chunk[0], framesThisChunk, numChannels_);
+      sink.consume(&chunk[0], framesThisChunk, numChannels_);
+      remaining -= framesThisChunk;
+    }
+
+    sink.end();
+
+    stats.wallSeconds = monotonicTime() - startTime;
+    stats.frames = numFrames;
+    stats.audioSeconds = (double)numFrames / source_.sampleRate();
+    stats.realtimeFactor = stats.wallSeconds > 0 ? stats.audioSeconds / stats.wallSeconds : 0;
+
+    return stats;
+  }
+
+  OfflineRenderStats OfflineRenderer::render(OfflineRenderSink & sink, double seconds){
+    return renderFrames(sink, framesForDuration(seconds));
+  }
+
+  OfflineRenderStats OfflineRenderer::renderInterleaved(TonicFloat *outData, unsigned long numFrames){
+    OfflineBufferSink sink(outData, numFrames);
+    return renderFrames(sink, numFrames);
+  }
+
+  OfflineRenderStats OfflineRenderer::renderPlanar(TonicFloat **channelData, unsigned long numFrames){
+    OfflineBufferSink sink(channelData, numFrames);
+    return renderFrames(sink, numFrames);
+  }
+
+  SampleTable OfflineRenderer::renderToSampleTable(double seconds, OfflineRenderStats *stats){
+    unsigned long numFrames = framesForDuration(seconds);
+    SampleTable table = SampleTable((unsigned int)numFrames, numChannels_);
+    vector<TonicFloat*> channelData(numChannels_);
+    for (unsigned int c=0; c<numChannels_; c++){
+      channelData[c] = table.channelPointer(c);
+    }
+    OfflineRenderStats renderStats = renderPlanar(&channelData[0], numFrames);
+    if (stats) *stats = renderStats;
+    return table;
+  }
+
+  OfflineRenderStats OfflineRenderer::renderToWavFile(string path, double seconds){
+    OfflineWavFileSink sink(path);
+    return render(sink, seconds);
+  }
+
+}
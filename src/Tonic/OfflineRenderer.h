@@ -0,0 +1,165 @@
+//
+//  OfflineRenderer.h
+//  Tonic
+//
+//
+// See LICENSE.txt for license and usage information.
+//
+
+//! Drives a BufferFiller (Synth, Mixer, etc) as fast as the CPU allows, without an audio device
+
+#ifndef TONIC_OFFLINERENDERER_H
+#define TONIC_OFFLINERENDERER_H
+
+#include "Synth.h"
+#include "SampleTable.h"
+
+namespace Tonic {
+
+  //! Statistics describing a completed offline render
+  struct OfflineRenderStats {
+
+    //! Number of sample frames rendered
+    unsigned long frames;
+
+    //! Duration of rendered audio, in seconds
+    double audioSeconds;
+
+    //! Wall-clock time spent rendering, in seconds
+    double wallSeconds;
+
+    //! Realtime factor (xRT). 10.0 means ten seconds of audio were rendered per second of wall time.
+    double realtimeFactor;
+
+    OfflineRenderStats() : frames(0), audioSeconds(0), wallSeconds(0), realtimeFactor(0) {}
+
+  };
+
+  //! Destination for offline-rendered audio
+  /*!
+      Subclass to stream rendered audio somewhere other than memory or a WAV file.
+      consume() is called with consecutive chunks of interleaved samples.
+   */
+  class OfflineRenderSink {
+
+  public:
+
+    virtual ~OfflineRenderSink() {}
+
+    //! Called once before rendering starts. Return false to abort the render.
+    virtual bool begin(unsigned int numChannels, TonicFloat sampleRate) { return true; }
+
+    //! Receives numFrames frames of interleaved audio with numChannels channels
+    virtual void consume(const TonicFloat *interleaved, unsigned int numFrames, unsigned int numChannels) = 0;
+
+    //! Called once after the last chunk has been consumed
+    virtual void end() {}
+
+  };
+
+  //! Writes rendered audio to caller-owned memory, either interleaved or one buffer per channel (planar)
+  class OfflineBufferSink : public OfflineRenderSink {
+
+  protected:
+
+    TonicFloat  *interleaved_;
+    TonicFloat  **planar_;
+    unsigned long capacity_;
+    unsigned long written_;
+
+  public:
+
+    //! Interleaved output. outData must hold at least capacityFrames * numChannels samples.
+    OfflineBufferSink(TonicFloat *outData, unsigned long capacityFrames);
+
+    //! Planar output. channelData must hold one pointer per channel, each to at least capacityFrames samples.
+    OfflineBufferSink(TonicFloat **channelData, unsigned long capacityFrames);
+
+    void consume(const TonicFloat *interleaved, unsigned int numFrames, unsigned int numChannels);
+
+    unsigned long framesWritten() const { return written_; }
+
+  };
+
+  //! Writes rendered audio to a 32-bit float WAV file, with WAVE_FORMAT_EXTENSIBLE for more than two channels
+  class OfflineWavFileSink : public OfflineRenderSink {
+
+  protected:
+
+    string        path_;
+    FILE          *file_;
+    unsigned long bytesWritten_;
+    unsigned int  numChannels_;
+
+  public:
+
+    OfflineWavFileSink(string path);
+    ~OfflineWavFileSink();
+
+    bool begin(unsigned int numChannels, TonicFloat sampleRate);
+    void consume(const TonicFloat *interleaved, unsigned int numFrames, unsigned int numChannels);
+    void end();
+
+  };
+
+  //! Renders any BufferFiller offline, faster than realtime
+  /*!
+      Typical usage:
+
+        OfflineRenderer renderer = OfflineRenderer(SynthFactory::createInstance("FMDroneSynth"));
+        OfflineRenderStats stats = renderer.renderToWavFile("drone.wav", 60.0);
+        printf("Rendered at %.1fx realtime\n", stats.realtimeFactor);
+
+      The source must not be attached to a live audio callback while rendering offline. A renderer created
+      for a synth name that isn't registered is not valid, and renders nothing.
+   */
+  class OfflineRenderer {
+
+  protected:
+
+    BufferFiller  source_;
+    unsigned int  numChannels_;
+    unsigned int  chunkFrames_;
+    bool          valid_;
+
+  public:
+
+    OfflineRenderer(BufferFiller source, unsigned int numChannels = 2);
+
+    //! Create a renderer for a synth registered with TONIC_REGISTER_SYNTH
+    OfflineRenderer(string synthName, unsigned int numChannels = 2);
+
+    //! Number of frames handed to the sink per consume() call. Defaults to 4096.
+    void setChunkFrames(unsigned int chunkFrames);
+
+    unsigned int numChannels() const { return numChannels_; }
+
+    //! False if the renderer was created for a synth name that isn't registered
+    bool isValid() const { return valid_; }
+
+    //! Number of whole frames needed to represent the given duration at the source's sample rate
+    unsigned long framesForDuration(double seconds) const;
+
+    //! Render numFrames frames into sink, as fast as possible. Renders nothing, with empty stats, if not valid.
+    OfflineRenderStats renderFrames(OfflineRenderSink & sink, unsigned long numFrames);
+
+    //! Render the given duration into sink, as fast as possible
+    OfflineRenderStats render(OfflineRenderSink & sink, double seconds);
+
+    //! Render into an interleaved buffer holding at least numFrames * numChannels() samples
+    OfflineRenderStats renderInterleaved(TonicFloat *outData, unsigned long numFrames);
+
+    //! Render into numChannels() separate buffers, each holding at least numFrames samples
+    OfflineRenderStats renderPlanar(TonicFloat **channelData, unsigned long numFrames);
+
+    //! Render the given duration into a newly allocated SampleTable
+    SampleTable renderToSampleTable(double seconds, OfflineRenderStats *stats = NULL);
+
+    //! Render the given duration to a 32-bit float WAV file
+    OfflineRenderStats renderToWavFile(string path, double seconds);
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,82 @@
+//
+//  OscillatorBank.cpp
+//  Tonic
+//
+//
+// See LICENSE.txt for license and usage information.
+//
+
+#include "OscillatorBank.h"
+#include "ControlValue.h"
+
+namespace Tonic {
+
+  namespace Tonic_ {
+
+    OscillatorBank_::OscillatorBank_() :
+      started_(false)
+    {
+    }
+
+    void OscillatorBank_::setNumPartials( unsigned int numPartials ){
+
+      const size_t lanes = VectorKernels::kSineBankLanes;
+      const size_t paddedPartials = (numPartials + lanes - 1) / lanes * lanes;
+
+      frequencies_.resize(numPartials, ControlValue(0));
+      amplitudes_.resize(numPartials, ControlValue(0));
+
+      // partials removed and padding are left silent, so the kernel can run over them
+      phase_.resize(paddedPartials, 0);
+      increment_.resize(paddedPartials, 0);
+      amplitude_.resize(paddedPartials, 0);
+      amplitudeStep_.resize(paddedPartials, 0);
+      targetAmplitude_.resize(paddedPartials, 0);
+      blockPhase_.resize(numPartials, 0);
+      for (size_t p=numPartials; p<paddedPartials; p++){
+        increment_[p] = amplitude_[p] = amplitudeStep_[p] = targetAmplitude_[p] = 0;
+      }
+    }
+
+    void OscillatorBank_::setFrequency( unsigned int partial, ControlGenerator frequency ){
+      if (partial >= frequencies_.size()){
+        error("OscillatorBank::setFrequency - no such partial. Call partials() first.");
+        return;
+      }
+      frequencies_[partial] = frequency;
+    }
+
+    void OscillatorBank_::setAmplitude( unsigned int partial, ControlGenerator amplitude ){
+      if (partial >= amplitudes_.size()){
+        error("OscillatorBank::setAmplitude - no such partial. Call partials() first.");
+        return;
+      }
+      amplitudes_[partial] = amplitude;
+    }
+
+  }
+
+  OscillatorBank & OscillatorBank::partials( unsigned int numPartials ){
+    gen()->setNumPartials(numPartials);
+    return *this;
+  }
+
+  OscillatorBank & OscillatorBank::freq( unsigned int partial, ControlGenerator frequency ){
+    gen()->setFrequency(partial, frequency);
+    return *this;
+  }
+
+  OscillatorBank & OscillatorBank::freq( unsigned int partial, float frequency ){
+    return freq(partial, ControlValue(frequency));
+  }
+
+  OscillatorBank & OscillatorBank::amp( unsigned int partial, ControlGenerator amplitude ){
+    gen()->setAmplitude(partial, amplitude);
+    return *this;
+  }
+
+  OscillatorBank & OscillatorBank::amp( unsigned int partial, float amplitude ){
+    return amp(partial, ControlValue(amplitude));
+  }
+
+}
@@ -0,0 +1,130 @@
+//
+//  OscillatorBank.h
+//  Tonic
+//
+//
+// See LICENSE.txt for license and usage information.
+//
+
+#ifndef TONIC_OSCILLATORBANK_H
+#define TONIC_OSCILLATORBANK_H
+
+#include "Generator.h"
+#include "ControlGenerator.h"
+
+namespace Tonic {
+
+  namespace Tonic_ {
+
+    //! Sum of many sine waves, computed together
+    /*!
+        Phases, per-sample phase increments and amplitudes are kept in structure-of-arrays form and run
+        through vectorKernels().sineBank() in one go, summing straight into the output - for hundreds of
+        partials at a fraction of the cost of as many SineWaves and an Adder.
+
+        Frequencies and amplitudes are read once per block. A frequency change takes effect at the block
+        boundary, without a phase jump; an amplitude change is ramped across the block.
+     */
+    class OscillatorBank_ : public Generator_ {
+
+    protected:
+
+      vector<ControlGenerator>  frequencies_;
+      vector<ControlGenerator>  amplitudes_;
+
+      // one element per partial, padded with silent partials to a multiple of VectorKernels::kSineBankLanes
+      vector<TonicFloat>        phase_;
+      vector<TonicFloat>        increment_;
+      vector<TonicFloat>        amplitude_;
+      vector<TonicFloat>        amplitudeStep_;
+
+      // amplitudes as of the end of the current block
+      vector<TonicFloat>        targetAmplitude_;
+
+      // phases at the start of the next block, kept in double precision - a single precision phase
+      // accumulator drifts audibly in seconds, so phase_ is only trusted for a block at a time
+      vector<double>            blockPhase_;
+
+      bool                      started_;
+
+      void computeSynthesisBlock( const SynthesisContext_ & context );
+
+    public:
+
+      OscillatorBank_();
+
+      //! New partials are silent, at 0 Hz. Allocates, so not while the bank is playing.
+      void setNumPartials( unsigned int numPartials );
+      unsigned int numPartials() const { return (unsigned int)frequencies_.size(); }
+
+      void setFrequency( unsigned int partial, ControlGenerator frequency );
+      void setAmplitude( unsigned int partial, ControlGenerator amplitude );
+
+    };
+
+    inline void OscillatorBank_::computeSynthesisBlock( const SynthesisContext_ & context ){
+
+      if (frequencies_.empty()){
+        fillConstant(0);
+        return;
+      }
+      isConstant_ = false;
+
+      const unsigned int nFrames = (unsigned int)outputFrames_.frames();
+      const double secondsPerSample = 1.0 / sampleRate_;
+
+      for (unsigned int p=0; p<frequencies_.size(); p++){
+
+        // cycles per sample, wrapped into [0, 1) so negative and very high frequencies alias as they would
+        double increment = frequencies_[p].tick(context).value * secondsPerSample;
+        increment -= floor(increment);
+        increment_[p] = (TonicFloat)increment < 1.f ? (TonicFloat)increment : 0.f;
+
+        double phase = blockPhase_[p];
+        phase_[p] = (TonicFloat)phase < 1.f ? (TonicFloat)phase : 0.f;
+        phase += increment * nFrames;
+        blockPhase_[p] = phase - floor(phase);
+
+        // the first block starts at the amplitude given, later ones ramp to it
+        targetAmplitude_[p] = amplitudes_[p].tick(context).value;
+        if (!started_) amplitude_[p] = targetAmplitude_[p];
+        amplitudeStep_[p] = (targetAmplitude_[p] - amplitude_[p]) / nFrames;
+      }
+
+      vectorKernels().sineBank(&outputFrames_[0], nFrames, &phase_[0], &increment_[0], &amplitude_[0], &amplitudeStep_[0], phase_.size());
+
+      // the ramps end at their targets to within rounding - don't let that accumulate
+      for (unsigned int p=0; p<amplitudes_.size(); p++){
+        amplitude_[p] = targetAmplitude_[p];
+      }
+
+      started_ = true;
+    }
+
+  }
+
+  //! Additive oscillator: any number of sine partials, each with its own frequency and amplitude
+  /*!
+      OscillatorBank bank = OscillatorBank().partials(3);
+      bank.freq(0, 220).amp(0, 0.5);
+      bank.freq(1, 440).amp(1, 0.25);
+      bank.freq(2, pitch * 3).amp(2, level);
+   */
+  class OscillatorBank : public TemplatedGenerator<Tonic_::OscillatorBank_> {
+
+  public:
+
+    OscillatorBank & partials( unsigned int numPartials );
+    unsigned int numPartials(){ return gen()->numPartials(); }
+
+    OscillatorBank & freq( unsigned int partial, ControlGenerator frequency );
+    OscillatorBank & freq( unsigned int partial, float frequency );
+
+    OscillatorBank & amp( unsigned int partial, ControlGenerator amplitude );
+    OscillatorBank & amp( unsigned int partial, float amplitude );
+
+  };
+
+}
+
+#endif
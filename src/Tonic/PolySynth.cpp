@@ -0,0 +1,245 @@
+//
+//  PolySynth.cpp
+//  Tonic
+//
+//
+// See LICENSE.txt for license and usage information.
+//
+
+#include "PolySynth.h"
+
+namespace Tonic {
+
+  namespace Tonic_ {
+
+    // Installs a new list of voices, prepared off the audio thread
+    class SetVoicesCommand_ : public BufferFillerCommand_ {
+
+      PolyVoices_ * voices_;
+      vector<PolyVoice_> newVoices_;
+
+    public:
+
+      SetVoicesCommand_(PolyVoices_ * voices, const vector<PolyVoice_> & newVoices) : voices_(voices), newVoices_(newVoices) {}
+
+      void execute(){
+        voices_->swapVoices(newVoices_);
+      }
+
+    };
+
+    class SetVoiceStealingCommand_ : public BufferFillerCommand_ {
+
+      PolyVoices_ * voices_;
+      VoiceStealingMode mode_;
+
+    public:
+
+      SetVoiceStealingCommand_(PolyVoices_ * voices, VoiceStealingMode mode) : voices_(voices), mode_(mode) {}
+
+      void execute(){
+        voices_->setVoiceStealing(mode_);
+      }
+
+    };
+
+    // Voices are allocated on the audio thread, where it's known which ones are still sounding
+    class NoteCommand_ : public BufferFillerCommand_ {
+
+    public:
+
+      enum Type {
+        NOTE_ON,
+        NOTE_OFF,
+        ALL_NOTES_OFF
+      };
+
+      NoteCommand_(PolyVoices_ * voices, Type type, int note = 0, int velocity = 0) :
+        voices_(voices), type_(type), note_(note), velocity_(velocity) {}
+
+      void execute(){
+        switch (type_) {
+          case NOTE_ON:
+            voices_->noteOn(note_, velocity_);
+            break;
+          case NOTE_OFF:
+            voices_->noteOff(note_);
+            break;
+          case ALL_NOTES_OFF:
+            voices_->allNotesOff();
+            break;
+        }
+      }
+
+    private:
+
+      PolyVoices_ * voices_;
+      Type type_;
+      int note_;
+      int velocity_;
+
+    };
+
+    // ---------------------------------
+
+    PolyVoices_::PolyVoices_() :
+      stealing_(VoiceStealingOldest),
+      noteCounter_(0),
+      numSoundingVoices_(0)
+    {
+      setIsStereoOutput(true);
+      voiceFrames_.resize(kSynthesisBlockSize, 2, 0);
+    }
+
+    void PolyVoices_::swapVoices(vector<PolyVoice_> & voices){
+      for (unsigned int i=0; i<voices.size() && i<voices_.size(); i++){
+        voices[i].copyStateFrom(voices_[i]);
+      }
+      voices_.swap(voices);
+    }
+
+    PolyVoice_ * PolyVoices_::voiceForNote(int note){
+
+      PolyVoice_ * freeVoice = NULL;
+      PolyVoice_ * releasedVoice = NULL;
+      PolyVoice_ * heldVoice = NULL;
+
+      for (unsigned int i=0; i<voices_.size(); i++){
+
+        PolyVoice_ & voice = voices_[i];
+
+        if (voice.sounding && voice.currentNote == note){
+          // retrigger rather than doubling up
+          return &voice;
+        }
+
+        if (!voice.sounding){
+          // least recently used, so a voice's release gets as long as possible before it's reused
+          if (!freeVoice || voice.noteOrder < freeVoice->noteOrder) freeVoice = &voice;
+        }
+        else if (!voice.held){
+          if (!releasedVoice ||
+              (stealing_ == VoiceStealingQuietest ? voice.level < releasedVoice->level : voice.noteOrder < releasedVoice->noteOrder))
+          {
+            releasedVoice = &voice;
+          }
+        }
+        else{
+          bool steal = false;
+          if (!heldVoice){
+            steal = true;
+          }
+          else{
+            switch (stealing_) {
+              case VoiceStealingOldest:       steal = voice.noteOrder < heldVoice->noteOrder; break;
+              case VoiceStealingQuietest:     steal = voice.level < heldVoice->level; break;
+              case VoiceStealingLowestNote:   steal = voice.currentNote < heldVoice->currentNote; break;
+              case VoiceStealingHighestNote:  steal = voice.currentNote > heldVoice->currentNote; break;
+              default: break;
+            }
+          }
+          if (steal) heldVoice = &voice;
+        }
+      }
+
+      if (freeVoice) return freeVoice;
+      if (releasedVoice) return releasedVoice;
+      if (stealing_ == VoiceStealingNone) return NULL;
+      return heldVoice;
+    }
+
+    void PolyVoices_::noteOn(int note, int velocity){
+
+      PolyVoice_ * voice = voiceForNote(note);
+      if (!voice) return;
+
+      voice->currentNote = note;
+      voice->held = true;
+      voice->sounding = true;
+      voice->noteOrder = ++noteCounter_;
+
+      voice->note.value(note);
+      voice->velocity.value(velocity);
+      voice->gate.value(1);
+    }
+
+    void PolyVoices_::noteOff(int note){
+      for (unsigned int i=0; i<voices_.size(); i++){
+        PolyVoice_ & voice = voices_[i];
+        if (voice.held && voice.currentNote == note){
+          voice.held = false;
+          voice.gate.value(0);
+        }
+      }
+    }
+
+    void PolyVoices_::allNotesOff(){
+      for (unsigned int i=0; i<voices_.size(); i++){
+        PolyVoice_ & voice = voices_[i];
+        if (voice.held){
+          voice.held = false;
+          voice.gate.value(0);
+        }
+      }
+    }
+
+    // ---------------------------------
+
+    PolySynth_::PolySynth_(){
+      voices_ = new PolyVoices_();
+      voicesGen_ = Generator(voices_);
+      setOutputGen(voicesGen_);
+    }
+
+    void PolySynth_::addVoice(Synth voice, ADSR envelope){
+
+      PolyVoice_ polyVoice;
+      polyVoice.synth = voice;
+      polyVoice.envelope = envelope;
+
+      // the mix is limited as a whole
+      voice.setLimitOutput(false);
+
+      bool hasGate = false;
+      vector<ControlParameter> parameters = voice.getParameters();
+      for (unsigned int i=0; i<parameters.size(); i++){
+        string name = parameters[i].getName();
+        if (name == "polyNote"){
+          polyVoice.note = parameters[i];
+        }
+        else if (name == "polyGate"){
+          polyVoice.gate = parameters[i];
+          hasGate = true;
+        }
+        else if (name == "polyVelocity"){
+          polyVoice.velocity = parameters[i];
+        }
+      }
+
+      if (!hasGate){
+        warning("PolySynth::addVoice - voice has no \"polyGate\" parameter, so notes will never start or stop its envelope.");
+      }
+
+      pendingVoices_.push_back(polyVoice);
+      postCommand(new SetVoicesCommand_(voices_, pendingVoices_));
+    }
+
+    void PolySynth_::setVoiceStealing(VoiceStealingMode mode){
+      postCommand(new SetVoiceStealingCommand_(voices_, mode));
+    }
+
+    void PolySynth_::noteOn(int note, int velocity){
+      postCommand(new NoteCommand_(voices_, NoteCommand_::NOTE_ON, note, velocity));
+    }
+
+    void PolySynth_::noteOff(int note){
+      postCommand(new NoteCommand_(voices_, NoteCommand_::NOTE_OFF, note));
+    }
+
+    void PolySynth_::allNotesOff(){
+      postCommand(new NoteCommand_(voices_, NoteCommand_::ALL_NOTES_OFF));
+    }
+
+  }
+
+} // Namespace Tonic
@@ -0,0 +1,262 @@
+//
+//  PolySynth.h
+//  Tonic
+//
+//
+// See LICENSE.txt for license and usage information.
+//
+
+
+#ifndef TONIC_POLYSYNTH_H
+#define TONIC_POLYSYNTH_H
+
+#include "Synth.h"
+#include "ADSR.h"
+
+using std::vector;
+
+namespace Tonic {
+
+  //! Which voice a PolySynth takes over when a note starts and every voice is held
+  typedef enum{
+
+    VoiceStealingOldest = 0,    // the voice whose note started first
+    VoiceStealingQuietest,      // the voice with the lowest peak level in the last block
+    VoiceStealingLowestNote,
+    VoiceStealingHighestNote,
+    VoiceStealingNone           // drop the new note
+
+  } VoiceStealingMode;
+
+  namespace Tonic_ {
+
+    //! One voice of a PolySynth, along with its allocation state
+    struct PolyVoice_ {
+
+      Synth             synth;
+      ADSR              envelope;
+
+      ControlParameter  note;
+      ControlParameter  gate;
+      ControlParameter  velocity;
+
+      // -- state, only touched on the audio thread --
+
+      int               currentNote;
+      bool              held;       // between note on and note off
+      bool              sounding;   // being rendered - held, or released with the envelope still running
+      unsigned long     noteOrder;  // when the voice's current note started
+      TonicFloat        level;      // peak output in the last block, only tracked for VoiceStealingQuietest
+
+      PolyVoice_() : currentNote(-1), held(false), sounding(false), noteOrder(0), level(0) {}
+
+      void copyStateFrom(const PolyVoice_ & other){
+        currentNote = other.currentNote;
+        held = other.held;
+        sounding = other.sounding;
+        noteOrder = other.noteOrder;
+        level = other.level;
+      }
+
+    };
+
+    //! Sum of the sounding voices of a PolySynth
+    /*!
+        Voices are only rendered while sounding. Once a released voice's envelope goes idle the voice
+        stops being ticked until its next note, so the cost of a block depends on the number of
+        sounding voices rather than the number allocated.
+     */
+    class PolyVoices_ : public Generator_ {
+
+    protected:
+
+      vector<PolyVoice_>  voices_;
+      TonicFrames         voiceFrames_;
+
+      VoiceStealingMode   stealing_;
+      unsigned long       noteCounter_;
+      unsigned int        numSoundingVoices_;
+
+      PolyVoice_ * voiceForNote(int note);
+
+      void computeSynthesisBlock( const SynthesisContext_ &context );
+
+    public:
+
+      PolyVoices_();
+
+      // -- audio thread only, called from commands --
+
+      //! Swap in a new list of voices, carrying over the state of those already playing
+      void swapVoices(vector<PolyVoice_> & voices);
+
+      void setVoiceStealing(VoiceStealingMode mode){ stealing_ = mode; }
+
+      void noteOn(int note, int velocity);
+      void noteOff(int note);
+      void allNotesOff();
+
+      //! Number of voices rendered in the last block. Safe to read from any thread.
+      unsigned int numSoundingVoices(){ return TONIC_ATOMIC_LOAD(numSoundingVoices_); }
+
+    };
+
+    inline void PolyVoices_::computeSynthesisBlock( const SynthesisContext_ &context ){
+
+      outputFrames_.clear();
+
+      unsigned int numSounding = 0;
+      bool allSilent = true;
+
+      for (unsigned int i=0; i<voices_.size(); i++){
+
+        PolyVoice_ & voice = voices_[i];
+        if (!voice.sounding) continue;
+
+        voice.synth.tick(voiceFrames_, context);
+        if (!voice.synth.isSilent()){
+          outputFrames_ += voiceFrames_;
+          allSilent = false;
+        }
+
+        if (stealing_ == VoiceStealingQuietest){
+          TonicFloat peak = 0;
+          TonicFloat *vptr = &voiceFrames_[0];
+          for (unsigned int s=0; s<voiceFrames_.size(); s++){
+            peak = max(peak, fabsf(*vptr++));
+          }
+          voice.level = peak;
+        }
+
+        // the envelope finished its release during this block - nothing left to render
+        if (!voice.held && voice.envelope.isIdle()){
+          voice.sounding = false;
+          voice.currentNote = -1;
+          voice.level = 0;
+        }
+        else{
+          numSounding++;
+        }
+      }
+
+      isSilent_ = allSilent;
+
+      if (numSounding != numSoundingVoices_){
+        TONIC_ATOMIC_STORE(numSoundingVoices_, numSounding);
+      }
+    }
+
+    //! Synth_ which plays notes on a fixed pool of voices
+    class PolySynth_ : public Synth_ {
+
+    protected:
+
+      Generator             voicesGen_;
+      PolyVoices_           *voices_;
+
+      // Voices as last set from the UI thread, ahead of the audio thread until the next block
+      vector<PolyVoice_>    pendingVoices_;
+
+    public:
+
+      PolySynth_();
+
+      void addVoice(Synth voice, ADSR envelope);
+      unsigned int numVoices(){ return (unsigned int)pendingVoices_.size(); }
+      unsigned int numSoundingVoices(){ return voices_->numSoundingVoices(); }
+
+      void setVoiceStealing(VoiceStealingMode mode);
+
+      void noteOn(int note, int velocity);
+      void noteOff(int note);
+      void allNotesOff();
+
+      Generator voices(){ return voicesGen_; }
+
+    };
+
+  }
+
+  //! Synth which plays notes on a preallocated pool of voices
+  /*!
+      Each voice is a Synth with its own graph, built once up front. A voice is driven by parameters
+      named "polyNote" (MIDI note number), "polyGate" (1 on note on, 0 on note off) and, optionally,
+      "polyVelocity" (MIDI velocity). Its envelope must be triggered by the gate:
+
+        Synth voice;
+        ControlParameter note = voice.addParameter("polyNote");
+        ADSR env = ADSR(0.01, 0.1, 0.8, 0.3).trigger(voice.addParameter("polyGate"));
+        voice.setOutputGen(SawtoothWave().freq(ControlMidiToFreq().input(note)) * env);
+        polySynth.addVoice(voice, env);
+
+      Notes go to a free voice if there is one, then to the longest-released voice, and otherwise steal
+      a held voice according to setVoiceStealing(). A note which is already sounding retriggers its voice.
+
+      Voices are only rendered from note on until their envelope has finished its release, so idle voices
+      cost nothing. By default the voices are summed straight to the output; use voices() to process the mix:
+
+        polySynth.setOutputGen(polySynth.voices() >> Reverb());
+
+      Note changes are posted to the audio thread and take effect at the start of the next block.
+   */
+  class PolySynth : public Synth {
+
+  protected:
+
+    Tonic_::PolySynth_ * polyGen(){
+      return static_cast<Tonic_::PolySynth_*>(obj);
+    }
+
+  public:
+
+    PolySynth() : Synth(new Tonic_::PolySynth_) {}
+
+    //! Add a voice to the pool. envelope must be the ADSR in the voice's graph triggered by "polyGate".
+    /*!
+        Voices are rendered without their own limiter - the PolySynth limits the mix instead.
+     */
+    void addVoice(Synth voice, ADSR envelope){
+      polyGen()->addVoice(voice, envelope);
+    }
+
+    //! Number of voices in the pool
+    unsigned int numVoices(){
+      return polyGen()->numVoices();
+    }
+
+    //! Number of voices rendered in the last block
+    unsigned int numSoundingVoices(){
+      return polyGen()->numSoundingVoices();
+    }
+
+    //! Choose which held voice a new note takes over when no voice is free. Defaults to VoiceStealingOldest.
+    /*!
+        Voices which are still releasing are always reused before held ones, even with VoiceStealingNone.
+     */
+    void setVoiceStealing(VoiceStealingMode mode){
+      polyGen()->setVoiceStealing(mode);
+    }
+
+    void noteOn(int note, int velocity = 127){
+      polyGen()->noteOn(note, velocity);
+    }
+
+    void noteOff(int note){
+      polyGen()->noteOff(note);
+    }
+
+    //! Release every held note
+    void allNotesOff(){
+      polyGen()->allNotesOff();
+    }
+
+    //! The sum of all voices, which is the default output gen
+    Generator voices(){
+      return polyGen()->voices();
+    }
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,281 @@
+//
+//  Profiler.cpp
+//  Tonic
+//
+//
+// See LICENSE.txt for license and usage information.
+//
+
+#include "Profiler.h"
+
+#ifdef TONIC_PROFILE
+
+#if defined (__GNUG__)
+  #include <cxxabi.h>
+#endif
+
+namespace Tonic {
+
+  namespace Tonic_ {
+
+    TONIC_THREAD_LOCAL ProfileTicks_ profileChildTicks_ = 0;
+
+    static unsigned int   profileSampleInterval_ = 0;
+    static long           profiledBlocks_ = 0;
+
+    // For converting timestamps to seconds - the span since the last reset is used as a calibration interval
+    static ProfileTicks_  resetTicks_ = 0;
+    static double         resetSeconds_ = 0;
+
+    // Every live node's counters, in a doubly linked list. Never touched on the audio thread.
+    class ProfileRegistry_ {
+
+    public:
+
+      TONIC_MUTEX_T           mutex;
+      NodeProfileCounters_    *first;
+
+      ProfileRegistry_() : first(NULL) {
+        TONIC_MUTEX_INIT(mutex);
+      }
+
+    };
+
+    static ProfileRegistry_ & profileRegistry(){
+      static ProfileRegistry_ registry;
+      return registry;
+    }
+
+    static void registerCounters(NodeProfileCounters_ * counters){
+      ProfileRegistry_ & registry = profileRegistry();
+      TONIC_MUTEX_LOCK(registry.mutex);
+      counters->previous_ = NULL;
+      counters->next_ = registry.first;
+      if (registry.first) registry.first->previous_ = counters;
+      registry.first = counters;
+      TONIC_MUTEX_UNLOCK(registry.mutex);
+    }
+
+    NodeProfileCounters_::NodeProfileCounters_() : node(NULL), nodeType(NULL) {
+      reset();
+      registerCounters(this);
+    }
+
+    NodeProfileCounters_::NodeProfileCounters_(const NodeProfileCounters_ &) : node(NULL), nodeType(NULL) {
+      reset();
+      registerCounters(this);
+    }
+
+    NodeProfileCounters_::~NodeProfileCounters_(){
+      ProfileRegistry_ & registry = profileRegistry();
+      TONIC_MUTEX_LOCK(registry.mutex);
+      if (previous_) previous_->next_ = next_;
+      else registry.first = next_;
+      if (next_) next_->previous_ = previous_;
+      TONIC_MUTEX_UNLOCK(registry.mutex);
+    }
+
+    bool profileNextBlock(unsigned long & blockCounter){
+      unsigned int interval = TONIC_ATOMIC_LOAD(profileSampleInterval_);
+      if (interval == 0 || (blockCounter++ % interval) != 0) return false;
+      TONIC_ATOMIC_INCREMENT(profiledBlocks_);
+      return true;
+    }
+
+    static string demangledTypeName(const std::type_info * type){
+#if defined (__GNUG__)
+      int status = 0;
+      char * demangled = abi::__cxa_demangle(type->name(), NULL, NULL, &status);
+      if (demangled){
+        string name(demangled);
+        free(demangled);
+        return name;
+      }
+#endif
+      return type->name();
+    }
+
+    static double secondsPerTick(){
+      // calibrate over at least 10ms
+      ProfileTicks_ ticks = profileTimestamp();
+      double seconds = monotonicTime();
+      while (seconds - resetSeconds_ < 0.01){
+        ticks = profileTimestamp();
+        seconds = monotonicTime();
+      }
+      return ticks > resetTicks_ ? (seconds - resetSeconds_) / (double)(ticks - resetTicks_) : 0;
+    }
+
+    static bool moreSelfTime(const NodeProfile & a, const NodeProfile & b){
+      return a.selfSeconds > b.selfSeconds;
+    }
+
+  }
+
+  bool profilerEnabled(){
+    return true;
+  }
+
+  void setProfileSampleInterval(unsigned int blocks){
+    using namespace Tonic_;
+    if (blocks && !profileSampleInterval_ && resetTicks_ == 0){
+      resetTicks_ = profileTimestamp();
+      resetSeconds_ = monotonicTime();
+    }
+    TONIC_ATOMIC_STORE(profileSampleInterval_, blocks);
+  }
+
+  unsigned int profileSampleInterval(){
+    return TONIC_ATOMIC_LOAD(Tonic_::profileSampleInterval_);
+  }
+
+  unsigned long profiledBlocks(){
+    return TONIC_ATOMIC_LOAD(Tonic_::profiledBlocks_);
+  }
+
+  vector<NodeProfile> profileByNode(){
+
+    using namespace Tonic_;
+
+    const double tickSeconds = secondsPerTick();
+
+    vector<NodeProfile> profiles;
+
+    ProfileRegistry_ & registry = profileRegistry();
+    TONIC_MUTEX_LOCK(registry.mutex);
+    for (NodeProfileCounters_ * counters = registry.first; counters; counters = counters->next_){
+      if (!counters->nodeType || counters->calls == 0) continue;
+      NodeProfile profile;
+      profile.className = demangledTypeName(counters->nodeType);
+      profile.node = counters->node;
+      profile.numNodes = 1;
+      profile.calls = counters->calls;
+      profile.cacheHits = counters->cacheHits;
+      profile.seconds = counters->ticks * tickSeconds;
+      profile.selfSeconds = counters->selfTicks * tickSeconds;
+      profiles.push_back(profile);
+    }
+    TONIC_MUTEX_UNLOCK(registry.mutex);
+
+    std::stable_sort(profiles.begin(), profiles.end(), moreSelfTime);
+    return profiles;
+  }
+
+  vector<NodeProfile> profileByClass(){
+
+    using namespace Tonic_;
+
+    vector<NodeProfile> nodes = profileByNode();
+
+    std::map<string, NodeProfile> classes;
+    for (unsigned int i=0; i<nodes.size(); i++){
+      NodeProfile & total = classes[nodes[i].className];
+      total.className = nodes[i].className;
+      total.numNodes++;
+      total.calls += nodes[i].calls;
+      total.cacheHits += nodes[i].cacheHits;
+      total.seconds += nodes[i].seconds;
+      total.selfSeconds += nodes[i].selfSeconds;
+    }
+
+    vector<NodeProfile> profiles;
+    for (std::map<string, NodeProfile>::iterator it = classes.begin(); it != classes.end(); it++){
+      profiles.push_back(it->second);
+    }
+
+    std::stable_sort(profiles.begin(), profiles.end(), moreSelfTime);
+    return profiles;
+  }
+
+  void resetProfile(){
+
+    using namespace Tonic_;
+
+    ProfileRegistry_ & registry = profileRegistry();
+    TONIC_MUTEX_LOCK(registry.mutex);
+    for (NodeProfileCounters_ * counters = registry.first; counters; counters = counters->next_){
+      counters->reset();
+    }
+    TONIC_MUTEX_UNLOCK(registry.mutex);
+
+    TONIC_ATOMIC_STORE(profiledBlocks_, 0);
+    resetTicks_ = profileTimestamp();
+    resetSeconds_ = monotonicTime();
+  }
+
+  static void printProfileRows(const vector<NodeProfile> & profiles, bool byNode, unsigned int maxRows, double totalSelfSeconds, unsigned long blocks){
+    printf("    self us/block  self %%  total us/block     calls  cache hits  %s\n", byNode ? "node" : "class (nodes)");
+    for (unsigned int i=0; i<profiles.size() && i<maxRows; i++){
+      const NodeProfile & profile = profiles[i];
+      printf("    %13.2f  %6.1f  %14.2f  %8lu  %10lu  %s", profile.selfSeconds * 1e6 / blocks,
+             totalSelfSeconds > 0 ? 100.0 * profile.selfSeconds / totalSelfSeconds : 0,
+             profile.seconds * 1e6 / blocks, profile.calls, profile.cacheHits, profile.className.c_str());
+      if (byNode){
+        printf(" %p\n", profile.node);
+      }
+      else{
+        printf(" (%u)\n", profile.numNodes);
+      }
+    }
+  }
+
+  void printProfile(unsigned int maxRows){
+
+    unsigned long blocks = profiledBlocks();
+    if (blocks == 0){
+      printf("[Tonic] No blocks profiled - see setProfileSampleInterval()\n");
+      return;
+    }
+
+    vector<NodeProfile> classes = profileByClass();
+    vector<NodeProfile> nodes = profileByNode();
+
+    double totalSelfSeconds = 0;
+    for (unsigned int i=0; i<classes.size(); i++){
+      totalSelfSeconds += classes[i].selfSeconds;
+    }
+
+    printf("[Tonic] Profiled %lu blocks, %.2f us per block in %lu nodes\n\n  By class:\n",
+           blocks, totalSelfSeconds * 1e6 / blocks, (unsigned long)nodes.size());
+    printProfileRows(classes, false, maxRows, totalSelfSeconds, blocks);
+    printf("\n  By node:\n");
+    printProfileRows(nodes, true, maxRows, totalSelfSeconds, blocks);
+  }
+
+}
+
+#else
+
+namespace Tonic {
+
+  bool profilerEnabled(){
+    return false;
+  }
+
+  void setProfileSampleInterval(unsigned int blocks){}
+
+  unsigned int profileSampleInterval(){
+    return 0;
+  }
+
+  unsigned long profiledBlocks(){
+    return 0;
+  }
+
+  vector<NodeProfile> profileByNode(){
+    return vector<NodeProfile>();
+  }
+
+  vector<NodeProfile> profileByClass(){
+    return vector<NodeProfile>();
+  }
+
+  void resetProfile(){}
+
+  void printProfile(unsigned int maxRows){
+    printf("[Tonic] Not profiling - build with TONIC_PROFILE defined\n");
+  }
+
+}
+
+#endif
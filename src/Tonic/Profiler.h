@@ -0,0 +1,199 @@
+//
+//  Profiler.h
+//  Tonic
+//
+//
+// See LICENSE.txt for license and usage information.
+//
+
+#ifndef TONIC_PROFILER_H
+#define TONIC_PROFILER_H
+
+#include "TonicCore.h"
+
+#ifdef TONIC_PROFILE
+
+  #include <typeinfo>
+
+  #if (defined (__x86_64__) || defined (__i386__)) && defined (__GNUC__)
+    #include <x86intrin.h>
+    #define TONIC_PROFILE_USE_TSC
+  #elif (defined (_M_X64) || defined (_M_IX86)) && defined (_MSC_VER)
+    #include <intrin.h>
+    #define TONIC_PROFILE_USE_TSC
+  #endif
+
+#endif
+
+namespace Tonic {
+
+  //! Time spent computing one node, or every node of one class, during profiled blocks
+  struct NodeProfile {
+
+    //! Class of the node, e.g. "Tonic::Tonic_::SineWave_"
+    string          className;
+
+    //! The Generator_ or ControlGenerator_ profiled, or NULL when aggregated by class
+    const void *    node;
+
+    //! Number of nodes aggregated - 1 when profiling by node
+    unsigned int    numNodes;
+
+    //! Times the node was ticked
+    unsigned long   calls;
+
+    //! Ticks which returned a block already computed for the same frame
+    unsigned long   cacheHits;
+
+    //! Time spent computing, including inputs ticked from inside computeSynthesisBlock(). Totals by class
+    //! count time twice where nodes of the class feed each other, e.g. a chain of Adders.
+    double          seconds;
+
+    //! Time spent computing, not counting other nodes
+    double          selfSeconds;
+
+    NodeProfile() : node(NULL), numNodes(0), calls(0), cacheHits(0), seconds(0), selfSeconds(0) {}
+
+  };
+
+  //! Find out which nodes of a graph take up the rendering budget
+  /*!
+      Only available when Tonic and the app using it are built with TONIC_PROFILE defined. Otherwise there is
+      no instrumentation at all, and reports are always empty.
+
+      When built in, profiling is still off until a sample interval is set. Every interval-th block rendered by
+      a BufferFiller is then timed node by node, using the CPU's timestamp counter where there is one. Blocks in
+      between only pay for checking a flag in each tick, so a large interval is cheap enough to leave running:
+
+        setProfileSampleInterval(16);
+        ...
+        printProfile();
+
+      Only live nodes are reported. Counters are read without synchronisation while audio is running, so
+      values may be momentarily inconsistent.
+   */
+  bool profilerEnabled();
+
+  //! Profile one in every blocks blocks, or stop profiling if 0. Defaults to 0.
+  void setProfileSampleInterval(unsigned int blocks);
+  unsigned int profileSampleInterval();
+
+  //! Number of blocks profiled since the last reset
+  unsigned long profiledBlocks();
+
+  //! Every node ticked in a profiled block, by selfSeconds, most expensive first
+  vector<NodeProfile> profileByNode();
+
+  //! Totals for each class of node, by selfSeconds, most expensive first
+  vector<NodeProfile> profileByClass();
+
+  void resetProfile();
+
+  //! Print the most expensive classes and nodes to stdout
+  void printProfile(unsigned int maxRows = 20);
+
+  namespace Tonic_ {
+
+#ifdef TONIC_PROFILE
+
+    typedef uint64_t ProfileTicks_;
+
+    //! Timestamp in arbitrary units, converted to seconds by calibrating against monotonicTime()
+    inline ProfileTicks_ profileTimestamp(){
+#if defined (TONIC_PROFILE_USE_TSC)
+      return __rdtsc();
+#elif defined (__APPLE__)
+      return mach_absolute_time();
+#elif (defined (_WIN32) || defined (__WIN32__))
+      LARGE_INTEGER count;
+      QueryPerformanceCounter(&count);
+      return count.QuadPart;
+#elif defined (__linux__)
+      struct timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return (ProfileTicks_)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#else
+      return clock();
+#endif
+    }
+
+    // Time spent in nodes nested inside the one being computed on this thread. Defined in Profiler.cpp.
+    extern TONIC_THREAD_LOCAL ProfileTicks_ profileChildTicks_;
+
+    //! Counters for one node. Registered for reports for as long as the node exists.
+    struct NodeProfileCounters_ {
+
+      // set when first profiled, since constructors only see the base class
+      const void              *node;
+      const std::type_info    *nodeType;
+      unsigned long           calls;
+      unsigned long           cacheHits;
+      ProfileTicks_           ticks;
+      ProfileTicks_           selfTicks;
+
+      NodeProfileCounters_    *previous_;
+      NodeProfileCounters_    *next_;
+
+      NodeProfileCounters_();
+      NodeProfileCounters_(const NodeProfileCounters_ &);
+      NodeProfileCounters_ & operator=(const NodeProfileCounters_ &){ return *this; }
+      ~NodeProfileCounters_();
+
+      void reset(){ calls = 0; cacheHits = 0; ticks = 0; selfTicks = 0; }
+
+    };
+
+    //! Times a node from construction to destruction, if the context is a profiled block
+    class NodeProfileScope_ {
+
+      NodeProfileCounters_  *counters_;
+      ProfileTicks_         startTicks_;
+      ProfileTicks_         outerChildTicks_;
+
+    public:
+
+      template<class Node>
+      NodeProfileScope_(Node * node, NodeProfileCounters_ & counters, const SynthesisContext_ & context, bool cacheHit) : counters_(NULL) {
+        if (!context.profile) return;
+        if (!counters.nodeType){
+          counters.node = node;
+          counters.nodeType = &typeid(*node);
+        }
+        counters.calls++;
+        if (cacheHit){
+          counters.cacheHits++;
+          return;
+        }
+        counters_ = &counters;
+        outerChildTicks_ = profileChildTicks_;
+        profileChildTicks_ = 0;
+        startTicks_ = profileTimestamp();
+      }
+
+      ~NodeProfileScope_(){
+        if (!counters_) return;
+        ProfileTicks_ elapsed = profileTimestamp() - startTicks_;
+        counters_->ticks += elapsed;
+        counters_->selfTicks += elapsed - profileChildTicks_;
+        profileChildTicks_ = outerChildTicks_ + elapsed;
+      }
+
+    };
+
+    //! Decide whether the next top-level block is profiled. Called by BufferFiller_ with its own block counter.
+    bool profileNextBlock(unsigned long & blockCounter);
+
+  #define TONIC_PROFILE_NODE(counters, context, cacheHit) \
+    Tonic::Tonic_::NodeProfileScope_ nodeProfileScope(this, counters, context, cacheHit)
+
+#else
+
+  #define TONIC_PROFILE_NODE(counters, context, cacheHit)
+
+#endif
+
+  }
+
+}
+
+#endif
@@ -63,13 +63,12 @@ namespace Tonic {
       ControlGeneratorOutput lengthOutput = lengthGen_.tick(context);
       ControlGeneratorOutput targetOutput = targetGen_.tick(context);
       if (lengthOutput.triggered || targetOutput.triggered){
-        unsigned long lSamp = lengthOutput.value*Tonic::sampleRate();
+        unsigned long lSamp = lengthOutput.value*sampleRate_;
         updateTarget(targetOutput.value, lSamp);
       }
       
       TonicFloat *fdata = &outputFrames_[0];
-      unsigned int nFrames = kSynthesisBlockSize;
-      unsigned int stride = outputFrames_.channels();
+      unsigned int nFrames = outputFrames_.frames();
       
       // edge case
       if (count_ == len_){
@@ -77,17 +76,13 @@ namespace Tonic {
       }
             
       if (finished_){
-        #ifdef USE_APPLE_ACCELERATE
-        vDSP_vfill(&last_, fdata, stride, nFrames);
-        #else
-        for (unsigned int i=0; i<nFrames; i++){
-          *fdata = last_;
-          fdata += stride;
-        }
-        #endif
+        // a constant, only rewritten when it changes
+        fillConstant(last_);
       }
       else{
         
+        isConstant_ = false;
+        
         // figure out if we will finish the ramp in this tick
         unsigned long remainder = count_ > len_ ? 0 : len_ - count_;
         
@@ -98,7 +93,7 @@ namespace Tonic {
           #ifdef USE_APPLE_ACCELERATE
           // starting point
           last_ += inc_;
-          vDSP_vramp(&last_, &inc_, fdata, stride, remainder);
+          vDSP_vramp(&last_, &inc_, fdata, 1, remainder);
           
             #ifdef TONIC_DEBUG
             if(*fdata != *fdata){
@@ -110,16 +105,16 @@ namespace Tonic {
           for (unsigned int i=0; i<remainder; i++){
             last_ += inc_;
             *fdata = last_;
-            fdata += stride;
+            fdata++;
           }
           #endif
         
           #ifdef USE_APPLE_ACCELERATE
-          vDSP_vfill(&target_, fdata + remainder, stride, nFrames - remainder);
+          vDSP_vfill(&target_, fdata + remainder, 1, nFrames - remainder);
           #else
           for (unsigned int i=remainder; i<nFrames; i++){
             *fdata = target_;
-            fdata += stride;
+            fdata++;
           }
           #endif
 
@@ -132,7 +127,7 @@ namespace Tonic {
           // fill the whole ramp
           #ifdef USE_APPLE_ACCELERATE
           last_ += inc_;
-          vDSP_vramp(&last_, &inc_, fdata, stride, nFrames);
+          vDSP_vramp(&last_, &inc_, fdata, 1, nFrames);
           
             #ifdef TONIC_DEBUG
             if(*fdata != *fdata){
@@ -144,7 +139,7 @@ namespace Tonic {
           for (unsigned int i=0; i<nFrames; i++){
             last_ += inc_;
             *fdata = last_;
-            fdata += stride;
+            fdata++;
           }
           #endif
           
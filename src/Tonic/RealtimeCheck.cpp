@@ -0,0 +1,352 @@
+//
+//  RealtimeCheck.cpp
+//  Tonic
+//
+//
+// See LICENSE.txt for license and usage information.
+//
+
+#include "RealtimeCheck.h"
+
+#ifdef TONIC_CHECK_REALTIME
+
+#include <new>
+#include <cstdlib>
+
+#if defined (__GLIBC__) || defined (__APPLE__)
+  #include <execinfo.h>
+  #define TONIC_HAS_BACKTRACE
+#endif
+
+#if defined (__GNUG__)
+  #include <cxxabi.h>
+#endif
+
+#if TONIC_HAS_CPP_11
+  #define TONIC_NOTHROW     noexcept
+  #define TONIC_NEW_THROWS
+#else
+  #define TONIC_NOTHROW     throw()
+  #define TONIC_NEW_THROWS  throw(std::bad_alloc)
+#endif
+
+namespace Tonic {
+
+  namespace Tonic_ {
+
+    static const int kMaxRealtimeViolationRecords = 256;
+    static const int kMaxRealtimeStackDepth = 32;
+
+    // frames for recordRealtimeViolation() and the hook calling it
+    static const int kRealtimeStackFramesToSkip = 2;
+
+    // Everything here is written while rendering, from inside the allocator, so it is all preallocated
+    struct RealtimeViolationRecord_ {
+      RealtimeViolationType   type;
+      const std::type_info    *nodeType;
+      unsigned long           count;
+      void                    *stack[kMaxRealtimeStackDepth];
+      int                     stackDepth;
+    };
+
+    static RealtimeViolationRecord_ records_[kMaxRealtimeViolationRecords];
+    static int                      numRecords_ = 0;
+    static unsigned long            numDroppedViolations_ = 0;
+
+    // spinlock over the records. Rendering threads only hold it to copy a few words.
+    static void * recordsLock_ = NULL;
+
+    static void lockRecords(){
+      while (!TONIC_ATOMIC_COMPARE_EXCHANGE_PTR(recordsLock_, (void*)NULL, (void*)records_)) {}
+    }
+
+    static void unlockRecords(){
+      TONIC_ATOMIC_STORE(recordsLock_, (void*)NULL);
+    }
+
+    static TONIC_THREAD_LOCAL const std::type_info * currentNodeType_ = NULL;
+
+    // set while recording, so allocations made by the checker itself (e.g. the first backtrace()) are ignored
+    static TONIC_THREAD_LOCAL bool recording_ = false;
+
+    static int captureStack(void ** stack, int maxDepth){
+#if defined (TONIC_HAS_BACKTRACE)
+      void * frames[kMaxRealtimeStackDepth + kRealtimeStackFramesToSkip];
+      int depth = backtrace(frames, maxDepth + kRealtimeStackFramesToSkip) - kRealtimeStackFramesToSkip;
+      if (depth < 0) depth = 0;
+      memcpy(stack, frames + kRealtimeStackFramesToSkip, depth * sizeof(void*));
+      return depth;
+#elif (defined (_WIN32) || defined (__WIN32__))
+      return CaptureStackBackTrace(kRealtimeStackFramesToSkip, maxDepth, stack, NULL);
+#else
+      return 0;
+#endif
+    }
+
+    static void recordRealtimeViolation(RealtimeViolationType type){
+
+      if (!isRendering() || recording_) return;
+      recording_ = true;
+
+      void * stack[kMaxRealtimeStackDepth];
+      int stackDepth = captureStack(stack, kMaxRealtimeStackDepth);
+
+      lockRecords();
+
+      RealtimeViolationRecord_ * record = NULL;
+      for (int i=0; i<numRecords_; i++){
+        RealtimeViolationRecord_ & r = records_[i];
+        if (r.type == type && r.nodeType == currentNodeType_ && r.stackDepth == stackDepth &&
+            memcmp(r.stack, stack, stackDepth * sizeof(void*)) == 0){
+          record = &r;
+          break;
+        }
+      }
+
+      if (!record && numRecords_ < kMaxRealtimeViolationRecords){
+        record = &records_[numRecords_++];
+        record->type = type;
+        record->nodeType = currentNodeType_;
+        record->count = 0;
+        record->stackDepth = stackDepth;
+        memcpy(record->stack, stack, stackDepth * sizeof(void*));
+      }
+
+      if (record){
+        record->count++;
+      }
+      else{
+        numDroppedViolations_++;
+      }
+
+      unlockRecords();
+
+      recording_ = false;
+    }
+
+    void checkRealtimeLock(){
+      recordRealtimeViolation(RealtimeLock);
+    }
+
+    RealtimeCheckNodeScope_::RealtimeCheckNodeScope_(const std::type_info & nodeType) : previousNodeType_(currentNodeType_) {
+      currentNodeType_ = &nodeType;
+    }
+
+    RealtimeCheckNodeScope_::~RealtimeCheckNodeScope_(){
+      currentNodeType_ = previousNodeType_;
+    }
+
+    static string demangledTypeName(const std::type_info * type){
+      if (!type) return "";
+#if defined (__GNUG__)
+      int status = 0;
+      char * demangled = abi::__cxa_demangle(type->name(), NULL, NULL, &status);
+      if (demangled){
+        string name(demangled);
+        free(demangled);
+        return name;
+      }
+#endif
+      return type->name();
+    }
+
+    static bool moreFrequent(const RealtimeViolation & a, const RealtimeViolation & b){
+      return a.count > b.count;
+    }
+
+  }
+
+  bool realtimeCheckEnabled(){
+    return true;
+  }
+
+  vector<RealtimeViolation> realtimeViolations(){
+
+    using namespace Tonic_;
+
+    // copy out under the lock, then build strings without holding it
+    vector<RealtimeViolationRecord_> records;
+    records.reserve(kMaxRealtimeViolationRecords);
+    lockRecords();
+    for (int i=0; i<numRecords_; i++){
+      records.push_back(records_[i]);
+    }
+    unlockRecords();
+
+    vector<RealtimeViolation> violations(records.size());
+    for (unsigned int i=0; i<records.size(); i++){
+      RealtimeViolation & violation = violations[i];
+      violation.type = records[i].type;
+      violation.nodeType = demangledTypeName(records[i].nodeType);
+      violation.count = records[i].count;
+
+#if defined (TONIC_HAS_BACKTRACE)
+      char ** symbols = backtrace_symbols(records[i].stack, records[i].stackDepth);
+      if (symbols){
+        violation.callStack.assign(symbols, symbols + records[i].stackDepth);
+        free(symbols);
+      }
+#else
+      for (int f=0; f<records[i].stackDepth; f++){
+        char address[32];
+        snprintf(address, sizeof(address), "%p", records[i].stack[f]);
+        violation.callStack.push_back(address);
+      }
+#endif
+    }
+
+    std::stable_sort(violations.begin(), violations.end(), moreFrequent);
+    return violations;
+  }
+
+  unsigned long numRealtimeViolations(){
+    using namespace Tonic_;
+    lockRecords();
+    unsigned long total = numDroppedViolations_;
+    for (int i=0; i<numRecords_; i++){
+      total += records_[i].count;
+    }
+    unlockRecords();
+    return total;
+  }
+
+  void resetRealtimeViolations(){
+    using namespace Tonic_;
+    lockRecords();
+    numRecords_ = 0;
+    numDroppedViolations_ = 0;
+    unlockRecords();
+  }
+
+  void printRealtimeViolations(){
+
+    static const char * typeNames[] = { "allocation", "deallocation", "lock" };
+
+    vector<RealtimeViolation> violations = realtimeViolations();
+    if (violations.empty()){
+      printf("[Tonic] No allocations or locks while rendering\n");
+      return;
+    }
+
+    printf("[Tonic] %lu allocations, deallocations or locks while rendering, from %lu places:\n",
+           numRealtimeViolations(), (unsigned long)violations.size());
+
+    for (unsigned int i=0; i<violations.size(); i++){
+      RealtimeViolation & violation = violations[i];
+      printf("\n  %lu x %s in %s\n", violation.count, typeNames[violation.type],
+             violation.nodeType.empty() ? "(no generator)" : violation.nodeType.c_str());
+      for (unsigned int f=0; f<violation.callStack.size(); f++){
+        printf("      %s\n", violation.callStack[f].c_str());
+      }
+    }
+  }
+
+}
+
+// -- Interception --
+
+#if defined (__GLIBC__)
+
+// glibc exports its allocator under these names too, so it can be wrapped by defining the public ones
+extern "C" {
+
+  void * __libc_malloc(size_t size);
+  void * __libc_calloc(size_t count, size_t size);
+  void * __libc_realloc(void * ptr, size_t size);
+  void   __libc_free(void * ptr);
+
+  void * malloc(size_t size) TONIC_NOTHROW {
+    Tonic::Tonic_::recordRealtimeViolation(Tonic::RealtimeAllocation);
+    return __libc_malloc(size);
+  }
+
+  void * calloc(size_t count, size_t size) TONIC_NOTHROW {
+    Tonic::Tonic_::recordRealtimeViolation(Tonic::RealtimeAllocation);
+    return __libc_calloc(count, size);
+  }
+
+  void * realloc(void * ptr, size_t size) TONIC_NOTHROW {
+    Tonic::Tonic_::recordRealtimeViolation(Tonic::RealtimeAllocation);
+    return __libc_realloc(ptr, size);
+  }
+
+  void free(void * ptr) TONIC_NOTHROW {
+    if (ptr) Tonic::Tonic_::recordRealtimeViolation(Tonic::RealtimeDeallocation);
+    __libc_free(ptr);
+  }
+
+}
+
+#define TONIC_RAW_MALLOC(size)  __libc_malloc(size)
+#define TONIC_RAW_FREE(ptr)     __libc_free(ptr)
+
+#else
+
+#define TONIC_RAW_MALLOC(size)  malloc(size)
+#define TONIC_RAW_FREE(ptr)     free(ptr)
+
+#endif
+
+void * operator new(std::size_t size) TONIC_NEW_THROWS {
+  Tonic::Tonic_::recordRealtimeViolation(Tonic::RealtimeAllocation);
+  void * ptr = TONIC_RAW_MALLOC(size ? size : 1);
+  if (!ptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void * operator new[](std::size_t size) TONIC_NEW_THROWS {
+  return operator new(size);
+}
+
+void * operator new(std::size_t size, const std::nothrow_t &) TONIC_NOTHROW {
+  Tonic::Tonic_::recordRealtimeViolation(Tonic::RealtimeAllocation);
+  return TONIC_RAW_MALLOC(size ? size : 1);
+}
+
+void * operator new[](std::size_t size, const std::nothrow_t & nothrow) TONIC_NOTHROW {
+  return operator new(size, nothrow);
+}
+
+void operator delete(void * ptr) TONIC_NOTHROW {
+  if (!ptr) return;
+  Tonic::Tonic_::recordRealtimeViolation(Tonic::RealtimeDeallocation);
+  TONIC_RAW_FREE(ptr);
+}
+
+void operator delete[](void * ptr) TONIC_NOTHROW {
+  operator delete(ptr);
+}
+
+void operator delete(void * ptr, const std::nothrow_t &) TONIC_NOTHROW {
+  operator delete(ptr);
+}
+
+void operator delete[](void * ptr, const std::nothrow_t &) TONIC_NOTHROW {
+  operator delete(ptr);
+}
+
+#else
+
+namespace Tonic {
+
+  bool realtimeCheckEnabled(){
+    return false;
+  }
+
+  vector<RealtimeViolation> realtimeViolations(){
+    return vector<RealtimeViolation>();
+  }
+
+  unsigned long numRealtimeViolations(){
+    return 0;
+  }
+
+  void resetRealtimeViolations(){}
+
+  void printRealtimeViolations(){
+    printf("[Tonic] Not checking for allocations or locks while rendering - build with TONIC_CHECK_REALTIME defined\n");
+  }
+
+}
+
+#endif
@@ -0,0 +1,72 @@
+//
+//  RealtimeCheck.h
+//  Tonic
+//
+//
+// See LICENSE.txt for license and usage information.
+//
+
+#ifndef TONIC_REALTIMECHECK_H
+#define TONIC_REALTIMECHECK_H
+
+#include "TonicCore.h"
+
+namespace Tonic {
+
+  typedef enum {
+
+    RealtimeAllocation = 0,     // malloc, calloc, realloc, operator new
+    RealtimeDeallocation,       // free, operator delete
+    RealtimeLock                // a mutex taken
+
+  } RealtimeViolationType;
+
+  //! Calls which are not realtime-safe, made from the same place while rendering
+  struct RealtimeViolation {
+
+    RealtimeViolationType   type;
+
+    //! Innermost Generator or ControlGenerator being computed at the time, or empty if none was
+    string                  nodeType;
+
+    //! Number of times it happened since the last reset
+    unsigned long           count;
+
+    //! Symbolicated call stack, innermost call first. May be empty on platforms without backtraces.
+    vector<string>          callStack;
+
+  };
+
+  //! Check that rendering never allocates, frees or locks
+  /*!
+      Only available when Tonic and the app using it are built with TONIC_CHECK_REALTIME defined. Each allocation,
+      free and lock on a thread which is rendering (inside BufferFiller::fillBufferOfFloats, or rendering a parallel
+      Mixer input) is then recorded along with its call stack and the generator computing at the time. Render a
+      patch for a while, exercising its parameters, then check:
+
+        synth.fillBufferOfFloats(...);
+        ...
+        printRealtimeViolations();
+
+      Intercepts operator new and delete everywhere, and malloc, calloc, realloc and free where the C library
+      allows it (glibc). Locks are caught if taken with TONIC_MUTEX_LOCK or by a parallel Mixer waking its
+      workers; other mutexes, such as a plain std::mutex, are not seen.
+
+      When TONIC_CHECK_REALTIME is not defined nothing is intercepted, and there are never any violations.
+   */
+  bool realtimeCheckEnabled();
+
+  //! Every distinct violation since the last reset, most frequent first
+  vector<RealtimeViolation> realtimeViolations();
+
+  //! Total number of violations since the last reset
+  unsigned long numRealtimeViolations();
+
+  void resetRealtimeViolations();
+
+  //! Print a report of realtimeViolations() to stdout
+  void printRealtimeViolations();
+
+}
+
+#endif
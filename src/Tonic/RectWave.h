@@ -58,7 +58,7 @@ namespace Tonic {
       freqGen_.tick(freqFrames_, context);
       pwmGen_.tick(pwmFrames_, context);
       
-      const TonicFloat rateConstant =  TONIC_RECT_RES / Tonic::sampleRate();
+      const TonicFloat rateConstant =  TONIC_RECT_RES / sampleRate_;
 
       TonicFloat *outptr = &outputFrames_[0];
       TonicFloat *freqptr = &freqFrames_[0];
@@ -68,9 +68,9 @@ namespace Tonic {
       
       // pre-multiply rate constant for speed
 #ifdef USE_APPLE_ACCELERATE
-      vDSP_vsmul(freqptr, 1, &rateConstant, freqptr, 1, kSynthesisBlockSize);
+      vDSP_vsmul(freqptr, 1, &rateConstant, freqptr, 1, outputFrames_.frames());
 #else
-      for (unsigned int i=0; i<kSynthesisBlockSize; i++){
+      for (unsigned int i=0; i<outputFrames_.frames(); i++){
         *freqptr++ *= rateConstant;
       }
       freqptr = &freqFrames_[0];
@@ -123,7 +123,7 @@ namespace Tonic {
     inline void RectWaveBL_::computeSynthesisBlock(const Tonic_::SynthesisContext_ &context)
     {
       
-      static const TonicFloat rateConstant =  1.0f / Tonic::sampleRate();
+      const TonicFloat rateConstant =  1.0f / sampleRate_;
       
       // tick freq and pwm
       freqGen_.tick(freqFrames_, context);
@@ -135,16 +135,16 @@ namespace Tonic {
             
       // pre-multiply rate constant for speed
 #ifdef USE_APPLE_ACCELERATE
-      vDSP_vsmul(freqptr, 1, &rateConstant, freqptr, 1, kSynthesisBlockSize);
+      vDSP_vsmul(freqptr, 1, &rateConstant, freqptr, 1, outputFrames_.frames());
 #else
-      for (unsigned int i=0; i<kSynthesisBlockSize; i++){
+      for (unsigned int i=0; i<outputFrames_.frames(); i++){
         *freqptr++ *= rateConstant;
       }
       freqptr = &freqFrames_[0];
 #endif
             
       // TODO: Maybe do this using a fast phasor for wraparound speed
-      for (unsigned int i=0; i<kSynthesisBlockSize; i++, pwmptr++, freqptr++, outptr++){
+      for (unsigned int i=0; i<outputFrames_.frames(); i++, pwmptr++, freqptr++, outptr++){
         
         phase_ += *freqptr;
         
@@ -50,6 +50,12 @@ namespace Tonic { namespace Tonic_{
     delayForward_.setInterpolates(false);
   }
   
+  void ImpulseDiffuserAllpass::setSampleRate(TonicFloat sampleRate)
+  {
+    delayBack_.setSampleRate(sampleRate);
+    delayForward_.setSampleRate(sampleRate);
+  }
+  
   // ==============
   
   // Changing these will change the character of the late-stage reverb.
@@ -167,6 +173,27 @@ namespace Tonic { namespace Tonic_{
     
   }
   
+  void Reverb_::setBlockSize( unsigned int blockSize )
+  {
+    WetDryEffect_::setBlockSize(blockSize);
+    for (unsigned int i=0; i<2; i++){
+      workspaceFrames_[i].resize(blockSize, 1, 0);
+      preOutputFrames_[i].resize(blockSize, 1, 0);
+    }
+  }
+  
+  // the input filters and comb filters follow the context they're ticked in
+  void Reverb_::setSampleRate( TonicFloat sampleRate )
+  {
+    WetDryEffect_::setSampleRate(sampleRate);
+    preDelayLine_.setSampleRate(sampleRate);
+    reflectDelayLine_.setSampleRate(sampleRate);
+    for (unsigned int i=0; i<TONIC_REVERB_N_ALLPASS; i++){
+      allpassFilters_[TONIC_LEFT][i].setSampleRate(sampleRate);
+      allpassFilters_[TONIC_RIGHT][i].setSampleRate(sampleRate);
+    }
+  }
+  
   void Reverb_::setDecayLPFCtrlGen( ControlGenerator gen )
   {
     for (unsigned int i=0; i<TONIC_REVERB_N_COMBS; i++){
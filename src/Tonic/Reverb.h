@@ -41,6 +41,7 @@ namespace Tonic {
       ImpulseDiffuserAllpass(TonicFloat delay, TonicFloat coef);
       ImpulseDiffuserAllpass( const ImpulseDiffuserAllpass & other);
       void tickThrough(TonicFrames & frames);
+      void setSampleRate(TonicFloat sampleRate);
       
     };
     
@@ -48,7 +49,7 @@ namespace Tonic {
     {
       TonicFloat *dptr = &frames[0];
       TonicFloat y;
-      for (int i=0; i<kSynthesisBlockSize; i++){
+      for (unsigned int i=0; i<frames.frames(); i++){
         
         // feedback stage
         y = *dptr + delayBack_.tickOut(delay_) * coef_;
@@ -116,6 +117,12 @@ namespace Tonic {
         void updateDelayTimes(const SynthesisContext_ & context);
             
         void computeSynthesisBlock( const SynthesisContext_ &context );
+      
+        // pre-delay and early reflections, then the combs' decay (60 dB per decay time) down to kSilenceThreshold
+        unsigned long tailFrames( const SynthesisContext_ &context ){
+          TonicFloat decaySeconds = max(0, decayTimeCtrlGen_.tick(context).value) * -20.f * log10f(kSilenceThreshold) / 60.f;
+          return preDelayLine_.frames() + reflectDelayLine_.frames() + (unsigned long)(decaySeconds * sampleRate_);
+        };
 
       public:
       
@@ -135,6 +142,10 @@ namespace Tonic {
         void setDecayLPFCtrlGen( ControlGenerator gen );
         void setDecayHPFCtrlGen( ControlGenerator gen );
       
+        void setBlockSize( unsigned int blockSize );
+      
+        void setSampleRate( TonicFloat sampleRate );
+      
     };
     
     inline void Reverb_::computeSynthesisBlock(const SynthesisContext_ &context){
@@ -144,12 +155,12 @@ namespace Tonic {
       // pass thru input filters
       if (inputFiltBypasCtrlGen_.tick(context).value == 0.f){
         
-        inputLPF_.tickThrough(dryFrames_, workspaceFrames_[0], context);
+        inputLPF_.tickThrough(*dryInput_, workspaceFrames_[0], context);
         inputHPF_.tickThrough(workspaceFrames_[0], workspaceFrames_[0], context);
         
       }
       else{
-        workspaceFrames_[0].copy(dryFrames_);
+        workspaceFrames_[0].copy(*dryInput_);
       }
       
       TonicFloat *wkptr0 = &(workspaceFrames_[0])[0];
@@ -159,7 +170,7 @@ namespace Tonic {
       
       TonicFloat preDelayTime = preDelayTimeCtrlGen_.tick(context).value;
       
-      for (unsigned int i=0; i<kSynthesisBlockSize; i++){
+      for (unsigned int i=0; i<outputFrames_.frames(); i++){
       
         // filtered input is in w0
         // predelay output is in w1
@@ -196,17 +207,18 @@ namespace Tonic {
         allpassFilters_[TONIC_RIGHT][i].tickThrough(preOutputFrames_[TONIC_RIGHT]);
       }
       
-      // interleave pre-output frames into output frames
-      TonicFloat *outptr = &outputFrames_[0];
-      TonicFloat *preoutptrL = &preOutputFrames_[TONIC_LEFT][0];
-      TonicFloat *preoutptrR = &preOutputFrames_[TONIC_RIGHT][0];
+      // mix pre-output frames into the output channels
+      TonicFloat *outptrL = outputFrames_.channelData(TONIC_LEFT);
+      TonicFloat *outptrR = outputFrames_.channelData(TONIC_RIGHT);
+      const TonicFloat *preoutptrL = preOutputFrames_[TONIC_LEFT].data();
+      const TonicFloat *preoutptrR = preOutputFrames_[TONIC_RIGHT].data();
       
       TonicFloat spreadValue = clamp(1.0f - stereoWidthCtrlGen_.tick(context).value, 0.f, 1.f);
       TonicFloat normValue = (1.0f/(1.0f+spreadValue))*0.04f; // scale back levels quite a bit
       
-      for (unsigned int i=0; i<kSynthesisBlockSize; i++){
-        *outptr++ = (*preoutptrL + (spreadValue * (*preoutptrR)))*normValue;
-        *outptr++ = (*preoutptrR++ + (spreadValue * (*preoutptrL++)))*normValue;
+      for (unsigned int i=0; i<outputFrames_.frames(); i++){
+        outptrL[i] = (preoutptrL[i] + (spreadValue * preoutptrR[i]))*normValue;
+        outptrR[i] = (preoutptrR[i] + (spreadValue * preoutptrL[i]))*normValue;
       }
 
 
@@ -44,47 +44,29 @@ namespace Tonic {
       }
 #endif
       
-      TonicFloat *writeptr = &frames_(writeHead_, 0);
-      
       unsigned int bufChannels = channels();
       unsigned long bufFrames = frames();
       
-      if (bufChannels == nChannels){
+      // data is interleaved - each frame is deinterleaved into the buffer's channels
+      for (unsigned int i=0; i<nFrames; i++, data += nChannels){
         
-        for (unsigned int i=0; i<nFrames; i++){
+        if (bufChannels == 1 && nChannels > 1){
+          // average into mono
+          TonicFloat sum = 0;
           for (unsigned int c=0; c<nChannels; c++){
-            *writeptr++ = *data++;
-          }
-          if (++writeHead_ >= bufFrames){
-            writeHead_ = 0;
-            writeptr = &frames_[0];
+            sum += data[c];
           }
+          frames_(writeHead_, 0) = sum / (float)nChannels;
         }
-        
-      }
-      else if (bufChannels > nChannels){
-        for (unsigned int i=0; i<nFrames; i++){
+        else {
+          // mono is copied to every channel, otherwise channels match by index
           for (unsigned int c=0; c<bufChannels; c++){
-            *writeptr++ = *data;
-          }
-          data++;
-          if (++writeHead_ >= bufFrames){
-            writeHead_ = 0;
-            writeptr = &frames_[0];
+            frames_(writeHead_, c) = nChannels == 1 ? data[0] : (c < nChannels ? data[c] : 0);
           }
         }
-      }
-      else {
-        for (unsigned int i=0; i<nFrames; i++){
-          *writeptr = 0;
-          for (unsigned int c=0; c<nChannels; c++){
-            *writeptr += *data++;
-          }
-          *writeptr++ /= (float)nChannels;
-          if (++writeHead_ >= bufFrames){
-            writeHead_ = 0;
-            writeptr = &frames_[0];
-          }
+        
+        if (++writeHead_ >= bufFrames){
+          writeHead_ = 0;
         }
       }
       
@@ -100,55 +82,43 @@ namespace Tonic {
       }
 #endif
       
-      TonicFloat *readptr = &frames_(readHead_, 0);
-      TonicFloat *outptr = &outFrames[0];
-      
       unsigned long nFrames = outFrames.frames();
       unsigned int nChannels = outFrames.channels();
       
       unsigned long bufFrames = frames();
       unsigned int bufChannels = channels();
       
-      if (bufChannels == nChannels){
+      // frames up to the end of the buffer, and any remainder from its start
+      unsigned long headFrames = nFrames < bufFrames - readHead_ ? nFrames : bufFrames - readHead_;
+      unsigned long tailFrames = nFrames - headFrames;
+      
+      for (unsigned int c=0; c<nChannels; c++){
         
-        for (unsigned int i=0; i<nFrames; i++){
-          for (unsigned int c=0; c<nChannels; c++){
-            *outptr++ = *readptr++;
-          }
-          if (++readHead_ >= bufFrames){
-            readHead_ = 0;
-            readptr = &frames_[0];
-          }
-        }
+        TonicFloat *outptr = outFrames.channelData(c);
         
-      }
-      else if (bufChannels > nChannels){
-        for (unsigned int i=0; i<nFrames; i++){
-          *outptr = 0;
-          for (unsigned int c=0; c<bufChannels; c++){
-            *outptr += *readptr++;
-          }
-          *outptr /= (float)bufChannels;
-          outptr++;
-          if (++readHead_ >= bufFrames){
-            readHead_ = 0;
-            readptr = &frames_[0];
+        if (nChannels == 1 && bufChannels > 1){
+          // average into mono
+          memset(outptr, 0, nFrames * sizeof(TonicFloat));
+          for (unsigned int bc=0; bc<bufChannels; bc++){
+            const TonicFloat *readptr = frames_.channelData(bc);
+            for (unsigned long i=0; i<headFrames; i++) outptr[i] += readptr[readHead_ + i];
+            for (unsigned long i=0; i<tailFrames; i++) outptr[headFrames + i] += readptr[i];
           }
+          for (unsigned long i=0; i<nFrames; i++) outptr[i] /= (float)bufChannels;
         }
-      }
-      else {
-        for (unsigned int i=0; i<nFrames; i++){
-          for (unsigned int c=0; c<nChannels; c++){
-            *outptr++ = *readptr;
-          }
-          readptr++;
-          if (++readHead_ >= bufFrames){
-            readHead_ = 0;
-            readptr = &frames_[0];
-          }
+        else if (bufChannels == 1 || c < bufChannels){
+          // mono is copied to every channel, otherwise channels match by index
+          const TonicFloat *readptr = frames_.channelData(bufChannels == 1 ? 0 : c);
+          memcpy(outptr, readptr + readHead_, headFrames * sizeof(TonicFloat));
+          memcpy(outptr + headFrames, readptr, tailFrames * sizeof(TonicFloat));
+        }
+        else {
+          memset(outptr, 0, nFrames * sizeof(TonicFloat));
         }
       }
       
+      readHead_ = (readHead_ + nFrames) % bufFrames;
+      
     }
     
     inline void RingBuffer_::reset(){
@@ -199,7 +169,7 @@ namespace Tonic {
     public:
                   
       void setRingBuffer( RingBuffer buffer ) {
-        setIsStereoOutput(buffer.channels() == 2);
+        setNumOutputChannels(buffer.channels());
         ringBuffer_ = buffer;
       }
       
@@ -213,7 +183,7 @@ namespace Tonic {
     };
     
     // TODO: Maybe make this an Effect_?
-    class RingBufferWriter_ {
+    class RingBufferWriter_ : public ReferenceCounted_ {
       
     protected:
       
@@ -12,7 +12,7 @@ namespace Tonic {
   namespace Tonic_ {
     
     SampleTable_::SampleTable_(unsigned int frames, unsigned int channels){
-      frames_.resize(frames, min(channels, 2)); // limited to 2 channels
+      frames_.resize(frames, channels);
     }
     
   }
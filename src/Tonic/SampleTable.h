@@ -22,7 +22,7 @@ namespace Tonic {
   
   namespace Tonic_ {
     
-    class SampleTable_ {
+    class SampleTable_ : public ReferenceCounted_ {
       
     protected:
       TonicFrames frames_;
@@ -44,11 +44,16 @@ namespace Tonic {
         return frames_.size();
       }
       
-      // Pointer to start of data array
-      TonicFloat * dataPointer() {
+      // Pointer to start of data array. Channels are stored one after another, each channel's frames together.
+      TonicFloat * planarDataPointer() {
         return &frames_[0];
       }
       
+      // Pointer to the first frame of a channel
+      TonicFloat * channelPointer(unsigned int channel) {
+        return frames_.channelData(channel);
+      }
+      
       // Resize
       void resize(unsigned int frames, unsigned int channels){
         frames_.resize(frames, channels);
@@ -84,9 +89,15 @@ namespace Tonic {
       return obj->size();
     }
   
-    // Pointer to start of data array
-    TonicFloat * dataPointer() {
-      return obj->dataPointer();
+    // Pointer to start of data array. Channels are stored one after another, each channel's frames together.
+    // Replaces dataPointer(), whose data was interleaved - use channelPointer() for one channel.
+    TonicFloat * planarDataPointer() {
+      return obj->planarDataPointer();
+    }
+    
+    // Pointer to the first frame of a channel
+    TonicFloat * channelPointer(unsigned int channel) {
+      return obj->channelPointer(channel);
     }
   
     // Resize
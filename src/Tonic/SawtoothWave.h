@@ -58,7 +58,7 @@ namespace Tonic {
       slopeGen_.tick(slopeFrames_, context);
       
       // calculate the output wave
-      TonicFloat const rateConstant = TONIC_SAW_RES/Tonic::sampleRate();
+      TonicFloat const rateConstant = TONIC_SAW_RES/sampleRate_;
       
       TonicFloat slope, frac, phase;
       TonicFloat *outptr = &outputFrames_[0];
@@ -69,9 +69,9 @@ namespace Tonic {
       
       // pre-multiply rate constant for speed
 #ifdef USE_APPLE_ACCELERATE
-      vDSP_vsmul(freqptr, 1, &rateConstant, freqptr, 1, kSynthesisBlockSize);
+      vDSP_vsmul(freqptr, 1, &rateConstant, freqptr, 1, outputFrames_.frames());
 #else
-      for (unsigned int i=0; i<kSynthesisBlockSize; i++){
+      for (unsigned int i=0; i<outputFrames_.frames(); i++){
         *freqptr++ *= rateConstant;
       }
       freqptr = &freqFrames_[0];
@@ -129,7 +129,7 @@ namespace Tonic {
     inline void SawtoothWaveBL_::computeSynthesisBlock(const Tonic_::SynthesisContext_ &context)
     {
       
-      static const TonicFloat rateConstant =  1.0f / Tonic::sampleRate();
+      const TonicFloat rateConstant =  1.0f / sampleRate_;
       
       // tick freq and pwm
       freqGen_.tick(freqFrames_, context);
@@ -139,16 +139,16 @@ namespace Tonic {
       
       // pre-multiply rate constant for speed
 #ifdef USE_APPLE_ACCELERATE
-      vDSP_vsmul(freqptr, 1, &rateConstant, freqptr, 1, kSynthesisBlockSize);
+      vDSP_vsmul(freqptr, 1, &rateConstant, freqptr, 1, outputFrames_.frames());
 #else
-      for (unsigned int i=0; i<kSynthesisBlockSize; i++){
+      for (unsigned int i=0; i<outputFrames_.frames(); i++){
         *freqptr++ *= rateConstant;
       }
       freqptr = &freqFrames_[0];
 #endif
       
       // TODO: Maybe do this using a fast phasor for wraparound speed
-      for (unsigned int i=0; i<kSynthesisBlockSize; i++, freqptr++, outptr++){
+      for (unsigned int i=0; i<outputFrames_.frames(); i++, freqptr++, outptr++){
         
         phase_ += *freqptr;
         
@@ -0,0 +1,232 @@
+//
+//  SessionHost.cpp
+//  Tonic
+//
+//
+// See LICENSE.txt for license and usage information.
+//
+
+#include "SessionHost.h"
+#include <algorithm>
+#include <sstream>
+
+namespace Tonic {
+
+  SessionHost::SessionHost(unsigned int numThreads, int firstCore) :
+    numFrames_(0),
+    numThreads_(1),
+    firstCore_(firstCore),
+    callerPinned_(false),
+    batchStartTime_(0)
+  {
+    TONIC_MUTEX_INIT(sessionsMutex_);
+
+#if TONIC_HAS_CPP_11
+    if (numThreads == 0){
+      numThreads = std::thread::hardware_concurrency();
+    }
+    numThreads_ = numThreads > 0 ? numThreads : 1;
+    workerPool_ = numThreads_ > 1 ? new Tonic_::WorkerPool(numThreads_ - 1, firstCore_) : NULL;
+#else
+    if (numThreads > 1){
+      warning("SessionHost requires C++11 to render on more than one thread. Sessions will be rendered serially.");
+    }
+#endif
+
+    stats_.numThreads = numThreads_;
+  }
+
+  SessionHost::~SessionHost(){
+#if TONIC_HAS_CPP_11
+    delete workerPool_;
+#endif
+    TONIC_MUTEX_DESTROY(sessionsMutex_);
+  }
+
+  // sessions without a deadline go last
+  static bool rendersBefore(const double & a, const double & b){
+    return (a > 0 ? a : HUGE_VAL) < (b > 0 ? b : HUGE_VAL);
+  }
+
+  void SessionHost::sortSessionsByDeadline(){
+    // insertion sort - stable, and sessions are added one at a time to an already sorted list
+    for (unsigned int i=1; i<sessions_.size(); i++){
+      for (unsigned int j=i; j>0 && rendersBefore(sessions_[j].deadlineSeconds, sessions_[j-1].deadlineSeconds); j--){
+        std::swap(sessions_[j], sessions_[j-1]);
+      }
+    }
+  }
+
+  void SessionHost::addSession(BufferFiller session, unsigned int numChannels, double deadlineSeconds){
+
+    if (numChannels < 1){
+      error("SessionHost sessions need at least one channel. Rendering in stereo.");
+      numChannels = 2;
+    }
+
+    // reading more channels than the session renders would run off the end of its output
+    if (numChannels > session.numChannels()){
+      std::ostringstream message;
+      message << "SessionHost: the session only renders " << session.numChannels() << " channels. Rendering " << session.numChannels() << ".";
+      error(message.str());
+      numChannels = session.numChannels();
+    }
+
+    TONIC_MUTEX_LOCK(sessionsMutex_);
+
+    sessions_.push_back(Session_(session, numChannels, deadlineSeconds, numFrames_));
+    sortSessionsByDeadline();
+
+    TONIC_MUTEX_UNLOCK(sessionsMutex_);
+  }
+
+  void SessionHost::removeSession(BufferFiller session){
+    TONIC_MUTEX_LOCK(sessionsMutex_);
+    for (unsigned int i=0; i<sessions_.size(); i++){
+      if (sessions_[i].filler == session){
+        // keep its renders in the host's totals
+        stats_.sessionBlocks += sessions_[i].stats.blocks;
+        stats_.missedDeadlines += sessions_[i].stats.missedDeadlines;
+        stats_.busySeconds += sessions_[i].stats.renderSeconds;
+        sessions_.erase(sessions_.begin() + i);
+        break;
+      }
+    }
+    TONIC_MUTEX_UNLOCK(sessionsMutex_);
+  }
+
+  unsigned int SessionHost::numSessions(){
+    TONIC_MUTEX_LOCK(sessionsMutex_);
+    unsigned int numSessions = (unsigned int)sessions_.size();
+    TONIC_MUTEX_UNLOCK(sessionsMutex_);
+    return numSessions;
+  }
+
+  BufferFiller SessionHost::session(unsigned int index){
+    TONIC_MUTEX_LOCK(sessionsMutex_);
+    BufferFiller session = sessions_.at(index).filler;
+    TONIC_MUTEX_UNLOCK(sessionsMutex_);
+    return session;
+  }
+
+  const TonicFloat * SessionHost::sessionOutput(unsigned int index){
+    TONIC_MUTEX_LOCK(sessionsMutex_);
+    const vector<TonicFloat> & output = sessions_.at(index).output;
+    const TonicFloat * outputData = output.empty() ? NULL : &output[0];
+    TONIC_MUTEX_UNLOCK(sessionsMutex_);
+    return outputData;
+  }
+
+  unsigned int SessionHost::sessionNumChannels(unsigned int index){
+    TONIC_MUTEX_LOCK(sessionsMutex_);
+    unsigned int numChannels = sessions_.at(index).numChannels;
+    TONIC_MUTEX_UNLOCK(sessionsMutex_);
+    return numChannels;
+  }
+
+  SessionStats SessionHost::sessionStats(unsigned int index){
+    TONIC_MUTEX_LOCK(sessionsMutex_);
+    SessionStats stats = sessions_.at(index).stats;
+    TONIC_MUTEX_UNLOCK(sessionsMutex_);
+    return stats;
+  }
+
+  void SessionHost::renderSessionTask(void *host, unsigned int sessionIndex, unsigned int workerIndex){
+
+    SessionHost *self = static_cast<SessionHost*>(host);
+    Session_ & session = self->sessions_[sessionIndex];
+
+    const double startTime = monotonicTime();
+    session.filler.fillBufferOfFloats(&session.output[0], self->numFrames_, session.numChannels);
+    const double endTime = monotonicTime();
+
+    const double latency = endTime - self->batchStartTime_;
+
+    session.stats.blocks++;
+    session.stats.renderSeconds += endTime - startTime;
+    if (latency > session.stats.maxLatencySeconds){
+      session.stats.maxLatencySeconds = latency;
+    }
+    if (session.deadlineSeconds > 0 && latency > session.deadlineSeconds){
+      session.stats.missedDeadlines++;
+    }
+  }
+
+  void SessionHost::render(unsigned int numFrames){
+
+    if (numFrames == 0) return;
+
+    TONIC_MUTEX_LOCK(sessionsMutex_);
+
+#if TONIC_HAS_CPP_11
+    if (firstCore_ >= 0 && !callerPinned_){
+      if (!Tonic_::pinCurrentThreadToCore(firstCore_)){
+        warning("SessionHost - could not pin the rendering thread to a core");
+      }
+      callerPinned_ = true;
+    }
+#endif
+
+    if (numFrames != numFrames_){
+      numFrames_ = numFrames;
+      for (unsigned int i=0; i<sessions_.size(); i++){
+        sessions_[i].output.resize(numFrames_ * sessions_[i].numChannels, 0);
+      }
+    }
+
+    batchStartTime_ = monotonicTime();
+
+#if TONIC_HAS_CPP_11
+    if (workerPool_){
+      workerPool_->run(&SessionHost::renderSessionTask, this, (unsigned int)sessions_.size());
+    }
+    else
+#endif
+    {
+      for (unsigned int i=0; i<sessions_.size(); i++){
+        renderSessionTask(this, i, 0);
+      }
+    }
+
+    const double batchSeconds = monotonicTime() - batchStartTime_;
+
+    stats_.batches++;
+    stats_.wallSeconds += batchSeconds;
+    if (batchSeconds > stats_.maxBatchSeconds){
+      stats_.maxBatchSeconds = batchSeconds;
+    }
+
+    TONIC_MUTEX_UNLOCK(sessionsMutex_);
+  }
+
+  SessionHostStats SessionHost::stats(){
+
+    TONIC_MUTEX_LOCK(sessionsMutex_);
+
+    SessionHostStats stats = stats_;
+    stats.numSessions = (unsigned int)sessions_.size();
+    for (unsigned int i=0; i<sessions_.size(); i++){
+      stats.sessionBlocks += sessions_[i].stats.blocks;
+      stats.missedDeadlines += sessions_[i].stats.missedDeadlines;
+      stats.busySeconds += sessions_[i].stats.renderSeconds;
+    }
+
+    TONIC_MUTEX_UNLOCK(sessionsMutex_);
+
+    return stats;
+  }
+
+  void SessionHost::resetStats(){
+
+    TONIC_MUTEX_LOCK(sessionsMutex_);
+
+    stats_ = SessionHostStats();
+    stats_.numThreads = numThreads_;
+    for (unsigned int i=0; i<sessions_.size(); i++){
+      sessions_[i].stats = SessionStats();
+    }
+
+    TONIC_MUTEX_UNLOCK(sessionsMutex_);
+  }
+
+}
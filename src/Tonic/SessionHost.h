@@ -0,0 +1,208 @@
+//
+//  SessionHost.h
+//  Tonic
+//
+//
+// See LICENSE.txt for license and usage information.
+//
+
+//! Renders many independent BufferFillers (one per user session) in batches on a fixed pool of threads
+
+#ifndef TONIC_SESSIONHOST_H
+#define TONIC_SESSIONHOST_H
+
+#include "BufferFiller.h"
+#include "WorkerPool.h"
+
+namespace Tonic {
+
+  //! Timing of one session since the last reset
+  struct SessionStats {
+
+    //! Number of batches the session was rendered in
+    unsigned long blocks;
+
+    //! Number of batches in which the session finished after its deadline
+    unsigned long missedDeadlines;
+
+    //! Time spent rendering this session, in seconds
+    double        renderSeconds;
+
+    //! Longest time from the start of a batch until this session's output was ready, in seconds
+    double        maxLatencySeconds;
+
+    SessionStats() : blocks(0), missedDeadlines(0), renderSeconds(0), maxLatencySeconds(0) {}
+
+  };
+
+  //! Timing of a SessionHost since the last reset
+  struct SessionHostStats {
+
+    //! Number of threads (including the one calling render()) rendering sessions
+    unsigned int  numThreads;
+
+    //! Number of sessions currently hosted
+    unsigned int  numSessions;
+
+    //! Number of batches rendered
+    unsigned long batches;
+
+    //! Number of session renders, summed over all batches
+    unsigned long sessionBlocks;
+
+    //! Number of session renders which finished after their session's deadline
+    unsigned long missedDeadlines;
+
+    //! Wall-clock time spent rendering batches, in seconds
+    double        wallSeconds;
+
+    //! Longest batch, in seconds
+    double        maxBatchSeconds;
+
+    //! Sum of the time each session took to render, in seconds
+    double        busySeconds;
+
+    SessionHostStats() : numThreads(1), numSessions(0), batches(0), sessionBlocks(0), missedDeadlines(0),
+                         wallSeconds(0), maxBatchSeconds(0), busySeconds(0) {}
+
+    //! Average time one session takes to render one batch, in seconds
+    double meanSessionSeconds() const { return sessionBlocks > 0 ? busySeconds / sessionBlocks : 0; }
+
+    //! Number of sessions one core can render, on average, within latencySeconds of a batch starting
+    /*!
+        Based on the average cost of a session render, so it doesn't account for scheduling jitter.
+        Compare maxBatchSeconds and missedDeadlines with the target to see how much headroom to keep.
+     */
+    double sessionsPerCore(double latencySeconds) const {
+      return meanSessionSeconds() > 0 ? latencySeconds / meanSessionSeconds() : 0;
+    }
+
+    //! Fraction of available thread time spent rendering sessions (1.0 = perfect scaling)
+    double efficiency() const { return wallSeconds > 0 && numThreads > 0 ? busySeconds / (wallSeconds * numThreads) : 0; }
+
+  };
+
+  //! Hosts many independent BufferFillers, e.g. one Synth per user session on a server
+  /*!
+      Each call to render() renders every session by numFrames into its own output buffer. Sessions are
+      shared out between a fixed pool of threads, the calling thread included, and a thread which runs
+      out of sessions steals from the others, so a batch finishes as soon as all sessions are done.
+
+      Sessions are rendered in order of their deadlines, tightest first. A session's latency is the time
+      from the start of the batch until its output is ready, and sessionStats() counts the batches in
+      which that exceeded its deadline.
+
+      Sessions must not share Generators or ControlGenerators with each other. Read-only assets - the
+      SineWave table and the BLEP oscillators' minBLEP data - are built once per process and shared by
+      every session.
+
+      Sessions can be added and removed from any thread. Doing so waits for a batch in progress to finish.
+      Requires C++11 for more than one thread; sessions are rendered on the calling thread otherwise.
+
+      Typical usage:
+
+        SessionHost host(8, 0);                  // 8 threads, pinned to cores 0-7
+        host.addSession(synth, 2, 0.005);         // stereo, ready within 5ms of each batch starting
+        ...
+        while (serving){
+          host.render(kSynthesisBlockSize);
+          for (unsigned int i=0; i<host.numSessions(); i++){
+            send(host.session(i), host.sessionOutput(i));
+          }
+        }
+   */
+  class SessionHost {
+
+  protected:
+
+    struct Session_ {
+      BufferFiller        filler;
+      unsigned int        numChannels;
+      double              deadlineSeconds;
+      vector<TonicFloat>  output;
+      SessionStats        stats;
+
+      Session_(BufferFiller filler, unsigned int numChannels, double deadlineSeconds, unsigned int numFrames) :
+        filler(filler), numChannels(numChannels), deadlineSeconds(deadlineSeconds), output(numFrames * numChannels, 0) {}
+    };
+
+    // guards everything below. Held by render() for a whole batch.
+    TONIC_MUTEX_T       sessionsMutex_;
+
+    vector<Session_>    sessions_;
+    unsigned int        numFrames_;
+    unsigned int        numThreads_;
+    int                 firstCore_;
+    bool                callerPinned_;
+
+    SessionHostStats    stats_;
+    double              batchStartTime_;
+
+#if TONIC_HAS_CPP_11
+    Tonic_::WorkerPool  *workerPool_;
+#endif
+
+    static void renderSessionTask(void *host, unsigned int sessionIndex, unsigned int workerIndex);
+
+    // stable, so sessions with the same deadline keep the order they were added in
+    void sortSessionsByDeadline();
+
+  private:
+
+    SessionHost(const SessionHost&);
+    SessionHost& operator=(const SessionHost&);
+
+  public:
+
+    //! Render on numThreads threads, including the one calling render(). 0 means one per core.
+    /*!
+        If firstCore is zero or more, the thread calling render() is pinned to core firstCore the first
+        time it renders, and worker n to core firstCore + n. Pinning isn't available on macOS.
+     */
+    SessionHost(unsigned int numThreads = 0, int firstCore = -1);
+    ~SessionHost();
+
+    unsigned int numThreads() const { return numThreads_; }
+
+    //! Add a session, rendered with numChannels interleaved output channels - mono, or up to the session's BufferFiller::numChannels()
+    /*!
+        deadlineSeconds is the session's latency budget for each batch. 0 means no deadline.
+     
+        More channels than the session renders is an error, and the session's own count is used instead.
+        Set the session's channels before adding it, and don't reduce them while it's hosted.
+     */
+    void addSession(BufferFiller session, unsigned int numChannels = 2, double deadlineSeconds = 0);
+
+    void removeSession(BufferFiller session);
+
+    //! Number of sessions. Indices are in render order and change when sessions are added or removed.
+    unsigned int numSessions();
+
+    BufferFiller session(unsigned int index);
+
+    //! Interleaved output of the session at index from the most recent batch
+    /*!
+        Holds render()'s numFrames frames of the session's channels. Valid until the next call to render(),
+        addSession() or removeSession().
+     */
+    const TonicFloat * sessionOutput(unsigned int index);
+
+    //! Channels in the output of the session at index
+    unsigned int sessionNumChannels(unsigned int index);
+
+    SessionStats sessionStats(unsigned int index);
+
+    //! Render numFrames frames of every session
+    void render(unsigned int numFrames);
+
+    //! Timing of every batch since the last reset
+    SessionHostStats stats();
+
+    //! Clear the host's and every session's timing stats
+    void resetStats();
+
+  };
+
+}
+
+#endif
@@ -10,30 +10,34 @@
 
 namespace Tonic {
   
-  SineWave::SineWave(){
+  // Created, and registered in s_oscillatorTables(), by the first SineWave allocated on any thread.
+  // Stays in memory for program lifetime, shared by every SineWave in every BufferFiller.
+  static SampleTable * createSineTable(){
     
     static string const TONIC_SIN_TABLE = "_TONIC_SIN_TABLE_";
     
-    // As soon as the first SineWave is allocated, persistent SampleTable is created. Will stay in memory for program lifetime.
-    if (!Tonic_::s_oscillatorTables()->containsObjectNamed(TONIC_SIN_TABLE)){
-      
-      const unsigned int tableSize = 4096;
-      
-      SampleTable sineTable = SampleTable(tableSize+1, 1);
-      TonicFloat norm = 1.0f / tableSize;
-      TonicFloat *data = sineTable.dataPointer();
-      for ( unsigned long i=0; i<tableSize+1; i++ ){
-        *data++ = sinf( TWO_PI * i * norm );
-      }
-      
-      Tonic_::s_oscillatorTables()->insertObject(TONIC_SIN_TABLE, sineTable);
-      
-      this->gen()->setLookupTable(sineTable);
-    }
-    else{
-      this->gen()->setLookupTable(Tonic_::s_oscillatorTables()->objectNamed(TONIC_SIN_TABLE));
+    const unsigned int tableSize = 4096;
+    
+    SampleTable * sineTable = new SampleTable(tableSize+1, 1);
+    TonicFloat norm = 1.0f / tableSize;
+    TonicFloat *data = sineTable->planarDataPointer();
+    for ( unsigned long i=0; i<tableSize+1; i++ ){
+      *data++ = sinf( TWO_PI * i * norm );
     }
-
+    
+    TONIC_MUTEX_LOCK(Tonic_::s_oscillatorTablesMutex());
+    Tonic_::s_oscillatorTables()->insertObject(TONIC_SIN_TABLE, *sineTable);
+    TONIC_MUTEX_UNLOCK(Tonic_::s_oscillatorTablesMutex());
+    
+    return sineTable;
+  }
+  
+  SineWave::SineWave(){
+    
+    // initialised once even if SineWaves are first created on several threads at once (e.g. by SessionHost sessions)
+    static SampleTable * const sineTable = createSineTable();
+    
+    this->gen()->setLookupTable(*sineTable);
     
   }
   
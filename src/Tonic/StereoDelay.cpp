@@ -29,6 +29,12 @@ namespace Tonic { namespace Tonic_{
     delayLine_[TONIC_LEFT].initialize(maxDelayLeft, 1);
     delayLine_[TONIC_RIGHT].initialize(maxDelayRight, 1);
   }
+  
+  void StereoDelay_::setSampleRate(TonicFloat sampleRate){
+    WetDryEffect_::setSampleRate(sampleRate);
+    delayLine_[TONIC_LEFT].setSampleRate(sampleRate);
+    delayLine_[TONIC_RIGHT].setSampleRate(sampleRate);
+  }
 
   
 } // Namespace Tonic_
@@ -33,12 +33,20 @@ namespace Tonic {
       
       void computeSynthesisBlock( const SynthesisContext_ &context );
       
+      unsigned long tailFrames( const SynthesisContext_ &context ){
+        const TonicFrames & fbkFrames = fbkGen_.tick(context, fbkFrames_);
+        TonicFloat fbk = fbkFrames(fbkFrames.frames()-1, 0);
+        return std::max(delayLine_[TONIC_LEFT].tailFrames(fbk), delayLine_[TONIC_RIGHT].tailFrames(fbk));
+      };
+      
     public:
       
       StereoDelay_();
       
       void initialize(float leftDelayArg, float rightDelayArg, float maxDelayLeft, float maxDelayRight);
       
+      void setSampleRate( TonicFloat sampleRate );
+      
       void setFeedback(Generator arg){
         fbkGen_ = arg;
       };
@@ -56,32 +64,38 @@ namespace Tonic {
     
     inline void StereoDelay_::computeSynthesisBlock(const SynthesisContext_ &context){
       
-      delayTimeGen_[0].tick(delayTimeFrames_[TONIC_LEFT], context);
-      delayTimeGen_[1].tick(delayTimeFrames_[TONIC_RIGHT], context);
-      fbkGen_.tick(fbkFrames_, context);
+      // read modulations in place. Constant ones are read from their first sample throughout.
+      const TonicFloat *delptr_l = delayTimeGen_[0].tick(context, delayTimeFrames_[TONIC_LEFT]).data();
+      const TonicFloat *delptr_r = delayTimeGen_[1].tick(context, delayTimeFrames_[TONIC_RIGHT]).data();
+      const TonicFloat *fbkptr = fbkGen_.tick(context, fbkFrames_).data();
+      const unsigned int delStride_l = delayTimeGen_[0].isConstant() ? 0 : 1;
+      const unsigned int delStride_r = delayTimeGen_[1].isConstant() ? 0 : 1;
+      const unsigned int fbkStride = fbkGen_.isConstant() ? 0 : 1;
       
       TonicFloat outSamp[2], fbk;
-      TonicFloat *dryptr = &dryFrames_[0];
-      TonicFloat *outptr = &outputFrames_[0];
-      TonicFloat *fbkptr = &fbkFrames_[0];
-      TonicFloat *delptr_l = &(delayTimeFrames_[TONIC_LEFT])[0];
-      TonicFloat *delptr_r = &(delayTimeFrames_[TONIC_RIGHT])[0];
+      const TonicFloat *dryptr_l = dryInput_->channelData(TONIC_LEFT);
+      const TonicFloat *dryptr_r = dryInput_->channelData(TONIC_RIGHT);
+      TonicFloat *outptr_l = outputFrames_.channelData(TONIC_LEFT);
+      TonicFloat *outptr_r = outputFrames_.channelData(TONIC_RIGHT);
       
-      for (unsigned int i=0; i<kSynthesisBlockSize; i++){
+      for (unsigned int i=0; i<outputFrames_.frames(); i++){
         
         // Don't clamp feeback - be careful! Negative feedback could be interesting.
-        fbk = *fbkptr++;
+        fbk = *fbkptr;
+        fbkptr += fbkStride;
 
-        outSamp[TONIC_LEFT] = delayLine_[TONIC_LEFT].tickOut(*delptr_l++);
-        outSamp[TONIC_RIGHT] = delayLine_[TONIC_RIGHT].tickOut(*delptr_r++);
+        outSamp[TONIC_LEFT] = delayLine_[TONIC_LEFT].tickOut(*delptr_l);
+        outSamp[TONIC_RIGHT] = delayLine_[TONIC_RIGHT].tickOut(*delptr_r);
+        delptr_l += delStride_l;
+        delptr_r += delStride_r;
         
         // output left sample
-        *outptr++ = outSamp[TONIC_LEFT];
-        delayLine_[TONIC_LEFT].tickIn(*dryptr++ + outSamp[TONIC_LEFT] * fbk);
+        *outptr_l++ = outSamp[TONIC_LEFT];
+        delayLine_[TONIC_LEFT].tickIn(*dryptr_l++ + outSamp[TONIC_LEFT] * fbk);
         
         // output right sample
-        *outptr++ = outSamp[TONIC_RIGHT];
-        delayLine_[TONIC_RIGHT].tickIn(*dryptr++ + outSamp[TONIC_RIGHT] * fbk);
+        *outptr_r++ = outSamp[TONIC_RIGHT];
+        delayLine_[TONIC_RIGHT].tickIn(*dryptr_r++ + outSamp[TONIC_RIGHT] * fbk);
         
         // advance delay lines
         delayLine_[TONIC_LEFT].advance();
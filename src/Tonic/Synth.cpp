@@ -19,9 +19,37 @@ namespace Tonic {
 
   namespace Tonic_ {
     
-    Synth_::Synth_() : limitOutput_(true) {
+    Synth_::Synth_() : limitOutput_(true), limiterIsIdle_(false), bufferPool_(NULL) {
       limiter_.setIsStereo(true);
     }
+    
+    Synth_::~Synth_(){
+      if (bufferPool_) bufferPool_->release();
+    }
+    
+    BufferPool Synth_::bufferPool(){
+      if (!bufferPool_){
+        bufferPool_ = new BufferPool_(BufferPool::kDefaultSlabBytes);
+        bufferPool_->retain();
+      }
+      return BufferPool(bufferPool_);
+    }
+    
+    void Synth_::setNumOutputChannels(unsigned int numChannels){
+      BufferFiller_::setNumOutputChannels(numChannels);
+      limiter_.setNumChannels(numChannels);
+    }
+    
+    void Synth_::setOutputGen(Generator gen){
+      pendingOutputGen_ = gen;
+      postCommand(new SwapCommand_<Generator>(&outputGen_, gen));
+    }
+    
+    void Synth_::addAuxControlGenerator(ControlGenerator generator){
+      // the new list is built here, the audio thread only swaps it in
+      pendingAuxControlGenerators_.push_back(generator);
+      postCommand(new SwapCommand_< vector<ControlGenerator> >(&auxControlGenerators_, pendingAuxControlGenerators_));
+    }
 
     void Synth_::setParameter(string name, float value, bool normalized){
       
@@ -14,6 +14,7 @@
 
 #include <map>
 #include "BufferFiller.h"
+#include "BufferPool.h"
 #include "ControlParameter.h"
 #include "CompressorLimiter.h"
 #include "ControlChangeNotifier.h"
@@ -31,9 +32,16 @@ namespace Tonic{
       
       Generator     outputGen_;
       
+      // Values as last set from the UI thread, ahead of the audio thread until the next block
+      Generator     pendingOutputGen_;
+      vector<ControlGenerator> pendingAuxControlGenerators_;
+      
       Limiter limiter_;
       bool limitOutput_;
       
+      // True once the limiter's output has gone silent along with its input
+      bool limiterIsIdle_;
+      
       std::map<string, ControlParameter> parameters_;
       std::vector<string> orderedParameterNames_;
       std::map<string, ControlChangeNotifier> controlChangeNotifiers_;
@@ -41,18 +49,27 @@ namespace Tonic{
       // ControlGenerators that may not be part of the synthesis graph, but should be ticked anyway
       vector<ControlGenerator> auxControlGenerators_;
       
+      // made the first time bufferPool() is asked for, so synths built without one don't pay for it
+      BufferPool_ * bufferPool_;
+      
       void computeSynthesisBlock(const Tonic::Tonic_::SynthesisContext_ &context);
       
     public:
       
       Synth_();
+      ~Synth_();
       
-      //! Set the output gen that produces audio for the Synth
-      void  setOutputGen(Generator gen){ outputGen_ = gen; }
-      const Generator getOutputGen() { return outputGen_; };
+      //! Set the output gen that produces audio for the Synth. Takes effect at the start of the next block.
+      void  setOutputGen(Generator gen);
+      const Generator getOutputGen() { return pendingOutputGen_; };
       
       void setLimitOutput(bool shouldLimit) { limitOutput_ = shouldLimit; };
       
+      BufferPool bufferPool();
+      
+      // Overridden so the limiter follows the output channel layout
+      void setNumOutputChannels(unsigned int numChannels);
+      
       ControlParameter addParameter(string name, TonicFloat initialValue);
       
       void addParameter(ControlParameter parameter);
@@ -65,13 +82,7 @@ namespace Tonic{
       
       ControlChangeNotifier publishChanges(ControlGenerator input, string name);
       
-      void addAuxControlGenerator(ControlGenerator generator){
-        auxControlGenerators_.push_back(generator);
-      }
-      
-      void forceNewOutput(){
-        synthContext_.forceNewOutput = true;
-      }
+      void addAuxControlGenerator(ControlGenerator generator);
       
       void sendControlChangesToSubscribers();
       
@@ -89,9 +100,25 @@ namespace Tonic{
         it->tick(context);
       }
       
+      const bool outputGenIsSilent = outputGen_.isSilent();
+      
       if (limitOutput_){
-        limiter_.tickThrough(outputFrames_, context);
+        if (outputGenIsSilent && limiterIsIdle_ && context.skipSilence){
+          // the lookahead has drained, so the limiter would only pass silence through
+          context.countSkippedNode();
+        }
+        else{
+          limiter_.tickThrough(outputFrames_, context);
+          
+          limiterIsIdle_ = outputGenIsSilent;
+          const TonicFloat *outptr = outputFrames_.data();
+          for (unsigned int i=0; i<outputFrames_.size() && limiterIsIdle_; i++){
+            limiterIsIdle_ = (*outptr++ == 0);
+          }
+        }
       }
+      
+      isSilent_ = outputGenIsSilent && (!limitOutput_ || limiterIsIdle_);
     }
     
   }
@@ -100,13 +127,18 @@ namespace Tonic{
   
   class Synth  : public TemplatedBufferFiller<Tonic_::Synth_> {
     
+  protected:
+    
+    //! For subclasses whose implementation derives from Synth_ (e.g. PolySynth)
+    Synth(Tonic_::Synth_ * newSynth) : TemplatedBufferFiller<Tonic_::Synth_>(newSynth) {}
+    
   public:
+    
+    Synth() {}
         
     //! Set the output gen that produces audio for the Synth
     void  setOutputGen(Generator generator){
-      gen()->lockMutex();
       gen()->setOutputGen(generator);
-      gen()->unlockMutex();
     }
     
     //! Returns a reference to outputGen
@@ -114,6 +146,11 @@ namespace Tonic{
       return gen()->getOutputGen();
     }
 
+    //! Pool for this synth's patch, made on first use. Build the patch inside a BufferPoolScope on it to keep the patch's buffers together in memory.
+    BufferPool bufferPool() {
+      return gen()->bufferPool();
+    }
+    
     //! Set whether synth uses dynamic limiter to prevent clipping/wrapping. Defaults to true.
     void setLimitOutput(bool shouldLimit) {
       gen()->setLimitOutput(shouldLimit);
@@ -151,9 +188,7 @@ namespace Tonic{
     
     //! Add a ControlGenerator to a list of objects which will be ticked regardless of whether they're part of the synthesis graph or not.
     void addAuxControlGenerator(ControlGenerator generator){
-      gen()->lockMutex();
       gen()->addAuxControlGenerator(generator);
-      gen()->unlockMutex();
     }
     
     //! Add an object which will be notified when a particular ControlChangeNotifier changes value or is triggered.
@@ -195,12 +230,6 @@ namespace Tonic{
     {
       return gen()->getParameters();
     }
-    
-    void forceNewOutput(){
-      gen()->lockMutex();
-      gen()->forceNewOutput();
-      gen()->unlockMutex();
-    }
             
   };
 
@@ -238,6 +267,11 @@ namespace Tonic{
       return it->second();
     }
     
+    //! Whether a synth has been registered under this name
+    static bool isRegistered(std::string const& s) {
+      return getMap()->find(s) != getMap()->end();
+    }
+    
   protected:
     static map_type * getMap() {
       // never delete'ed. (exist until program termination)
@@ -17,6 +17,17 @@ namespace Tonic {
       static TonicDictionary<SampleTable> * s_oscillatorTables = new TonicDictionary<SampleTable>;
       return s_oscillatorTables;
     }
+    
+    struct OscillatorTablesLock_ {
+      TONIC_MUTEX_T mutex;
+      OscillatorTablesLock_() { TONIC_MUTEX_INIT(mutex); }
+    };
+    
+    TONIC_MUTEX_T & s_oscillatorTablesMutex()
+    {
+      static OscillatorTablesLock_ * lock = new OscillatorTablesLock_;
+      return lock->mutex;
+    }
   
     TableLookupOsc_::TableLookupOsc_() :
       phase_(0.0)
@@ -42,7 +53,7 @@ namespace Tonic {
         
         table.resample(nearestPo2, 1);
         table.resize(nearestPo2+1, 1);
-        table.dataPointer()[nearestPo2] = table.dataPointer()[0]; // copy first sample to last
+        table.planarDataPointer()[nearestPo2] = table.planarDataPointer()[0]; // copy first sample to last
         
       }
       
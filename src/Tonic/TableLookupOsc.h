@@ -22,6 +22,9 @@ namespace Tonic {
     // Registry for all static oscillator lookup table data
     TonicDictionary<SampleTable> * s_oscillatorTables();
     
+    // Oscillators may be made on any thread - hold this around every use of s_oscillatorTables()
+    TONIC_MUTEX_T & s_oscillatorTablesMutex();
+    
     class TableLookupOsc_ : public Generator_{
       
       //------------------------------------
@@ -68,11 +71,11 @@ namespace Tonic {
       
       unsigned long tableSize = lookupTable_.size()-1;
       
-      const TonicFloat rateConstant = (TonicFloat)tableSize / Tonic::sampleRate();
+      const TonicFloat rateConstant = (TonicFloat)tableSize / sampleRate_;
       
       TonicFloat *samples = &outputFrames_[0];
       TonicFloat *rateBuffer = &modFrames_[0];
-      TonicFloat *tableData = lookupTable_.dataPointer();
+      TonicFloat *tableData = lookupTable_.planarDataPointer();
       
       // R. Hoelderich style fast phasor.
       
@@ -80,12 +83,9 @@ namespace Tonic {
       
       // pre-multiply rate constant for speed
 #ifdef USE_APPLE_ACCELERATE
-      vDSP_vsmul(rateBuffer, 1, &rateConstant, rateBuffer, 1, kSynthesisBlockSize);
+      vDSP_vsmul(rateBuffer, 1, &rateConstant, rateBuffer, 1, outputFrames_.frames());
 #else
-      for (unsigned int i=0; i<kSynthesisBlockSize; i++){
-        *rateBuffer++ *= rateConstant;
-      }
-      rateBuffer = &modFrames_[0];
+      vectorKernels().multiplyScalar(rateBuffer, rateConstant, outputFrames_.frames());
 #endif
       
       sd.d = BIT32DECPT;
@@ -98,7 +98,7 @@ namespace Tonic {
       
       TonicFloat *tAddr, f1, f2;
       
-      for ( unsigned int i=0; i<kSynthesisBlockSize; i++ ) {
+      for ( unsigned int i=0; i<outputFrames_.frames(); i++ ) {
         
         sd.d = ps;
         ps += *rateBuffer++;
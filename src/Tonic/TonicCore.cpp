@@ -0,0 +1,110 @@
+//
+//  TonicCore.cpp
+//  Tonic
+//
+//
+// See LICENSE.txt for license and usage information.
+//
+
+#include "TonicCore.h"
+
+#if TONIC_HAS_CPP_11
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#endif
+
+namespace Tonic {
+
+  namespace Tonic_ {
+
+    TonicFloat sampleRate_ = 44100.f;
+
+    TONIC_THREAD_LOCAL int renderScopeDepth_ = 0;
+
+    // Objects waiting to be deleted, as an intrusive stack linked through nextDeferred_.
+    // Any number of threads push. Reclaiming takes the whole stack at once, so there's no ABA problem.
+    static ReferenceCounted_ * deferredDeletions_ = NULL;
+
+    void deferDeletion(ReferenceCounted_ * object){
+      ReferenceCounted_ * head;
+      do {
+        head = TONIC_ATOMIC_LOAD(deferredDeletions_);
+        object->nextDeferred_ = head;
+      } while (!TONIC_ATOMIC_COMPARE_EXCHANGE_PTR(deferredDeletions_, head, object));
+    }
+
+    unsigned long reclaimDeferredDeletions(){
+
+      if (isRendering()){
+        error("reclaimDeferredDeletions - called while rendering, nothing reclaimed");
+        return 0;
+      }
+
+      unsigned long numReclaimed = 0;
+
+      // deleting an object can release others, which are deleted straight away since this thread isn't rendering
+      ReferenceCounted_ * object = (ReferenceCounted_ *)TONIC_ATOMIC_EXCHANGE_PTR(deferredDeletions_, NULL);
+      while (object){
+        ReferenceCounted_ * next = object->nextDeferred_;
+        delete object;
+        object = next;
+        numReclaimed++;
+      }
+
+      return numReclaimed;
+    }
+
+#if TONIC_HAS_CPP_11
+
+    // Deletes deferred objects in the background, so they don't wait for the next change to a graph
+    class ReclaimerThread_ {
+
+      std::thread               thread_;
+      std::mutex                mutex_;
+      std::condition_variable   wakeCondition_;
+      bool                      quit_;
+
+      void run(){
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!quit_){
+          wakeCondition_.wait_for(lock, std::chrono::milliseconds(20));
+          lock.unlock();
+          reclaimDeferredDeletions();
+          lock.lock();
+        }
+      }
+
+    public:
+
+      ReclaimerThread_() : quit_(false) {
+        thread_ = std::thread(&ReclaimerThread_::run, this);
+      }
+
+      ~ReclaimerThread_(){
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          quit_ = true;
+        }
+        wakeCondition_.notify_one();
+        thread_.join();
+        reclaimDeferredDeletions();
+      }
+
+    };
+
+    void startReclaimerThread(){
+      // constructed once, by whichever thread gets here first, and stopped at exit
+      static ReclaimerThread_ reclaimerThread;
+    }
+
+#else
+
+    void startReclaimerThread(){}
+
+#endif
+
+  }
+
+}
@@ -22,6 +22,7 @@
 #include <cstring>
 #include <cstdio>
 #include <cmath>
+#include <ctime>
 
 extern "C" {
   #include <stdint.h>
@@ -30,6 +31,14 @@ extern "C" {
 // Uncomment or define in your build configuration to log debug messages and perform extra debug checks
 // #define TONIC_DEBUG
 
+// Uncomment or define in your build configuration (for Tonic and your app alike) to record memory allocation
+// and locking on rendering threads - see RealtimeCheck.h. Slows down every allocation, so for debug builds only.
+// #define TONIC_CHECK_REALTIME
+
+// Uncomment or define in your build configuration (for Tonic and your app alike) to be able to time every
+// node of a graph - see Profiler.h. Costs nothing unless defined.
+// #define TONIC_PROFILE
+
 // Determine if C++11 is available. If not, some synths cannot be used. (applies to oF demos, mostly)
 #define TONIC_HAS_CPP_11 (__cplusplus > 199711L)
 
@@ -41,16 +50,67 @@ extern "C" {
 
 #endif
 
+#if defined (__APPLE__)
+
+  #include <mach/mach_time.h>
+
+#elif defined (__linux__)
+
+  #include <time.h>
+
+#endif
+
+#ifdef TONIC_CHECK_REALTIME
+
+  #include <typeinfo>
+
+  namespace Tonic {
+    namespace Tonic_ {
+
+      // Record a lock taken, if the current thread is rendering. Defined in RealtimeCheck.cpp.
+      void checkRealtimeLock();
+
+      // Marks node as the innermost generator computing on this thread, for attributing violations to it
+      class RealtimeCheckNodeScope_ {
+        const std::type_info * previousNodeType_;
+      public:
+        RealtimeCheckNodeScope_(const std::type_info & nodeType);
+        ~RealtimeCheckNodeScope_();
+      };
+
+    }
+  }
+
+  #define TONIC_CHECK_REALTIME_LOCK()       Tonic::Tonic_::checkRealtimeLock()
+  #define TONIC_CHECK_REALTIME_NODE(node)   Tonic::Tonic_::RealtimeCheckNodeScope_ realtimeCheckNodeScope(typeid(*node))
+
+#else
+
+  #define TONIC_CHECK_REALTIME_LOCK()       ((void)0)
+  #define TONIC_CHECK_REALTIME_NODE(node)
+
+#endif
+
 #if (defined (__APPLE__) || defined (__linux__))
 
-  #include <pthread.h> 
+  #include <pthread.h>
 
   #define TONIC_MUTEX_T           pthread_mutex_t
   #define TONIC_MUTEX_INIT(x)     pthread_mutex_init(&x, NULL)
   #define TONIC_MUTEX_DESTROY(x)  pthread_mutex_destroy(&x)
-  #define TONIC_MUTEX_LOCK(x)     pthread_mutex_lock(&x)
+  #define TONIC_MUTEX_LOCK(x)     (TONIC_CHECK_REALTIME_LOCK(), pthread_mutex_lock(&x))
   #define TONIC_MUTEX_UNLOCK(x)   pthread_mutex_unlock(&x)
 
+  // Lock-free primitives for communicating with the audio thread (GCC/Clang builtins)
+  #define TONIC_ATOMIC_LOAD(x)        __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+  #define TONIC_ATOMIC_STORE(x, v)    __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+  #define TONIC_ATOMIC_INCREMENT(x)   __atomic_add_fetch(&(x), 1, __ATOMIC_ACQ_REL)
+  #define TONIC_ATOMIC_DECREMENT(x)   __atomic_sub_fetch(&(x), 1, __ATOMIC_ACQ_REL)
+
+  // Pointers only. Compare-exchange evaluates to true if x was expected and has been set to desired.
+  #define TONIC_ATOMIC_COMPARE_EXCHANGE_PTR(x, expected, desired)  __sync_bool_compare_and_swap(&(x), (expected), (desired))
+  #define TONIC_ATOMIC_EXCHANGE_PTR(x, v)                          __atomic_exchange_n(&(x), (v), __ATOMIC_ACQ_REL)
+
 #elif (defined (_WIN32) || defined (__WIN32__))
 
   #define WIN32_LEAN_AND_MEAN
@@ -71,9 +131,33 @@ extern "C" {
   #define TONIC_MUTEX_T CRITICAL_SECTION
   #define TONIC_MUTEX_INIT(x) InitializeCriticalSection(&x)
   #define TONIC_MUTEX_DESTROY(x) DeleteCriticalSection(&x)
-  #define TONIC_MUTEX_LOCK(x) EnterCriticalSection(&x)
+  #define TONIC_MUTEX_LOCK(x) (TONIC_CHECK_REALTIME_LOCK(), EnterCriticalSection(&x))
   #define TONIC_MUTEX_UNLOCK(x) LeaveCriticalSection(&x)
 
+  // Lock-free primitives for communicating with the audio thread.
+  // Volatile accesses have acquire/release semantics under MSVC's default /volatile:ms
+  template<class T> inline T tonicAtomicLoad(T volatile * x){ T v = *x; _ReadWriteBarrier(); return v; }
+  template<class T, class V> inline void tonicAtomicStore(T volatile * x, V v){ _ReadWriteBarrier(); *x = v; }
+
+  #define TONIC_ATOMIC_LOAD(x)        tonicAtomicLoad(&(x))
+  #define TONIC_ATOMIC_STORE(x, v)    tonicAtomicStore(&(x), (v))
+  #define TONIC_ATOMIC_INCREMENT(x)   InterlockedIncrement((volatile LONG*)&(x))
+  #define TONIC_ATOMIC_DECREMENT(x)   InterlockedDecrement((volatile LONG*)&(x))
+
+  // Pointers only. Compare-exchange evaluates to true if x was expected and has been set to desired.
+  #define TONIC_ATOMIC_COMPARE_EXCHANGE_PTR(x, expected, desired) \
+    (InterlockedCompareExchangePointer((PVOID volatile *)&(x), (PVOID)(desired), (PVOID)(expected)) == (PVOID)(expected))
+  #define TONIC_ATOMIC_EXCHANGE_PTR(x, v)   InterlockedExchangePointer((PVOID volatile *)&(x), (PVOID)(v))
+
+#endif
+
+// Per-thread storage for plain data
+#if TONIC_HAS_CPP_11
+  #define TONIC_THREAD_LOCAL thread_local
+#elif (defined (_WIN32) || defined (__WIN32__))
+  #define TONIC_THREAD_LOCAL __declspec(thread)
+#else
+  #define TONIC_THREAD_LOCAL __thread
 #endif
 
 // --- Macro for enabling denormal rounding on audio thread ---
@@ -117,27 +201,41 @@ namespace Tonic {
   /*! Objects under the Tonic_ namespace are internal DSP-level objects not intended for public usage */
   namespace Tonic_ {
     
-    static TonicFloat sampleRate_ = 44100.f;
+    //! Default sample rate, shared by every translation unit
+    extern TonicFloat sampleRate_;
     
   }
   
   // -- Global Constants --
   
-  //! Set the operational sample rate.
-  /*! !!!: CHANGING WHILE RUNNING WILL RESULT IN UNDEFINED BEHAVIOR. MUST BE SET PRIOR TO OBJECT ALLOCATION. */
+  //! Set the default sample rate. Defaults to 44100.
+  /*! 
+      BufferFillers (Synths, Mixers...) created afterwards render at this rate until given their own with
+      BufferFiller::setSampleRate, so engines at different rates can run side by side. Generators follow
+      the rate of whichever BufferFiller renders them, and size delay lines for this rate until first rendered.
+   */
   static void setSampleRate(TonicFloat sampleRate){
     Tonic_::sampleRate_ = sampleRate;
   }
   
-  //! Return sample rate
+  //! Return the default sample rate
   static TonicFloat sampleRate(){
     return Tonic_::sampleRate_;
   };
 
-  //! "Vector" size for audio processing. ControlGenerators update at this rate.
-  /*! !!!: THIS VALUE SHOULD BE A POWER-OF-TWO WHICH IS LESS THAN THE HARDWARE BUFFER SIZE */
+  //! Default "vector" size for audio processing. ControlGenerators update once per block.
+  /*! 
+      Each BufferFiller can render at its own block size (see BufferFiller::setBlockSize). Larger blocks
+      amortise per-block overhead for offline rendering, smaller ones reduce latency and make control
+      changes finer-grained. Block arithmetic runs on SIMD kernels picked for the CPU at startup
+      (see VectorKernels), whatever the size.
+      !!!: THE BLOCK SIZE SHOULD BE LESS THAN OR EQUAL TO THE HARDWARE BUFFER SIZE
+   */
   static const unsigned int kSynthesisBlockSize = 64;
   
+  //! Peak level (-100 dB) below which a decaying tail is treated as silence, letting its generator sleep
+  static const float kSilenceThreshold = 1.0e-5f;
+  
   // -- Global Types --
   
   //!For fast computation of int/fract using some bit-twiddlery
@@ -150,6 +248,8 @@ namespace Tonic {
   
   namespace Tonic_{
     
+    class GraphSchedule_;
+    
     //! Context which defines a particular synthesis graph
     
     /*! 
@@ -168,12 +268,40 @@ namespace Tonic {
       //! If true, generators will be forced to compute fresh output
       // TODO: Not fully implmenented yet -- ND 2013/05/20
       bool forceNewOutput;
+      
+      //! If non-NULL, generators append themselves here after computing a block (see BufferFiller::compile)
+      GraphSchedule_ * recordSchedule;
+      
+      //! Number of frames generators compute per block
+      unsigned int blockSize;
+      
+      //! Sample rate generators compute at (see BufferFiller::setSampleRate)
+      TonicFloat sampleRate;
+      
+      //! If true, generators may stop computing inputs and effects known to be silent (see BufferFiller::setSkipSilence)
+      bool skipSilence;
+      
+      //! If non-NULL, incremented for every generator (with everything upstream of it) not computed because of silence
+      unsigned long * skippedNodes;
+      
+#ifdef TONIC_PROFILE
+      //! If true, generators time themselves (see Profiler.h)
+      bool profile;
+#endif
             
-      SynthesisContext_() : elapsedFrames(0), elapsedTime(0), forceNewOutput(true){}
+      SynthesisContext_() : elapsedFrames(0), elapsedTime(0), forceNewOutput(true), recordSchedule(NULL), blockSize(kSynthesisBlockSize),
+                            sampleRate(Tonic::sampleRate()), skipSilence(false), skippedNodes(NULL)
+#ifdef TONIC_PROFILE
+                            , profile(false)
+#endif
+      {}
+      
+      //! Count a generator skipped because of silence
+      void countSkippedNode() const { if (skippedNodes) (*skippedNodes)++; }
     
       void tick() {
-        elapsedFrames += kSynthesisBlockSize;
-        elapsedTime = (double)elapsedFrames/sampleRate();
+        elapsedFrames += blockSize;
+        elapsedTime = (double)elapsedFrames/sampleRate;
         forceNewOutput = false;
       };
     
@@ -303,6 +431,29 @@ namespace Tonic {
     return a + r;
 }
 
+  // -- Timing --
+
+  //! Monotonic wall-clock time in seconds. Only differences between two calls are meaningful.
+  /*! Use for measuring render throughput, not for anything that affects synthesis output. */
+  inline static double monotonicTime(){
+#if defined (__APPLE__)
+    static mach_timebase_info_data_t timebase;
+    if (timebase.denom == 0) mach_timebase_info(&timebase);
+    return (double)mach_absolute_time() * timebase.numer / timebase.denom * 1.0e-9;
+#elif (defined (_WIN32) || defined (__WIN32__))
+    LARGE_INTEGER count, frequency;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&frequency);
+    return (double)count.QuadPart / (double)frequency.QuadPart;
+#elif defined (__linux__)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+#else
+    return (double)clock() / CLOCKS_PER_SEC;
+#endif
+  }
+
   //! Tonic exception class
   // May want to implement custom exception behavior here, but for now, this is essentially a typedef
   class TonicException : public runtime_error
@@ -373,22 +524,107 @@ namespace Tonic {
     
   };
   
+  namespace Tonic_ {
+    
+    // Nesting depth of RenderScope_ on this thread. Defined in TonicCore.cpp.
+    extern TONIC_THREAD_LOCAL int renderScopeDepth_;
+    
+    //! Marks the current thread as rendering audio for as long as it exists. May be nested.
+    /*!
+        While a thread is rendering, objects whose last reference it drops are not deleted there but
+        queued for reclaimDeferredDeletions(), so the audio thread never runs destructors or frees memory.
+     */
+    class RenderScope_ {
+    public:
+      RenderScope_(){ renderScopeDepth_++; }
+      ~RenderScope_(){ renderScopeDepth_--; }
+    };
+    
+    //! True if the current thread is inside a RenderScope_
+    inline bool isRendering(){ return renderScopeDepth_ > 0; }
+    
+    //! Base class for objects owned through TonicSmartPointer, holding their reference count
+    /*!
+        The count is updated atomically, so handles to one object can be copied and dropped on different threads.
+        Copying an object does not copy its references.
+     */
+    class ReferenceCounted_ {
+      
+    public:
+      
+      ReferenceCounted_() : referenceCount_(0), nextDeferred_(NULL) {}
+      ReferenceCounted_(const ReferenceCounted_ &) : referenceCount_(0), nextDeferred_(NULL) {}
+      ReferenceCounted_ & operator=(const ReferenceCounted_ &){ return *this; }
+      
+      virtual ~ReferenceCounted_() {}
+      
+      void retain(){
+        TONIC_ATOMIC_INCREMENT(referenceCount_);
+      }
+      
+      //! Drop a reference, deleting the object (or deferring its deletion while rendering) if it was the last
+      void release();
+      
+    private:
+      
+      long                  referenceCount_;
+      
+      // link in the queue of objects waiting for reclaimDeferredDeletions()
+      ReferenceCounted_     *nextDeferred_;
+      
+      friend void deferDeletion(ReferenceCounted_ * object);
+      friend unsigned long reclaimDeferredDeletions();
+      
+    };
+    
+    //! Queue object for reclaimDeferredDeletions(). Lock-free and allocation-free, so safe on the audio thread.
+    void deferDeletion(ReferenceCounted_ * object);
+    
+    //! Delete every object queued by deferDeletion(). Returns the number deleted. Never call while rendering.
+    /*!
+        Called whenever a BufferFiller posts a change or collects garbage. With C++11 a background thread,
+        started with the first BufferFiller, also calls it every few tens of milliseconds.
+     */
+    unsigned long reclaimDeferredDeletions();
+    
+    //! Start the background thread which reclaims deferred deletions, if it isn't running. C++11 only.
+    void startReclaimerThread();
+    
+    inline void ReferenceCounted_::release(){
+      if (TONIC_ATOMIC_DECREMENT(referenceCount_) == 0){
+        if (isRendering()){
+          deferDeletion(this);
+        }
+        else{
+          delete this;
+        }
+      }
+    }
+    
+  }
+  
   //! Reference counting smart pointer class template
+  /*!
+      T must derive from Tonic_::ReferenceCounted_, which holds the count, so handles made separately from the
+      same raw pointer share it. Handles may be copied and dropped on any thread. An object whose last handle
+      is dropped on a rendering thread is deleted later, off the audio thread.
+   */
   template<class T>
   class TonicSmartPointer {
     
     protected:
       
       T * obj;
-      int * pcount;
       
     public:
       
-      TonicSmartPointer() : obj(NULL), pcount(NULL) {}
+      TonicSmartPointer() : obj(NULL) {}
       
-      TonicSmartPointer(T * initObj) : obj(initObj) , pcount(initObj ? new int(1) : NULL) {}
+      TonicSmartPointer(T * initObj) : obj(initObj) {
+        retain();
+      }
       
-      TonicSmartPointer(const TonicSmartPointer& r) : obj(r.obj), pcount(r.pcount){
+      TonicSmartPointer(const TonicSmartPointer& r) : obj(r.obj) {
         retain();
       }
       
@@ -396,13 +632,13 @@ namespace Tonic {
       {
         if(obj == r.obj) return *this;
         
-        release();
-        
+        // retain first, in case dropping the old object drops the last reference to r
+        T * oldObj = obj;
         obj = r.obj;
-        pcount = r.pcount;
-        
         retain();
         
+        if (oldObj) oldObj->release();
+        
         return *this;
       }
       
@@ -411,22 +647,27 @@ namespace Tonic {
       }
       
       void retain(){
-        if (pcount) (*pcount)++;
+        if (obj) obj->retain();
       }
       
       void release(){
-        if(pcount && --(*pcount) == 0){
-          delete obj;
-          delete pcount;
-          
+        if (obj){
+          obj->release();
           obj = NULL;
-          pcount = NULL;
         }
       }
       
       bool operator==(const TonicSmartPointer& r){
         return obj == r.obj;
       }
+      
+      //! Exchange referenced objects without touching reference counts.
+      /*! Never deletes anything, so it is safe to call on the audio thread. */
+      void swap(TonicSmartPointer& r){
+        T * tmpObj = obj;
+        obj = r.obj;
+        r.obj = tmpObj;
+      }
     
   };
 
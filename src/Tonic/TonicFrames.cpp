@@ -10,119 +10,118 @@
 
 
 #include "TonicFrames.h"
+#include "BufferPool.h"
 
 namespace Tonic {
   
-
-TonicFrames :: TonicFrames( unsigned int nFrames, unsigned int nChannels )
-  : nFrames_( nFrames ), nChannels_( nChannels )
+TonicFloat * TonicFrames :: allocateData( size_t nSamples )
 {
-  if (nChannels_ > 2){
-    error("Invalid number of channels. TonicFrames is limited to mono or stereo only (1 or 2 channels)", true);
+  Tonic_::BufferPool_ * pool = data_ ? pool_ : Tonic_::currentBufferPool();
+  TonicFloat * data = pool->allocate( nSamples, bufferSize_ );
+  
+#if defined(TONIC_DEBUG)
+  if ( data == NULL ) {
+    std::string error = "TonicFrames: memory allocation error!";
+    Tonic::error(error, true);
   }
+#endif
+  
+  pool_ = pool;
+  return data;
+}
   
+void TonicFrames :: freeData( TonicFloat * data, size_t capacity )
+{
+  if ( data ) pool_->deallocate( data, capacity );
+}
+
+
+TonicFrames :: TonicFrames( unsigned int nFrames, unsigned int nChannels )
+  : data_(0), nFrames_( nFrames ), nChannels_( nChannels ), bufferSize_(0), pool_(0)
+{
   size_ = nFrames_ * nChannels_;
-  bufferSize_ = size_;
 
   if ( size_ > 0 ) {
-    data_ = (TonicFloat *) calloc( size_, sizeof( TonicFloat ) );
-#if defined(TONIC_DEBUG)
-    if ( data_ == NULL ) {
-      std::string error = "TonicFrames: memory allocation error in constructor!";
-      Tonic::error(error, true);
-    }
-#endif
+    data_ = allocateData( size_ );
+    memset( data_, 0, size_ * sizeof(TonicFloat) );
   }
-  else data_ = 0;
 
   dataRate_ = Tonic::sampleRate();
 }
 
 TonicFrames :: TonicFrames( const TonicFloat& value, unsigned int nFrames, unsigned int nChannels )
-  : nFrames_( nFrames ), nChannels_( nChannels )
+  : data_(0), nFrames_( nFrames ), nChannels_( nChannels ), bufferSize_(0), pool_(0)
 {
-  if (nChannels_ > 2){
-    error("Invalid number of channels. TonicFrames is limited to mono or stereo only (1 or 2 channels)", true);
-  }
-  
   size_ = nFrames_ * nChannels_;
-  bufferSize_ = size_;
   if ( size_ > 0 ) {
-    data_ = (TonicFloat *) malloc( size_ * sizeof( TonicFloat ) );
-#if defined(TONIC_DEBUG)
-    if ( data_ == NULL ) {
-      std::string error = "TonicFrames: memory allocation error in constructor!";
-      Tonic::error(error, true);
-    }
-#endif
-    for ( long i=0; i<(long)size_; i++ ) data_[i] = value;
+    data_ = allocateData( size_ );
+    vectorKernels().fill( data_, value, size_ );
   }
-  else data_ = 0;
 
   dataRate_ = Tonic::sampleRate();
 }
 
 TonicFrames :: ~TonicFrames()
 {
-  if ( data_ ) free( data_ );
+  freeData( data_, bufferSize_ );
 }
 
 TonicFrames :: TonicFrames( const TonicFrames& f )
-  : size_(0), bufferSize_(0)
+  : data_(0), nFrames_(0), nChannels_(0), size_(0), bufferSize_(0), pool_(0)
 {
   resize( f.frames(), f.channels() );
   dataRate_ = Tonic::sampleRate();
-  for ( unsigned int i=0; i<size_; i++ ) data_[i] = f[i];
+  memcpy( data_, f.data_, size_ * sizeof(TonicFloat) );
 }
 
 TonicFrames& TonicFrames :: operator= ( const TonicFrames& f )
 {
-  size_ = 0;
-  bufferSize_ = 0;
+  if ( this == &f ) return *this;
   resize( f.frames(), f.channels() );
   dataRate_ = Tonic::sampleRate();
-  for ( unsigned int i=0; i<size_; i++ ) data_[i] = f[i];
+  memcpy( data_, f.data_, size_ * sizeof(TonicFloat) );
   return *this;
 }
 
 void TonicFrames :: resize( size_t nFrames, unsigned int nChannels )
 {
   
-  if (nChannels > 2){
-    error("Invalid number of channels. TonicFrames is limited to mono or stereo only (1 or 2 channels)", true);
-  }
-  
   if (nFrames != nFrames_ || nChannels != nChannels_){
     
+    // preserve as much of old data as we can - the leading frames of each channel we keep
+    TonicFloat * oldData = data_;
+    size_t oldFrames = nFrames_;
+    size_t keptFrames = nFrames < nFrames_ ? nFrames : nFrames_;
+    unsigned int keptChannels = nChannels < nChannels_ ? nChannels : nChannels_;
+    
     nFrames_ = nFrames;
     nChannels_ = nChannels;
-
-    // preserve as much of old data as we can
-    TonicFloat * oldData = data_;
-    unsigned long oldSize = size_;
     
     size_ = nFrames_ * nChannels_;
     
     if ( size_ > bufferSize_ ) {
       
-      data_ = (TonicFloat *) malloc( size_ * sizeof( TonicFloat ) );
+      size_t oldCapacity = bufferSize_;
+      data_ = allocateData( size_ );
       
       if (oldData){
-        for (unsigned int i=0; i<oldSize; i++){
-          data_[i] = oldData[i];
+        for (unsigned int c=0; c<keptChannels; c++){
+          memcpy(data_ + c*nFrames_, oldData + c*oldFrames, keptFrames * sizeof(TonicFloat));
         }
       }
       
-#if defined(TONIC_DEBUG)
-      if ( data_ == NULL ) {
-        std::string error = "TonicFrames::resize: memory allocation error!";
-        Tonic::error(error, true);
+      freeData( oldData, oldCapacity );
+    }
+    else if (nFrames_ > oldFrames){
+      // channels move up within the buffer - last channel first, so none is overwritten before it moves
+      for (unsigned int c=keptChannels; c-- > 1; ){
+        memmove(data_ + c*nFrames_, data_ + c*oldFrames, keptFrames * sizeof(TonicFloat));
+      }
+    }
+    else if (nFrames_ < oldFrames){
+      for (unsigned int c=1; c<keptChannels; c++){
+        memmove(data_ + c*nFrames_, data_ + c*oldFrames, keptFrames * sizeof(TonicFloat));
       }
-#endif
-      
-      bufferSize_ = size_;
-      
-      if (oldData) free(oldData);
     }
     
   }
@@ -135,22 +134,26 @@ void TonicFrames :: resize( size_t nFrames, unsigned int nChannels, TonicFloat v
 #ifdef USE_APPLE_ACCELERATE
   vDSP_vfill(&value, data_, 1, size_);
 #else
-  for ( size_t i=0; i<size_; i++ ) data_[i] = value;
+  vectorKernels().fill(data_, value, size_);
 #endif
   
 }
   
+// linear interpolation into one channel of resample()'s source, holding the last frame
+static inline TonicFloat resampledValue( const TonicFloat *channel, unsigned long nFrames, unsigned int idx, float frac )
+{
+  if (idx >= nFrames-1) return channel[nFrames-1];
+  return channel[idx] + frac * (channel[idx+1] - channel[idx]);
+}
+  
 void TonicFrames :: resample( size_t nFrames , unsigned int nChannels )
   {
-    if (nChannels > 2){
-      error("Invalid number of channels. TonicFrames is limited to mono or stereo only (1 or 2 channels)", true);
-    }
-    
     if (nFrames != nFrames_ || nChannels != nChannels_){
       
       
       // preserve as much of old data as we can
       TonicFloat * oldData = data_;
+      size_t oldCapacity = bufferSize_;
       unsigned long oldFrames = nFrames_;
       unsigned int oldchannels = nChannels_;
       
@@ -159,48 +162,40 @@ void TonicFrames :: resample( size_t nFrames , unsigned int nChannels )
       
       size_ = nFrames_ * nChannels_;
         
-      data_ = (TonicFloat *) malloc( size_ * sizeof( TonicFloat ) );
-      
-#if defined(TONIC_DEBUG)
-      if ( data_ == NULL ) {
-        std::string error = "TonicFrames::resize: memory allocation error!";
-        Tonic::error(error, true);
-      }
-#endif
+      data_ = allocateData( size_ );
       
       // resample the content (brute-force, no AA applied)
-      if (oldData){
+      if (oldData && oldFrames > 0){
         
         float inc = (float)oldFrames/nFrames_;
         
         for (unsigned int c=0; c<nChannels_; c++){
           
+          TonicFloat *dptr = data_ + c*nFrames_;
           float fIdx = 0.f;
           
           for (unsigned int i=0; i<nFrames_; i++){
             
-            float fi, y1, y2;
+            float fi;
             float frac = modff(fIdx, &fi);
             unsigned int idx = (unsigned int)fi;
             
-            unsigned int ocIdx = oldchannels > 1 ? c : 0;
-            
-            if (idx == oldFrames-1){
-              data_[i*nChannels_ + c] = oldData[idx * oldchannels + ocIdx];
+            // handle different channel mapping - mono is spread, a mono result averages, otherwise match by index
+            if (oldchannels == 1){
+              dptr[i] = resampledValue(oldData, oldFrames, idx, frac);
             }
-            else{
-              y1 = oldData[idx * oldchannels + ocIdx];
-              y2 = oldData[(idx+1) * oldchannels + ocIdx];
-              data_[i*nChannels + c] = y1 + frac * (y2 - y1);
+            else if (nChannels_ == 1){
+              dptr[i] = 0;
+              for (unsigned int oc=0; oc<oldchannels; oc++){
+                dptr[i] += resampledValue(oldData + oc*oldFrames, oldFrames, idx, frac);
+              }
+              dptr[i] /= oldchannels;
             }
-            
-            // handle different channel mapping
-            if (oldchannels > nChannels_){
-              // add and average
-              y1 = oldData[idx * oldchannels + ocIdx + 1];
-              y2 = oldData[(idx+1) * oldchannels + ocIdx + 1];
-              data_[i*nChannels + c] += (y1 + frac * (y2 - y1));
-              data_[i*nChannels + c] *= 0.5f;
+            else if (c < oldchannels){
+              dptr[i] = resampledValue(oldData + c*oldFrames, oldFrames, idx, frac);
+            }
+            else{
+              dptr[i] = 0;
             }
             
             fIdx += inc;
@@ -208,9 +203,7 @@ void TonicFrames :: resample( size_t nFrames , unsigned int nChannels )
         }
       }
       
-      bufferSize_ = size_;
-      
-      if (oldData) free(oldData);
+      freeData( oldData, oldCapacity );
     
     }
 
@@ -229,10 +222,10 @@ TonicFloat TonicFrames :: interpolate( TonicFloat frame, unsigned int channel )
   size_t iIndex = ( size_t ) frame;                    // integer part of index
   TonicFloat output, alpha = frame - (TonicFloat) iIndex;  // fractional part of index
 
-  iIndex = iIndex * nChannels_ + channel;
-  output = data_[ iIndex ];
+  const TonicFloat *cptr = data_ + channel * nFrames_;
+  output = cptr[ iIndex ];
   if ( alpha > 0.0 )
-    output += ( alpha * ( data_[ iIndex + nChannels_ ] - output ) );
+    output += ( alpha * ( cptr[ iIndex + 1 ] - output ) );
 
   return output;
 }
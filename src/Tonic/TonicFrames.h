@@ -13,15 +13,23 @@
 #define TONIC_TONICFRAMES_H
 
 #include "TonicCore.h"
+#include "VectorKernels.h"
 #include <sstream>
 
 /*
   This is an almost exact copy of STKFrames. Many thanks to Perry Cook and Gary Scavone.
   https://ccrma.stanford.edu/software/stk/
+ 
+  Unlike STKFrames, samples are stored planar: each channel's frames are contiguous, one channel
+  after another, so per-channel loops run over unit-stride memory. Any number of channels is allowed.
+  Sample memory is aligned to a cache line and comes from a BufferPool rather than malloc.
 */
 
 namespace Tonic {
 
+  namespace Tonic_ {
+    class BufferPool_;
+  }
 
   class TonicFrames
   {
@@ -58,27 +66,52 @@ namespace Tonic {
     */
     TonicFloat operator[] ( size_t n ) const;
 
+    //! Pointer to the first sample, for reading a block without copying it
+    const TonicFloat * data() const { return data_; };
+
+    //! Pointer to the first frame of a channel. The channel's frames() samples are contiguous.
+    TonicFloat * channelData( unsigned int channel ) { return data_ + channel * nFrames_; };
+    const TonicFloat * channelData( unsigned int channel ) const { return data_ + channel * nFrames_; };
+
     //! Assignment by sum operator into self.
     /*!
-      The dimensions of the argument are expected to be the same as
-      self.  No range checking is performed unless TONIC_DEBUG is
-      defined.
+      The frame count of the argument is expected to be the same as
+      self, and the argument must not be self.  No range checking is
+      performed unless TONIC_DEBUG is defined. A mono argument is applied
+      to every channel; otherwise channels are paired by index and any
+      channels of self beyond the argument's are left alone. The same
+      goes for the other arithmetic operators.
     */
-    void operator+= ( TonicFrames& f );
+    void operator+= ( const TonicFrames& f );
     
     
-    void operator-= ( TonicFrames& f );
+    void operator-= ( const TonicFrames& f );
 
     //! Assignment by product operator into self.
     /*!
-      The dimensions of the argument are expected to be the same as
-      self.  No range checking is performed unless TONIC_DEBUG is
-      defined.
+      The frame count of the argument is expected to be the same as
+      self, and the argument must not be self.  No range checking is
+      performed unless TONIC_DEBUG is defined.
     */
-    void operator*= ( TonicFrames& f );
+    void operator*= ( const TonicFrames& f );
     
     
-    void operator/= ( TonicFrames& f );
+    void operator/= ( const TonicFrames& f );
+
+    //! Scalar versions of the assignment operators, applied to every sample
+    void operator+= ( TonicFloat value );
+    void operator-= ( TonicFloat value );
+    void operator*= ( TonicFloat value );
+    void operator/= ( TonicFloat value );
+
+    //! Set every sample to value
+    void fill( TonicFloat value );
+
+    //! Copy f scaled by gain. Same channel conversion as copy().
+    void copyScaled( const TonicFrames & f, TonicFloat gain );
+
+    //! Add f scaled by gain. Same channel handling as operator+=.
+    void addScaled( const TonicFrames & f, TonicFloat gain );
 
     //! Channel / frame subscript operator that returns a reference.
     /*!
@@ -102,7 +135,7 @@ namespace Tonic {
     //! Copy one channel to another
     /*!
       The \c src and \c dst indices must be between 0 and channels() - 1, and
-      should not be the same number. No range checking is performed (yet)
+      must not be the same number. No range checking is performed (yet)
     */
     void copyChannel(unsigned int src, unsigned int dst);
 
@@ -115,10 +148,10 @@ namespace Tonic {
     //! Fill frames from other source.
     /*! 
       Copies channels from one object to another. Frame count must match.
-      If source has more channels than destination, they will be averaged.
-      If destination has more channels than source, they will be copied to all channels.
+      A mono source is copied to all channels, and a mono destination gets the average of the source channels.
+      Otherwise channels are matched by index, and destination channels the source doesn't have are silent.
     */
-    void copy( TonicFrames & f );
+    void copy( const TonicFrames & f );
         
     //! Return an interpolated value at the fractional frame index and channel.
     /*!
@@ -138,7 +171,8 @@ namespace Tonic {
     //! Resize self to represent the specified number of channels and frames.
     /*!
       Changes the size of self based on the number of frames and
-      channels.  No element assignment is performed.  No memory
+      channels.  The leading frames of each kept channel are preserved,
+      and anything new is left unassigned.  No memory
       deallocation occurs if the new size is smaller than the previous
       size.  Further, no new memory is allocated when the new size is
       smaller or equal to a previously allocated size.
@@ -181,12 +215,20 @@ namespace Tonic {
 
   protected:
 
+    //! A buffer of at least nSamples, aligned for vector kernels, setting bufferSize_ to its capacity
+    /*!
+        Comes from the pool data_ came from, if there is data_, otherwise the current one (see BufferPool).
+     */
+    TonicFloat * allocateData( size_t nSamples );
+    void freeData( TonicFloat * data, size_t capacity );
+
     TonicFloat *data_;
     TonicFloat dataRate_;
     size_t nFrames_;
     unsigned int nChannels_;
     size_t size_;
     size_t bufferSize_;
+    Tonic_::BufferPool_ *pool_;
 
   };
 
@@ -232,7 +274,7 @@ namespace Tonic {
     }
   #endif
 
-    return data_[ frame * nChannels_ + channel ];
+    return data_[ channel * nFrames_ + frame ];
   }
 
   inline TonicFloat TonicFrames :: operator() ( size_t frame, unsigned int channel ) const
@@ -245,18 +287,12 @@ namespace Tonic {
     }
   #endif
 
-    return data_[ frame * nChannels_ + channel ];
+    return data_[ channel * nFrames_ + frame ];
   }
     
   inline void TonicFrames :: copyChannel(unsigned int src, unsigned int dst)
   {
-
-    TonicFloat *sptr = data_ + src;
-    TonicFloat *dptr = data_ + dst;
-    unsigned int stride = nChannels_;
-    
-    vcopy(dptr, stride, sptr, stride, (unsigned int)nFrames_);
-
+    memcpy(channelData(dst), channelData(src), nFrames_ * sizeof(TonicFloat));
   }
 
   inline void TonicFrames::fillChannels()
@@ -270,7 +306,7 @@ namespace Tonic {
     memset(data_, 0, size_ * sizeof(TonicFloat));
   }
   
-  inline void TonicFrames::copy( TonicFrames &f ){
+  inline void TonicFrames::copy( const TonicFrames &f ){
     
 #if defined(TONIC_DEBUG)
     if ( f.frames() != nFrames_) {
@@ -281,42 +317,38 @@ namespace Tonic {
 #endif
     
     unsigned int fChannels = f.channels();
-    TonicFloat *dptr = data_;
-    TonicFloat *fptr = &f[0];
     
     if (nChannels_ == fChannels){
-      memcpy(dptr, fptr, size_ * sizeof(TonicFloat));
+      memcpy(data_, f.data_, size_ * sizeof(TonicFloat));
     }
-    else if (nChannels_ < fChannels){
+    else if (fChannels == 1){
+      // copy mono source to every channel
+      for (unsigned int c=0; c<nChannels_; c++){
+        memcpy(channelData(c), f.data_, nFrames_ * sizeof(TonicFloat));
+      }
+    }
+    else if (nChannels_ == 1){
       
       // sum channels
-      memset(dptr, 0, size_ * sizeof(TonicFloat));
+      memset(data_, 0, size_ * sizeof(TonicFloat));
       for (unsigned int c=0; c<fChannels; c++){
-        dptr = data_;
-        fptr = &f(0,c);
-        for (unsigned int i=0; i<nFrames_; i++, dptr+=nChannels_, fptr+=fChannels){
-          *dptr += *fptr;
-        }
+        vectorKernels().add(data_, f.channelData(c), nFrames_);
       }
       
       // apply scaling (average of channels)
       TonicFloat s = 1.0f/fChannels;
-      dptr = data_;
-      for (unsigned int i=0; i<nFrames_; i++, dptr+=nChannels_){
-        *dptr *= s;
-      }
+      vectorKernels().multiplyScalar(data_, s, nFrames_);
     }
     else{
-      // just copy one channel, then fill
-      vcopy(dptr, nChannels_, fptr, fChannels, (unsigned int)nFrames_);
-      
-      // fill all channels if necessary
-      fillChannels();
+      // match channels by index, any channels missing from the source are silent
+      unsigned int nCopy = nChannels_ < fChannels ? nChannels_ : fChannels;
+      memcpy(data_, f.data_, nCopy * nFrames_ * sizeof(TonicFloat));
+      memset(channelData(nCopy), 0, (nChannels_ - nCopy) * nFrames_ * sizeof(TonicFloat));
     }
       
   }
 
-  inline void TonicFrames :: operator+= ( TonicFrames& f )
+  inline void TonicFrames :: operator+= ( const TonicFrames& f )
   {
   #if defined(TONIC_DEBUG)
     if ( f.frames() != nFrames_ ) {
@@ -326,7 +358,7 @@ namespace Tonic {
     }
   #endif
     
-    TonicFloat *fptr = &f[0];
+    const TonicFloat *fptr = f.data_;
     TonicFloat *dptr = data_;
     
     unsigned int fChannels = f.channels();
@@ -336,41 +368,29 @@ namespace Tonic {
 #ifdef USE_APPLE_ACCELERATE
       vDSP_vadd(dptr, 1, fptr, 1, dptr, 1, size_);
 #else
-      for ( unsigned int i=0; i<size_; i++ )
-        *dptr++ += *fptr++;
+      vectorKernels().add(dptr, fptr, size_);
 #endif
       
     }
-    else if (nChannels_ < fChannels){
+    else{
       
-      //  just add first channel of rhs
+      // mono rhs is added to every channel, otherwise channels are added pairwise
+      unsigned int nApply = fChannels == 1 ? nChannels_ : (nChannels_ < fChannels ? nChannels_ : fChannels);
+      for (unsigned int c=0; c<nApply; c++, dptr += nFrames_){
+        if (fChannels > 1) fptr = f.channelData(c);
 #ifdef USE_APPLE_ACCELERATE
-      vDSP_vadd(dptr, 1, fptr, fChannels, dptr, 1, nFrames_);
+        vDSP_vadd(dptr, 1, fptr, 1, dptr, 1, nFrames_);
 #else
-      for ( unsigned int i=0; i<nFrames_; i++ ){
-        *dptr++ -= *fptr++;
-        fptr++;
-      }
+        vectorKernels().add(dptr, fptr, nFrames_);
 #endif
-      
-    }
-    else{
-      //  add rhs to both channels
-#ifdef USE_APPLE_ACCELERATE
-      vDSP_vadd(dptr, 2, fptr, 1, dptr, 2, nFrames_);
-      vDSP_vadd(dptr+1, 2, fptr, 1, dptr+1, 2, nFrames_);
-#else
-      for ( unsigned int i=0; i<nFrames_; i++ ){
-        *dptr++ += *fptr;
-        *dptr++ += *fptr++;
       }
-#endif
+      
     }
     
   }
   
   
-  inline void TonicFrames :: operator -= ( TonicFrames& f )
+  inline void TonicFrames :: operator-= ( const TonicFrames& f )
   {
   #if defined(TONIC_DEBUG)
     if ( f.frames() != nFrames_ ) {
@@ -381,7 +401,7 @@ namespace Tonic {
   #endif
 
     
-    TonicFloat *fptr = &f[0];
+    const TonicFloat *fptr = f.data_;
     TonicFloat *dptr = data_;
 
     unsigned int fChannels = f.channels();
@@ -391,41 +411,29 @@ namespace Tonic {
 #ifdef USE_APPLE_ACCELERATE
       vDSP_vsub(fptr, 1, dptr, 1, dptr, 1, size_);
 #else
-      for ( unsigned int i=0; i<size_; i++ )
-        *dptr++ -= *fptr++;
+      vectorKernels().subtract(dptr, fptr, size_);
 #endif
     }
-    else if (nChannels_ < fChannels){
+    else{
       
-      //  just subtract first channel of rhs
+      // mono rhs is subtracted from every channel, otherwise channels are subtracted pairwise
+      unsigned int nApply = fChannels == 1 ? nChannels_ : (nChannels_ < fChannels ? nChannels_ : fChannels);
+      for (unsigned int c=0; c<nApply; c++, dptr += nFrames_){
+        if (fChannels > 1) fptr = f.channelData(c);
 #ifdef USE_APPLE_ACCELERATE
-      vDSP_vsub(dptr, 1, fptr, fChannels, dptr, 1, nFrames_);
+        vDSP_vsub(fptr, 1, dptr, 1, dptr, 1, nFrames_);
 #else
-      for ( unsigned int i=0; i<nFrames_; i++ ){
-        *dptr++ -= *fptr++;
-        fptr++;
-      }
+        vectorKernels().subtract(dptr, fptr, nFrames_);
 #endif
-      
-    }
-    else{
-      //  subtract both channels by rhs
-#ifdef USE_APPLE_ACCELERATE
-      vDSP_vsub(dptr, 2, fptr, 1, dptr, 2, nFrames_);
-      vDSP_vsub(dptr+1, 2, fptr, 1, dptr+1, 2, nFrames_);
-#else
-      for ( unsigned int i=0; i<nFrames_; i++ ){
-        *dptr++ -= *fptr;
-        *dptr++ -= *fptr++;
       }
-#endif
+      
     }
 
 
   }
   
 
-  inline void TonicFrames :: operator*= ( TonicFrames& f )
+  inline void TonicFrames :: operator*= ( const TonicFrames& f )
   {
     
 #if defined(TONIC_DEBUG)
@@ -436,7 +444,7 @@ namespace Tonic {
     }
 #endif
     
-    TonicFloat *fptr = &f[0];
+    const TonicFloat *fptr = f.data_;
     TonicFloat *dptr = data_;
 
     unsigned int fChannels = f.channels();
@@ -446,41 +454,28 @@ namespace Tonic {
 #ifdef USE_APPLE_ACCELERATE
       vDSP_vmul(dptr, 1, fptr, 1, dptr, 1, size_);
 #else
-      for ( unsigned int i=0; i<size_; i++ ){
-        *dptr++ *= *fptr++;
-      }
+      vectorKernels().multiply(dptr, fptr, size_);
 #endif
       
     }
-    else if (nChannels_ < fChannels){
+    else{
       
-      //  just multiply by first channel of rhs
+      // every channel is multiplied by mono rhs, otherwise channels are multiplied pairwise
+      unsigned int nApply = fChannels == 1 ? nChannels_ : (nChannels_ < fChannels ? nChannels_ : fChannels);
+      for (unsigned int c=0; c<nApply; c++, dptr += nFrames_){
+        if (fChannels > 1) fptr = f.channelData(c);
 #ifdef USE_APPLE_ACCELERATE
-      vDSP_vmul(dptr, 1, fptr, fChannels, dptr, 1, nFrames_);
+        vDSP_vmul(dptr, 1, fptr, 1, dptr, 1, nFrames_);
 #else
-      for ( unsigned int i=0; i<nFrames_; i++ ){
-        *dptr++ *= *fptr++;
-        fptr++;
-      }
+        vectorKernels().multiply(dptr, fptr, nFrames_);
 #endif
-
-    }
-    else{
-      //  multiply both channels by rhs
-#ifdef USE_APPLE_ACCELERATE
-      vDSP_vmul(dptr, 2, fptr, 1, dptr, 2, nFrames_);
-      vDSP_vmul(dptr+1, 2, fptr, 1, dptr+1, 2, nFrames_);
-#else
-      for ( unsigned int i=0; i<nFrames_; i++ ){
-        *dptr++ *= *fptr;
-        *dptr++ *= *fptr++;
       }
-#endif
+
     }
   }
 
 
-  inline void TonicFrames :: operator /= ( TonicFrames& f )
+  inline void TonicFrames :: operator/= ( const TonicFrames& f )
   {
   #if defined(TONIC_DEBUG)
     if ( f.frames() != nFrames_ ) {
@@ -490,7 +485,7 @@ namespace Tonic {
     }
   #endif
     
-    TonicFloat *fptr = &f[0];
+    const TonicFloat *fptr = f.data_;
     TonicFloat *dptr = data_;
     
     unsigned int fChannels = f.channels();
@@ -500,39 +495,124 @@ namespace Tonic {
 #ifdef USE_APPLE_ACCELERATE
       vDSP_vdiv(fptr, 1, dptr, 1, dptr, 1, size_);
 #else
-      for ( unsigned int i=0; i<size_; i++ ){
-        *dptr++ /= *fptr++;
-      }
+      vectorKernels().divide(dptr, fptr, size_);
 #endif
       
     }
-    else if (nChannels_ < fChannels){
+    else{
       
-      //  just multiply by first channel of rhs
+      // every channel is divided by mono rhs, otherwise channels are divided pairwise
+      unsigned int nApply = fChannels == 1 ? nChannels_ : (nChannels_ < fChannels ? nChannels_ : fChannels);
+      for (unsigned int c=0; c<nApply; c++, dptr += nFrames_){
+        if (fChannels > 1) fptr = f.channelData(c);
 #ifdef USE_APPLE_ACCELERATE
-      vDSP_vdiv(fptr, fChannels, dptr, 1, dptr, 1, nFrames_);
+        vDSP_vdiv(fptr, 1, dptr, 1, dptr, 1, nFrames_);
 #else
-      for ( unsigned int i=0; i<nFrames_; i++ ){
-        *dptr++ /= *fptr++;
-        fptr++;
-      }
+        vectorKernels().divide(dptr, fptr, nFrames_);
 #endif
+      }
       
     }
+  }
+
+  inline void TonicFrames :: operator+= ( TonicFloat value )
+  {
+#ifdef USE_APPLE_ACCELERATE
+    vDSP_vsadd(data_, 1, &value, data_, 1, size_);
+#else
+    vectorKernels().addScalar(data_, value, size_);
+#endif
+  }
+
+  inline void TonicFrames :: operator-= ( TonicFloat value )
+  {
+#ifdef USE_APPLE_ACCELERATE
+    TonicFloat negValue = -value;
+    vDSP_vsadd(data_, 1, &negValue, data_, 1, size_);
+#else
+    vectorKernels().subtractScalar(data_, value, size_);
+#endif
+  }
+
+  inline void TonicFrames :: operator*= ( TonicFloat value )
+  {
+#ifdef USE_APPLE_ACCELERATE
+    vDSP_vsmul(data_, 1, &value, data_, 1, size_);
+#else
+    vectorKernels().multiplyScalar(data_, value, size_);
+#endif
+  }
+
+  inline void TonicFrames :: operator/= ( TonicFloat value )
+  {
+#ifdef USE_APPLE_ACCELERATE
+    vDSP_vsdiv(data_, 1, &value, data_, 1, size_);
+#else
+    vectorKernels().divideScalar(data_, value, size_);
+#endif
+  }
+
+  inline void TonicFrames::fill( TonicFloat value ){
+#ifdef USE_APPLE_ACCELERATE
+    vDSP_vfill(&value, data_, 1, size_);
+#else
+    vectorKernels().fill(data_, value, size_);
+#endif
+  }
+
+  inline void TonicFrames::copyScaled( const TonicFrames & f, TonicFloat gain ){
+
+    if (nChannels_ == f.channels()){
+#ifdef USE_APPLE_ACCELERATE
+      vDSP_vsmul(f.data_, 1, &gain, data_, 1, size_);
+#else
+      vectorKernels().copyScaled(data_, f.data_, gain, size_);
+#endif
+    }
+    else{
+      copy(f);
+      *this *= gain;
+    }
+
+  }
+
+  inline void TonicFrames::addScaled( const TonicFrames & f, TonicFloat gain ){
+
+#if defined(TONIC_DEBUG)
+    if ( f.frames() != nFrames_ ) {
+      std::ostringstream error;
+      error << "TonicFrames::addScaled: frames argument must be of equal dimensions!";
+      Tonic::error(error.str(), true);
+    }
+#endif
+
+    const TonicFloat *fptr = f.data_;
+    TonicFloat *dptr = data_;
+
+    unsigned int fChannels = f.channels();
+
+    if (nChannels_ == fChannels){
+#ifdef USE_APPLE_ACCELERATE
+      vDSP_vsma(fptr, 1, &gain, dptr, 1, dptr, 1, size_);
+#else
+      vectorKernels().addScaled(dptr, fptr, gain, size_);
+#endif
+    }
     else{
-      //  multiply both channels by rhs
+      // mono rhs is added to every channel, otherwise channels are added pairwise
+      unsigned int nApply = fChannels == 1 ? nChannels_ : (nChannels_ < fChannels ? nChannels_ : fChannels);
+      for (unsigned int c=0; c<nApply; c++, dptr += nFrames_){
+        if (fChannels > 1) fptr = f.channelData(c);
 #ifdef USE_APPLE_ACCELERATE
-      vDSP_vdiv(fptr, 2, dptr, 1, dptr, 2, nFrames_);
-      vDSP_vdiv(fptr, 2, dptr+1, 1, dptr+1, 2, nFrames_);
+        vDSP_vsma(fptr, 1, &gain, dptr, 1, dptr, 1, nFrames_);
 #else
-      for ( unsigned int i=0; i<nFrames_; i++ ){
-        *dptr++ /= *fptr;
-        *dptr++ /= *fptr++;
-      }
+        vectorKernels().addScaled(dptr, fptr, gain, nFrames_);
 #endif
+      }
     }
+
   }
-  
+
 }
 
 #endif
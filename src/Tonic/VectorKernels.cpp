@@ -0,0 +1,359 @@
+//
+//  VectorKernels.cpp
+//  Tonic
+//
+//
+// See LICENSE.txt for license and usage information.
+//
+
+#include "VectorKernels.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+  #include <immintrin.h>
+  #if defined(__SSE2__)
+    #define TONIC_VECTOR_KERNELS_SSE2
+  #endif
+  // built with a target attribute whatever the compiler flags, and only used if the CPU reports it
+  #define TONIC_VECTOR_KERNELS_AVX2
+#elif defined(_MSC_VER) && (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+  #include <emmintrin.h>
+  #define TONIC_VECTOR_KERNELS_SSE2
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+  // 32-bit NEON flushes denormals regardless of the FPU mode, so would not match the scalar kernels
+  #include <arm_neon.h>
+  #define TONIC_VECTOR_KERNELS_NEON
+#endif
+
+/*
+  Defines the kernels for one instruction set as PREFIX##Add etc, from its vector type, width and
+  unaligned load/store, broadcast, arithmetic and phase wrapping intrinsics. ATTR goes in front of every
+  function (e.g. a target attribute). Two vectors are processed per iteration, then one, then the
+  remaining samples one at a time.
+*/
+
+#define TONIC_VECTOR_BINARY_KERNEL(ATTR, NAME, V, W, LOAD, STORE, OP, SCALAR_OP) \
+  ATTR static void NAME( TonicFloat * dst, const TonicFloat * src, size_t length ){ \
+    size_t i = 0; \
+    for (; i + 2*W <= length; i += 2*W){ \
+      V a = OP(LOAD(dst + i), LOAD(src + i)); \
+      V b = OP(LOAD(dst + i + W), LOAD(src + i + W)); \
+      STORE(dst + i, a); \
+      STORE(dst + i + W, b); \
+    } \
+    for (; i + W <= length; i += W){ \
+      STORE(dst + i, OP(LOAD(dst + i), LOAD(src + i))); \
+    } \
+    for (; i < length; i++) dst[i] SCALAR_OP src[i]; \
+  }
+
+#define TONIC_VECTOR_SCALAR_KERNEL(ATTR, NAME, V, W, LOAD, STORE, SET1, OP, SCALAR_OP) \
+  ATTR static void NAME( TonicFloat * dst, TonicFloat value, size_t length ){ \
+    const V v = SET1(value); \
+    size_t i = 0; \
+    for (; i + 2*W <= length; i += 2*W){ \
+      V a = OP(LOAD(dst + i), v); \
+      V b = OP(LOAD(dst + i + W), v); \
+      STORE(dst + i, a); \
+      STORE(dst + i + W, b); \
+    } \
+    for (; i + W <= length; i += W){ \
+      STORE(dst + i, OP(LOAD(dst + i), v)); \
+    } \
+    for (; i < length; i++) dst[i] SCALAR_OP value; \
+  }
+
+// Odd polynomial for sin(2 pi t), t in [-0.5, 0.5], fitted for the smallest largest error (7e-7)
+#define TONIC_SINE_BANK_C1   6.28318262f
+#define TONIC_SINE_BANK_C3  -41.341423f
+#define TONIC_SINE_BANK_C5   81.5961838f
+#define TONIC_SINE_BANK_C7  -76.580101f
+#define TONIC_SINE_BANK_C9   41.2054024f
+#define TONIC_SINE_BANK_C11 -12.2712727f
+
+/*
+  Each vector of W partials is run through a chunk of samples at a time, its phases and amplitudes held
+  in registers, adding into one lane sum per sample and lane. sin(2 pi phase) = -sin(2 pi (phase - 0.5)),
+  so the polynomial of phase - 0.5 is subtracted. WRAP(x) subtracts 1 from lanes of x that are >= 1.
+*/
+#define TONIC_VECTOR_SINE_BANK_KERNEL(ATTR, NAME, V, W, LOAD, STORE, SET1, ADD, SUB, MUL, WRAP) \
+  ATTR static void NAME( TonicFloat * dst, size_t length, TonicFloat * phase, const TonicFloat * increment, \
+                         TonicFloat * amplitude, const TonicFloat * amplitudeStep, size_t numPartials ){ \
+    const size_t lanes = VectorKernels::kSineBankLanes; \
+    const size_t chunkLength = 64; \
+    TonicFloat sums[chunkLength * VectorKernels::kSineBankLanes]; \
+    const V half = SET1(0.5f); \
+    const V c1 = SET1(TONIC_SINE_BANK_C1), c3 = SET1(TONIC_SINE_BANK_C3), c5 = SET1(TONIC_SINE_BANK_C5); \
+    const V c7 = SET1(TONIC_SINE_BANK_C7), c9 = SET1(TONIC_SINE_BANK_C9), c11 = SET1(TONIC_SINE_BANK_C11); \
+    for (size_t start = 0; start < length; start += chunkLength){ \
+      const size_t n = length - start < chunkLength ? length - start : chunkLength; \
+      for (size_t i = 0; i < n * lanes; i++) sums[i] = 0; \
+      for (size_t p = 0; p + W <= numPartials; p += W){ \
+        V ph = LOAD(phase + p); \
+        V amp = LOAD(amplitude + p); \
+        const V inc = LOAD(increment + p); \
+        const V step = LOAD(amplitudeStep + p); \
+        TonicFloat * laneSums = sums + p % lanes; \
+        for (size_t i = 0; i < n; i++){ \
+          const V t = SUB(ph, half); \
+          const V t2 = MUL(t, t); \
+          V poly = ADD(MUL(c11, t2), c9); \
+          poly = ADD(MUL(poly, t2), c7); \
+          poly = ADD(MUL(poly, t2), c5); \
+          poly = ADD(MUL(poly, t2), c3); \
+          poly = ADD(MUL(poly, t2), c1); \
+          poly = MUL(poly, t); \
+          STORE(laneSums + i * lanes, SUB(LOAD(laneSums + i * lanes), MUL(amp, poly))); \
+          ph = WRAP(ADD(ph, inc)); \
+          amp = ADD(amp, step); \
+        } \
+        STORE(phase + p, ph); \
+        STORE(amplitude + p, amp); \
+      } \
+      for (size_t i = 0; i < n; i++){ \
+        const TonicFloat * s = sums + i * lanes; \
+        dst[start + i] = ((s[0] + s[1]) + (s[2] + s[3])) + ((s[4] + s[5]) + (s[6] + s[7])); \
+      } \
+    } \
+  }
+
+/*
+  FFT passes. The butterfly of element k is written once for vectors of W elements and once more, with
+  the scalar helpers, for the last stride % W - the same operations either way. A complex product
+  (ar + i ai)(wr + i wi) is always (ar wr - ai wi) + i(ar wi + ai wr). A pass whose stride is shorter
+  than a vector would be all scalar, so goes to NARROWER's kernels instead (e.g. SSE2's for AVX2).
+*/
+#define TONIC_FFT_RADIX2_BUTTERFLY(V, LOAD, STORE, ADD, SUB, MUL, WR, WI) { \
+    const V ar = LOAD(aReal + k), ai = LOAD(aImag + k), br = LOAD(bReal + k), bi = LOAD(bImag + k); \
+    STORE(y0Real + k, ADD(ar, br)); \
+    STORE(y0Imag + k, ADD(ai, bi)); \
+    const V dr = SUB(ar, br), di = SUB(ai, bi); \
+    STORE(y1Real + k, SUB(MUL(dr, WR), MUL(di, WI))); \
+    STORE(y1Imag + k, ADD(MUL(dr, WI), MUL(di, WR))); \
+  }
+
+#define TONIC_VECTOR_FFT_RADIX2_KERNEL(ATTR, NAME, V, W, LOAD, STORE, SET1, ADD, SUB, MUL, NARROWER) \
+  ATTR static void NAME( const TonicFloat * xReal, const TonicFloat * xImag, TonicFloat * yReal, TonicFloat * yImag, \
+                         size_t stride, size_t span, const TonicFloat * twiddleReal, const TonicFloat * twiddleImag ){ \
+    if (stride < W){ \
+      NARROWER##FFTRadix2(xReal, xImag, yReal, yImag, stride, span, twiddleReal, twiddleImag); \
+      return; \
+    } \
+    for (size_t q = 0; q < span; q++){ \
+      const TonicFloat * aReal = xReal + stride * q, * aImag = xImag + stride * q; \
+      const TonicFloat * bReal = aReal + stride * span, * bImag = aImag + stride * span; \
+      TonicFloat * y0Real = yReal + stride * 2 * q, * y0Imag = yImag + stride * 2 * q; \
+      TonicFloat * y1Real = y0Real + stride, * y1Imag = y0Imag + stride; \
+      const TonicFloat wr = twiddleReal[q], wi = twiddleImag[q]; \
+      const V vwr = SET1(wr), vwi = SET1(wi); \
+      size_t k = 0; \
+      for (; k + W <= stride; k += W) TONIC_FFT_RADIX2_BUTTERFLY(V, LOAD, STORE, ADD, SUB, MUL, vwr, vwi) \
+      for (; k < stride; k++) TONIC_FFT_RADIX2_BUTTERFLY(TonicFloat, scalarLoad, scalarStore, scalarAdd, scalarSub, scalarMul, wr, wi) \
+    } \
+  }
+
+// -i times (t1, t3) for the forward 4-point DFT: b1 = t1 - i t3, b3 = t1 + i t3
+#define TONIC_FFT_RADIX4_BUTTERFLY(V, LOAD, STORE, ADD, SUB, MUL, W1R, W1I, W2R, W2I, W3R, W3I) { \
+    const V a0r = LOAD(x0Real + k), a0i = LOAD(x0Imag + k), a1r = LOAD(x1Real + k), a1i = LOAD(x1Imag + k); \
+    const V a2r = LOAD(x2Real + k), a2i = LOAD(x2Imag + k), a3r = LOAD(x3Real + k), a3i = LOAD(x3Imag + k); \
+    const V t0r = ADD(a0r, a2r), t0i = ADD(a0i, a2i), t1r = SUB(a0r, a2r), t1i = SUB(a0i, a2i); \
+    const V t2r = ADD(a1r, a3r), t2i = ADD(a1i, a3i), t3r = SUB(a1r, a3r), t3i = SUB(a1i, a3i); \
+    STORE(y0Real + k, ADD(t0r, t2r)); \
+    STORE(y0Imag + k, ADD(t0i, t2i)); \
+    const V b1r = ADD(t1r, t3i), b1i = SUB(t1i, t3r); \
+    const V b2r = SUB(t0r, t2r), b2i = SUB(t0i, t2i); \
+    const V b3r = SUB(t1r, t3i), b3i = ADD(t1i, t3r); \
+    STORE(y1Real + k, SUB(MUL(b1r, W1R), MUL(b1i, W1I))); \
+    STORE(y1Imag + k, ADD(MUL(b1r, W1I), MUL(b1i, W1R))); \
+    STORE(y2Real + k, SUB(MUL(b2r, W2R), MUL(b2i, W2I))); \
+    STORE(y2Imag + k, ADD(MUL(b2r, W2I), MUL(b2i, W2R))); \
+    STORE(y3Real + k, SUB(MUL(b3r, W3R), MUL(b3i, W3I))); \
+    STORE(y3Imag + k, ADD(MUL(b3r, W3I), MUL(b3i, W3R))); \
+  }
+
+#define TONIC_VECTOR_FFT_RADIX4_KERNEL(ATTR, NAME, V, W, LOAD, STORE, SET1, ADD, SUB, MUL, NARROWER) \
+  ATTR static void NAME( const TonicFloat * xReal, const TonicFloat * xImag, TonicFloat * yReal, TonicFloat * yImag, \
+                         size_t stride, size_t span, const TonicFloat * twiddleReal, const TonicFloat * twiddleImag ){ \
+    if (stride < W){ \
+      NARROWER##FFTRadix4(xReal, xImag, yReal, yImag, stride, span, twiddleReal, twiddleImag); \
+      return; \
+    } \
+    const size_t quarter = stride * span; \
+    for (size_t q = 0; q < span; q++){ \
+      const TonicFloat * x0Real = xReal + stride * q, * x0Imag = xImag + stride * q; \
+      const TonicFloat * x1Real = x0Real + quarter, * x1Imag = x0Imag + quarter; \
+      const TonicFloat * x2Real = x1Real + quarter, * x2Imag = x1Imag + quarter; \
+      const TonicFloat * x3Real = x2Real + quarter, * x3Imag = x2Imag + quarter; \
+      TonicFloat * y0Real = yReal + stride * 4 * q, * y0Imag = yImag + stride * 4 * q; \
+      TonicFloat * y1Real = y0Real + stride, * y1Imag = y0Imag + stride; \
+      TonicFloat * y2Real = y1Real + stride, * y2Imag = y1Imag + stride; \
+      TonicFloat * y3Real = y2Real + stride, * y3Imag = y2Imag + stride; \
+      const TonicFloat w1r = twiddleReal[3 * q], w2r = twiddleReal[3 * q + 1], w3r = twiddleReal[3 * q + 2]; \
+      const TonicFloat w1i = twiddleImag[3 * q], w2i = twiddleImag[3 * q + 1], w3i = twiddleImag[3 * q + 2]; \
+      const V v1r = SET1(w1r), v2r = SET1(w2r), v3r = SET1(w3r), v1i = SET1(w1i), v2i = SET1(w2i), v3i = SET1(w3i); \
+      size_t k = 0; \
+      for (; k + W <= stride; k += W) TONIC_FFT_RADIX4_BUTTERFLY(V, LOAD, STORE, ADD, SUB, MUL, v1r, v1i, v2r, v2i, v3r, v3i) \
+      for (; k < stride; k++) TONIC_FFT_RADIX4_BUTTERFLY(TonicFloat, scalarLoad, scalarStore, scalarAdd, scalarSub, scalarMul, w1r, w1i, w2r, w2i, w3r, w3i) \
+    } \
+  }
+
+#define TONIC_DEFINE_VECTOR_KERNELS(ATTR, PREFIX, V, W, LOAD, STORE, SET1, ADD, SUB, MUL, DIV, WRAP, NARROWER) \
+  TONIC_VECTOR_BINARY_KERNEL(ATTR, PREFIX##Add, V, W, LOAD, STORE, ADD, +=) \
+  TONIC_VECTOR_BINARY_KERNEL(ATTR, PREFIX##Subtract, V, W, LOAD, STORE, SUB, -=) \
+  TONIC_VECTOR_BINARY_KERNEL(ATTR, PREFIX##Multiply, V, W, LOAD, STORE, MUL, *=) \
+  TONIC_VECTOR_BINARY_KERNEL(ATTR, PREFIX##Divide, V, W, LOAD, STORE, DIV, /=) \
+  TONIC_VECTOR_SCALAR_KERNEL(ATTR, PREFIX##AddScalar, V, W, LOAD, STORE, SET1, ADD, +=) \
+  TONIC_VECTOR_SCALAR_KERNEL(ATTR, PREFIX##SubtractScalar, V, W, LOAD, STORE, SET1, SUB, -=) \
+  TONIC_VECTOR_SCALAR_KERNEL(ATTR, PREFIX##MultiplyScalar, V, W, LOAD, STORE, SET1, MUL, *=) \
+  TONIC_VECTOR_SCALAR_KERNEL(ATTR, PREFIX##DivideScalar, V, W, LOAD, STORE, SET1, DIV, /=) \
+  ATTR static void PREFIX##CopyScaled( TonicFloat * dst, const TonicFloat * src, TonicFloat gain, size_t length ){ \
+    const V g = SET1(gain); \
+    size_t i = 0; \
+    for (; i + W <= length; i += W){ \
+      STORE(dst + i, MUL(LOAD(src + i), g)); \
+    } \
+    for (; i < length; i++) dst[i] = src[i] * gain; \
+  } \
+  ATTR static void PREFIX##AddScaled( TonicFloat * dst, const TonicFloat * src, TonicFloat gain, size_t length ){ \
+    const V g = SET1(gain); \
+    size_t i = 0; \
+    for (; i + W <= length; i += W){ \
+      STORE(dst + i, ADD(LOAD(dst + i), MUL(LOAD(src + i), g))); \
+    } \
+    for (; i < length; i++) dst[i] += src[i] * gain; \
+  } \
+  ATTR static void PREFIX##Fill( TonicFloat * dst, TonicFloat value, size_t length ){ \
+    const V v = SET1(value); \
+    size_t i = 0; \
+    for (; i + W <= length; i += W){ \
+      STORE(dst + i, v); \
+    } \
+    for (; i < length; i++) dst[i] = value; \
+  } \
+  TONIC_VECTOR_SINE_BANK_KERNEL(ATTR, PREFIX##SineBank, V, W, LOAD, STORE, SET1, ADD, SUB, MUL, WRAP) \
+  ATTR static void PREFIX##ComplexMultiplyAdd( TonicFloat * dstReal, TonicFloat * dstImag, const TonicFloat * aReal, const TonicFloat * aImag, \
+                                               const TonicFloat * bReal, const TonicFloat * bImag, size_t length ){ \
+    size_t i = 0; \
+    for (; i + W <= length; i += W){ \
+      const V ar = LOAD(aReal + i), ai = LOAD(aImag + i), br = LOAD(bReal + i), bi = LOAD(bImag + i); \
+      STORE(dstReal + i, ADD(LOAD(dstReal + i), SUB(MUL(ar, br), MUL(ai, bi)))); \
+      STORE(dstImag + i, ADD(LOAD(dstImag + i), ADD(MUL(ar, bi), MUL(ai, br)))); \
+    } \
+    for (; i < length; i++){ \
+      dstReal[i] += aReal[i] * bReal[i] - aImag[i] * bImag[i]; \
+      dstImag[i] += aReal[i] * bImag[i] + aImag[i] * bReal[i]; \
+    } \
+  } \
+  TONIC_VECTOR_FFT_RADIX2_KERNEL(ATTR, PREFIX##FFTRadix2, V, W, LOAD, STORE, SET1, ADD, SUB, MUL, NARROWER) \
+  TONIC_VECTOR_FFT_RADIX4_KERNEL(ATTR, PREFIX##FFTRadix4, V, W, LOAD, STORE, SET1, ADD, SUB, MUL, NARROWER) \
+  static const VectorKernels PREFIX##Kernels = { \
+    #PREFIX, \
+    PREFIX##Add, PREFIX##Subtract, PREFIX##Multiply, PREFIX##Divide, \
+    PREFIX##AddScalar, PREFIX##SubtractScalar, PREFIX##MultiplyScalar, PREFIX##DivideScalar, \
+    PREFIX##CopyScaled, PREFIX##AddScaled, PREFIX##Fill, \
+    PREFIX##SineBank, \
+    PREFIX##ComplexMultiplyAdd, \
+    PREFIX##FFTRadix2, PREFIX##FFTRadix4 \
+  };
+
+namespace Tonic {
+
+  // -- scalar: one sample is a "vector" of width 1 --
+
+  static inline TonicFloat scalarLoad( const TonicFloat * p ) { return *p; }
+  static inline void scalarStore( TonicFloat * p, TonicFloat v ) { *p = v; }
+  static inline TonicFloat scalarSet1( TonicFloat v ) { return v; }
+  static inline TonicFloat scalarAdd( TonicFloat a, TonicFloat b ) { return a + b; }
+  static inline TonicFloat scalarSub( TonicFloat a, TonicFloat b ) { return a - b; }
+  static inline TonicFloat scalarMul( TonicFloat a, TonicFloat b ) { return a * b; }
+  static inline TonicFloat scalarDiv( TonicFloat a, TonicFloat b ) { return a / b; }
+  static inline TonicFloat scalarWrap( TonicFloat a ) { return a >= 1.f ? a - 1.f : a; }
+
+  // a stride is never shorter than one, so the scalar FFT passes never hand on
+  TONIC_DEFINE_VECTOR_KERNELS(, scalar, TonicFloat, 1, scalarLoad, scalarStore, scalarSet1, scalarAdd, scalarSub, scalarMul, scalarDiv, scalarWrap, scalar)
+
+#ifdef TONIC_VECTOR_KERNELS_SSE2
+  static inline __m128 sse2Wrap( __m128 a ){
+    const __m128 one = _mm_set1_ps(1.f);
+    return _mm_sub_ps(a, _mm_and_ps(_mm_cmpge_ps(a, one), one));
+  }
+
+  TONIC_DEFINE_VECTOR_KERNELS(, sse2, __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_set1_ps, _mm_add_ps, _mm_sub_ps, _mm_mul_ps, _mm_div_ps, sse2Wrap, scalar)
+#endif
+
+#ifdef TONIC_VECTOR_KERNELS_AVX2
+  __attribute__((target("avx2"))) static inline __m256 avx2Wrap( __m256 a ){
+    const __m256 one = _mm256_set1_ps(1.f);
+    return _mm256_sub_ps(a, _mm256_and_ps(_mm256_cmp_ps(a, one, _CMP_GE_OQ), one));
+  }
+
+  // FFT passes with strides of 4 are common (the second pass of any power of two), and SSE2 does them whole
+  #ifdef TONIC_VECTOR_KERNELS_SSE2
+    #define TONIC_AVX2_NARROWER_KERNELS sse2
+  #else
+    #define TONIC_AVX2_NARROWER_KERNELS scalar
+  #endif
+
+  TONIC_DEFINE_VECTOR_KERNELS(__attribute__((target("avx2"))), avx2, __m256, 8,
+                              _mm256_loadu_ps, _mm256_storeu_ps, _mm256_set1_ps, _mm256_add_ps, _mm256_sub_ps, _mm256_mul_ps, _mm256_div_ps, avx2Wrap,
+                              TONIC_AVX2_NARROWER_KERNELS)
+#endif
+
+#ifdef TONIC_VECTOR_KERNELS_NEON
+  static inline float32x4_t neonWrap( float32x4_t a ){
+    const float32x4_t one = vdupq_n_f32(1.f);
+    return vsubq_f32(a, vreinterpretq_f32_u32(vandq_u32(vcgeq_f32(a, one), vreinterpretq_u32_f32(one))));
+  }
+
+  TONIC_DEFINE_VECTOR_KERNELS(, neon, float32x4_t, 4, vld1q_f32, vst1q_f32, vdupq_n_f32, vaddq_f32, vsubq_f32, vmulq_f32, vdivq_f32, neonWrap, scalar)
+#endif
+
+  vector<const VectorKernels *> availableVectorKernels(){
+
+    vector<const VectorKernels *> kernels;
+    kernels.push_back(&scalarKernels);
+
+#ifdef TONIC_VECTOR_KERNELS_SSE2
+    kernels.push_back(&sse2Kernels);
+#endif
+
+#ifdef TONIC_VECTOR_KERNELS_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")){
+      kernels.push_back(&avx2Kernels);
+    }
+#endif
+
+#ifdef TONIC_VECTOR_KERNELS_NEON
+    kernels.push_back(&neonKernels);
+#endif
+
+    return kernels;
+  }
+
+  bool setVectorKernels( const string & name ){
+    vector<const VectorKernels *> kernels = availableVectorKernels();
+    for (unsigned int i=0; i<kernels.size(); i++){
+      if (name == kernels[i]->name){
+        Tonic_::activeVectorKernels_ = kernels[i];
+        return true;
+      }
+    }
+    return false;
+  }
+
+  namespace Tonic_ {
+
+    // Statically initialized, so TonicFrames used by other files' static initializers always find kernels.
+    // The widest available replace them during dynamic initialization, below.
+    const VectorKernels * activeVectorKernels_ = &scalarKernels;
+
+    static const VectorKernels * selectWidestVectorKernels(){
+      activeVectorKernels_ = availableVectorKernels().back();
+      return activeVectorKernels_;
+    }
+
+    static const VectorKernels * const initialVectorKernels_ = selectWidestVectorKernels();
+
+  }
+
+}
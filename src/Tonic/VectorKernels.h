@@ -0,0 +1,107 @@
+//
+//  VectorKernels.h
+//  Tonic
+//
+//
+// See LICENSE.txt for license and usage information.
+//
+
+#ifndef TONIC_VECTORKERNELS_H
+#define TONIC_VECTORKERNELS_H
+
+#include "TonicCore.h"
+
+/*
+  Contiguous kernels behind TonicFrames arithmetic, OscillatorBank, FFT and ConvolutionReverb, implemented once per instruction set
+  (plain C++, SSE2, AVX2, NEON) and picked once, at startup, for the CPU the library is running on.
+
+  Every implementation performs the same single-precision operations in the same order - no fused
+  multiply-adds, no reciprocal approximations - so all of them produce identical output to the scalar one.
+
+  Apple builds using Accelerate call vDSP instead, where it has an equivalent.
+*/
+
+namespace Tonic {
+
+  //! One implementation of every kernel. dst and src may be identical, but must not otherwise overlap.
+  struct VectorKernels {
+
+    //! Short lowercase name, e.g. "scalar" or "avx2"
+    const char * name;
+
+    void (*add)( TonicFloat * dst, const TonicFloat * src, size_t length );
+    void (*subtract)( TonicFloat * dst, const TonicFloat * src, size_t length );
+    void (*multiply)( TonicFloat * dst, const TonicFloat * src, size_t length );
+    void (*divide)( TonicFloat * dst, const TonicFloat * src, size_t length );
+
+    void (*addScalar)( TonicFloat * dst, TonicFloat value, size_t length );
+    void (*subtractScalar)( TonicFloat * dst, TonicFloat value, size_t length );
+    void (*multiplyScalar)( TonicFloat * dst, TonicFloat value, size_t length );
+    void (*divideScalar)( TonicFloat * dst, TonicFloat value, size_t length );
+
+    //! dst = src * gain
+    void (*copyScaled)( TonicFloat * dst, const TonicFloat * src, TonicFloat gain, size_t length );
+    //! dst += src * gain
+    void (*addScaled)( TonicFloat * dst, const TonicFloat * src, TonicFloat gain, size_t length );
+
+    void (*fill)( TonicFloat * dst, TonicFloat value, size_t length );
+
+    //! Partials summed by sineBank are processed in groups of this many
+    static const size_t kSineBankLanes = 8;
+
+    //! dst = the sum of numPartials sine waves, given in structure-of-arrays form
+    /*!
+        Partial p is amplitude[p] * sin(2 pi phase[p]), with phase in cycles. After each sample, phase[p]
+        advances by increment[p] and wraps, and amplitude[p] by amplitudeStep[p]; both arrays are left
+        where the next block starts. Phases and increments must be in [0, 1). numPartials must be a
+        multiple of kSineBankLanes - pad with silent partials.
+
+        Partial p is added to lane p % kSineBankLanes, and the lanes are summed last, in the same order
+        by every implementation.
+     */
+    void (*sineBank)( TonicFloat * dst, size_t length, TonicFloat * phase, const TonicFloat * increment,
+                      TonicFloat * amplitude, const TonicFloat * amplitudeStep, size_t numPartials );
+
+    //! dst += a * b, for complex values in separate arrays of real and imaginary parts
+    void (*complexMultiplyAdd)( TonicFloat * dstReal, TonicFloat * dstImag, const TonicFloat * aReal, const TonicFloat * aImag,
+                                const TonicFloat * bReal, const TonicFloat * bImag, size_t length );
+
+    //! One radix-2 pass of a Stockham FFT on split complex data (see FFT)
+    /*!
+        For every q < span and k < stride, with a = x[k + stride * q] and b = x[k + stride * (q + span)]:
+        y[k + stride * 2q] = a + b and y[k + stride * (2q + 1)] = (a - b) * twiddle[q]. x and y are
+        arrays of real and imaginary parts, and y must not overlap x. Vectorized across k, so strides shorter
+        than a vector use the next narrower kernels.
+     */
+    void (*fftRadix2)( const TonicFloat * xReal, const TonicFloat * xImag, TonicFloat * yReal, TonicFloat * yImag,
+                       size_t stride, size_t span, const TonicFloat * twiddleReal, const TonicFloat * twiddleImag );
+
+    //! One radix-4 pass, as fftRadix2: the 4-point DFT of x[k + stride * (q + span * j)], j < 4, goes to
+    //! y[k + stride * (4q + r)], output r > 0 multiplied by twiddle[3q + r - 1]
+    void (*fftRadix4)( const TonicFloat * xReal, const TonicFloat * xImag, TonicFloat * yReal, TonicFloat * yImag,
+                       size_t stride, size_t span, const TonicFloat * twiddleReal, const TonicFloat * twiddleImag );
+
+  };
+
+  namespace Tonic_ {
+    extern const VectorKernels * activeVectorKernels_;
+  }
+
+  //! The kernels in use - the widest this CPU supports, unless changed with setVectorKernels
+  inline const VectorKernels & vectorKernels(){
+    return *Tonic_::activeVectorKernels_;
+  }
+
+  //! Every implementation compiled in and supported by this CPU, "scalar" first and the widest last
+  vector<const VectorKernels *> availableVectorKernels();
+
+  //! Use the implementation called name from now on, for testing and benchmarking
+  /*!
+      Returns false, leaving the kernels unchanged, if there is no such implementation on this CPU.
+      Must not be called while anything is rendering.
+   */
+  bool setVectorKernels( const string & name );
+
+}
+
+#endif
@@ -0,0 +1,127 @@
+//
+//  WavetableOsc.cpp
+//  Tonic
+//
+//
+// See LICENSE.txt for license and usage information.
+//
+
+#include "WavetableOsc.h"
+#include "ControlValue.h"
+#include "DSPUtils.h"
+#include <sstream>
+
+namespace Tonic {
+
+  namespace Tonic_ {
+
+    // Registry name for the levels of a cycle - its length and a hash of its samples
+    static string wavetableName( const TonicFloat * cycle, unsigned int length ){
+      unsigned long long hash = 14695981039346656037ULL;
+      const unsigned char * bytes = (const unsigned char *)cycle;
+      for (size_t i=0; i<length * sizeof(TonicFloat); i++){
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+      }
+      std::ostringstream name;
+      name << "_TONIC_WAVETABLE_" << length << "_" << std::hex << hash;
+      return name.str();
+    }
+
+    static SampleTable buildMipMappedWavetable( const TonicFloat * cycle, unsigned int length ){
+
+      SampleTable levels = SampleTable(kWavetableLength + 1, kWavetableLevels);
+
+      // spectrum of the source, at its own length
+      FFT sourceFFT(length);
+      vector<TonicFloat> realFreq(length / 2 + 1), imagFreq(length / 2 + 1);
+      sourceFFT.forwardReal(cycle, &realFreq[0], &imagFreq[0]);
+
+      // each level resynthesized at kWavetableLength from the harmonics it keeps, and below the source's Nyquist
+      FFT levelFFT(kWavetableLength);
+      const TonicFloat scale = (TonicFloat)kWavetableLength / length;
+      const unsigned int sourceHarmonics = (length - 1) / 2;
+      vector<TonicFloat> realLevel(kWavetableLength / 2 + 1), imagLevel(kWavetableLength / 2 + 1);
+
+      for (unsigned int l=0; l<kWavetableLevels; l++){
+
+        unsigned int harmonics = min(kWavetableHarmonics >> l, sourceHarmonics);
+
+        std::fill(realLevel.begin(), realLevel.end(), 0.f);
+        std::fill(imagLevel.begin(), imagLevel.end(), 0.f);
+        for (unsigned int h=0; h<=harmonics; h++){
+          realLevel[h] = realFreq[h] * scale;
+          imagLevel[h] = imagFreq[h] * scale;
+        }
+
+        TonicFloat *data = levels.channelPointer(l);
+        levelFFT.inverseReal(&realLevel[0], &imagLevel[0], data);
+        data[kWavetableLength] = data[0];
+      }
+
+      return levels;
+    }
+
+    SampleTable mipMappedWavetable( SampleTable source ){
+
+      unsigned int length = (unsigned int)source.frames();
+      unsigned int powerOf2;
+      if (length > 2 && isPowerOf2(length - 1, &powerOf2)) length--;
+
+      const TonicFloat *cycle = source.channelPointer(0);
+      string name = wavetableName(cycle, length);
+
+      TONIC_MUTEX_LOCK(s_oscillatorTablesMutex());
+      SampleTable levels;
+      if (s_oscillatorTables()->containsObjectNamed(name)){
+        levels = s_oscillatorTables()->objectNamed(name);
+      }
+      else{
+        levels = buildMipMappedWavetable(cycle, length);
+        s_oscillatorTables()->insertObject(name, levels);
+      }
+      TONIC_MUTEX_UNLOCK(s_oscillatorTablesMutex());
+
+      return levels;
+    }
+
+    // Levels of silence, played by every oscillator until it is given a table. Never freed, like the sine table.
+    static SampleTable * createSilentLevels(){
+      SampleTable * levels = new SampleTable(kWavetableLength + 1, kWavetableLevels);
+      memset(levels->planarDataPointer(), 0, levels->size() * sizeof(TonicFloat));
+      return levels;
+    }
+
+    static const SampleTable & silentLevels(){
+      static SampleTable * const levels = createSilentLevels();
+      return *levels;
+    }
+
+    WavetableOsc_::WavetableOsc_() :
+      levels_(silentLevels()),
+      phase_(0)
+    {
+      modFrames_.resize(kSynthesisBlockSize, 1);
+      crossfade_ = ControlValue(1);
+    }
+
+    void WavetableOsc_::setTable( SampleTable table ){
+
+      if (table.frames() < 2){
+        error("WavetableOsc::setTable - the table must have at least two samples");
+        return;
+      }
+      if (table.channels() != 1){
+        warning("WavetableOsc::setTable - only the first channel of the table will be played");
+      }
+
+      levels_ = mipMappedWavetable(table);
+    }
+
+  }
+
+  WavetableOsc & WavetableOsc::setTable( SampleTable table ){
+    gen()->setTable(table);
+    return *this;
+  }
+
+}
@@ -0,0 +1,167 @@
+//
+//  WavetableOsc.h
+//  Tonic
+//
+//
+// See LICENSE.txt for license and usage information.
+//
+
+#ifndef TONIC_WAVETABLEOSC_H
+#define TONIC_WAVETABLEOSC_H
+
+#include "TableLookupOsc.h"
+#include "ControlGenerator.h"
+
+namespace Tonic {
+
+  namespace Tonic_ {
+
+    //! Band-limited copies of one cycle of a waveform, an octave apart
+    /*!
+        Level l of the kWavetableLevels in the returned table (its channel l) holds the source's harmonics
+        up to kWavetableHarmonics >> l, in kWavetableLength samples plus a wraparound sample. Level l is
+        free of aliasing for frequencies up to sampleRate * 2^l / (2 * kWavetableHarmonics); the last
+        level is a single sine.
+
+        The levels are built with FFTs, once for any table with the same samples, and
+        shared from then on through s_oscillatorTables(). A source of a power of two plus one samples, as
+        TableLookupOsc takes, is read without its last sample. Not for the audio thread.
+     */
+    SampleTable mipMappedWavetable( SampleTable source );
+
+    static const unsigned int kWavetableLengthBits = 11;
+    static const unsigned int kWavetableLength = 1 << kWavetableLengthBits;
+    static const unsigned int kWavetableHarmonics = kWavetableLength / 4;
+    static const unsigned int kWavetableLevels = 10;  // log2(kWavetableHarmonics) + 1
+
+    class WavetableOsc_ : public Generator_ {
+
+    protected:
+
+      SampleTable   levels_;
+
+      // in 2^-32 cycles, so it wraps by itself
+      TonicUInt32   phase_;
+
+      Generator         frequencyGenerator_;
+      ControlGenerator  crossfade_;
+      TonicFrames       modFrames_;
+
+      void computeSynthesisBlock( const SynthesisContext_ & context );
+
+    public:
+
+      WavetableOsc_();
+
+      //! Any single cycle, mono. Builds or looks up its levels (see mipMappedWavetable), so not while playing.
+      void setTable( SampleTable table );
+
+      void setFrequency( Generator frequency ){ frequencyGenerator_ = frequency; }
+
+      //! Non-zero to blend the two levels either side of the frequency rather than switch between them
+      void setCrossfade( ControlGenerator crossfade ){ crossfade_ = crossfade; }
+
+      void reset(){ phase_ = 0; }
+
+    };
+
+    inline void WavetableOsc_::computeSynthesisBlock( const SynthesisContext_ & context ){
+
+      frequencyGenerator_.tick(modFrames_, context);
+      const bool crossfade = crossfade_.tick(context).value != 0;
+
+      const unsigned int nFrames = (unsigned int)outputFrames_.frames();
+      const int lastLevel = kWavetableLevels - 1;
+      const double phasePerHz = 4294967296.0 / sampleRate_;
+
+      // the top bits of the phase index the table, the rest interpolate
+      const unsigned int fractionBits = 32 - kWavetableLengthBits;
+      const TonicFloat fractionScale = 1.f / (1 << fractionBits);
+
+      // y = 2 * harmonics * cycles per sample: level l is alias-free while y <= 2^l
+      const TonicFloat levelScale = 2.f * kWavetableHarmonics / sampleRate_;
+
+      const TonicFloat *levels = levels_.channelPointer(0);
+      const size_t levelStride = levels_.channelPointer(1) - levels;
+
+      TonicFloat *samples = &outputFrames_[0];
+      const TonicFloat *frequency = &modFrames_[0];
+      TonicUInt32 phase = phase_;
+
+      // level and blend for the previous sample's frequency - usually the same for the whole block
+      TonicFloat lastFrequency = 0;
+      int level = 0;
+      TonicFloat weight = 1.f;
+      TonicUInt32 increment = 0;
+
+      for (unsigned int i=0; i<nFrames; i++){
+
+        if (frequency[i] != lastFrequency){
+
+          lastFrequency = frequency[i];
+          // negative frequencies, and those above the sample rate, wrap like the phase
+          increment = (TonicUInt32)(long long)(lastFrequency * phasePerHz);
+
+          // the lowest level safe at this frequency, and how much of it to blend with the next
+          level = 0;
+          weight = 1.f;
+          union { TonicFloat f; TonicUInt32 i; } y;
+          y.f = fabsf(lastFrequency) * levelScale;
+          if (y.f > 1.f){
+            // log2(y) from the float's exponent, plus its mantissa for the fraction - overestimated by at
+            // most 0.09, so never low, and continuous, so the blend is too
+            TonicFloat x = (TonicFloat)((int)(y.i >> 23) - 127) + (TonicFloat)(y.i & 0x7FFFFF) * (1.f / 0x800000) + 0.0861f;
+            level = (int)x + 1;
+            if (level >= lastLevel){
+              level = lastLevel;
+            }
+            else if (crossfade){
+              weight = level - x;
+            }
+          }
+        }
+
+        unsigned int index = phase >> fractionBits;
+        TonicFloat fraction = (TonicFloat)(phase & ((1 << fractionBits) - 1)) * fractionScale;
+
+        const TonicFloat *table = levels + level * levelStride + index;
+        TonicFloat value = table[0] + fraction * (table[1] - table[0]);
+        if (weight < 1.f){
+          const TonicFloat *next = table + levelStride;
+          value = weight * value + (1.f - weight) * (next[0] + fraction * (next[1] - next[0]));
+        }
+        samples[i] = value;
+
+        phase += increment;
+      }
+
+      phase_ = phase;
+
+    }
+
+  }
+
+  //! Band-limited wavetable oscillator, for any single-cycle waveform
+  /*!
+      Plays one of a set of band-limited copies of the table, an octave apart, picked sample by sample from
+      the frequency so nothing is ever above Nyquist - clean at any pitch, at close to the cost of a
+      TableLookupOsc. With crossfade, neighbouring levels are blended so sweeps don't step in brightness.
+
+        SampleTable saw = SampleTable(1024, 1);
+        for (unsigned int i=0; i<1024; i++) saw.planarDataPointer()[i] = 1.f - 2.f * i / 1024;
+        Generator osc = WavetableOsc().setTable(saw).freq(110 + 880 * lfo);
+   */
+  class WavetableOsc : public TemplatedGenerator<Tonic_::WavetableOsc_> {
+
+  public:
+
+    WavetableOsc & setTable( SampleTable table );
+
+    TONIC_MAKE_GEN_SETTERS(WavetableOsc, freq, setFrequency)
+    TONIC_MAKE_CTRL_GEN_SETTERS(WavetableOsc, crossfade, setCrossfade)
+
+  };
+
+}
+
+#endif
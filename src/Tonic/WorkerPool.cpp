@@ -0,0 +1,181 @@
+//
+//  WorkerPool.cpp
+//  Tonic
+//
+//
+// See LICENSE.txt for license and usage information.
+//
+
+#include "WorkerPool.h"
+
+#if TONIC_HAS_CPP_11
+
+#if defined (__linux__)
+#include <sched.h>
+#endif
+
+namespace Tonic {
+
+  namespace Tonic_ {
+
+    // Number of polls a worker makes for a new batch before going to sleep. Enough to catch a batch
+    // that follows right behind the last, without idle workers holding on to cores between blocks.
+    static const unsigned int kWorkerSpinCount = 256;
+
+    bool pinCurrentThreadToCore(unsigned int core){
+
+      const unsigned int numCores = std::thread::hardware_concurrency();
+      if (numCores == 0) return false;
+      core %= numCores;
+
+#if defined (__linux__)
+      cpu_set_t cores;
+      CPU_ZERO(&cores);
+      CPU_SET(core, &cores);
+      return pthread_setaffinity_np(pthread_self(), sizeof(cores), &cores) == 0;
+#elif (defined (_WIN32) || defined (__WIN32__))
+      return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << core) != 0;
+#else
+      // no hard affinity on macOS - the scheduler keeps busy threads where they are well enough
+      return false;
+#endif
+    }
+
+    WorkerPool::WorkerPool(unsigned int numWorkers, int firstCore) :
+      numWorkers_(numWorkers),
+      firstCore_(firstCore),
+      fn_(NULL),
+      userData_(NULL),
+      generation_(0),
+      activeWorkers_(0),
+      sleepingWorkers_(0),
+      quit_(false)
+    {
+      ranges_ = new TaskRange[numWorkers_ + 1];
+      for (unsigned int i=0; i<=numWorkers_; i++){
+        ranges_[i].next.store(0);
+        ranges_[i].end = 0;
+      }
+
+      threads_ = new std::thread[numWorkers_];
+      for (unsigned int i=0; i<numWorkers_; i++){
+        threads_[i] = std::thread(&WorkerPool::workerLoop, this, i+1);
+      }
+    }
+
+    WorkerPool::~WorkerPool(){
+
+      {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        quit_.store(true);
+      }
+      wakeCondition_.notify_all();
+
+      for (unsigned int i=0; i<numWorkers_; i++){
+        threads_[i].join();
+      }
+
+      delete [] threads_;
+      delete [] ranges_;
+    }
+
+    void WorkerPool::run(TaskFunction fn, void *userData, unsigned int numTasks){
+
+      if (numTasks == 0) return;
+
+      // nothing to share - don't bother waking anyone
+      if (numWorkers_ == 0 || numTasks == 1){
+        for (unsigned int i=0; i<numTasks; i++){
+          fn(userData, i, 0);
+        }
+        return;
+      }
+
+      const unsigned int participants = numWorkers_ + 1;
+      for (unsigned int i=0; i<participants; i++){
+        ranges_[i].next.store((unsigned int)((unsigned long)i * numTasks / participants), std::memory_order_relaxed);
+        ranges_[i].end = (unsigned int)((unsigned long)(i+1) * numTasks / participants);
+      }
+
+      fn_ = fn;
+      userData_ = userData;
+      activeWorkers_.store(numWorkers_, std::memory_order_relaxed);
+
+      // publish the batch
+      generation_.fetch_add(1);
+
+      // only take the lock if someone actually went to sleep
+      if (sleepingWorkers_.load() > 0){
+        TONIC_CHECK_REALTIME_LOCK();
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        wakeCondition_.notify_all();
+      }
+
+      executeTasks(0);
+
+      // all tasks are claimed by now, wait for workers to finish the ones they are running
+      while (activeWorkers_.load(std::memory_order_acquire) > 0){
+        std::this_thread::yield();
+      }
+    }
+
+    void WorkerPool::executeTasks(unsigned int workerIndex){
+
+      const unsigned int participants = numWorkers_ + 1;
+
+      for (unsigned int r=0; r<participants; r++){
+
+        TaskRange & range = ranges_[(workerIndex + r) % participants];
+
+        while (true){
+          unsigned int task = range.next.fetch_add(1, std::memory_order_relaxed);
+          if (task >= range.end) break;
+          fn_(userData_, task, workerIndex);
+        }
+      }
+    }
+
+    void WorkerPool::workerLoop(unsigned int workerIndex){
+
+      TONIC_ENABLE_DENORMAL_ROUNDING();
+
+      if (firstCore_ >= 0 && !pinCurrentThreadToCore(firstCore_ + workerIndex)){
+        warning("WorkerPool - could not pin worker thread to a core");
+      }
+
+      unsigned long seenGeneration = 0;
+
+      while (true){
+
+        // spin for a while waiting for the next batch, then sleep
+        unsigned int spins = 0;
+        while (generation_.load(std::memory_order_acquire) == seenGeneration && !quit_.load()){
+          if (++spins < kWorkerSpinCount){
+            std::this_thread::yield();
+          }
+          else{
+            std::unique_lock<std::mutex> lock(sleepMutex_);
+            sleepingWorkers_.fetch_add(1);
+            while (generation_.load() == seenGeneration && !quit_.load()){
+              wakeCondition_.wait(lock);
+            }
+            sleepingWorkers_.fetch_sub(1);
+            spins = 0;
+          }
+        }
+
+        if (quit_.load()) break;
+
+        seenGeneration = generation_.load(std::memory_order_acquire);
+
+        executeTasks(workerIndex);
+
+        activeWorkers_.fetch_sub(1, std::memory_order_release);
+      }
+    }
+
+  }
+
+}
+
+#endif
@@ -0,0 +1,105 @@
+//
+//  WorkerPool.h
+//  Tonic
+//
+//
+// See LICENSE.txt for license and usage information.
+//
+
+#ifndef TONIC_WORKERPOOL_H
+#define TONIC_WORKERPOOL_H
+
+#include "TonicCore.h"
+
+#if TONIC_HAS_CPP_11
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace Tonic {
+
+  namespace Tonic_ {
+
+    //! Restrict the calling thread to one CPU core, counted modulo the number of cores
+    /*!
+        Returns false if the platform has no way to do so (e.g. macOS) or the call fails.
+     */
+    bool pinCurrentThreadToCore(unsigned int core);
+
+    //! Persistent pool of worker threads which cooperatively execute a batch of independent tasks
+    /*!
+        run() splits task indices evenly between the calling thread and the workers. Each participant
+        drains its own share first and then steals unclaimed tasks from the others, so a batch
+        finishes as soon as all tasks are done regardless of how uneven they are.
+
+        Workers poll for a few hundred iterations after a batch, so batches run back to back do not pay
+        for a wakeup, then sleep on a condition variable until run() wakes them.
+
+        run() is not reentrant and must only be called from one thread at a time.
+     */
+    class WorkerPool {
+
+    public:
+
+      //! Task callback. workerIndex is 0 for the calling thread, 1...numWorkers for pool threads.
+      typedef void (*TaskFunction)(void *userData, unsigned int taskIndex, unsigned int workerIndex);
+
+      //! Create a pool with numWorkers background threads. The thread calling run() participates too.
+      /*!
+          If firstCore is zero or more, worker n is pinned to core firstCore + n, leaving firstCore
+          for the thread calling run().
+       */
+      WorkerPool(unsigned int numWorkers, int firstCore = -1);
+      ~WorkerPool();
+
+      //! Total number of threads participating in run(), including the caller
+      unsigned int numThreads() const { return numWorkers_ + 1; };
+
+      //! Execute fn for every task index in [0, numTasks) and return once all have completed
+      void run(TaskFunction fn, void *userData, unsigned int numTasks);
+
+    protected:
+
+      // One contiguous share of the task indices per participant, padded to its own cache line
+      struct TaskRange {
+        std::atomic<unsigned int> next;
+        unsigned int              end;
+        char                      padding[64 - sizeof(std::atomic<unsigned int>) - sizeof(unsigned int)];
+      };
+
+      unsigned int                  numWorkers_;
+      int                           firstCore_;
+      TaskRange                     *ranges_;
+      std::thread                   *threads_;
+
+      TaskFunction                  fn_;
+      void                          *userData_;
+
+      std::atomic<unsigned long>    generation_;
+      std::atomic<unsigned int>     activeWorkers_;
+      std::atomic<unsigned int>     sleepingWorkers_;
+      std::atomic<bool>             quit_;
+
+      std::mutex                    sleepMutex_;
+      std::condition_variable       wakeCondition_;
+
+      void workerLoop(unsigned int workerIndex);
+
+      // Claim and execute tasks until none are left, starting with this participant's own range
+      void executeTasks(unsigned int workerIndex);
+
+    private:
+
+      WorkerPool(const WorkerPool&);
+      WorkerPool& operator=(const WorkerPool&);
+
+    };
+
+  }
+
+}
+
+#endif
+
+#endif